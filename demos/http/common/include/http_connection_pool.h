@@ -0,0 +1,114 @@
+/*
+ * AWS IoT Device SDK for Embedded C 202103.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef HTTP_CONNECTION_POOL_H_
+#define HTTP_CONNECTION_POOL_H_
+
+/**
+ * @file http_connection_pool.h
+ * @brief A pool of keep-alive TLS connections for the HTTP demos.
+ *
+ * Requests to the same server reuse an idle connection instead of paying for
+ * a new TCP connection and TLS handshake. Connections are keyed by host, port
+ * and credentials; they are health-checked on checkout and closed once idle
+ * for longer than #HTTP_POOL_IDLE_TIMEOUT_MS.
+ *
+ * @note The pool is not thread safe.
+ */
+
+/* Standard includes. */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* OpenSSL transport header. */
+#include "openssl_posix.h"
+
+/**
+ * @brief Number of connections the pool holds, idle or checked out.
+ */
+#ifndef HTTP_POOL_MAX_CONNECTIONS
+    #define HTTP_POOL_MAX_CONNECTIONS    ( 2U )
+#endif
+
+/**
+ * @brief Time after which an idle connection is closed rather than reused.
+ *
+ * This should be shorter than the idle timeout of the server, so that a
+ * request is not sent on a connection the server is about to close. S3 closes
+ * connections idle for about 20 seconds.
+ */
+#ifndef HTTP_POOL_IDLE_TIMEOUT_MS
+    #define HTTP_POOL_IDLE_TIMEOUT_MS    ( 15000U )
+#endif
+
+/**
+ * @brief Longest host name the pool can connect to.
+ */
+#ifndef HTTP_POOL_MAX_HOST_LENGTH
+    #define HTTP_POOL_MAX_HOST_LENGTH    ( 256U )
+#endif
+
+/**
+ * @brief Get a connection to a server, reusing an idle one if possible.
+ *
+ * Idle connections past #HTTP_POOL_IDLE_TIMEOUT_MS are closed first. An idle
+ * connection with the same host, port and credentials is reused if the server
+ * has not closed it or sent unexpected data; otherwise a new connection is
+ * established with #Openssl_Connect, with backoff retries. If the pool is
+ * full, the least recently used idle connection is closed to make room.
+ *
+ * @param[in] pHost Host name of the server; need not be null-terminated.
+ * @param[in] hostLength Length of @p pHost.
+ * @param[in] port Port of the server.
+ * @param[in] pCredentials Credentials of the TLS connection. The strings it
+ * points to must remain valid until #HttpPool_CloseAll.
+ * @param[in] sendRecvTimeoutMs Send and receive timeout of new connections.
+ *
+ * @return The network context of the connection, or NULL if no connection
+ * could be established.
+ */
+NetworkContext_t * HttpPool_Checkout( const char * pHost,
+                                      size_t hostLength,
+                                      uint16_t port,
+                                      const OpensslCredentials_t * pCredentials,
+                                      uint32_t sendRecvTimeoutMs );
+
+/**
+ * @brief Return a connection to the pool.
+ *
+ * @param[in] pNetworkContext A network context returned by #HttpPool_Checkout.
+ * @param[in] keepAlive true to keep the connection for later requests; false
+ * to close it, e.g. after an error or if the server answered with
+ * "Connection: close".
+ */
+void HttpPool_Checkin( NetworkContext_t * pNetworkContext,
+                       bool keepAlive );
+
+/**
+ * @brief Close every connection of the pool.
+ *
+ * Connections must not be checked out when this is called.
+ */
+void HttpPool_CloseAll( void );
+
+#endif /* ifndef HTTP_CONNECTION_POOL_H_ */
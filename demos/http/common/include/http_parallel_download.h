@@ -0,0 +1,163 @@
+/*
+ * AWS IoT Device SDK for Embedded C 202103.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef HTTP_PARALLEL_DOWNLOAD_H_
+#define HTTP_PARALLEL_DOWNLOAD_H_
+
+/**
+ * @file http_parallel_download.h
+ * @brief Download a file with ranged GET requests over several connections.
+ *
+ * Worker threads, each with its own keep-alive TLS connection, take byte
+ * ranges of the file from a shared work queue and write each received range
+ * at its offset in the output file with pwrite, so ranges may complete in any
+ * order. The length of the ranges a worker requests adapts to how fast its
+ * connection is, and ranges that fail are put back in the queue for another
+ * attempt.
+ *
+ * @note One download runs at a time.
+ */
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* OpenSSL transport header. */
+#include "openssl_posix.h"
+
+/**
+ * @brief Largest number of worker threads, and so of connections.
+ */
+#ifndef HTTP_PARALLEL_DOWNLOAD_MAX_WORKERS
+    #define HTTP_PARALLEL_DOWNLOAD_MAX_WORKERS    ( 4U )
+#endif
+
+/**
+ * @brief Length of the first range a worker requests, and the shortest length
+ * the adaptive sizing goes down to.
+ */
+#ifndef HTTP_PARALLEL_DOWNLOAD_MIN_RANGE_LENGTH
+    #define HTTP_PARALLEL_DOWNLOAD_MIN_RANGE_LENGTH    ( 64U * 1024U )
+#endif
+
+/**
+ * @brief Longest range a worker requests.
+ *
+ * Each worker statically allocates a buffer of this length plus
+ * #HTTP_PARALLEL_DOWNLOAD_HEADER_BUFFER_LENGTH for the responses.
+ */
+#ifndef HTTP_PARALLEL_DOWNLOAD_MAX_RANGE_LENGTH
+    #define HTTP_PARALLEL_DOWNLOAD_MAX_RANGE_LENGTH    ( 1024U * 1024U )
+#endif
+
+/**
+ * @brief Space for the request headers, and for the response headers in front
+ * of the body of a range.
+ */
+#ifndef HTTP_PARALLEL_DOWNLOAD_HEADER_BUFFER_LENGTH
+    #define HTTP_PARALLEL_DOWNLOAD_HEADER_BUFFER_LENGTH    ( 2048U )
+#endif
+
+/**
+ * @brief Time a range request should take.
+ *
+ * A worker doubles the length of its ranges while they complete in less than
+ * half of this time, and halves it when they take more than twice this time.
+ * Longer ranges amortize the request latency; shorter ones keep a slow
+ * connection from holding up the end of the download.
+ */
+#ifndef HTTP_PARALLEL_DOWNLOAD_TARGET_RANGE_MS
+    #define HTTP_PARALLEL_DOWNLOAD_TARGET_RANGE_MS    ( 1000U )
+#endif
+
+/**
+ * @brief Number of times a range is requested before the download fails.
+ */
+#ifndef HTTP_PARALLEL_DOWNLOAD_MAX_RANGE_ATTEMPTS
+    #define HTTP_PARALLEL_DOWNLOAD_MAX_RANGE_ATTEMPTS    ( 3U )
+#endif
+
+/**
+ * @brief Status codes of #HttpDownload_Run.
+ */
+typedef enum HttpDownloadStatus
+{
+    HTTP_DOWNLOAD_SUCCESS = 0,       /**< The file was downloaded. */
+    HTTP_DOWNLOAD_INVALID_PARAMETER, /**< A parameter was invalid. */
+    HTTP_DOWNLOAD_CONNECT_FAILURE,   /**< A connection to the server could not be established. */
+    HTTP_DOWNLOAD_REQUEST_FAILURE,   /**< A range could not be downloaded in #HTTP_PARALLEL_DOWNLOAD_MAX_RANGE_ATTEMPTS attempts. */
+    HTTP_DOWNLOAD_WRITE_FAILURE,     /**< The output file could not be written. */
+    HTTP_DOWNLOAD_THREAD_FAILURE,    /**< A worker thread could not be created. */
+    HTTP_DOWNLOAD_FILE_TOO_LARGE     /**< The file is larger than the Range header of coreHTTP can address. */
+} HttpDownloadStatus_t;
+
+/**
+ * @brief The file to download and how to download it.
+ */
+typedef struct HttpDownloadConfig
+{
+    const char * pHost;                        /**< @brief Null-terminated host name of the server. */
+    size_t hostLength;                         /**< @brief Length of the host name. */
+    uint16_t port;                             /**< @brief Port of the server. */
+    const char * pPath;                        /**< @brief Request-URI of the file, with its query. */
+    size_t pathLength;                         /**< @brief Length of the Request-URI. */
+    const OpensslCredentials_t * pCredentials; /**< @brief Credentials of the connections. */
+    uint32_t sendRecvTimeoutMs;                /**< @brief Timeout of the connections. */
+    int fileDescriptor;                        /**< @brief File to write the download to, opened for writing. */
+    size_t workerCount;                        /**< @brief Number of workers, up to #HTTP_PARALLEL_DOWNLOAD_MAX_WORKERS. */
+} HttpDownloadConfig_t;
+
+/**
+ * @brief Statistics of a download.
+ */
+typedef struct HttpDownloadResult
+{
+    size_t fileSize;      /**< @brief Size of the downloaded file. */
+    size_t rangeRequests; /**< @brief Number of range requests sent, including retries. */
+    size_t rangeRetries;  /**< @brief Number of ranges requested again after a failure. */
+    uint64_t elapsedUs;   /**< @brief Duration of the download. */
+} HttpDownloadResult_t;
+
+/**
+ * @brief Download a file with ranged GET requests over several connections.
+ *
+ * The first range is requested on the calling thread to learn the size of the
+ * file from its Content-Range header. The rest of the file is then split
+ * between @p pConfig->workerCount threads. The function returns when the file
+ * is downloaded, or when a range failed
+ * #HTTP_PARALLEL_DOWNLOAD_MAX_RANGE_ATTEMPTS times; every connection is closed
+ * on return.
+ *
+ * @note The Range header of coreHTTP takes 32-bit offsets, so the file must
+ * be at most INT32_MAX bytes. Larger files fail with
+ * #HTTP_DOWNLOAD_FILE_TOO_LARGE once the first range tells their size.
+ *
+ * @param[in] pConfig The file to download and how to download it.
+ * @param[out] pResult Statistics of the download. May be NULL.
+ *
+ * @return #HTTP_DOWNLOAD_SUCCESS if the whole file was written; an error code
+ * otherwise.
+ */
+HttpDownloadStatus_t HttpDownload_Run( const HttpDownloadConfig_t * pConfig,
+                                       HttpDownloadResult_t * pResult );
+
+#endif /* ifndef HTTP_PARALLEL_DOWNLOAD_H_ */
@@ -0,0 +1,110 @@
+/*
+ * AWS IoT Device SDK for Embedded C 202103.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SPSC_RING_H_
+#define SPSC_RING_H_
+
+/**
+ * @file spsc_ring.h
+ * @brief A single-producer single-consumer ring of 32-bit descriptors, for
+ * passing buffer indices between two processes over shared memory.
+ *
+ * The ring only carries descriptors: the data they refer to stays in place in
+ * the shared memory. Pushing and popping use atomic loads and stores; a
+ * consumer waiting on an empty ring sleeps on a futex, which the producer
+ * wakes only when the consumer is asleep. The futex is not private, so the
+ * ring works across processes when placed in a MAP_SHARED mapping.
+ */
+
+/* Standard includes. */
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Number of descriptors the ring holds. Must be a power of two.
+ */
+#ifndef SPSC_RING_CAPACITY
+    #define SPSC_RING_CAPACITY    ( 16U )
+#endif
+
+/**
+ * @brief Timeout of #SpscRing_Pop to wait until a descriptor is pushed,
+ * however long it takes.
+ */
+#define SPSC_RING_WAIT_FOREVER    ( UINT32_MAX )
+
+/**
+ * @brief Size of a cache line, to keep the indices of the producer and the
+ * consumer from sharing one.
+ */
+#define SPSC_RING_CACHE_LINE_SIZE    ( 64U )
+
+/**
+ * @brief A single-producer single-consumer ring.
+ *
+ * @note Indices run freely and wrap around; they are reduced modulo
+ * #SPSC_RING_CAPACITY to index the entries.
+ */
+typedef struct SpscRing
+{
+    uint32_t head;                                                                  /**< @brief Next entry to write. Written by the producer; the futex word. */
+    uint32_t consumerWaiting;                                                       /**< @brief Set while the consumer may sleep on head. */
+    uint8_t headPadding[ SPSC_RING_CACHE_LINE_SIZE - ( 2U * sizeof( uint32_t ) ) ]; /**< @brief Moves tail to another cache line. */
+    uint32_t tail;                                                                  /**< @brief Next entry to read. Written by the consumer. */
+    uint8_t tailPadding[ SPSC_RING_CACHE_LINE_SIZE - sizeof( uint32_t ) ];          /**< @brief Moves entries to another cache line. */
+    uint32_t entries[ SPSC_RING_CAPACITY ];                                         /**< @brief The descriptors. */
+} SpscRing_t;
+
+/**
+ * @brief Initialize an empty ring.
+ *
+ * @param[out] pRing The ring, in memory shared by the producer and consumer.
+ */
+void SpscRing_Init( SpscRing_t * pRing );
+
+/**
+ * @brief Push a descriptor. Only the producer may call this.
+ *
+ * @param[in] pRing The ring.
+ * @param[in] descriptor The descriptor.
+ *
+ * @return true if the descriptor was pushed; false if the ring is full.
+ */
+bool SpscRing_Push( SpscRing_t * pRing,
+                    uint32_t descriptor );
+
+/**
+ * @brief Pop a descriptor, waiting for one if the ring is empty. Only the
+ * consumer may call this.
+ *
+ * @param[in] pRing The ring.
+ * @param[out] pDescriptor The descriptor.
+ * @param[in] timeoutMs How long to wait for a descriptor: 0 to not wait, or
+ * #SPSC_RING_WAIT_FOREVER.
+ *
+ * @return true if a descriptor was popped; false if the ring stayed empty.
+ */
+bool SpscRing_Pop( SpscRing_t * pRing,
+                   uint32_t * pDescriptor,
+                   uint32_t timeoutMs );
+
+#endif /* ifndef SPSC_RING_H_ */
@@ -0,0 +1,436 @@
+/*
+ * AWS IoT Device SDK for Embedded C 202103.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Standard includes. */
+#include <assert.h>
+#include <string.h>
+
+/* POSIX includes. */
+#include <poll.h>
+
+/* Include Demo Config as the first non-system header. */
+#include "demo_config.h"
+
+/* Connection pool header. */
+#include "http_connection_pool.h"
+
+/* Demo utils header for the connection retries. */
+#include "http_demo_utils.h"
+
+/* Include clock header for the idle times of connections. */
+#include "clock.h"
+
+/*-----------------------------------------------------------*/
+
+/* Each compilation unit must define the NetworkContext struct. */
+struct NetworkContext
+{
+    OpensslParams_t * pParams;
+};
+
+/**
+ * @brief A connection of the pool.
+ */
+typedef struct HttpPoolEntry
+{
+    bool connected;                              /**< @brief The connection is established. */
+    bool checkedOut;                             /**< @brief The connection is in use by a caller. */
+    uint32_t lastUsedMs;                         /**< @brief Time of the last check in. */
+    char host[ HTTP_POOL_MAX_HOST_LENGTH + 1U ]; /**< @brief Null-terminated host name of the server. */
+    ServerInfo_t serverInfo;                     /**< @brief Server of the connection, pointing to host. */
+    OpensslCredentials_t credentials;            /**< @brief Copy of the credentials of the connection. */
+    uint32_t sendRecvTimeoutMs;                  /**< @brief Timeout of the connection. */
+    OpensslParams_t opensslParams;
+    NetworkContext_t networkContext;
+} HttpPoolEntry_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The connections of the pool.
+ */
+static HttpPoolEntry_t pool[ HTTP_POOL_MAX_CONNECTIONS ];
+
+/**
+ * @brief The entry being connected by #connectEntry, which takes no other
+ * argument than the network context.
+ */
+static HttpPoolEntry_t * pConnectingEntry = NULL;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Compare two optional strings.
+ *
+ * @return true if both are NULL or both have the same contents.
+ */
+static bool stringsEqual( const char * pLeft,
+                          const char * pRight );
+
+/**
+ * @brief Check whether an entry connects to the given server with the given
+ * credentials.
+ *
+ * @return true if the entry matches.
+ */
+static bool entryMatches( const HttpPoolEntry_t * pEntry,
+                          const char * pHost,
+                          size_t hostLength,
+                          uint16_t port,
+                          const OpensslCredentials_t * pCredentials );
+
+/**
+ * @brief Check that an idle connection can carry a new request.
+ *
+ * An idle keep-alive connection has nothing to read. A readable socket means
+ * that the server closed the connection, or sent data no request waits for.
+ *
+ * @return true if the connection can be reused.
+ */
+static bool isHealthy( const HttpPoolEntry_t * pEntry );
+
+/**
+ * @brief Close the connection of an entry and free the entry.
+ */
+static void closeEntry( HttpPoolEntry_t * pEntry );
+
+/**
+ * @brief Connect #pConnectingEntry to its server.
+ *
+ * @param[in] pNetworkContext The network context of #pConnectingEntry.
+ *
+ * @return EXIT_FAILURE on failure; EXIT_SUCCESS on successful connection.
+ */
+static int32_t connectEntry( NetworkContext_t * pNetworkContext );
+
+/**
+ * @brief Find an entry to establish a new connection in, closing the least
+ * recently used idle connection if the pool is full.
+ *
+ * @return The free entry, or NULL if every connection is checked out.
+ */
+static HttpPoolEntry_t * allocateEntry( void );
+
+/*-----------------------------------------------------------*/
+
+static bool stringsEqual( const char * pLeft,
+                          const char * pRight )
+{
+    bool equal = false;
+
+    if( ( pLeft == NULL ) || ( pRight == NULL ) )
+    {
+        equal = ( pLeft == pRight );
+    }
+    else
+    {
+        equal = ( strcmp( pLeft, pRight ) == 0 );
+    }
+
+    return equal;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool entryMatches( const HttpPoolEntry_t * pEntry,
+                          const char * pHost,
+                          size_t hostLength,
+                          uint16_t port,
+                          const OpensslCredentials_t * pCredentials )
+{
+    const OpensslCredentials_t * pEntryCredentials = &pEntry->credentials;
+
+    return ( pEntry->serverInfo.port == port ) &&
+           ( pEntry->serverInfo.hostNameLength == hostLength ) &&
+           ( strncmp( pEntry->host, pHost, hostLength ) == 0 ) &&
+           stringsEqual( pEntryCredentials->pRootCaPath, pCredentials->pRootCaPath ) &&
+           stringsEqual( pEntryCredentials->pClientCertPath, pCredentials->pClientCertPath ) &&
+           stringsEqual( pEntryCredentials->pPrivateKeyPath, pCredentials->pPrivateKeyPath ) &&
+           ( pEntryCredentials->alpnProtosLen == pCredentials->alpnProtosLen ) &&
+           ( ( pCredentials->alpnProtosLen == 0U ) ||
+             ( memcmp( pEntryCredentials->pAlpnProtos,
+                       pCredentials->pAlpnProtos,
+                       pCredentials->alpnProtosLen ) == 0 ) );
+}
+
+/*-----------------------------------------------------------*/
+
+static bool isHealthy( const HttpPoolEntry_t * pEntry )
+{
+    struct pollfd pollDescriptor;
+    bool healthy = true;
+
+    if( Openssl_HasPendingData( &pEntry->networkContext ) == 1U )
+    {
+        healthy = false;
+    }
+    else
+    {
+        pollDescriptor.fd = Openssl_GetSocketDescriptor( &pEntry->networkContext );
+        pollDescriptor.events = POLLIN;
+        pollDescriptor.revents = 0;
+
+        /* Do not wait: only data or a hang up that already arrived count. */
+        healthy = ( poll( &pollDescriptor, 1U, 0 ) == 0 );
+    }
+
+    return healthy;
+}
+
+/*-----------------------------------------------------------*/
+
+static void closeEntry( HttpPoolEntry_t * pEntry )
+{
+    if( pEntry->connected == true )
+    {
+        /* End the TLS session, then close the TCP connection. */
+        ( void ) Openssl_Disconnect( &pEntry->networkContext );
+    }
+
+    pEntry->connected = false;
+    pEntry->checkedOut = false;
+}
+
+/*-----------------------------------------------------------*/
+
+static int32_t connectEntry( NetworkContext_t * pNetworkContext )
+{
+    OpensslStatus_t opensslStatus = OPENSSL_SUCCESS;
+
+    assert( pConnectingEntry != NULL );
+    assert( pNetworkContext == &pConnectingEntry->networkContext );
+
+    LogInfo( ( "Establishing a TLS session to %s:%u.",
+               pConnectingEntry->host,
+               ( unsigned int ) pConnectingEntry->serverInfo.port ) );
+
+    opensslStatus = Openssl_Connect( pNetworkContext,
+                                     &pConnectingEntry->serverInfo,
+                                     &pConnectingEntry->credentials,
+                                     pConnectingEntry->sendRecvTimeoutMs,
+                                     pConnectingEntry->sendRecvTimeoutMs );
+
+    return ( opensslStatus == OPENSSL_SUCCESS ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*-----------------------------------------------------------*/
+
+static HttpPoolEntry_t * allocateEntry( void )
+{
+    HttpPoolEntry_t * pFree = NULL;
+    HttpPoolEntry_t * pOldest = NULL;
+    uint32_t nowMs = Clock_GetTimeMs();
+    size_t i;
+
+    for( i = 0U; ( i < HTTP_POOL_MAX_CONNECTIONS ) && ( pFree == NULL ); i++ )
+    {
+        if( pool[ i ].connected == false )
+        {
+            pFree = &pool[ i ];
+        }
+        else if( ( pool[ i ].checkedOut == false ) &&
+                 ( ( pOldest == NULL ) ||
+                   ( ( nowMs - pool[ i ].lastUsedMs ) > ( nowMs - pOldest->lastUsedMs ) ) ) )
+        {
+            pOldest = &pool[ i ];
+        }
+        else
+        {
+            /* The connection is in use. */
+        }
+    }
+
+    if( ( pFree == NULL ) && ( pOldest != NULL ) )
+    {
+        LogInfo( ( "Pool is full: closing the idle connection to %s:%u.",
+                   pOldest->host,
+                   ( unsigned int ) pOldest->serverInfo.port ) );
+        closeEntry( pOldest );
+        pFree = pOldest;
+    }
+
+    return pFree;
+}
+
+/*-----------------------------------------------------------*/
+
+NetworkContext_t * HttpPool_Checkout( const char * pHost,
+                                      size_t hostLength,
+                                      uint16_t port,
+                                      const OpensslCredentials_t * pCredentials,
+                                      uint32_t sendRecvTimeoutMs )
+{
+    HttpPoolEntry_t * pEntry = NULL;
+    NetworkContext_t * pNetworkContext = NULL;
+    uint32_t nowMs = Clock_GetTimeMs();
+    size_t i;
+
+    if( ( pHost == NULL ) || ( hostLength == 0U ) || ( hostLength > HTTP_POOL_MAX_HOST_LENGTH ) ||
+        ( pCredentials == NULL ) )
+    {
+        LogError( ( "Invalid parameter passed to HttpPool_Checkout()." ) );
+    }
+    else
+    {
+        for( i = 0U; i < HTTP_POOL_MAX_CONNECTIONS; i++ )
+        {
+            if( ( pool[ i ].connected == false ) || ( pool[ i ].checkedOut == true ) )
+            {
+                /* Nothing to reuse or evict. */
+            }
+            else if( ( nowMs - pool[ i ].lastUsedMs ) > HTTP_POOL_IDLE_TIMEOUT_MS )
+            {
+                LogDebug( ( "Closing the connection to %s:%u, idle for %u ms.",
+                            pool[ i ].host,
+                            ( unsigned int ) pool[ i ].serverInfo.port,
+                            ( unsigned int ) ( nowMs - pool[ i ].lastUsedMs ) ) );
+                closeEntry( &pool[ i ] );
+            }
+            else if( ( pEntry == NULL ) &&
+                     ( entryMatches( &pool[ i ], pHost, hostLength, port, pCredentials ) == true ) )
+            {
+                if( isHealthy( &pool[ i ] ) == true )
+                {
+                    pEntry = &pool[ i ];
+                }
+                else
+                {
+                    LogInfo( ( "The idle connection to %s:%u was closed by the server.",
+                               pool[ i ].host,
+                               ( unsigned int ) pool[ i ].serverInfo.port ) );
+                    closeEntry( &pool[ i ] );
+                }
+            }
+            else
+            {
+                /* The connection is to another server, or a duplicate. */
+            }
+        }
+
+        if( pEntry != NULL )
+        {
+            LogInfo( ( "Reusing the idle connection to %s:%u.",
+                       pEntry->host,
+                       ( unsigned int ) pEntry->serverInfo.port ) );
+        }
+        else
+        {
+            pEntry = allocateEntry();
+
+            if( pEntry == NULL )
+            {
+                LogError( ( "Every connection of the pool is checked out." ) );
+            }
+        }
+    }
+
+    if( ( pEntry != NULL ) && ( pEntry->connected == false ) )
+    {
+        ( void ) memset( pEntry, 0, sizeof( HttpPoolEntry_t ) );
+        ( void ) memcpy( pEntry->host, pHost, hostLength );
+        pEntry->host[ hostLength ] = '\0';
+        pEntry->serverInfo.pHostName = pEntry->host;
+        pEntry->serverInfo.hostNameLength = hostLength;
+        pEntry->serverInfo.port = port;
+        pEntry->sendRecvTimeoutMs = sendRecvTimeoutMs;
+        pEntry->networkContext.pParams = &pEntry->opensslParams;
+
+        /* The copy must not point to buffers of the caller that may change.
+         * A read-ahead buffer cannot be shared by several connections. */
+        pEntry->credentials = *pCredentials;
+        pEntry->credentials.pReadAheadBuffer = NULL;
+        pEntry->credentials.readAheadBufferSize = 0U;
+
+        if( pCredentials->sniHostName != NULL )
+        {
+            pEntry->credentials.sniHostName = pEntry->host;
+        }
+
+        pConnectingEntry = pEntry;
+
+        if( connectToServerWithBackoffRetries( connectEntry,
+                                               &pEntry->networkContext ) == EXIT_SUCCESS )
+        {
+            pEntry->connected = true;
+        }
+        else
+        {
+            pEntry = NULL;
+        }
+
+        pConnectingEntry = NULL;
+    }
+
+    if( pEntry != NULL )
+    {
+        pEntry->checkedOut = true;
+        pNetworkContext = &pEntry->networkContext;
+    }
+
+    return pNetworkContext;
+}
+
+/*-----------------------------------------------------------*/
+
+void HttpPool_Checkin( NetworkContext_t * pNetworkContext,
+                       bool keepAlive )
+{
+    HttpPoolEntry_t * pEntry = NULL;
+    size_t i;
+
+    for( i = 0U; ( i < HTTP_POOL_MAX_CONNECTIONS ) && ( pEntry == NULL ); i++ )
+    {
+        if( ( pool[ i ].checkedOut == true ) && ( &pool[ i ].networkContext == pNetworkContext ) )
+        {
+            pEntry = &pool[ i ];
+        }
+    }
+
+    if( pEntry == NULL )
+    {
+        LogError( ( "HttpPool_Checkin() was passed a connection that is not checked out." ) );
+    }
+    else if( keepAlive == false )
+    {
+        closeEntry( pEntry );
+    }
+    else
+    {
+        pEntry->checkedOut = false;
+        pEntry->lastUsedMs = Clock_GetTimeMs();
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+void HttpPool_CloseAll( void )
+{
+    size_t i;
+
+    for( i = 0U; i < HTTP_POOL_MAX_CONNECTIONS; i++ )
+    {
+        assert( pool[ i ].checkedOut == false );
+        closeEntry( &pool[ i ] );
+    }
+}
+
+/*-----------------------------------------------------------*/
@@ -98,6 +98,8 @@ int32_t connectToServerWithBackoffRetries( TransportConnect_t connectFunction,
     /* Struct containing the next backoff time. */
     BackoffAlgorithmContext_t reconnectParams;
     uint16_t nextRetryBackOff = 0U;
+    /* Start time of the current connection attempt. */
+    uint64_t connectStartUs = 0U;
     struct timespec tp;
 
     assert( connectFunction != NULL );
@@ -122,9 +124,15 @@ int32_t connectToServerWithBackoffRetries( TransportConnect_t connectFunction,
      * attempts are reached. */
     do
     {
+        connectStartUs = Clock_GetTimeUs64();
         returnStatus = connectFunction( pNetworkContext );
 
-        if( returnStatus != EXIT_SUCCESS )
+        if( returnStatus == EXIT_SUCCESS )
+        {
+            LogInfo( ( "Connection to the HTTP server established in %lu us.",
+                       ( unsigned long ) ( Clock_GetTimeUs64() - connectStartUs ) ) );
+        }
+        else
         {
             /* Generate a random number and get back-off value (in milliseconds) for the next connection retry. */
             backoffAlgStatus = BackoffAlgorithm_GetNextBackoff( &reconnectParams, generateRandomNumber(), &nextRetryBackOff );
@@ -0,0 +1,991 @@
+/*
+ * AWS IoT Device SDK for Embedded C 202103.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Standard includes. */
+#include <errno.h>
+#include <string.h>
+
+/* POSIX includes. */
+#include <pthread.h>
+#include <unistd.h>
+
+/* Include Demo Config as the first non-system header. */
+#include "demo_config.h"
+
+/* Parallel download header. */
+#include "http_parallel_download.h"
+
+/* Demo utils header for the connection retries. */
+#include "http_demo_utils.h"
+
+/* HTTP API header. */
+#include "core_http_client.h"
+
+/* Include clock header for the duration of the range requests. */
+#include "clock.h"
+
+#if HTTP_PARALLEL_DOWNLOAD_MIN_RANGE_LENGTH > HTTP_PARALLEL_DOWNLOAD_MAX_RANGE_LENGTH
+    #error "HTTP_PARALLEL_DOWNLOAD_MIN_RANGE_LENGTH must not exceed HTTP_PARALLEL_DOWNLOAD_MAX_RANGE_LENGTH."
+#endif
+
+/**
+ * @brief The length of the HTTP GET method.
+ */
+#define HTTP_METHOD_GET_LENGTH                    ( sizeof( HTTP_METHOD_GET ) - 1 )
+
+/**
+ * @brief Field name of the HTTP range header to read from server response.
+ */
+#define HTTP_CONTENT_RANGE_HEADER_FIELD           "Content-Range"
+
+/**
+ * @brief Length of the HTTP range header field.
+ */
+#define HTTP_CONTENT_RANGE_HEADER_FIELD_LENGTH    ( sizeof( HTTP_CONTENT_RANGE_HEADER_FIELD ) - 1 )
+
+/**
+ * @brief Unit of the value of the Content-Range header.
+ */
+#define HTTP_CONTENT_RANGE_UNIT                   "bytes "
+
+/**
+ * @brief Length of the unit of the Content-Range header.
+ */
+#define HTTP_CONTENT_RANGE_UNIT_LENGTH            ( sizeof( HTTP_CONTENT_RANGE_UNIT ) - 1 )
+
+/**
+ * @brief HTTP status code returned for partial content.
+ */
+#define HTTP_STATUS_CODE_PARTIAL_CONTENT          206
+
+/**
+ * @brief Length of the buffer of a worker, holding the request headers, then
+ * the response headers and body.
+ */
+#define WORKER_BUFFER_LENGTH                      ( HTTP_PARALLEL_DOWNLOAD_HEADER_BUFFER_LENGTH + HTTP_PARALLEL_DOWNLOAD_MAX_RANGE_LENGTH )
+
+/*-----------------------------------------------------------*/
+
+/* Each compilation unit must define the NetworkContext struct. */
+struct NetworkContext
+{
+    OpensslParams_t * pParams;
+};
+
+/**
+ * @brief A byte range of the file.
+ */
+typedef struct DownloadRange
+{
+    size_t offset;     /**< @brief Offset of the first byte of the range. */
+    size_t length;     /**< @brief Number of bytes of the range. */
+    uint32_t attempts; /**< @brief Number of failed requests of the range. */
+} DownloadRange_t;
+
+/**
+ * @brief A worker thread and its connection.
+ */
+typedef struct DownloadWorker
+{
+    NetworkContext_t networkContext;
+    OpensslParams_t opensslParams;
+    bool connected;                         /**< @brief The connection is established. */
+    size_t rangeLength;                     /**< @brief Length of the next range to request. */
+    DownloadRange_t heldRange;              /**< @brief Range to request again that did not fit in the queue. */
+    bool holdsRange;                        /**< @brief heldRange is set. */
+    pthread_t thread;                       /**< @brief The thread of the worker. */
+    uint8_t buffer[ WORKER_BUFFER_LENGTH ]; /**< @brief Buffer of the requests and responses. */
+} DownloadWorker_t;
+
+/**
+ * @brief The work queue and status of the download, shared by the workers.
+ */
+typedef struct DownloadState
+{
+    const HttpDownloadConfig_t * pConfig;                          /**< @brief The running download. */
+    size_t fileSize;                                               /**< @brief Size of the file; 0 until the first range is received. */
+    size_t nextOffset;                                             /**< @brief First byte that no range was cut for yet. */
+    DownloadRange_t pending[ HTTP_PARALLEL_DOWNLOAD_MAX_WORKERS ]; /**< @brief Ranges to request again. */
+    size_t pendingCount;                                           /**< @brief Number of ranges in pending. */
+    HttpDownloadStatus_t status;                                   /**< @brief First error of the download. */
+    size_t rangeRequests;                                          /**< @brief Number of range requests. */
+    size_t rangeRetries;                                           /**< @brief Number of failed range requests put back. */
+} DownloadState_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The workers of the download.
+ */
+static DownloadWorker_t workers[ HTTP_PARALLEL_DOWNLOAD_MAX_WORKERS ];
+
+/**
+ * @brief The state of the running download.
+ */
+static DownloadState_t download;
+
+/**
+ * @brief Protects #download while the workers run.
+ */
+static pthread_mutex_t downloadMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Record the first error of the download, which stops the workers.
+ *
+ * @param[in] status The error.
+ */
+static void failDownload( HttpDownloadStatus_t status );
+
+/**
+ * @brief Put a range back in the work queue.
+ *
+ * Splitting queued ranges between workers can leave more ranges to request
+ * again than the queue holds. A range that does not fit is held by the worker
+ * instead, which requests it next. A worker puts back at most one range
+ * before taking the next one, so it never needs to hold two.
+ *
+ * @param[in] pWorker The worker putting the range back.
+ * @param[in] pRange The range to request again.
+ *
+ * @return false if the range could not be kept, which fails the download.
+ */
+static bool putBackRange( DownloadWorker_t * pWorker,
+                          const DownloadRange_t * pRange );
+
+/**
+ * @brief Take the next range to request from the work queue.
+ *
+ * A range held by the worker is taken first, then ranges put back. Ranges
+ * longer than the range length of the worker are split, and the rest is left
+ * in the queue.
+ *
+ * @param[in] pWorker The worker taking the range.
+ * @param[out] pRange The range to request.
+ *
+ * @return true if a range was taken; false if the download is complete or
+ * failed.
+ */
+static bool takeRange( DownloadWorker_t * pWorker,
+                       DownloadRange_t * pRange );
+
+/**
+ * @brief Connect a worker to the server.
+ *
+ * @param[in] pNetworkContext The network context of the worker.
+ *
+ * @return EXIT_FAILURE on failure; EXIT_SUCCESS on successful connection.
+ */
+static int32_t connectWorker( NetworkContext_t * pNetworkContext );
+
+/**
+ * @brief Parse a decimal number.
+ *
+ * @param[in,out] ppCursor The first digit; set past the last digit on return.
+ * @param[in] pEnd The end of the string.
+ * @param[out] pValue The number.
+ *
+ * @return true if at least one digit was parsed without overflow.
+ */
+static bool parseDecimal( const char ** ppCursor,
+                          const char * pEnd,
+                          size_t * pValue );
+
+/**
+ * @brief Read the first byte of the range and the size of the file from the
+ * Content-Range header of a response, "bytes FIRST-LAST/SIZE".
+ *
+ * @param[in] pResponse The response to a range request.
+ * @param[out] pFirstByte The offset of the first byte of the response body.
+ * @param[out] pFileSize The size of the file.
+ *
+ * @return true if the header was parsed.
+ */
+static bool parseContentRange( const HTTPResponse_t * pResponse,
+                               size_t * pFirstByte,
+                               size_t * pFileSize );
+
+/**
+ * @brief Send a range request and check the response.
+ *
+ * @param[in] pWorker The worker sending the request on its connection.
+ * @param[in] pRange The range to request.
+ * @param[out] pResponse The response, stored in the buffer of the worker.
+ * @param[out] pFileSize The size of the file, from the response.
+ *
+ * @return true if the response holds the start of the range.
+ */
+static bool requestRange( DownloadWorker_t * pWorker,
+                          const DownloadRange_t * pRange,
+                          HTTPResponse_t * pResponse,
+                          size_t * pFileSize );
+
+/**
+ * @brief Write data at an offset of the output file.
+ *
+ * @param[in] pData The data to write.
+ * @param[in] length The length of the data.
+ * @param[in] offset The offset in the file.
+ *
+ * @return true if all of the data was written.
+ */
+static bool writeRange( const uint8_t * pData,
+                        size_t length,
+                        size_t offset );
+
+/**
+ * @brief Adapt the range length of a worker to the duration of its last
+ * range request.
+ *
+ * @param[in] pWorker The worker.
+ * @param[in] elapsedUs The duration of the last range request.
+ */
+static void adaptRangeLength( DownloadWorker_t * pWorker,
+                              uint64_t elapsedUs );
+
+/**
+ * @brief Download a range and write it to the output file.
+ *
+ * A range that the server sent only the start of is put back with the rest,
+ * and a failed range is put back until it reaches
+ * #HTTP_PARALLEL_DOWNLOAD_MAX_RANGE_ATTEMPTS attempts.
+ *
+ * @param[in] pWorker The worker downloading the range.
+ * @param[in] pRange The range.
+ */
+static void downloadRange( DownloadWorker_t * pWorker,
+                           const DownloadRange_t * pRange );
+
+/**
+ * @brief Download a range, connecting the worker first if needed.
+ *
+ * @param[in] pWorker The worker.
+ * @param[in] pRange The range.
+ */
+static void runRange( DownloadWorker_t * pWorker,
+                      const DownloadRange_t * pRange );
+
+/**
+ * @brief Download ranges until the work queue is empty or the download fails.
+ *
+ * @param[in] pWorker The worker.
+ */
+static void runWorker( DownloadWorker_t * pWorker );
+
+/**
+ * @brief Entry point of a worker thread.
+ *
+ * @param[in] pArgument The worker.
+ *
+ * @return NULL.
+ */
+static void * workerThread( void * pArgument );
+
+/*-----------------------------------------------------------*/
+
+static void failDownload( HttpDownloadStatus_t status )
+{
+    ( void ) pthread_mutex_lock( &downloadMutex );
+
+    if( download.status == HTTP_DOWNLOAD_SUCCESS )
+    {
+        download.status = status;
+    }
+
+    ( void ) pthread_mutex_unlock( &downloadMutex );
+}
+
+/*-----------------------------------------------------------*/
+
+static bool putBackRange( DownloadWorker_t * pWorker,
+                          const DownloadRange_t * pRange )
+{
+    bool kept = true;
+
+    ( void ) pthread_mutex_lock( &downloadMutex );
+
+    if( download.pendingCount < HTTP_PARALLEL_DOWNLOAD_MAX_WORKERS )
+    {
+        download.pending[ download.pendingCount ] = *pRange;
+        download.pendingCount++;
+    }
+    else if( pWorker->holdsRange == false )
+    {
+        /* The queue is full: the worker requests the range again itself. */
+        pWorker->heldRange = *pRange;
+        pWorker->holdsRange = true;
+    }
+    else
+    {
+        kept = false;
+    }
+
+    if( ( kept == true ) && ( pRange->attempts > 0U ) )
+    {
+        download.rangeRetries++;
+    }
+
+    ( void ) pthread_mutex_unlock( &downloadMutex );
+
+    if( kept == false )
+    {
+        LogError( ( "No space to put back the %lu bytes at offset %lu.",
+                    ( unsigned long ) pRange->length,
+                    ( unsigned long ) pRange->offset ) );
+        failDownload( HTTP_DOWNLOAD_REQUEST_FAILURE );
+    }
+
+    return kept;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool takeRange( DownloadWorker_t * pWorker,
+                       DownloadRange_t * pRange )
+{
+    bool taken = false;
+    DownloadRange_t * pPending = NULL;
+
+    ( void ) pthread_mutex_lock( &downloadMutex );
+
+    if( download.status != HTTP_DOWNLOAD_SUCCESS )
+    {
+        /* Another worker failed the download. */
+    }
+    else if( pWorker->holdsRange == true )
+    {
+        *pRange = pWorker->heldRange;
+        pWorker->holdsRange = false;
+        taken = true;
+    }
+    else if( download.pendingCount > 0U )
+    {
+        pPending = &download.pending[ download.pendingCount - 1U ];
+        *pRange = *pPending;
+
+        if( pRange->length > pWorker->rangeLength )
+        {
+            /* Leave the rest of the range in the queue. */
+            pRange->length = pWorker->rangeLength;
+            pPending->offset += pWorker->rangeLength;
+            pPending->length -= pWorker->rangeLength;
+        }
+        else
+        {
+            download.pendingCount--;
+        }
+
+        taken = true;
+    }
+    else if( download.nextOffset < download.fileSize )
+    {
+        pRange->offset = download.nextOffset;
+        pRange->length = download.fileSize - download.nextOffset;
+        pRange->attempts = 0U;
+
+        if( pRange->length > pWorker->rangeLength )
+        {
+            pRange->length = pWorker->rangeLength;
+        }
+
+        download.nextOffset += pRange->length;
+        taken = true;
+    }
+    else
+    {
+        /* Every range was taken. */
+    }
+
+    if( taken == true )
+    {
+        download.rangeRequests++;
+    }
+
+    ( void ) pthread_mutex_unlock( &downloadMutex );
+
+    return taken;
+}
+
+/*-----------------------------------------------------------*/
+
+static int32_t connectWorker( NetworkContext_t * pNetworkContext )
+{
+    OpensslStatus_t opensslStatus = OPENSSL_SUCCESS;
+    ServerInfo_t serverInfo = { 0 };
+    const HttpDownloadConfig_t * pConfig = download.pConfig;
+
+    serverInfo.pHostName = pConfig->pHost;
+    serverInfo.hostNameLength = pConfig->hostLength;
+    serverInfo.port = pConfig->port;
+
+    LogDebug( ( "Establishing a TLS session with %s:%u.",
+                pConfig->pHost,
+                ( unsigned int ) pConfig->port ) );
+
+    opensslStatus = Openssl_Connect( pNetworkContext,
+                                     &serverInfo,
+                                     pConfig->pCredentials,
+                                     pConfig->sendRecvTimeoutMs,
+                                     pConfig->sendRecvTimeoutMs );
+
+    return ( opensslStatus == OPENSSL_SUCCESS ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool parseDecimal( const char ** ppCursor,
+                          const char * pEnd,
+                          size_t * pValue )
+{
+    const char * pCursor = *ppCursor;
+    size_t value = 0U;
+    bool valid = true;
+
+    while( ( valid == true ) && ( pCursor < pEnd ) && ( *pCursor >= '0' ) && ( *pCursor <= '9' ) )
+    {
+        if( value > ( ( SIZE_MAX - 9U ) / 10U ) )
+        {
+            valid = false;
+        }
+        else
+        {
+            value = ( value * 10U ) + ( size_t ) ( *pCursor - '0' );
+            pCursor++;
+        }
+    }
+
+    if( pCursor == *ppCursor )
+    {
+        valid = false;
+    }
+
+    *ppCursor = pCursor;
+    *pValue = value;
+
+    return valid;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool parseContentRange( const HTTPResponse_t * pResponse,
+                               size_t * pFirstByte,
+                               size_t * pFileSize )
+{
+    HTTPStatus_t httpStatus = HTTPSuccess;
+    const char * pValue = NULL;
+    size_t valueLength = 0U;
+    const char * pCursor = NULL;
+    const char * pEnd = NULL;
+    size_t lastByte = 0U;
+    bool parsed = false;
+
+    httpStatus = HTTPClient_ReadHeader( pResponse,
+                                        HTTP_CONTENT_RANGE_HEADER_FIELD,
+                                        HTTP_CONTENT_RANGE_HEADER_FIELD_LENGTH,
+                                        &pValue,
+                                        &valueLength );
+
+    if( httpStatus != HTTPSuccess )
+    {
+        LogError( ( "Failed to read Content-Range header from HTTP response: Error=%s.",
+                    HTTPClient_strerror( httpStatus ) ) );
+    }
+    else if( ( valueLength > HTTP_CONTENT_RANGE_UNIT_LENGTH ) &&
+             ( strncmp( pValue, HTTP_CONTENT_RANGE_UNIT, HTTP_CONTENT_RANGE_UNIT_LENGTH ) == 0 ) )
+    {
+        /* The value is not null-terminated: parse it within its length. */
+        pCursor = &pValue[ HTTP_CONTENT_RANGE_UNIT_LENGTH ];
+        pEnd = &pValue[ valueLength ];
+
+        parsed = ( parseDecimal( &pCursor, pEnd, pFirstByte ) == true ) &&
+                 ( pCursor < pEnd ) && ( *pCursor == '-' );
+
+        if( parsed == true )
+        {
+            pCursor++;
+            parsed = ( parseDecimal( &pCursor, pEnd, &lastByte ) == true ) &&
+                     ( pCursor < pEnd ) && ( *pCursor == '/' );
+        }
+
+        if( parsed == true )
+        {
+            pCursor++;
+            parsed = ( parseDecimal( &pCursor, pEnd, pFileSize ) == true ) &&
+                     ( lastByte < *pFileSize );
+        }
+    }
+    else
+    {
+        /* The value does not start with the unit. */
+    }
+
+    if( ( httpStatus == HTTPSuccess ) && ( parsed == false ) )
+    {
+        LogError( ( "Invalid Content-Range header value: %.*s.",
+                    ( int ) valueLength,
+                    pValue ) );
+    }
+
+    return parsed;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool requestRange( DownloadWorker_t * pWorker,
+                          const DownloadRange_t * pRange,
+                          HTTPResponse_t * pResponse,
+                          size_t * pFileSize )
+{
+    HTTPStatus_t httpStatus = HTTPSuccess;
+    HTTPRequestHeaders_t requestHeaders;
+    HTTPRequestInfo_t requestInfo;
+    TransportInterface_t transportInterface;
+    const HttpDownloadConfig_t * pConfig = download.pConfig;
+    size_t firstByte = 0U;
+    bool returnStatus = false;
+
+    /* Initialize all HTTP Client library API structs to 0. */
+    ( void ) memset( &requestHeaders, 0, sizeof( requestHeaders ) );
+    ( void ) memset( &requestInfo, 0, sizeof( requestInfo ) );
+    ( void ) memset( pResponse, 0, sizeof( HTTPResponse_t ) );
+    ( void ) memset( &transportInterface, 0, sizeof( transportInterface ) );
+
+    transportInterface.recv = Openssl_Recv;
+    transportInterface.send = Openssl_Send;
+    transportInterface.pNetworkContext = &pWorker->networkContext;
+
+    /* Initialize the request object. */
+    requestInfo.pHost = pConfig->pHost;
+    requestInfo.hostLen = pConfig->hostLength;
+    requestInfo.pMethod = HTTP_METHOD_GET;
+    requestInfo.methodLen = HTTP_METHOD_GET_LENGTH;
+    requestInfo.pPath = pConfig->pPath;
+    requestInfo.pathLen = pConfig->pathLength;
+
+    /* Keep the connection of the worker open for its next range. */
+    requestInfo.reqFlags = HTTP_REQUEST_KEEP_ALIVE_FLAG;
+
+    /* The request headers and the response share the buffer of the worker. */
+    requestHeaders.pBuffer = pWorker->buffer;
+    requestHeaders.bufferLen = WORKER_BUFFER_LENGTH;
+    pResponse->pBuffer = pWorker->buffer;
+    pResponse->bufferLen = WORKER_BUFFER_LENGTH;
+
+    httpStatus = HTTPClient_InitializeRequestHeaders( &requestHeaders,
+                                                      &requestInfo );
+
+    if( httpStatus == HTTPSuccess )
+    {
+        httpStatus = HTTPClient_AddRangeHeader( &requestHeaders,
+                                                ( int32_t ) pRange->offset,
+                                                ( int32_t ) ( pRange->offset + pRange->length - 1U ) );
+    }
+
+    if( httpStatus == HTTPSuccess )
+    {
+        LogDebug( ( "Downloading bytes %lu-%lu from %s...",
+                    ( unsigned long ) pRange->offset,
+                    ( unsigned long ) ( pRange->offset + pRange->length - 1U ),
+                    pConfig->pHost ) );
+
+        httpStatus = HTTPClient_Send( &transportInterface,
+                                      &requestHeaders,
+                                      NULL,
+                                      0,
+                                      pResponse,
+                                      0 );
+    }
+
+    if( httpStatus != HTTPSuccess )
+    {
+        LogError( ( "Failed to send HTTP GET request to %s: Error=%s.",
+                    pConfig->pHost,
+                    HTTPClient_strerror( httpStatus ) ) );
+    }
+    else if( pResponse->statusCode != HTTP_STATUS_CODE_PARTIAL_CONTENT )
+    {
+        LogError( ( "Received an invalid response from the server "
+                    "(Status Code: %u).",
+                    pResponse->statusCode ) );
+    }
+    else if( parseContentRange( pResponse, &firstByte, pFileSize ) == false )
+    {
+        /* Error logged by parseContentRange. */
+    }
+    else if( ( firstByte != pRange->offset ) || ( pResponse->bodyLen == 0U ) ||
+             ( pResponse->bodyLen > pRange->length ) )
+    {
+        LogError( ( "Server sent %lu bytes at offset %lu for the %lu bytes at offset %lu.",
+                    ( unsigned long ) pResponse->bodyLen,
+                    ( unsigned long ) firstByte,
+                    ( unsigned long ) pRange->length,
+                    ( unsigned long ) pRange->offset ) );
+    }
+    else
+    {
+        returnStatus = true;
+    }
+
+    return returnStatus;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool writeRange( const uint8_t * pData,
+                        size_t length,
+                        size_t offset )
+{
+    ssize_t bytesWritten = 0;
+    size_t bytesRemaining = length;
+
+    /* Each range is written at its own offset, so the file is in order
+     * whatever the order ranges complete in. */
+    while( bytesRemaining > 0U )
+    {
+        bytesWritten = pwrite( download.pConfig->fileDescriptor,
+                               &pData[ length - bytesRemaining ],
+                               bytesRemaining,
+                               ( off_t ) ( offset + length - bytesRemaining ) );
+
+        if( bytesWritten > 0 )
+        {
+            bytesRemaining -= ( size_t ) bytesWritten;
+        }
+        else if( ( bytesWritten < 0 ) && ( errno == EINTR ) )
+        {
+            /* Interrupted before writing anything: try again. */
+        }
+        else
+        {
+            LogError( ( "Failed to write %lu bytes at offset %lu of the file: errno=%d.",
+                        ( unsigned long ) bytesRemaining,
+                        ( unsigned long ) ( offset + length - bytesRemaining ),
+                        errno ) );
+            break;
+        }
+    }
+
+    return( bytesRemaining == 0U );
+}
+
+/*-----------------------------------------------------------*/
+
+static void adaptRangeLength( DownloadWorker_t * pWorker,
+                              uint64_t elapsedUs )
+{
+    uint64_t targetUs = ( uint64_t ) HTTP_PARALLEL_DOWNLOAD_TARGET_RANGE_MS * 1000U;
+
+    if( ( elapsedUs < ( targetUs / 2U ) ) &&
+        ( pWorker->rangeLength < HTTP_PARALLEL_DOWNLOAD_MAX_RANGE_LENGTH ) )
+    {
+        pWorker->rangeLength *= 2U;
+
+        if( pWorker->rangeLength > HTTP_PARALLEL_DOWNLOAD_MAX_RANGE_LENGTH )
+        {
+            pWorker->rangeLength = HTTP_PARALLEL_DOWNLOAD_MAX_RANGE_LENGTH;
+        }
+    }
+    else if( ( elapsedUs > ( targetUs * 2U ) ) &&
+             ( pWorker->rangeLength > HTTP_PARALLEL_DOWNLOAD_MIN_RANGE_LENGTH ) )
+    {
+        pWorker->rangeLength /= 2U;
+
+        if( pWorker->rangeLength < HTTP_PARALLEL_DOWNLOAD_MIN_RANGE_LENGTH )
+        {
+            pWorker->rangeLength = HTTP_PARALLEL_DOWNLOAD_MIN_RANGE_LENGTH;
+        }
+    }
+    else
+    {
+        /* The range length suits the connection. */
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void downloadRange( DownloadWorker_t * pWorker,
+                           const DownloadRange_t * pRange )
+{
+    HTTPResponse_t response;
+    DownloadRange_t rest;
+    size_t fileSize = 0U;
+    size_t rangeEnd = 0U;
+    uint64_t startUs = Clock_GetTimeUs64();
+    bool success = false;
+
+    success = requestRange( pWorker, pRange, &response, &fileSize );
+
+    if( success == true )
+    {
+        ( void ) pthread_mutex_lock( &downloadMutex );
+
+        if( download.fileSize == 0U )
+        {
+            /* The first range tells the size of the file. */
+            download.fileSize = fileSize;
+        }
+
+        success = ( download.fileSize == fileSize );
+        ( void ) pthread_mutex_unlock( &downloadMutex );
+
+        if( success == false )
+        {
+            LogError( ( "The file changed size during the download." ) );
+        }
+    }
+
+    if( success == true )
+    {
+        if( writeRange( response.pBody, response.bodyLen, pRange->offset ) == false )
+        {
+            failDownload( HTTP_DOWNLOAD_WRITE_FAILURE );
+        }
+        else
+        {
+            /* The first range may be requested past the end of the file. */
+            rangeEnd = pRange->offset + pRange->length;
+
+            if( rangeEnd > fileSize )
+            {
+                rangeEnd = fileSize;
+            }
+
+            if( ( pRange->offset + response.bodyLen ) < rangeEnd )
+            {
+                rest.offset = pRange->offset + response.bodyLen;
+                rest.length = rangeEnd - rest.offset;
+                rest.attempts = 0U;
+                ( void ) putBackRange( pWorker, &rest );
+            }
+
+            adaptRangeLength( pWorker, Clock_GetTimeUs64() - startUs );
+        }
+
+        if( ( response.respFlags & HTTP_RESPONSE_CONNECTION_CLOSE_FLAG ) != 0U )
+        {
+            /* The next range of the worker will need a new connection. */
+            ( void ) Openssl_Disconnect( &pWorker->networkContext );
+            pWorker->connected = false;
+        }
+    }
+    else
+    {
+        /* The connection may be in an unknown state: drop it, and restart
+         * with short ranges on the new one. */
+        ( void ) Openssl_Disconnect( &pWorker->networkContext );
+        pWorker->connected = false;
+        pWorker->rangeLength = HTTP_PARALLEL_DOWNLOAD_MIN_RANGE_LENGTH;
+
+        rest = *pRange;
+        rest.attempts++;
+
+        if( rest.attempts < HTTP_PARALLEL_DOWNLOAD_MAX_RANGE_ATTEMPTS )
+        {
+            LogWarn( ( "Failed to download the %lu bytes at offset %lu. Retrying...",
+                       ( unsigned long ) rest.length,
+                       ( unsigned long ) rest.offset ) );
+            ( void ) putBackRange( pWorker, &rest );
+        }
+        else
+        {
+            LogError( ( "Failed to download the %lu bytes at offset %lu in %u attempts.",
+                        ( unsigned long ) rest.length,
+                        ( unsigned long ) rest.offset,
+                        ( unsigned int ) rest.attempts ) );
+            failDownload( HTTP_DOWNLOAD_REQUEST_FAILURE );
+        }
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void runRange( DownloadWorker_t * pWorker,
+                      const DownloadRange_t * pRange )
+{
+    if( pWorker->connected == false )
+    {
+        pWorker->connected = ( connectToServerWithBackoffRetries( connectWorker,
+                                                                  &pWorker->networkContext ) == EXIT_SUCCESS );
+    }
+
+    if( pWorker->connected == true )
+    {
+        downloadRange( pWorker, pRange );
+    }
+    else
+    {
+        LogError( ( "Failed to connect to HTTP server %s.",
+                    download.pConfig->pHost ) );
+        failDownload( HTTP_DOWNLOAD_CONNECT_FAILURE );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void runWorker( DownloadWorker_t * pWorker )
+{
+    DownloadRange_t range;
+
+    while( takeRange( pWorker, &range ) == true )
+    {
+        runRange( pWorker, &range );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+static void * workerThread( void * pArgument )
+{
+    runWorker( ( DownloadWorker_t * ) pArgument );
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+HttpDownloadStatus_t HttpDownload_Run( const HttpDownloadConfig_t * pConfig,
+                                       HttpDownloadResult_t * pResult )
+{
+    HttpDownloadStatus_t returnStatus = HTTP_DOWNLOAD_SUCCESS;
+    DownloadRange_t range;
+    uint64_t startUs = Clock_GetTimeUs64();
+    size_t threadCount = 0U;
+    size_t i;
+
+    if( ( pConfig == NULL ) || ( pConfig->pHost == NULL ) || ( pConfig->hostLength == 0U ) ||
+        ( pConfig->pPath == NULL ) || ( pConfig->pathLength == 0U ) ||
+        ( pConfig->pCredentials == NULL ) || ( pConfig->fileDescriptor < 0 ) ||
+        ( pConfig->workerCount == 0U ) ||
+        ( pConfig->workerCount > HTTP_PARALLEL_DOWNLOAD_MAX_WORKERS ) )
+    {
+        LogError( ( "Invalid parameter passed to HttpDownload_Run()." ) );
+        returnStatus = HTTP_DOWNLOAD_INVALID_PARAMETER;
+    }
+    else
+    {
+        download.pConfig = pConfig;
+        download.nextOffset = HTTP_PARALLEL_DOWNLOAD_MIN_RANGE_LENGTH;
+        download.rangeRequests = 0U;
+        download.rangeRetries = 0U;
+        download.status = HTTP_DOWNLOAD_SUCCESS;
+
+        /* The size of the file is not known yet: queue a first range, which
+         * the calling thread requests to learn it. */
+        download.fileSize = 0U;
+        download.pending[ 0 ].offset = 0U;
+        download.pending[ 0 ].length = HTTP_PARALLEL_DOWNLOAD_MIN_RANGE_LENGTH;
+        download.pending[ 0 ].attempts = 0U;
+        download.pendingCount = 1U;
+
+        for( i = 0U; i < pConfig->workerCount; i++ )
+        {
+            workers[ i ].networkContext.pParams = &workers[ i ].opensslParams;
+            workers[ i ].connected = false;
+            workers[ i ].rangeLength = HTTP_PARALLEL_DOWNLOAD_MIN_RANGE_LENGTH;
+            workers[ i ].holdsRange = false;
+        }
+
+        /* Only the calling thread runs until the size is known, so the size
+         * can be read without the lock. */
+        while( ( download.fileSize == 0U ) && ( takeRange( &workers[ 0 ], &range ) == true ) )
+        {
+            runRange( &workers[ 0 ], &range );
+        }
+
+        returnStatus = download.status;
+    }
+
+    if( ( returnStatus == HTTP_DOWNLOAD_SUCCESS ) && ( download.fileSize > ( size_t ) INT32_MAX ) )
+    {
+        /* The offsets of the Range header are 32-bit signed integers. */
+        LogError( ( "The file is %lu bytes; ranges can only address the first %ld.",
+                    ( unsigned long ) download.fileSize,
+                    ( long ) INT32_MAX ) );
+        returnStatus = HTTP_DOWNLOAD_FILE_TOO_LARGE;
+    }
+
+    if( returnStatus == HTTP_DOWNLOAD_SUCCESS )
+    {
+        LogInfo( ( "Downloading %lu bytes with %lu connections.",
+                   ( unsigned long ) download.fileSize,
+                   ( unsigned long ) pConfig->workerCount ) );
+
+        /* Drop anything past the end of the file from a previous content. */
+        if( ftruncate( pConfig->fileDescriptor, ( off_t ) download.fileSize ) != 0 )
+        {
+            LogError( ( "Failed to set the size of the file: errno=%d.", errno ) );
+            returnStatus = HTTP_DOWNLOAD_WRITE_FAILURE;
+        }
+    }
+
+    if( returnStatus == HTTP_DOWNLOAD_SUCCESS )
+    {
+        for( threadCount = 0U; threadCount < pConfig->workerCount; threadCount++ )
+        {
+            if( pthread_create( &workers[ threadCount ].thread,
+                                NULL,
+                                workerThread,
+                                &workers[ threadCount ] ) != 0 )
+            {
+                LogError( ( "Failed to create worker thread %lu.",
+                            ( unsigned long ) threadCount ) );
+                failDownload( HTTP_DOWNLOAD_THREAD_FAILURE );
+                break;
+            }
+        }
+
+        for( i = 0U; i < threadCount; i++ )
+        {
+            ( void ) pthread_join( workers[ i ].thread, NULL );
+        }
+
+        returnStatus = download.status;
+    }
+
+    if( returnStatus != HTTP_DOWNLOAD_INVALID_PARAMETER )
+    {
+        for( i = 0U; i < pConfig->workerCount; i++ )
+        {
+            if( workers[ i ].connected == true )
+            {
+                /* End the TLS session, then close the TCP connection. */
+                ( void ) Openssl_Disconnect( &workers[ i ].networkContext );
+                workers[ i ].connected = false;
+            }
+        }
+
+        if( pResult != NULL )
+        {
+            pResult->fileSize = download.fileSize;
+            pResult->rangeRequests = download.rangeRequests;
+            pResult->rangeRetries = download.rangeRetries;
+            pResult->elapsedUs = Clock_GetTimeUs64() - startUs;
+        }
+
+        download.pConfig = NULL;
+    }
+
+    return returnStatus;
+}
+
+/*-----------------------------------------------------------*/
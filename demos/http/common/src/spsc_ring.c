@@ -0,0 +1,204 @@
+/*
+ * AWS IoT Device SDK for Embedded C 202103.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Standard includes. */
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+
+/* POSIX includes. */
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* Ring header. */
+#include "spsc_ring.h"
+
+/* Include clock header for the timeout of the consumer. */
+#include "clock.h"
+
+#if ( SPSC_RING_CAPACITY & ( SPSC_RING_CAPACITY - 1U ) ) != 0U
+    #error "SPSC_RING_CAPACITY must be a power of two."
+#endif
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Sleep until the value of a futex word changes from a value.
+ *
+ * @param[in] pWord The futex word.
+ * @param[in] value The value the word had when the caller decided to sleep.
+ * @param[in] timeoutMs Longest time to sleep, or #SPSC_RING_WAIT_FOREVER.
+ */
+static void futexWait( uint32_t * pWord,
+                       uint32_t value,
+                       uint32_t timeoutMs );
+
+/**
+ * @brief Wake the process sleeping on a futex word.
+ *
+ * @param[in] pWord The futex word.
+ */
+static void futexWake( uint32_t * pWord );
+
+/*-----------------------------------------------------------*/
+
+static void futexWait( uint32_t * pWord,
+                       uint32_t value,
+                       uint32_t timeoutMs )
+{
+    struct timespec timeout;
+    struct timespec * pTimeout = NULL;
+
+    if( timeoutMs != SPSC_RING_WAIT_FOREVER )
+    {
+        timeout.tv_sec = ( time_t ) ( timeoutMs / 1000U );
+        timeout.tv_nsec = ( long ) ( timeoutMs % 1000U ) * 1000000L;
+        pTimeout = &timeout;
+    }
+
+    /* The word is in memory shared between processes, so the futex must not
+     * be private. A wake up, a change of the word before sleeping, a signal or
+     * the timeout all return; the caller checks the ring again. */
+    ( void ) syscall( SYS_futex, pWord, FUTEX_WAIT, value, pTimeout, NULL, 0 );
+}
+
+/*-----------------------------------------------------------*/
+
+static void futexWake( uint32_t * pWord )
+{
+    ( void ) syscall( SYS_futex, pWord, FUTEX_WAKE, 1, NULL, NULL, 0 );
+}
+
+/*-----------------------------------------------------------*/
+
+void SpscRing_Init( SpscRing_t * pRing )
+{
+    assert( pRing != NULL );
+
+    ( void ) memset( pRing, 0, sizeof( SpscRing_t ) );
+}
+
+/*-----------------------------------------------------------*/
+
+bool SpscRing_Push( SpscRing_t * pRing,
+                    uint32_t descriptor )
+{
+    uint32_t head = 0U;
+    uint32_t tail = 0U;
+    bool pushed = false;
+
+    assert( pRing != NULL );
+
+    /* Only the producer writes head. The acquire load of tail orders the
+     * write of the entry after the consumer finished reading it. */
+    head = __atomic_load_n( &pRing->head, __ATOMIC_RELAXED );
+    tail = __atomic_load_n( &pRing->tail, __ATOMIC_ACQUIRE );
+
+    if( ( head - tail ) < SPSC_RING_CAPACITY )
+    {
+        pRing->entries[ head & ( SPSC_RING_CAPACITY - 1U ) ] = descriptor;
+
+        /* Publish the entry. */
+        __atomic_store_n( &pRing->head, head + 1U, __ATOMIC_RELEASE );
+
+        /* Either the consumer sees the new head before sleeping, or this sees
+         * that the consumer may be asleep and wakes it. */
+        __atomic_thread_fence( __ATOMIC_SEQ_CST );
+
+        if( __atomic_load_n( &pRing->consumerWaiting, __ATOMIC_RELAXED ) != 0U )
+        {
+            futexWake( &pRing->head );
+        }
+
+        pushed = true;
+    }
+
+    return pushed;
+}
+
+/*-----------------------------------------------------------*/
+
+bool SpscRing_Pop( SpscRing_t * pRing,
+                   uint32_t * pDescriptor,
+                   uint32_t timeoutMs )
+{
+    uint32_t head = 0U;
+    uint32_t tail = 0U;
+    uint32_t startMs = 0U;
+    uint32_t elapsedMs = 0U;
+    bool popped = false;
+    bool timedOut = false;
+
+    assert( pRing != NULL );
+    assert( pDescriptor != NULL );
+
+    /* Only the consumer writes tail. */
+    tail = __atomic_load_n( &pRing->tail, __ATOMIC_RELAXED );
+    head = __atomic_load_n( &pRing->head, __ATOMIC_ACQUIRE );
+
+    if( ( head == tail ) && ( timeoutMs != 0U ) )
+    {
+        startMs = Clock_GetTimeMs();
+    }
+
+    while( ( head == tail ) && ( timedOut == false ) )
+    {
+        if( timeoutMs != SPSC_RING_WAIT_FOREVER )
+        {
+            elapsedMs = Clock_GetTimeMs() - startMs;
+            timedOut = ( elapsedMs >= timeoutMs );
+        }
+
+        if( timedOut == false )
+        {
+            /* Announce the sleep, then check the ring again: a push between
+             * the two either is seen here or sees the announcement. */
+            __atomic_store_n( &pRing->consumerWaiting, 1U, __ATOMIC_SEQ_CST );
+            head = __atomic_load_n( &pRing->head, __ATOMIC_SEQ_CST );
+
+            if( head == tail )
+            {
+                futexWait( &pRing->head,
+                           head,
+                           ( timeoutMs == SPSC_RING_WAIT_FOREVER ) ?
+                           SPSC_RING_WAIT_FOREVER : ( timeoutMs - elapsedMs ) );
+            }
+
+            __atomic_store_n( &pRing->consumerWaiting, 0U, __ATOMIC_RELAXED );
+            head = __atomic_load_n( &pRing->head, __ATOMIC_ACQUIRE );
+        }
+    }
+
+    if( head != tail )
+    {
+        *pDescriptor = pRing->entries[ tail & ( SPSC_RING_CAPACITY - 1U ) ];
+
+        /* Hand the entry back to the producer. */
+        __atomic_store_n( &pRing->tail, tail + 1U, __ATOMIC_RELEASE );
+        popped = true;
+    }
+
+    return popped;
+}
+
+/*-----------------------------------------------------------*/
@@ -35,6 +35,9 @@
 /* Common HTTP demo utilities. */
 #include "http_demo_utils.h"
 
+/* Pool of the connections to the server. */
+#include "http_connection_pool.h"
+
 /* HTTP API header. */
 #include "core_http_client.h"
 
@@ -161,37 +164,33 @@ static const char * pPath;
 
 /*-----------------------------------------------------------*/
 
-/* Each compilation unit must define the NetworkContext struct. */
-struct NetworkContext
-{
-    OpensslParams_t * pParams;
-};
-
-/*-----------------------------------------------------------*/
-
 /**
- * @brief Connect to HTTP server with reconnection retries.
+ * @brief Check out a connection to the HTTP server from the connection pool.
  *
- * @param[out] pNetworkContext The output parameter to return the created
- * network context.
+ * An idle connection to the server is reused, skipping the TLS handshake.
+ * Otherwise, a new connection is established with reconnection retries.
  *
- * @return EXIT_FAILURE on failure; EXIT_SUCCESS on successful connection.
+ * @return The network context of the connection, or NULL on failure.
  */
-static int32_t connectToServer( NetworkContext_t * pNetworkContext );
+static NetworkContext_t * checkoutConnection( void );
 
 /**
  * @brief Send multiple HTTP GET requests, based on a specified path, to
  * download a file in chunks from the host S3 server.
  *
- * @param[in] pTransportInterface The transport interface for making network
- * calls.
+ * If the server closes the connection before the file is downloaded, the
+ * connection is replaced by another one from the connection pool.
+ *
+ * @param[in,out] pTransportInterface The transport interface for making network
+ * calls. Its network context is updated when the connection is replaced, and
+ * is NULL if no connection could be checked out.
  * @param[in] pPath The Request-URI to the objects of interest. This string
  * should be null-terminated.
  *
  * @return The status of the file download using multiple GET requests to the
  * server: true on success, false on failure.
  */
-static bool downloadS3ObjectFile( const TransportInterface_t * pTransportInterface,
+static bool downloadS3ObjectFile( TransportInterface_t * pTransportInterface,
                                   const char * pPath );
 
 /**
@@ -205,6 +204,8 @@ static bool downloadS3ObjectFile( const TransportInterface_t * pTransportInterfa
  * @param[in] hostLen The length of the server host address.
  * @param[in] pPath The Request-URI to the objects of interest. This string
  * should be null-terminated.
+ * @param[out] pConnectionClosed Set to true if the server closes the
+ * connection after its response.
  *
  * @return The status of the file size acquisition using a GET request to the
  * server: true on success, false on failure.
@@ -213,33 +214,29 @@ static bool getS3ObjectFileSize( size_t * pFileSize,
                                  const TransportInterface_t * pTransportInterface,
                                  const char * pHost,
                                  size_t hostLen,
-                                 const char * pPath );
+                                 const char * pPath,
+                                 bool * pConnectionClosed );
 
 /*-----------------------------------------------------------*/
 
-static int32_t connectToServer( NetworkContext_t * pNetworkContext )
+static NetworkContext_t * checkoutConnection( void )
 {
-    int32_t returnStatus = EXIT_FAILURE;
     HTTPStatus_t httpStatus = HTTPSuccess;
+    NetworkContext_t * pNetworkContext = NULL;
 
     /* The location of the host address within the pre-signed URL. */
     const char * pAddress = NULL;
 
-    /* Status returned by OpenSSL transport implementation. */
-    OpensslStatus_t opensslStatus;
     /* Credentials to establish the TLS connection. */
     OpensslCredentials_t opensslCredentials = { 0 };
-    /* Information about the server to send the HTTP requests. */
-    ServerInfo_t serverInfo = { 0 };
 
     /* Retrieve the address location and length from S3_PRESIGNED_GET_URL. */
     httpStatus = getUrlAddress( S3_PRESIGNED_GET_URL,
                                 S3_PRESIGNED_GET_URL_LENGTH,
                                 &pAddress,
                                 &serverHostLength );
-    returnStatus = ( httpStatus == HTTPSuccess ) ? EXIT_SUCCESS : EXIT_FAILURE;
 
-    if( returnStatus == EXIT_SUCCESS )
+    if( httpStatus == HTTPSuccess )
     {
         /* serverHost should consist only of the host address located in
          * S3_PRESIGNED_GET_URL. */
@@ -250,33 +247,22 @@ static int32_t connectToServer( NetworkContext_t * pNetworkContext )
         opensslCredentials.pRootCaPath = ROOT_CA_CERT_PATH;
         opensslCredentials.sniHostName = serverHost;
 
-        /* Initialize server information. */
-        serverInfo.pHostName = serverHost;
-        serverInfo.hostNameLength = serverHostLength;
-        serverInfo.port = HTTPS_PORT;
-
-        /* Establish a TLS session with the HTTP server. This example connects
-         * to the HTTP server as specified in S3_PRESIGNED_GET_URL and HTTPS_PORT in
-         * demo_config.h. */
-        LogInfo( ( "Establishing a TLS session with %s:%d.",
-                   serverHost,
-                   HTTPS_PORT ) );
-
-        opensslStatus = Openssl_Connect( pNetworkContext,
-                                         &serverInfo,
-                                         &opensslCredentials,
-                                         TRANSPORT_SEND_RECV_TIMEOUT_MS,
-                                         TRANSPORT_SEND_RECV_TIMEOUT_MS );
-
-        returnStatus = ( opensslStatus == OPENSSL_SUCCESS ) ? EXIT_SUCCESS : EXIT_FAILURE;
+        /* Reuse an idle TLS session with the HTTP server, or establish a new
+         * one. This example connects to the HTTP server as specified in
+         * S3_PRESIGNED_GET_URL and HTTPS_PORT in demo_config.h. */
+        pNetworkContext = HttpPool_Checkout( serverHost,
+                                             serverHostLength,
+                                             HTTPS_PORT,
+                                             &opensslCredentials,
+                                             TRANSPORT_SEND_RECV_TIMEOUT_MS );
     }
 
-    return returnStatus;
+    return pNetworkContext;
 }
 
 /*-----------------------------------------------------------*/
 
-static bool downloadS3ObjectFile( const TransportInterface_t * pTransportInterface,
+static bool downloadS3ObjectFile( TransportInterface_t * pTransportInterface,
                                   const char * pPath )
 {
     bool returnStatus = false;
@@ -290,6 +276,8 @@ static bool downloadS3ObjectFile( const TransportInterface_t * pTransportInterfa
     size_t numReqBytes = 0;
     /* curByte indicates which starting byte we want to download next. */
     size_t curByte = 0;
+    /* Whether the server closes the connection after its response. */
+    bool connectionClosed = false;
 
     assert( pPath != NULL );
 
@@ -325,7 +313,16 @@ static bool downloadS3ObjectFile( const TransportInterface_t * pTransportInterfa
                                         pTransportInterface,
                                         serverHost,
                                         serverHostLength,
-                                        pPath );
+                                        pPath,
+                                        &connectionClosed );
+
+    if( ( returnStatus == true ) && ( connectionClosed == true ) )
+    {
+        LogInfo( ( "Server closed the connection. Checking out another one." ) );
+        HttpPool_Checkin( pTransportInterface->pNetworkContext, false );
+        pTransportInterface->pNetworkContext = checkoutConnection();
+        returnStatus = ( pTransportInterface->pNetworkContext != NULL ) ? true : false;
+    }
 
     if( fileSize < RANGE_REQUEST_LENGTH )
     {
@@ -414,6 +411,20 @@ static bool downloadS3ObjectFile( const TransportInterface_t * pTransportInterfa
                         "(Status Code: %u).",
                         response.statusCode ) );
         }
+        else if( ( ( response.respFlags & HTTP_RESPONSE_CONNECTION_CLOSE_FLAG ) != 0U ) &&
+                 ( curByte < fileSize ) )
+        {
+            /* S3 closes a connection after a number of requests. Continue the
+             * download on another connection. */
+            LogInfo( ( "Server closed the connection. Checking out another one." ) );
+            HttpPool_Checkin( pTransportInterface->pNetworkContext, false );
+            pTransportInterface->pNetworkContext = checkoutConnection();
+            returnStatus = ( pTransportInterface->pNetworkContext != NULL ) ? true : false;
+        }
+        else
+        {
+            /* The connection is kept alive for the next request. */
+        }
     }
 
     return( ( returnStatus == true ) && ( httpStatus == HTTPSuccess ) );
@@ -425,7 +436,8 @@ static bool getS3ObjectFileSize( size_t * pFileSize,
                                  const TransportInterface_t * pTransportInterface,
                                  const char * pHost,
                                  size_t hostLen,
-                                 const char * pPath )
+                                 const char * pPath,
+                                 bool * pConnectionClosed )
 {
     bool returnStatus = true;
     HTTPStatus_t httpStatus = HTTPSuccess;
@@ -443,6 +455,9 @@ static bool getS3ObjectFileSize( size_t * pFileSize,
 
     assert( pHost != NULL );
     assert( pPath != NULL );
+    assert( pConnectionClosed != NULL );
+
+    *pConnectionClosed = false;
 
     /* Initialize all HTTP Client library API structs to 0. */
     ( void ) memset( &requestHeaders, 0, sizeof( requestHeaders ) );
@@ -515,6 +530,10 @@ static bool getS3ObjectFileSize( size_t * pFileSize,
                         pHost, pPath, HTTPClient_strerror( httpStatus ) ) );
             returnStatus = false;
         }
+        else
+        {
+            *pConnectionClosed = ( ( response.respFlags & HTTP_RESPONSE_CONNECTION_CLOSE_FLAG ) != 0U ) ? true : false;
+        }
     }
 
     if( returnStatus == true )
@@ -613,10 +632,8 @@ static bool getS3ObjectFileSize( size_t * pFileSize,
  *
  * @note If your file requires more than 99 range requests to S3 (depending on
  * the size of the file and the length specified in RANGE_REQUEST_LENGTH), your
- * connection may be dropped by S3. In this case, either increase the buffer
- * size and range request length (if feasible), to reduce the number of requests
- * required, or re-establish the connection with S3 after receiving a
- * "Connection: close" response header.
+ * connection may be dropped by S3. The demo then continues the download on a
+ * new connection after receiving a "Connection: close" response header.
  */
 int main( int argc,
           char ** argv )
@@ -639,15 +656,11 @@ int main( int argc,
     /* The transport layer interface used by the HTTP Client library. */
     TransportInterface_t transportInterface;
     /* The network context for the transport layer interface. */
-    NetworkContext_t networkContext;
-    OpensslParams_t opensslParams;
+    NetworkContext_t * pNetworkContext = NULL;
 
     ( void ) argc;
     ( void ) argv;
 
-    /* Set the pParams member of the network context with desired transport. */
-    networkContext.pParams = &opensslParams;
-
     LogInfo( ( "HTTP Client Synchronous S3 download demo using pre-signed URL:\n%s",
                S3_PRESIGNED_GET_URL ) );
 
@@ -655,16 +668,13 @@ int main( int argc,
     {
         /**************************** Connect. ******************************/
 
-        /* Establish TLS connection on top of TCP connection using OpenSSL. */
-
-        /* Attempt to connect to the HTTP server. If connection fails, retry
-         * after a timeout. The timeout value will be exponentially
-         * increased until either the maximum number of attempts or the
-         * maximum timeout value is reached. The function returns
-         * EXIT_FAILURE if the TCP connection cannot be established to the
-         * broker after the configured number of attempts. */
-        returnStatus = connectToServerWithBackoffRetries( connectToServer,
-                                                          &networkContext );
+        /* Check out a TLS connection on top of TCP connection using OpenSSL.
+         * A connection kept alive by a previous iteration is reused. If a new
+         * connection fails, it is retried after a timeout. The timeout value
+         * will be exponentially increased until either the maximum number of
+         * attempts or the maximum timeout value is reached. */
+        pNetworkContext = checkoutConnection();
+        returnStatus = ( pNetworkContext != NULL ) ? EXIT_SUCCESS : EXIT_FAILURE;
 
         if( returnStatus == EXIT_FAILURE )
         {
@@ -680,7 +690,7 @@ int main( int argc,
             ( void ) memset( &transportInterface, 0, sizeof( transportInterface ) );
             transportInterface.recv = Openssl_Recv;
             transportInterface.send = Openssl_Send;
-            transportInterface.pNetworkContext = &networkContext;
+            transportInterface.pNetworkContext = pNetworkContext;
         }
 
         /******************** Download S3 Object File. **********************/
@@ -702,13 +712,20 @@ int main( int argc,
         {
             ret = downloadS3ObjectFile( &transportInterface,
                                         pPath );
+            pNetworkContext = transportInterface.pNetworkContext;
             returnStatus = ( ret == true ) ? EXIT_SUCCESS : EXIT_FAILURE;
         }
 
-        /************************** Disconnect. *****************************/
+        /*************************** Check in. *****************************/
 
-        /* End the TLS session, then close the TCP connection. */
-        ( void ) Openssl_Disconnect( &networkContext );
+        /* Return the connection to the pool. It is kept alive for the next
+         * requests unless a request failed or the server closes it. */
+        if( pNetworkContext != NULL )
+        {
+            HttpPool_Checkin( pNetworkContext,
+                              ( returnStatus == EXIT_SUCCESS ) &&
+                              ( ( response.respFlags & HTTP_RESPONSE_CONNECTION_CLOSE_FLAG ) == 0U ) );
+        }
 
         /******************* Retry in case of failure. **********************/
 
@@ -733,6 +750,9 @@ int main( int argc,
         }
     } while( returnStatus != EXIT_SUCCESS );
 
+    /* End the TLS sessions, then close the TCP connections. */
+    HttpPool_CloseAll();
+
     if( returnStatus == EXIT_SUCCESS )
     {
         /* Log a message indicating an iteration completed successfully. */
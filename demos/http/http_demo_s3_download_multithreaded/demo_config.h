@@ -88,6 +88,10 @@
 
 /**
  * @brief The length in bytes of the user buffer.
+ *
+ * @note Each of the QUEUE_SIZE request slots shared by the main and HTTP
+ * threads has a buffer of this length. Only slot indices are passed between
+ * the threads, so the length is not limited by message queue sizes.
  */
 #define USER_BUFFER_LENGTH                ( 4096 )
 
@@ -101,7 +105,8 @@
 #define RANGE_REQUEST_LENGTH              ( 2048 )
 
 /**
- * @brief The number of items that can be held in each queue.
+ * @brief The number of range requests that can be in flight between the main
+ * and HTTP threads. Must not exceed SPSC_RING_CAPACITY.
  */
 #define QUEUE_SIZE                        10
 
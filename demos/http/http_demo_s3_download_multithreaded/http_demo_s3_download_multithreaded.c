@@ -29,9 +29,10 @@
 /* POSIX includes. */
 #include <unistd.h>
 #include <fcntl.h>
-#include <mqueue.h>
 #include <errno.h>
+#include <sys/mman.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <signal.h>
 
 /* Include Demo Config as the first non-system header. */
@@ -46,6 +47,9 @@
 /* OpenSSL transport header. */
 #include "openssl_posix.h"
 
+/* Shared-memory ring for passing ranges between the threads. */
+#include "spsc_ring.h"
+
 /*Include backoff algorithm header for retry logic.*/
 #include "backoff_algorithm.h"
 
@@ -84,21 +88,19 @@
     #error "Please define a QUEUE_SIZE."
 #endif
 
-/**
- * @brief The name of the HTTP thread's input queue. Must begin with a slash and
- * be a valid pathname.
- */
-#define REQUEST_QUEUE                             "/demo_request_queue"
+/* Check that every range in flight fits in the rings. */
+#if QUEUE_SIZE > SPSC_RING_CAPACITY
+    #error "QUEUE_SIZE must not exceed SPSC_RING_CAPACITY."
+#endif
 
 /**
- * @brief The name of the HTTP thread's output queue. Must begin with a slash
- * and be a valid pathname.
+ * @brief Time for the main thread to wait for a response from the HTTP thread
+ * before giving up.
+ *
+ * The HTTP thread answers every request, successful or not, so this is only
+ * reached if the HTTP thread died.
  */
-#define RESPONSE_QUEUE                            "/demo_response_queue"
-
-/* Posix file permissions for the queues. Allows read and write access to the
- * user this demo is running as. */
-#define QUEUE_PERMISSIONS                         0600
+#define RESPONSE_TIMEOUT_MS                       ( 4 * TRANSPORT_SEND_RECV_TIMEOUT_MS )
 
 /**
  * @brief Length of the S3 presigned URL.
@@ -152,48 +154,52 @@ static const char * pHost = NULL;
 static size_t hostLen = 0;
 
 /**
- * @brief Data type for request queue.
+ * @brief A range request and its response.
  *
- * In addition to sending #HTTPRequestHeaders_t, we need to send the buffer it uses.
- * The pointer to the buffer in #HTTPRequestHeaders_t will be incorrect after
- * it is received, so it will need to be fixed.
+ * The main thread writes the request headers in the buffer and passes the
+ * index of the slot to the HTTP thread, which sends the request and receives
+ * the response in the same buffer before passing the index back.
  */
-typedef struct RequestItem
+typedef struct RangeSlot
 {
     HTTPRequestHeaders_t requestHeaders;
-    uint8_t headersBuffer[ USER_BUFFER_LENGTH ];
-} RequestItem_t;
+    HTTPResponse_t response;
+    HTTPStatus_t sendStatus;
+    uint8_t buffer[ USER_BUFFER_LENGTH ];
+} RangeSlot_t;
 
 /**
- * @brief Data type for response queue.
+ * @brief Memory shared by the main and HTTP threads.
  *
- * In addition to sending the #HTTPResponse_t, we need to send the buffer it uses.
- * The pointer to the buffer in #HTTPResponse_t will be incorrect after
- * it is received, so it will need to be fixed.
+ * Only slot indices go through the rings; requests and responses stay in
+ * their slot. The memory is mapped before the HTTP thread is forked, so it is
+ * at the same address in both threads and the pointers in the slots remain
+ * valid in each.
  */
-typedef struct ResponseItem
+typedef struct SharedQueues
 {
-    HTTPResponse_t response;
-    uint8_t responseBuffer[ USER_BUFFER_LENGTH ];
-} ResponseItem_t;
+    SpscRing_t requestRing;          /**< @brief Slots to send, from the main thread to the HTTP thread. */
+    SpscRing_t responseRing;         /**< @brief Slots with a response, from the HTTP thread to the main thread. */
+    RangeSlot_t slots[ QUEUE_SIZE ]; /**< @brief The requests and responses. */
+} SharedQueues_t;
 
-/* @brief Struct used for sending requests to the HTTP thread.
- *
- * This is used by both the main and HTTP threads, though since we create the
- * HTTP thread without a shared memory space, each will have its own copy. We
- * have this as a global so that it will be located at the same address in the
- * main and HTTP threads so that way pointers remain valid when copied over.
+/**
+ * @brief The memory shared by the main and HTTP threads.
  */
-static RequestItem_t requestItem = { 0 };
+static SharedQueues_t * pSharedQueues = NULL;
 
-/* @brief Struct used for receiving responses from the HTTP thread.
+/**
+ * @brief The slot of the next request of the main thread.
  *
- * This is used by both the main and HTTP threads, though since we create the
- * HTTP thread without a shared memory space, each will have its own copy. We
- * have this as a global so that it will be located at the same address in the
- * main and HTTP threads so that way pointers remain valid when copied over.
+ * The HTTP thread serves requests in order, so slots are also freed in order.
  */
-static ResponseItem_t responseItem = { 0 };
+static uint32_t nextSlot = 0;
+
+/**
+ * @brief The number of slots whose response the main thread has not
+ * retrieved.
+ */
+static uint32_t slotsInUse = 0;
 
 /**
  * @brief The return status for requestS3ObjectRange() and retrieveHTTPResponse().
@@ -206,8 +212,8 @@ typedef enum QueueOpStatus
     QUEUE_OP_SUCCESS,
 
     /**
-     * @brief The function was given a non-blocking queue and would have blocked
-     * were it a blocking queue.
+     * @brief The function would have had to wait: every request slot is in
+     * use, or no response has arrived yet.
      */
     QUEUE_OP_WOULD_BLOCK,
 
@@ -244,67 +250,57 @@ static int connectToServer( NetworkContext_t * pNetworkContext );
  * @param[in] hostLen The length of pHost.
  * @param[in] pRequest The HTTP Request-URI.
  * @param[in] requestUriLen The length of pRequest.
- * @param[in] fileSize The length of the file at S3_PRESIGNED_GET_URL.
- * @param[in] requestQueue The queue to which HTTP requests should be written.
- * @param[in] responseQueue The queue from which HTTP responses should be read.
  *
  * @return false on failure; true on success.
  */
 static bool downloadS3ObjectFile( const char * pHost,
                                   const size_t hostLen,
                                   const char * pRequest,
-                                  const size_t requestUriLen,
-                                  mqd_t requestQueue,
-                                  mqd_t responseQueue );
+                                  const size_t requestUriLen );
 
 /**
  * @brief Enqueue an HTTP request for a range of the S3 file.
  *
  * @param[in] requestInfo The #HTTPRequestInfo_t for configuring the request.
- * @param[in] requestQueue The queue to which HTTP requests should be written.
  * @param[in] start The position of the first byte in the range.
  * @param[in] end The position of the last byte in the range, inclusive.
  *
- * @return QUEUE_OP_FAILURE on failure; QUEUE_OP_WOULD_BLOCK if would block,
- * QUEUE_OP_SUCCESS on success.
+ * @return QUEUE_OP_FAILURE on failure; QUEUE_OP_WOULD_BLOCK if every slot is
+ * in use, QUEUE_OP_SUCCESS on success.
  */
 static QueueOpStatus_t requestS3ObjectRange( const HTTPRequestInfo_t * requestInfo,
-                                             mqd_t requestQueue,
                                              const size_t start,
                                              const size_t end );
 
 
 /**
- * @brief Processes an HTTP response from the response queue.
+ * @brief Retrieve the slot of the next HTTP response from the response ring.
  *
- * @param[in] responseQueue The queue from which HTTP responses should be read.
- * @param[out] responseItem The HTTP response received.
+ * @param[in] timeoutMs How long to wait for a response; 0 to not wait.
+ * @param[out] ppSlot The slot holding the HTTP response received. It remains
+ * valid until the next request is enqueued.
  *
- * @return QUEUE_OP_FAILURE on failure; QUEUE_OP_WOULD_BLOCK if would block,
- * QUEUE_OP_SUCCESS on success.
+ * @return QUEUE_OP_FAILURE on failure; QUEUE_OP_WOULD_BLOCK if no response
+ * arrived in time, QUEUE_OP_SUCCESS on success.
  */
-static QueueOpStatus_t retrieveHTTPResponse( mqd_t responseQueue,
-                                             ResponseItem_t * responseItem );
+static QueueOpStatus_t retrieveHTTPResponse( uint32_t timeoutMs,
+                                             RangeSlot_t ** ppSlot );
 
 /**
  * @brief Retrieve the size of the S3 object that is specified in pPath using
  * HTTP thread.
  *
  * @param[in] requestInfo The #HTTPRequestInfo_t for configuring the request.
- * @param[in] requestQueue The queue to which HTTP requests should be written.
- * @param[in] responseQueue The queue from which HTTP responses should be read.
  * @param[out] pFileSize - The size of the S3 object.
  *
  * @return false on failure; true on success.
  */
 static bool getS3ObjectFileSize( const HTTPRequestInfo_t * requestInfo,
-                                 mqd_t requestQueue,
-                                 mqd_t responseQueue,
                                  size_t * pFileSize );
 
 /**
- * @brief Services HTTP requests from the request queue and writes the
- * responses to the response queue.
+ * @brief Services HTTP requests from the request ring and passes the
+ * responses back on the response ring.
  *
  * @param[in] pTransportInterface The transport interface for making network calls.
  *
@@ -316,12 +312,8 @@ static pid_t startHTTPThread( const TransportInterface_t * pTransportInterface )
  * @brief Clean up resources created by demo.
  *
  * @param[in] httpThread The HTTP thread.
- * @param[in] requestQueue The request queue.
- * @param[in] responseQueue The response queue.
  */
-static void tearDown( pid_t httpThread,
-                      mqd_t requestQueue,
-                      mqd_t responseQueue );
+static void tearDown( pid_t httpThread );
 
 /*-----------------------------------------------------------*/
 
@@ -370,13 +362,14 @@ static int connectToServer( NetworkContext_t * pNetworkContext )
 static bool downloadS3ObjectFile( const char * pHost,
                                   const size_t hostLen,
                                   const char * pRequest,
-                                  const size_t requestUriLen,
-                                  mqd_t requestQueue,
-                                  mqd_t responseQueue )
+                                  const size_t requestUriLen )
 {
     bool returnStatus = true;
     QueueOpStatus_t queueOpStatus = QUEUE_OP_SUCCESS;
 
+    /* The slot of the response retrieved. */
+    RangeSlot_t * pSlot = NULL;
+
     size_t requestCount = 0;
 
     /* Configurations of the initial request headers. */
@@ -405,8 +398,6 @@ static bool downloadS3ObjectFile( const char * pHost,
 
     /* Get the length of the S3 file. */
     returnStatus = getS3ObjectFileSize( &requestInfo,
-                                        requestQueue,
-                                        responseQueue,
                                         &fileSize );
 
     if( returnStatus == true )
@@ -432,7 +423,6 @@ static bool downloadS3ObjectFile( const char * pHost,
             if( curByte < fileSize )
             {
                 queueOpStatus = requestS3ObjectRange( &requestInfo,
-                                                      requestQueue,
                                                       curByte,
                                                       curByte + numReqBytes - 1 );
 
@@ -452,10 +442,14 @@ static bool downloadS3ObjectFile( const char * pHost,
                 }
             }
 
-            /* Retrieve response. */
+            /* Retrieve response. Wait for it when no other request can be
+             * enqueued, rather than spinning. */
             if( ( requestCount > 0 ) && ( queueOpStatus != QUEUE_OP_FAILURE ) )
             {
-                queueOpStatus = retrieveHTTPResponse( responseQueue, &responseItem );
+                queueOpStatus = retrieveHTTPResponse( ( ( curByte < fileSize ) &&
+                                                        ( queueOpStatus == QUEUE_OP_SUCCESS ) ) ?
+                                                      0U : RESPONSE_TIMEOUT_MS,
+                                                      &pSlot );
 
                 if( queueOpStatus == QUEUE_OP_FAILURE )
                 {
@@ -465,15 +459,15 @@ static bool downloadS3ObjectFile( const char * pHost,
                 {
                     LogInfo( ( "Main thread received HTTP response" ) );
                     LogInfo( ( "Response Headers:\n%.*s",
-                               ( int32_t ) responseItem.response.headersLen,
-                               responseItem.response.pHeaders ) );
-                    LogInfo( ( "Response Status:\n%u", responseItem.response.statusCode ) );
-                    LogInfo( ( "Response Body:\n%.*s\n", ( int32_t ) responseItem.response.bodyLen,
-                               responseItem.response.pBody ) );
+                               ( int32_t ) pSlot->response.headersLen,
+                               pSlot->response.pHeaders ) );
+                    LogInfo( ( "Response Status:\n%u", pSlot->response.statusCode ) );
+                    LogInfo( ( "Response Body:\n%.*s\n", ( int32_t ) pSlot->response.bodyLen,
+                               pSlot->response.pBody ) );
 
-                    if( responseItem.response.statusCode != HTTP_STATUS_CODE_PARTIAL_CONTENT )
+                    if( pSlot->response.statusCode != HTTP_STATUS_CODE_PARTIAL_CONTENT )
                     {
-                        LogError( ( "Recieved repsonse with unexpected status code: %d", responseItem.response.statusCode ) );
+                        LogError( ( "Recieved repsonse with unexpected status code: %d", pSlot->response.statusCode ) );
                         returnStatus = false;
                     }
                     else
@@ -491,33 +485,42 @@ static bool downloadS3ObjectFile( const char * pHost,
 /*-----------------------------------------------------------*/
 
 static QueueOpStatus_t requestS3ObjectRange( const HTTPRequestInfo_t * requestInfo,
-                                             mqd_t requestQueue,
                                              const size_t start,
                                              const size_t end )
 {
     QueueOpStatus_t returnStatus = QUEUE_OP_SUCCESS;
     HTTPStatus_t httpStatus = HTTPSuccess;
 
-    /* Return value of mq_send. */
-    int mqerror = 0;
+    /* The slot of the request. */
+    RangeSlot_t * pSlot = NULL;
 
-    /* Set the buffer used for storing request headers. */
-    requestItem.requestHeaders.pBuffer = requestItem.headersBuffer;
-    requestItem.requestHeaders.bufferLen = USER_BUFFER_LENGTH;
+    if( slotsInUse == QUEUE_SIZE )
+    {
+        /* Every slot waits for its response. */
+        returnStatus = QUEUE_OP_WOULD_BLOCK;
+    }
+    else
+    {
+        pSlot = &pSharedQueues->slots[ nextSlot ];
 
-    httpStatus = HTTPClient_InitializeRequestHeaders( &( requestItem.requestHeaders ),
-                                                      requestInfo );
+        /* Set the buffer used for storing request headers. */
+        pSlot->requestHeaders.pBuffer = pSlot->buffer;
+        pSlot->requestHeaders.bufferLen = USER_BUFFER_LENGTH;
 
-    if( httpStatus != HTTPSuccess )
-    {
-        LogError( ( "Failed to initialize HTTP request headers: Error=%s.",
-                    HTTPClient_strerror( httpStatus ) ) );
-        returnStatus = QUEUE_OP_FAILURE;
+        httpStatus = HTTPClient_InitializeRequestHeaders( &( pSlot->requestHeaders ),
+                                                          requestInfo );
+
+        if( httpStatus != HTTPSuccess )
+        {
+            LogError( ( "Failed to initialize HTTP request headers: Error=%s.",
+                        HTTPClient_strerror( httpStatus ) ) );
+            returnStatus = QUEUE_OP_FAILURE;
+        }
     }
 
     if( returnStatus == QUEUE_OP_SUCCESS )
     {
-        httpStatus = HTTPClient_AddRangeHeader( &( requestItem.requestHeaders ),
+        httpStatus = HTTPClient_AddRangeHeader( &( pSlot->requestHeaders ),
                                                 start,
                                                 end );
 
@@ -529,34 +532,27 @@ static QueueOpStatus_t requestS3ObjectRange( const HTTPRequestInfo_t * requestIn
         }
     }
 
-    if( returnStatus == EXIT_SUCCESS )
+    if( returnStatus == QUEUE_OP_SUCCESS )
     {
         /* Enqueue the request. */
         LogInfo( ( "Enqueuing bytes %d to %d of S3 Object:  ",
                    ( int32_t ) start,
                    ( int32_t ) end ) );
         LogInfo( ( "Request Headers:\n%.*s",
-                   ( int32_t ) requestItem.requestHeaders.headersLen,
-                   ( char * ) requestItem.requestHeaders.pBuffer ) );
+                   ( int32_t ) pSlot->requestHeaders.headersLen,
+                   ( char * ) pSlot->requestHeaders.pBuffer ) );
 
-        mqerror = mq_send( requestQueue,
-                           ( char * ) &requestItem,
-                           sizeof( RequestItem_t ),
-                           0 );
-
-        if( mqerror == -1 )
+        /* Only the index of the slot is passed: the request stays in place.
+         * The ring cannot be full, as it holds at least QUEUE_SIZE slots. */
+        if( SpscRing_Push( &pSharedQueues->requestRing, nextSlot ) == false )
         {
-            if( errno != EAGAIN )
-            {
-                /* Error other than due to not blocking. */
-                LogError( ( "Failed to write to request queue with error %s.",
-                            strerror( errno ) ) );
-                returnStatus = QUEUE_OP_FAILURE;
-            }
-            else
-            {
-                returnStatus = QUEUE_OP_WOULD_BLOCK;
-            }
+            LogError( ( "Failed to write to the request ring." ) );
+            returnStatus = QUEUE_OP_FAILURE;
+        }
+        else
+        {
+            nextSlot = ( nextSlot + 1U ) % QUEUE_SIZE;
+            slotsInUse++;
         }
     }
 
@@ -565,25 +561,21 @@ static QueueOpStatus_t requestS3ObjectRange( const HTTPRequestInfo_t * requestIn
 
 /*-----------------------------------------------------------*/
 
-static QueueOpStatus_t retrieveHTTPResponse( mqd_t responseQueue,
-                                             ResponseItem_t * responseItem )
+static QueueOpStatus_t retrieveHTTPResponse( uint32_t timeoutMs,
+                                             RangeSlot_t ** ppSlot )
 {
     QueueOpStatus_t returnStatus = QUEUE_OP_SUCCESS;
 
-    /* Return value of mq_receive. */
-    int mqread = 0;
-
-    /* Read response from queue. */
-    mqread = mq_receive( responseQueue, ( char * ) responseItem,
-                         sizeof( ResponseItem_t ), NULL );
+    /* Index of the slot of the response. */
+    uint32_t slotIndex = 0;
 
-    if( mqread == -1 )
+    /* Read the index of the response slot from the ring. */
+    if( SpscRing_Pop( &pSharedQueues->responseRing, &slotIndex, timeoutMs ) == false )
     {
-        if( errno != EAGAIN )
+        if( timeoutMs != 0U )
         {
-            /* Error other than due to not blocking. */
-            LogError( ( "Failed to read from response queue with error %s.",
-                        strerror( errno ) ) );
+            LogError( ( "No response from the HTTP thread in %u ms.",
+                        ( unsigned int ) timeoutMs ) );
             returnStatus = QUEUE_OP_FAILURE;
         }
         else
@@ -591,12 +583,20 @@ static QueueOpStatus_t retrieveHTTPResponse( mqd_t responseQueue,
             returnStatus = QUEUE_OP_WOULD_BLOCK;
         }
     }
-
-    if( returnStatus == QUEUE_OP_SUCCESS )
+    else if( slotIndex >= QUEUE_SIZE )
+    {
+        LogError( ( "Response ring returned invalid slot %u.", ( unsigned int ) slotIndex ) );
+        returnStatus = QUEUE_OP_FAILURE;
+    }
+    else
     {
-        if( mqread != sizeof( ResponseItem_t ) )
+        slotsInUse--;
+        *ppSlot = &pSharedQueues->slots[ slotIndex ];
+
+        if( ( *ppSlot )->sendStatus != HTTPSuccess )
         {
-            LogError( ( "Response from response queue has incorrect size." ) );
+            LogError( ( "HTTP thread failed to send the request: Error=%s.",
+                        HTTPClient_strerror( ( *ppSlot )->sendStatus ) ) );
             returnStatus = QUEUE_OP_FAILURE;
         }
     }
@@ -607,14 +607,15 @@ static QueueOpStatus_t retrieveHTTPResponse( mqd_t responseQueue,
 /*-----------------------------------------------------------*/
 
 static bool getS3ObjectFileSize( const HTTPRequestInfo_t * requestInfo,
-                                 mqd_t requestQueue,
-                                 mqd_t responseQueue,
                                  size_t * pFileSize )
 {
     bool returnStatus = true;
     HTTPStatus_t httpStatus = HTTPSuccess;
     QueueOpStatus_t queueOpStatus = QUEUE_OP_SUCCESS;
 
+    /* The slot of the response. */
+    RangeSlot_t * pSlot = NULL;
+
     /* The location of the file size in contentRangeValStr. */
     char * pFileSizeStr = NULL;
 
@@ -629,7 +630,6 @@ static bool getS3ObjectFileSize( const HTTPRequestInfo_t * requestInfo,
      * like: "Content-Range: bytes 0-0/FILESIZE". The body will have a single
      * byte that we are ignoring. */
     queueOpStatus = requestS3ObjectRange( requestInfo,
-                                          requestQueue,
                                           0,
                                           0 );
 
@@ -640,25 +640,22 @@ static bool getS3ObjectFileSize( const HTTPRequestInfo_t * requestInfo,
 
     if( returnStatus == true )
     {
-        do
-        {
-            queueOpStatus = retrieveHTTPResponse( responseQueue, &responseItem );
-        } while( queueOpStatus == QUEUE_OP_WOULD_BLOCK );
+        queueOpStatus = retrieveHTTPResponse( RESPONSE_TIMEOUT_MS, &pSlot );
 
-        if( queueOpStatus == QUEUE_OP_FAILURE )
+        if( queueOpStatus != QUEUE_OP_SUCCESS )
         {
             returnStatus = false;
         }
-        else if( responseItem.response.statusCode != HTTP_STATUS_CODE_PARTIAL_CONTENT )
+        else if( pSlot->response.statusCode != HTTP_STATUS_CODE_PARTIAL_CONTENT )
         {
-            LogError( ( "Received response with unexpected status code: %d.", responseItem.response.statusCode ) );
+            LogError( ( "Received response with unexpected status code: %d.", pSlot->response.statusCode ) );
             returnStatus = false;
         }
     }
 
     if( returnStatus == true )
     {
-        httpStatus = HTTPClient_ReadHeader( &responseItem.response,
+        httpStatus = HTTPClient_ReadHeader( &pSlot->response,
                                             ( char * ) HTTP_CONTENT_RANGE_HEADER_FIELD,
                                             ( size_t ) HTTP_CONTENT_RANGE_HEADER_FIELD_LENGTH,
                                             ( const char ** ) &contentRangeValStr,
@@ -724,75 +721,62 @@ static pid_t startHTTPThread( const TransportInterface_t * pTransportInterface )
     {
         /* HTTP thread. */
 
-        /* Queues for HTTP requests and responses. */
-        mqd_t requestQueue = -1;
-        mqd_t responseQueue = -1;
-
-        /* Open queues for read/write. */
-        requestQueue = mq_open( REQUEST_QUEUE, O_RDONLY );
-        responseQueue = mq_open( RESPONSE_QUEUE, O_WRONLY );
-
-        /* Initialize response struct. */
-        responseItem.response.pBuffer = responseItem.responseBuffer;
-        responseItem.response.bufferLen = sizeof( responseItem.responseBuffer );
+        /* Index of the slot of the request. */
+        uint32_t slotIndex = 0;
+        RangeSlot_t * pSlot = NULL;
 
         for( ; ; )
         {
-            HTTPStatus_t httpStatus = HTTPSuccess;
-
-            /* Return value of mq_receive. */
-            int mqread = 0;
-            /* Return value of mq_send. */
-            int mqerror = 0;
-
-            /* Read request from queue. */
-            mqread = mq_receive( requestQueue,
-                                 ( char * ) &requestItem,
-                                 sizeof( RequestItem_t ),
-                                 NULL );
-
-            if( mqread == -1 )
+            /* Wait for the index of the next request slot. */
+            if( SpscRing_Pop( &pSharedQueues->requestRing,
+                              &slotIndex,
+                              SPSC_RING_WAIT_FOREVER ) == false )
             {
-                LogError( ( "Failed to read from request queue with error %s.",
-                            strerror( errno ) ) );
+                continue;
             }
 
-            if( mqread != sizeof( RequestItem_t ) )
+            if( slotIndex >= QUEUE_SIZE )
             {
-                LogError( ( "Response from request queue has incorrect size." ) );
+                LogError( ( "Request ring returned invalid slot %u.", ( unsigned int ) slotIndex ) );
+                continue;
             }
 
+            pSlot = &pSharedQueues->slots[ slotIndex ];
+
             LogInfo( ( "HTTP thread retrieved request." ) );
             LogInfo( ( "Request Headers:\n%.*s",
-                       ( int32_t ) requestItem.requestHeaders.headersLen,
-                       ( char * ) requestItem.requestHeaders.pBuffer ) );
-
-            httpStatus = HTTPClient_Send( pTransportInterface,
-                                          &requestItem.requestHeaders,
-                                          NULL,
-                                          0,
-                                          &responseItem.response,
-                                          0 );
-
-            if( httpStatus != HTTPSuccess )
+                       ( int32_t ) pSlot->requestHeaders.headersLen,
+                       ( char * ) pSlot->requestHeaders.pBuffer ) );
+
+            /* The response is received in the buffer of the request headers,
+             * which are no longer needed once sent. */
+            ( void ) memset( &pSlot->response, 0, sizeof( pSlot->response ) );
+            pSlot->response.pBuffer = pSlot->buffer;
+            pSlot->response.bufferLen = sizeof( pSlot->buffer );
+
+            pSlot->sendStatus = HTTPClient_Send( pTransportInterface,
+                                                 &pSlot->requestHeaders,
+                                                 NULL,
+                                                 0,
+                                                 &pSlot->response,
+                                                 0 );
+
+            if( pSlot->sendStatus != HTTPSuccess )
             {
                 LogError( ( "Failed to send HTTP request: Error=%s.",
-                            HTTPClient_strerror( httpStatus ) ) );
+                            HTTPClient_strerror( pSlot->sendStatus ) ) );
             }
             else
             {
                 LogInfo( ( "HTTP thread received HTTP response" ) );
-                /* Write response to queue. */
-                mqerror = mq_send( responseQueue,
-                                   ( char * ) &responseItem,
-                                   sizeof( ResponseItem_t ),
-                                   0 );
+            }
 
-                if( mqerror != 0 )
-                {
-                    LogError( ( "Failed to write to response queue with error %s.",
-                                strerror( errno ) ) );
-                }
+            /* Pass the slot back, so that the main thread learns of failures
+             * too. The ring cannot be full, as it holds at least QUEUE_SIZE
+             * slots. */
+            if( SpscRing_Push( &pSharedQueues->responseRing, slotIndex ) == false )
+            {
+                LogError( ( "Failed to write to the response ring." ) );
             }
         }
     }
@@ -802,45 +786,25 @@ static pid_t startHTTPThread( const TransportInterface_t * pTransportInterface )
 
 /*-----------------------------------------------------------*/
 
-void tearDown( pid_t httpThread,
-               mqd_t requestQueue,
-               mqd_t responseQueue )
+void tearDown( pid_t httpThread )
 {
     /* End http task. */
     if( httpThread != -1 )
     {
         kill( httpThread, SIGTERM );
+        ( void ) waitpid( httpThread, NULL, 0 );
     }
 
-    /* Close and then delete the queues. */
-    if( requestQueue != -1 )
+    /* Unmap the slots and rings. */
+    if( pSharedQueues != NULL )
     {
-        if( mq_close( requestQueue ) == -1 )
+        if( munmap( pSharedQueues, sizeof( SharedQueues_t ) ) == -1 )
         {
-            LogError( ( "Failed to close request queue with error %s.",
+            LogError( ( "Failed to unmap the shared queues with error %s.",
                         strerror( errno ) ) );
         }
 
-        if( mq_unlink( REQUEST_QUEUE ) == -1 )
-        {
-            LogError( ( "Failed to delete request queue with error %s.",
-                        strerror( errno ) ) );
-        }
-    }
-
-    if( responseQueue != -1 )
-    {
-        if( mq_close( responseQueue ) == -1 )
-        {
-            LogError( ( "Failed to close response queue with error %s.",
-                        strerror( errno ) ) );
-        }
-
-        if( mq_unlink( RESPONSE_QUEUE ) == -1 )
-        {
-            LogError( ( "Failed to delete response queue with error %s.",
-                        strerror( errno ) ) );
-        }
+        pSharedQueues = NULL;
     }
 }
 
@@ -854,12 +818,12 @@ void tearDown( pid_t httpThread,
  * header, then finally performs a TLS handshake with the HTTP server so that
  * all communication is encrypted. After which, an HTTP thread is started which
  * uses HTTP Client library API to send requests it reads from the request
- * queue, and writes the responses to the response queue. The main thread sends
- * requests on the request queue, which are used to download
- * the S3 file by sending multiple range requests. While it is doing this, the
- * main thread also reads responses from the response queue and prints them
- * until the entire file is received. If any request fails, an error
- * code is returned.
+ * ring, and passes the responses back on the response ring. The rings carry
+ * only the indices of request slots in memory shared by both threads. The main
+ * thread writes requests in the slots, which are used to download the S3 file
+ * by sending multiple range requests. While it is doing this, the main thread
+ * also reads responses from the response ring and prints them until the entire
+ * file is received. If any request fails, an error code is returned.
  *
  * @note This example is multi-threaded and uses statically allocated memory.
  *
@@ -902,14 +866,6 @@ int main( int argc,
     NetworkContext_t networkContext = { 0 };
     OpensslParams_t opensslParams = { 0 };
 
-    /* Queue for HTTP requests. Requests are written by the main thread,
-     * and serviced by the HTTP thread. */
-    mqd_t requestQueue = -1;
-
-    /* Queue for HTTP responses. Responses are written by the HTTP thread,
-     * and read by the main thread. */
-    mqd_t responseQueue = -1;
-
     /* PID of HTTP thread. */
     pid_t httpThread = -1;
     int demoRunCount = 0;
@@ -987,55 +943,33 @@ int main( int argc,
 
             /******************** Start queues and HTTP task. *******************/
 
-            /* Start request and response queues. */
+            /* Map the slots and rings shared with the HTTP thread. */
             if( returnStatus == EXIT_SUCCESS )
             {
-                /* Settings for constructing queues. */
-                struct mq_attr queueSettings;
-
-                queueSettings.mq_maxmsg = QUEUE_SIZE;
-                queueSettings.mq_msgsize = sizeof( RequestItem_t );
-
-                requestQueue = mq_open( REQUEST_QUEUE,
-
-                                        /* These options create a queue if it does
-                                         * not already exist, and then opens it in
-                                         * non-blocking mode. It is opened as
-                                         * write-only as the main thread only writes
-                                         * HTTP requests to it. */
-                                        O_CREAT | O_NONBLOCK | O_WRONLY,
-                                        QUEUE_PERMISSIONS,
-                                        &queueSettings );
-
-                if( requestQueue == -1 )
+                pSharedQueues = mmap( NULL,
+                                      sizeof( SharedQueues_t ),
+                                      PROT_READ | PROT_WRITE,
+                                      MAP_SHARED | MAP_ANONYMOUS,
+                                      -1,
+                                      0 );
+
+                if( pSharedQueues == MAP_FAILED )
                 {
-                    LogError( ( "Failed to open request queue with error %s.",
+                    LogError( ( "Failed to map the shared queues with error %s.",
                                 strerror( errno ) ) );
+                    pSharedQueues = NULL;
                     returnStatus = EXIT_FAILURE;
                 }
-
-                queueSettings.mq_msgsize = sizeof( ResponseItem_t );
-
-                responseQueue = mq_open( RESPONSE_QUEUE,
-
-                                         /* These options create a queue if it does
-                                          * not already exist, and then opens it in
-                                          * non-blocking mode. It is opened as
-                                          * read-only as the main thread only reads
-                                          * HTTP responses from it. */
-                                         O_CREAT | O_NONBLOCK | O_RDONLY,
-                                         QUEUE_PERMISSIONS,
-                                         &queueSettings );
-
-                if( responseQueue == -1 )
+                else
                 {
-                    LogError( ( "Failed to open response queue with error %s.",
-                                strerror( errno ) ) );
-                    returnStatus = EXIT_FAILURE;
+                    SpscRing_Init( &pSharedQueues->requestRing );
+                    SpscRing_Init( &pSharedQueues->responseRing );
+                    nextSlot = 0;
+                    slotsInUse = 0;
                 }
             }
 
-            /* Start the HTTP task which services requests in requestQueue. */
+            /* Start the HTTP task which services requests in the request ring. */
 
             if( returnStatus == EXIT_SUCCESS )
             {
@@ -1055,9 +989,7 @@ int main( int argc,
                 result = downloadS3ObjectFile( pHost,
                                                hostLen,
                                                pPath,
-                                               requestUriLen,
-                                               requestQueue,
-                                               responseQueue );
+                                               requestUriLen );
 
                 if( result == false )
                 {
@@ -1072,7 +1004,8 @@ int main( int argc,
 
             /******************** Clean up queues and HTTP task. ****************/
 
-            tearDown( httpThread, requestQueue, responseQueue );
+            tearDown( httpThread );
+            httpThread = -1;
 
             /******************* Retry in case of failure. **********************/
 
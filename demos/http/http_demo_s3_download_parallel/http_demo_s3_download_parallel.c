@@ -0,0 +1,281 @@
+/*
+ * AWS IoT Device SDK for Embedded C 202103.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Standard includes. */
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* POSIX includes. */
+#include <fcntl.h>
+#include <unistd.h>
+
+/* Include Demo Config as the first non-system header. */
+#include "demo_config.h"
+
+/* Common HTTP demo utilities. */
+#include "http_demo_utils.h"
+
+/* Parallel ranged download engine. */
+#include "http_parallel_download.h"
+
+/* HTTP API header. */
+#include "core_http_client.h"
+
+/* OpenSSL transport header. */
+#include "openssl_posix.h"
+
+/* Check that TLS port of the server is defined. */
+#ifndef HTTPS_PORT
+    #error "Please define a HTTPS_PORT."
+#endif
+
+/* Check that a path for Root CA Certificate is defined. */
+#ifndef ROOT_CA_CERT_PATH
+    #error "Please define a ROOT_CA_CERT_PATH."
+#endif
+
+/* Check that the pre-signed GET URL is defined. */
+#ifndef S3_PRESIGNED_GET_URL
+    #error "Please define a S3_PRESIGNED_GET_URL."
+#endif
+
+/* Check that transport timeout for transport send and receive is defined. */
+#ifndef TRANSPORT_SEND_RECV_TIMEOUT_MS
+    #define TRANSPORT_SEND_RECV_TIMEOUT_MS    ( 1000 )
+#endif
+
+/* Check that the number of connections is defined. */
+#ifndef DOWNLOAD_CONNECTION_COUNT
+    #define DOWNLOAD_CONNECTION_COUNT    ( 4 )
+#endif
+
+/* Check that the path of the downloaded file is defined. */
+#ifndef DOWNLOAD_FILE_PATH
+    #define DOWNLOAD_FILE_PATH    "s3_download.bin"
+#endif
+
+/**
+ * @brief Length of the pre-signed GET URL defined in demo_config.h.
+ */
+#define S3_PRESIGNED_GET_URL_LENGTH    ( sizeof( S3_PRESIGNED_GET_URL ) - 1 )
+
+/**
+ * @brief The maximum number of times to run the loop in this demo.
+ *
+ * @note The demo loop is attempted to re-run only if it fails in an iteration.
+ * Once the demo loop succeeds in an iteration, the demo exits successfully.
+ */
+#ifndef HTTP_MAX_DEMO_LOOP_COUNT
+    #define HTTP_MAX_DEMO_LOOP_COUNT    ( 3 )
+#endif
+
+/**
+ * @brief Time in seconds to wait between retries of the demo loop if
+ * demo loop fails.
+ */
+#define DELAY_BETWEEN_DEMO_RETRY_ITERATIONS_S    ( 5 )
+
+/**
+ * @brief The host address string extracted from the pre-signed URL.
+ *
+ * @note S3_PRESIGNED_GET_URL_LENGTH is set as the array length here as the
+ * length of the host name string cannot exceed this value.
+ */
+static char serverHost[ S3_PRESIGNED_GET_URL_LENGTH ];
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Download the S3 object of the pre-signed URL to #DOWNLOAD_FILE_PATH.
+ *
+ * @return EXIT_FAILURE on failure; EXIT_SUCCESS on success.
+ */
+static int32_t downloadS3ObjectFile( void );
+
+/*-----------------------------------------------------------*/
+
+static int32_t downloadS3ObjectFile( void )
+{
+    int32_t returnStatus = EXIT_SUCCESS;
+    HTTPStatus_t httpStatus = HTTPSuccess;
+    HttpDownloadStatus_t downloadStatus = HTTP_DOWNLOAD_SUCCESS;
+    HttpDownloadConfig_t downloadConfig = { 0 };
+    HttpDownloadResult_t downloadResult = { 0 };
+    OpensslCredentials_t opensslCredentials = { 0 };
+
+    /* The location of the host address within the pre-signed URL. */
+    const char * pAddress = NULL;
+    size_t serverHostLength = 0;
+
+    /* The location of the path within the pre-signed URL. The requests need
+     * all the query information following the location of the object, so the
+     * length of the path without the query is left unused. */
+    const char * pPath = NULL;
+    size_t pathLen = 0;
+
+    int fileDescriptor = -1;
+
+    /* Retrieve the address location and length from S3_PRESIGNED_GET_URL. */
+    httpStatus = getUrlAddress( S3_PRESIGNED_GET_URL,
+                                S3_PRESIGNED_GET_URL_LENGTH,
+                                &pAddress,
+                                &serverHostLength );
+
+    if( httpStatus == HTTPSuccess )
+    {
+        /* serverHost should consist only of the host address located in
+         * S3_PRESIGNED_GET_URL. */
+        memcpy( serverHost, pAddress, serverHostLength );
+        serverHost[ serverHostLength ] = '\0';
+
+        /* Retrieve the path location from S3_PRESIGNED_GET_URL. */
+        httpStatus = getUrlPath( S3_PRESIGNED_GET_URL,
+                                 S3_PRESIGNED_GET_URL_LENGTH,
+                                 &pPath,
+                                 &pathLen );
+    }
+
+    returnStatus = ( httpStatus == HTTPSuccess ) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if( returnStatus == EXIT_SUCCESS )
+    {
+        fileDescriptor = open( DOWNLOAD_FILE_PATH, O_WRONLY | O_CREAT, 0644 );
+
+        if( fileDescriptor < 0 )
+        {
+            LogError( ( "Failed to open %s: errno=%d.", DOWNLOAD_FILE_PATH, errno ) );
+            returnStatus = EXIT_FAILURE;
+        }
+    }
+
+    if( returnStatus == EXIT_SUCCESS )
+    {
+        /* Initialize TLS credentials. */
+        opensslCredentials.pRootCaPath = ROOT_CA_CERT_PATH;
+        opensslCredentials.sniHostName = serverHost;
+
+        downloadConfig.pHost = serverHost;
+        downloadConfig.hostLength = serverHostLength;
+        downloadConfig.port = HTTPS_PORT;
+        downloadConfig.pPath = pPath;
+        downloadConfig.pathLength = strlen( pPath );
+        downloadConfig.pCredentials = &opensslCredentials;
+        downloadConfig.sendRecvTimeoutMs = TRANSPORT_SEND_RECV_TIMEOUT_MS;
+        downloadConfig.fileDescriptor = fileDescriptor;
+        downloadConfig.workerCount = DOWNLOAD_CONNECTION_COUNT;
+
+        LogInfo( ( "Downloading %s%s to %s over %d connections.",
+                   serverHost, pPath, DOWNLOAD_FILE_PATH, DOWNLOAD_CONNECTION_COUNT ) );
+
+        downloadStatus = HttpDownload_Run( &downloadConfig, &downloadResult );
+
+        if( downloadStatus == HTTP_DOWNLOAD_SUCCESS )
+        {
+            LogInfo( ( "Downloaded %lu bytes in %lu ms (%lu KB/s) with %lu range requests, "
+                       "%lu of which were retries.",
+                       ( unsigned long ) downloadResult.fileSize,
+                       ( unsigned long ) ( downloadResult.elapsedUs / 1000U ),
+                       ( unsigned long ) ( ( ( uint64_t ) downloadResult.fileSize * 1000U ) /
+                                           ( ( downloadResult.elapsedUs / 1000U ) + 1U ) / 1024U ),
+                       ( unsigned long ) downloadResult.rangeRequests,
+                       ( unsigned long ) downloadResult.rangeRetries ) );
+        }
+        else
+        {
+            LogError( ( "Failed to download the file: Status=%d.", ( int ) downloadStatus ) );
+            returnStatus = EXIT_FAILURE;
+        }
+    }
+
+    if( fileDescriptor >= 0 )
+    {
+        ( void ) close( fileDescriptor );
+    }
+
+    return returnStatus;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Entry point of demo.
+ *
+ * This example, using a pre-signed URL, resolves a S3 domain and downloads the
+ * S3 file over several TLS connections at once, with the parallel download
+ * engine of the HTTP demo utilities. Each connection validates the server's
+ * certificate using the root CA certificate defined in the config header and
+ * sends ranged GET requests, so that large files can use all of the available
+ * bandwidth. If any range cannot be downloaded, an error code is returned.
+ *
+ * @note This demo requires user-generated pre-signed URLs to be pasted into
+ * demo_config.h. Please use the provided script "presigned_urls_gen.py"
+ * (located in located in demos/http/common/src) to generate these URLs. For
+ * detailed instructions, see the accompanied README.md.
+ */
+int main( int argc,
+          char ** argv )
+{
+    /* Return value of main. */
+    int32_t returnStatus = EXIT_SUCCESS;
+    int demoRunCount = 0;
+
+    ( void ) argc;
+    ( void ) argv;
+
+    LogInfo( ( "HTTP Client parallel S3 download demo using pre-signed URL:\n%s",
+               S3_PRESIGNED_GET_URL ) );
+
+    do
+    {
+        returnStatus = downloadS3ObjectFile();
+
+        /* Increment the demo run count. */
+        demoRunCount++;
+
+        if( returnStatus == EXIT_SUCCESS )
+        {
+            LogInfo( ( "Demo iteration %d is successful.", demoRunCount ) );
+        }
+        /* Attempt to retry a failed iteration of demo for up to #HTTP_MAX_DEMO_LOOP_COUNT times. */
+        else if( demoRunCount < HTTP_MAX_DEMO_LOOP_COUNT )
+        {
+            LogWarn( ( "Demo iteration %d failed. Retrying...", demoRunCount ) );
+            sleep( DELAY_BETWEEN_DEMO_RETRY_ITERATIONS_S );
+        }
+        /* Failed all #HTTP_MAX_DEMO_LOOP_COUNT demo iterations. */
+        else
+        {
+            LogError( ( "All %d demo iterations failed.", HTTP_MAX_DEMO_LOOP_COUNT ) );
+            break;
+        }
+    } while( returnStatus != EXIT_SUCCESS );
+
+    if( returnStatus == EXIT_SUCCESS )
+    {
+        /* Log a message indicating an iteration completed successfully. */
+        LogInfo( ( "Demo completed successfully." ) );
+    }
+
+    return returnStatus;
+}
@@ -35,6 +35,9 @@
 /* Common HTTP demo utilities. */
 #include "http_demo_utils.h"
 
+/* Pool of the connections to the server. */
+#include "http_connection_pool.h"
+
 /* HTTP API header. */
 #include "core_http_client.h"
 
@@ -181,23 +184,15 @@ static const char * pPath;
 
 /*-----------------------------------------------------------*/
 
-/* Each compilation unit must define the NetworkContext struct. */
-struct NetworkContext
-{
-    OpensslParams_t * pParams;
-};
-
-/*-----------------------------------------------------------*/
-
 /**
- * @brief Connect to HTTP server with reconnection retries.
+ * @brief Check out a connection to the HTTP server from the connection pool.
  *
- * @param[out] pNetworkContext The output parameter to return the created
- * network context.
+ * An idle connection to the server is reused, skipping the TLS handshake.
+ * Otherwise, a new connection is established with reconnection retries.
  *
- * @return EXIT_FAILURE on failure; EXIT_SUCCESS on successful connection.
+ * @return The network context of the connection, or NULL on failure.
  */
-static int32_t connectToServer( NetworkContext_t * pNetworkContext );
+static NetworkContext_t * checkoutConnection( void );
 
 /**
  * @brief Retrieve and verify the size of the S3 object that is specified in
@@ -207,12 +202,15 @@ static int32_t connectToServer( NetworkContext_t * pNetworkContext );
  * calls.
  * @param[in] pPath The Request-URI to the objects of interest. This string must
  * be null-terminated.
+ * @param[out] pConnectionClosed Set to true if the server closes the
+ * connection after its response.
  *
  * @return The status of the file size acquisition and verification using a GET
  * request to the server: true on success, false on failure.
  */
 static bool verifyS3ObjectFileSize( const TransportInterface_t * pTransportInterface,
-                                    const char * pPath );
+                                    const char * pPath,
+                                    bool * pConnectionClosed );
 
 /**
  * @brief Retrieve the size of the S3 object that is specified in pPath.
@@ -225,6 +223,8 @@ static bool verifyS3ObjectFileSize( const TransportInterface_t * pTransportInter
  * @param[in] hostLen The length of the server host address.
  * @param[in] pPath The Request-URI to the objects of interest. This string
  * should be null-terminated.
+ * @param[out] pConnectionClosed Set to true if the server closes the
+ * connection after its response.
  *
  * @return The status of the file size acquisition using a GET request to the
  * server: true on success, false on failure.
@@ -233,7 +233,8 @@ static bool getS3ObjectFileSize( size_t * pFileSize,
                                  const TransportInterface_t * pTransportInterface,
                                  const char * pHost,
                                  size_t hostLen,
-                                 const char * pPath );
+                                 const char * pPath,
+                                 bool * pConnectionClosed );
 
 /**
  * @brief Send an HTTP PUT request based on a specified path to upload a file,
@@ -252,20 +253,16 @@ static bool uploadS3ObjectFile( const TransportInterface_t * pTransportInterface
 
 /*-----------------------------------------------------------*/
 
-static int32_t connectToServer( NetworkContext_t * pNetworkContext )
+static NetworkContext_t * checkoutConnection( void )
 {
-    int32_t returnStatus = EXIT_FAILURE;
     HTTPStatus_t httpStatus = HTTPSuccess;
+    NetworkContext_t * pNetworkContext = NULL;
 
     /* The location of the host address within the pre-signed URL. */
     const char * pAddress = NULL;
 
-    /* Status returned by OpenSSL transport implementation. */
-    OpensslStatus_t opensslStatus;
     /* Credentials to establish the TLS connection. */
     OpensslCredentials_t opensslCredentials = { 0 };
-    /* Information about the server to send the HTTP requests. */
-    ServerInfo_t serverInfo = { 0 };
 
     /* Retrieve the address location and length from S3_PRESIGNED_PUT_URL. */
     httpStatus = getUrlAddress( S3_PRESIGNED_PUT_URL,
@@ -273,9 +270,7 @@ static int32_t connectToServer( NetworkContext_t * pNetworkContext )
                                 &pAddress,
                                 &serverHostLength );
 
-    returnStatus = ( httpStatus == HTTPSuccess ) ? EXIT_SUCCESS : EXIT_FAILURE;
-
-    if( returnStatus == EXIT_SUCCESS )
+    if( httpStatus == HTTPSuccess )
     {
         /* serverHost should consist only of the host address located in
          * S3_PRESIGNED_PUT_URL. */
@@ -286,34 +281,24 @@ static int32_t connectToServer( NetworkContext_t * pNetworkContext )
         opensslCredentials.pRootCaPath = ROOT_CA_CERT_PATH;
         opensslCredentials.sniHostName = serverHost;
 
-        /* Initialize server information. */
-        serverInfo.pHostName = serverHost;
-        serverInfo.hostNameLength = serverHostLength;
-        serverInfo.port = HTTPS_PORT;
-
-        /* Establish a TLS session with the HTTP server. This example connects
-         * to the HTTP server as specified in SERVER_HOST and HTTPS_PORT in
-         * demo_config.h. */
-        LogInfo( ( "Establishing a TLS session with %s:%d.",
-                   serverHost,
-                   HTTPS_PORT ) );
-
-        opensslStatus = Openssl_Connect( pNetworkContext,
-                                         &serverInfo,
-                                         &opensslCredentials,
-                                         TRANSPORT_SEND_RECV_TIMEOUT_MS,
-                                         TRANSPORT_SEND_RECV_TIMEOUT_MS );
-
-        returnStatus = ( opensslStatus == OPENSSL_SUCCESS ) ? EXIT_SUCCESS : EXIT_FAILURE;
+        /* Reuse an idle TLS session with the HTTP server, or establish a new
+         * one. This example connects to the HTTP server as specified in
+         * S3_PRESIGNED_PUT_URL and HTTPS_PORT in demo_config.h. */
+        pNetworkContext = HttpPool_Checkout( serverHost,
+                                             serverHostLength,
+                                             HTTPS_PORT,
+                                             &opensslCredentials,
+                                             TRANSPORT_SEND_RECV_TIMEOUT_MS );
     }
 
-    return returnStatus;
+    return pNetworkContext;
 }
 
 /*-----------------------------------------------------------*/
 
 static bool verifyS3ObjectFileSize( const TransportInterface_t * pTransportInterface,
-                                    const char * pPath )
+                                    const char * pPath,
+                                    bool * pConnectionClosed )
 {
     bool returnStatus = false;
     /* The size of the file uploaded to S3. */
@@ -324,7 +309,8 @@ static bool verifyS3ObjectFileSize( const TransportInterface_t * pTransportInter
                                         pTransportInterface,
                                         serverHost,
                                         serverHostLength,
-                                        pPath );
+                                        pPath,
+                                        pConnectionClosed );
 
     if( returnStatus == true )
     {
@@ -352,7 +338,8 @@ static bool getS3ObjectFileSize( size_t * pFileSize,
                                  const TransportInterface_t * pTransportInterface,
                                  const char * pHost,
                                  size_t hostLen,
-                                 const char * pPath )
+                                 const char * pPath,
+                                 bool * pConnectionClosed )
 {
     bool returnStatus = true;
     HTTPStatus_t httpStatus = HTTPSuccess;
@@ -370,6 +357,9 @@ static bool getS3ObjectFileSize( size_t * pFileSize,
 
     assert( pHost != NULL );
     assert( pPath != NULL );
+    assert( pConnectionClosed != NULL );
+
+    *pConnectionClosed = false;
 
     /* Initialize all HTTP Client library API structs to 0. */
     ( void ) memset( &requestHeaders, 0, sizeof( requestHeaders ) );
@@ -442,6 +432,10 @@ static bool getS3ObjectFileSize( size_t * pFileSize,
                         pHost, pPath, HTTPClient_strerror( httpStatus ) ) );
             returnStatus = false;
         }
+        else
+        {
+            *pConnectionClosed = ( ( response.respFlags & HTTP_RESPONSE_CONNECTION_CLOSE_FLAG ) != 0U ) ? true : false;
+        }
     }
 
     if( returnStatus == true )
@@ -652,15 +646,13 @@ int main( int argc,
     /* The transport layer interface used by the HTTP Client library. */
     TransportInterface_t transportInterface;
     /* The network context for the transport layer interface. */
-    NetworkContext_t networkContext;
-    OpensslParams_t opensslParams;
+    NetworkContext_t * pNetworkContext = NULL;
+    /* Whether the server closes the connection after its last response. */
+    bool connectionClosed = false;
 
     ( void ) argc;
     ( void ) argv;
 
-    /* Set the pParams member of the network context with desired transport. */
-    networkContext.pParams = &opensslParams;
-
     LogInfo( ( "HTTP Client Synchronous S3 upload demo using pre-signed PUT URL:\n%s",
                S3_PRESIGNED_PUT_URL ) );
 
@@ -668,16 +660,13 @@ int main( int argc,
     {
         /**************************** Connect. ******************************/
 
-        /* Establish TLS connection on top of TCP connection using OpenSSL. */
-
-        /* Attempt to connect to the HTTP server. If connection fails, retry
-         * after a timeout. The timeout value will be exponentially
-         * increased until either the maximum number of attempts or the
-         * maximum timeout value is reached. The function returns
-         * EXIT_FAILURE if the TCP connection cannot be established to the
-         * broker after the configured number of attempts. */
-        returnStatus = connectToServerWithBackoffRetries( connectToServer,
-                                                          &networkContext );
+        /* Check out a TLS connection on top of TCP connection using OpenSSL.
+         * A connection kept alive by a previous iteration is reused. If a new
+         * connection fails, it is retried after a timeout. The timeout value
+         * will be exponentially increased until either the maximum number of
+         * attempts or the maximum timeout value is reached. */
+        pNetworkContext = checkoutConnection();
+        returnStatus = ( pNetworkContext != NULL ) ? EXIT_SUCCESS : EXIT_FAILURE;
 
         if( returnStatus == EXIT_FAILURE )
         {
@@ -693,7 +682,7 @@ int main( int argc,
             ( void ) memset( &transportInterface, 0, sizeof( transportInterface ) );
             transportInterface.recv = Openssl_Recv;
             transportInterface.send = Openssl_Send;
-            transportInterface.pNetworkContext = &networkContext;
+            transportInterface.pNetworkContext = pNetworkContext;
         }
 
         /********************** Upload S3 Object File. **********************/
@@ -716,6 +705,18 @@ int main( int argc,
             ret = uploadS3ObjectFile( &transportInterface,
                                       pPath );
             returnStatus = ( ret == true ) ? EXIT_SUCCESS : EXIT_FAILURE;
+            connectionClosed = ( ( response.respFlags & HTTP_RESPONSE_CONNECTION_CLOSE_FLAG ) != 0U ) ? true : false;
+        }
+
+        /* Verify the upload on another connection if the server closes this
+         * one after the PUT response. */
+        if( ( returnStatus == EXIT_SUCCESS ) && ( connectionClosed == true ) )
+        {
+            LogInfo( ( "Server closed the connection. Checking out another one." ) );
+            HttpPool_Checkin( pNetworkContext, false );
+            pNetworkContext = checkoutConnection();
+            transportInterface.pNetworkContext = pNetworkContext;
+            returnStatus = ( pNetworkContext != NULL ) ? EXIT_SUCCESS : EXIT_FAILURE;
         }
 
         /******************* Verify S3 Object File Upload. ********************/
@@ -737,14 +738,20 @@ int main( int argc,
         {
             /* Verify the file exists by retrieving the file size. */
             ret = verifyS3ObjectFileSize( &transportInterface,
-                                          pPath );
+                                          pPath,
+                                          &connectionClosed );
             returnStatus = ( ret == true ) ? EXIT_SUCCESS : EXIT_FAILURE;
         }
 
-        /************************** Disconnect. *****************************/
+        /*************************** Check in. *****************************/
 
-        /* End the TLS session, then close the TCP connection. */
-        ( void ) Openssl_Disconnect( &networkContext );
+        /* Return the connection to the pool. It is kept alive for the next
+         * requests unless a request failed or the server closes it. */
+        if( pNetworkContext != NULL )
+        {
+            HttpPool_Checkin( pNetworkContext,
+                              ( returnStatus == EXIT_SUCCESS ) && ( connectionClosed == false ) );
+        }
 
         /******************* Retry in case of failure. **********************/
 
@@ -769,6 +776,9 @@ int main( int argc,
         }
     } while( returnStatus != EXIT_SUCCESS );
 
+    /* End the TLS sessions, then close the TCP connections. */
+    HttpPool_CloseAll();
+
     if( returnStatus == EXIT_SUCCESS )
     {
         /* Log a message indicating an iteration completed successfully. */
@@ -346,6 +346,12 @@ static uint8_t buffer[ NETWORK_BUFFER_SIZE ];
  */
 static MQTTSubAckStatus_t globalSubAckStatus = MQTTSubAckFailure;
 
+/**
+ * @brief TLS session saved by the OpenSSL transport so that reconnections
+ * to the broker can resume it instead of performing a full handshake.
+ */
+static SSL_SESSION * pTlsSession = NULL;
+
 /*-----------------------------------------------------------*/
 
 /* Each compilation unit must define the NetworkContext struct. */
@@ -569,6 +575,7 @@ static int connectToServerWithBackoffRetries( NetworkContext_t * pNetworkContext
     BackoffAlgorithmContext_t reconnectParams;
     ServerInfo_t serverInfo;
     OpensslCredentials_t opensslCredentials;
+    SocketsOptions_t socketsOptions;
     uint16_t nextRetryBackOff;
     bool createCleanSession;
 
@@ -595,6 +602,15 @@ static int connectToServerWithBackoffRetries( NetworkContext_t * pNetworkContext
      * https://docs.aws.amazon.com/iot/latest/developerguide/transport-security.html */
     opensslCredentials.sniHostName = AWS_IOT_ENDPOINT;
 
+    /* Save the negotiated TLS session and offer it on reconnection. */
+    opensslCredentials.ppSession = &pTlsSession;
+
+    /* Disable Nagle's algorithm so that small MQTT packets are sent
+     * immediately instead of being batched. */
+    memset( &socketsOptions, 0, sizeof( SocketsOptions_t ) );
+    socketsOptions.noDelay = 1U;
+    opensslCredentials.pSocketsOptions = &socketsOptions;
+
     if( AWS_MQTT_PORT == 443 )
     {
         /* Pass the ALPN protocol name depending on the port being used.
@@ -1574,6 +1590,14 @@ int main( int argc,
             LogInfo( ( "Short delay before starting the next iteration....\n" ) );
             sleep( MQTT_SUBPUB_LOOP_DELAY_SECONDS );
         }
+
+        /* Release the TLS session saved for resumption once no more
+         * reconnections will be made. */
+        if( pTlsSession != NULL )
+        {
+            SSL_SESSION_free( pTlsSession );
+            pTlsSession = NULL;
+        }
     }
 
     return returnStatus;
@@ -140,7 +140,8 @@
 #define MQTT_ACK_TIMEOUT_MS                 ( 5000U )
 
 /**
- * @brief Period for demo loop sleep in milliseconds.
+ * @brief Longest time the demo loop waits for the OTA agent to release the
+ * MQTT mutex, in milliseconds.
  */
 #define OTA_EXAMPLE_LOOP_SLEEP_PERIOD_MS    ( 5U )
 
@@ -285,6 +286,21 @@ static OpensslParams_t opensslParams;
  */
 static pthread_mutex_t mqttMutex;
 
+/**
+ * @brief Event signaled by the OTA agent before it takes #mqttMutex, so that
+ * the demo loop lets it have the mutex.
+ */
+static ClockEvent_t mqttMutexRequestEvent = { -1 };
+
+/**
+ * @brief Event signaled by the OTA agent when it is about to release
+ * #mqttMutex.
+ *
+ * It is signaled before the unlock, so that the demo loop can discard the
+ * signals of earlier releases while it holds the mutex.
+ */
+static ClockEvent_t mqttMutexReleaseEvent = { -1 };
+
 /**
  * @brief Semaphore for synchronizing buffer operations.
  */
@@ -1264,6 +1280,9 @@ static OtaMqttStatus_t mqttSubscribe( const char * pTopicFilter,
     pSubscriptionList[ 0 ].pTopicFilter = pTopicFilter;
     pSubscriptionList[ 0 ].topicFilterLength = topicFilterLength;
 
+    /* Ask the demo loop to release the mutex. */
+    ( void ) Clock_SignalEvent( &mqttMutexRequestEvent );
+
     if( pthread_mutex_lock( &mqttMutex ) == 0 )
     {
         /* Send SUBSCRIBE packet. */
@@ -1272,6 +1291,8 @@ static OtaMqttStatus_t mqttSubscribe( const char * pTopicFilter,
                                      sizeof( pSubscriptionList ) / sizeof( MQTTSubscribeInfo_t ),
                                      MQTT_GetPacketId( pMqttContext ) );
 
+        ( void ) Clock_SignalEvent( &mqttMutexReleaseEvent );
+
         pthread_mutex_unlock( &mqttMutex );
     }
     else
@@ -1323,6 +1344,9 @@ static OtaMqttStatus_t mqttPublish( const char * const pacTopic,
     publishInfo.pPayload = pMsg;
     publishInfo.payloadLength = msgSize;
 
+    /* Ask the demo loop to release the mutex. */
+    ( void ) Clock_SignalEvent( &mqttMutexRequestEvent );
+
     if( pthread_mutex_lock( &mqttMutex ) == 0 )
     {
         mqttStatus = MQTT_Publish( pMqttContext,
@@ -1336,6 +1360,8 @@ static OtaMqttStatus_t mqttPublish( const char * const pacTopic,
             otaRet = OtaMqttPublishFailed;
         }
 
+        ( void ) Clock_SignalEvent( &mqttMutexReleaseEvent );
+
         pthread_mutex_unlock( &mqttMutex );
     }
     else
@@ -1392,6 +1418,9 @@ static OtaMqttStatus_t mqttUnsubscribe( const char * pTopicFilter,
     pSubscriptionList[ 0 ].pTopicFilter = pTopicFilter;
     pSubscriptionList[ 0 ].topicFilterLength = topicFilterLength;
 
+    /* Ask the demo loop to release the mutex. */
+    ( void ) Clock_SignalEvent( &mqttMutexRequestEvent );
+
     if( pthread_mutex_lock( &mqttMutex ) == 0 )
     {
         /* Send UNSUBSCRIBE packet. */
@@ -1400,6 +1429,8 @@ static OtaMqttStatus_t mqttUnsubscribe( const char * pTopicFilter,
                                        sizeof( pSubscriptionList ) / sizeof( MQTTSubscribeInfo_t ),
                                        MQTT_GetPacketId( pMqttContext ) );
 
+        ( void ) Clock_SignalEvent( &mqttMutexReleaseEvent );
+
         pthread_mutex_unlock( &mqttMutex );
     }
     else
@@ -1573,6 +1604,12 @@ static int startOTADemo( void )
                     /* Loop to receive packet from transport interface. */
                     mqttStatus = MQTT_ProcessLoop( &mqttContext, MQTT_PROCESS_LOOP_TIMEOUT_MS );
 
+                    /* The OTA agent signals a release before it unlocks the
+                     * mutex, so a release signaled now is left over from an
+                     * earlier cycle. Discard it, so that only a release after
+                     * this unlock ends the wait below. */
+                    ( void ) Clock_WaitEvent( &mqttMutexReleaseEvent, 0U );
+
                     pthread_mutex_unlock( &mqttMutex );
                 }
                 else
@@ -1593,10 +1630,12 @@ static int startOTADemo( void )
                                otaStatistics.otaPacketsProcessed,
                                otaStatistics.otaPacketsDropped ) );
 
-                    /* Delay if mqtt process loop is set to zero.*/
-                    if( MQTT_PROCESS_LOOP_TIMEOUT_MS > 0 )
+                    /* Let the OTA agent take the MQTT mutex when it asked for
+                     * it, instead of sleeping after every process loop. Wait
+                     * until it is done, or at most the loop sleep period. */
+                    if( Clock_WaitEvent( &mqttMutexRequestEvent, 0U ) == CLOCK_EVENT_SUCCESS )
                     {
-                        Clock_SleepMs( OTA_EXAMPLE_LOOP_SLEEP_PERIOD_MS );
+                        ( void ) Clock_WaitEvent( &mqttMutexReleaseEvent, OTA_EXAMPLE_LOOP_SLEEP_PERIOD_MS );
                     }
                 }
                 else
@@ -1721,6 +1760,17 @@ int main( int argc,
         mqttMutexInitialized = true;
     }
 
+    /* Create the events for handing the MQTT mutex to the OTA agent. */
+    if( ( Clock_CreateEvent( &mqttMutexRequestEvent ) != CLOCK_EVENT_SUCCESS ) ||
+        ( Clock_CreateEvent( &mqttMutexReleaseEvent ) != CLOCK_EVENT_SUCCESS ) )
+    {
+        LogError( ( "Failed to create events for the mqtt mutex"
+                    ",errno=%s",
+                    strerror( errno ) ) );
+
+        returnStatus = EXIT_FAILURE;
+    }
+
     if( returnStatus == EXIT_SUCCESS )
     {
         /* Initialize MQTT library. Initialization of the MQTT library needs to be
@@ -1776,6 +1826,10 @@ int main( int argc,
         }
     }
 
+    /* Destroying an event that was not created does nothing. */
+    Clock_DestroyEvent( &mqttMutexRequestEvent );
+    Clock_DestroyEvent( &mqttMutexReleaseEvent );
+
     /* Wait and log message before exiting demo. */
     while( waitTimeoutMs > 0 )
     {
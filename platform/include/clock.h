@@ -31,6 +31,29 @@
 /* Standard includes. */
 #include <stdint.h>
 
+/**
+ * @brief Return codes of the event functions.
+ */
+typedef enum ClockEventStatus
+{
+    CLOCK_EVENT_SUCCESS = 0,       /**< Function successfully completed, or the event was signaled. */
+    CLOCK_EVENT_TIMEOUT,           /**< The event was not signaled before the timeout expired. */
+    CLOCK_EVENT_INVALID_PARAMETER, /**< At least one parameter was invalid. */
+    CLOCK_EVENT_API_ERROR          /**< A call to a system API resulted in an internal error. */
+} ClockEventStatus_t;
+
+/**
+ * @brief An event that a thread can block on until another thread signals
+ * it.
+ *
+ * Events reset automatically: a successful wait consumes every signal
+ * received since the previous one.
+ */
+typedef struct ClockEvent
+{
+    int32_t handle; /**< @brief Handle of the platform event; an eventfd on POSIX. */
+} ClockEvent_t;
+
 /**
  * @brief The timer query function.
  *
@@ -40,6 +63,26 @@
  */
 uint32_t Clock_GetTimeMs( void );
 
+/**
+ * @brief Get the time of a monotonic clock in microseconds.
+ *
+ * Unlike #Clock_GetTimeMs, this time does not wrap around, so it can be
+ * stored and compared directly. It is meant for measuring latencies.
+ *
+ * @return Time in microseconds.
+ */
+uint64_t Clock_GetTimeUs64( void );
+
+/**
+ * @brief Get the time of a monotonic clock in nanoseconds.
+ *
+ * This is the same clock as #Clock_GetTimeUs64, with the full resolution of
+ * the platform.
+ *
+ * @return Time in nanoseconds.
+ */
+uint64_t Clock_GetTimeNs64( void );
+
 /**
  * @brief Millisecond sleep function.
  *
@@ -47,4 +90,52 @@ uint32_t Clock_GetTimeMs( void );
  */
 void Clock_SleepMs( uint32_t sleepTimeMs );
 
+/**
+ * @brief Create an event.
+ *
+ * @param[out] pEvent The event to create.
+ *
+ * @return #CLOCK_EVENT_SUCCESS on success, #CLOCK_EVENT_INVALID_PARAMETER if
+ * @p pEvent is NULL, and #CLOCK_EVENT_API_ERROR if the platform event could
+ * not be created.
+ */
+ClockEventStatus_t Clock_CreateEvent( ClockEvent_t * pEvent );
+
+/**
+ * @brief Signal an event, waking up a thread blocked in #Clock_WaitEvent.
+ *
+ * This function may be called from any thread, and from a signal handler.
+ *
+ * @param[in] pEvent The event to signal.
+ *
+ * @return #CLOCK_EVENT_SUCCESS on success, #CLOCK_EVENT_INVALID_PARAMETER if
+ * @p pEvent is not a created event, and #CLOCK_EVENT_API_ERROR otherwise.
+ */
+ClockEventStatus_t Clock_SignalEvent( const ClockEvent_t * pEvent );
+
+/**
+ * @brief Block until an event is signaled or a timeout expires.
+ *
+ * Unlike polling with #Clock_SleepMs, the calling thread does not wake up
+ * until there is work to do or the timeout expires. A timeout of 0 checks the
+ * event without blocking.
+ *
+ * @param[in] pEvent The event to wait on.
+ * @param[in] timeoutMs The maximum time to wait, in milliseconds.
+ *
+ * @return #CLOCK_EVENT_SUCCESS if the event was signaled,
+ * #CLOCK_EVENT_TIMEOUT if the timeout expired first,
+ * #CLOCK_EVENT_INVALID_PARAMETER if @p pEvent is not a created event, and
+ * #CLOCK_EVENT_API_ERROR otherwise.
+ */
+ClockEventStatus_t Clock_WaitEvent( const ClockEvent_t * pEvent,
+                                    uint32_t timeoutMs );
+
+/**
+ * @brief Destroy an event created with #Clock_CreateEvent.
+ *
+ * @param[in] pEvent The event to destroy.
+ */
+void Clock_DestroyEvent( ClockEvent_t * pEvent );
+
 #endif /* ifndef CLOCK_H_ */
@@ -0,0 +1,155 @@
+/*
+ * AWS IoT Device SDK for Embedded C 202103.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file clock_benchmark.c
+ * @brief Measures the cost and the accuracy of #Clock_GetTimeMs for the time
+ * source it was built with, against reading CLOCK_MONOTONIC directly as the
+ * MONOTONIC time source does.
+ *
+ * The accuracy is the largest difference between #Clock_GetTimeMs and
+ * CLOCK_MONOTONIC over a few seconds, which covers several resyncs of the TSC
+ * time source.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+/* Platform clock include. */
+#include "clock.h"
+
+/**
+ * @brief Name of the time source of #Clock_GetTimeMs, set by CMake.
+ */
+#ifndef CLOCK_BENCHMARK_SOURCE_NAME
+    #define CLOCK_BENCHMARK_SOURCE_NAME    "MONOTONIC"
+#endif
+
+/**
+ * @brief Number of calls measured for each variant.
+ */
+#define BENCHMARK_ITERATIONS    ( 10000000U )
+
+/**
+ * @brief Number of times the accuracy is sampled, and the time between
+ * samples.
+ */
+#define DRIFT_SAMPLES           ( 100U )
+#define DRIFT_INTERVAL_MS       ( 37U )
+
+/**
+ * @brief Time conversion constants.
+ */
+#define ONE_SEC_TO_NS           ( 1000000000LL )
+#define ONE_MS_TO_NS            ( 1000000LL )
+#define ONE_SEC_TO_MS           ( 1000LL )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Read the monotonic clock in nanoseconds.
+ */
+static int64_t getTimeNs( void )
+{
+    struct timespec now;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( ( int64_t ) now.tv_sec * ONE_SEC_TO_NS ) + ( int64_t ) now.tv_nsec;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The MONOTONIC time source, inlined in the benchmark so that it is
+ * measured whichever source #Clock_GetTimeMs was built with.
+ */
+static uint32_t monotonicTimeMs( void )
+{
+    struct timespec now;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( uint32_t ) ( ( now.tv_sec * ONE_SEC_TO_MS ) + ( now.tv_nsec / ONE_MS_TO_NS ) );
+}
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    /* Accumulate the results so that the calls are not optimized away. */
+    volatile uint32_t sink = 0U;
+    uint32_t i;
+    int64_t start, monotonicNs, clockNs;
+    int32_t error, maxError = 0, minError = 0;
+
+    start = getTimeNs();
+
+    for( i = 0U; i < BENCHMARK_ITERATIONS; i++ )
+    {
+        sink += monotonicTimeMs();
+    }
+
+    monotonicNs = getTimeNs() - start;
+
+    start = getTimeNs();
+
+    for( i = 0U; i < BENCHMARK_ITERATIONS; i++ )
+    {
+        sink += Clock_GetTimeMs();
+    }
+
+    clockNs = getTimeNs() - start;
+
+    /* A positive error means that Clock_GetTimeMs is ahead of
+     * CLOCK_MONOTONIC. */
+    for( i = 0U; i < DRIFT_SAMPLES; i++ )
+    {
+        error = ( int32_t ) ( Clock_GetTimeMs() - monotonicTimeMs() );
+
+        if( error > maxError )
+        {
+            maxError = error;
+        }
+
+        if( error < minError )
+        {
+            minError = error;
+        }
+
+        Clock_SleepMs( DRIFT_INTERVAL_MS );
+    }
+
+    printf( "%-28s %10s %14s\n", "variant", "ns/call", "error (ms)" );
+    printf( "%-28s %10.1f %14s\n", "clock_gettime(MONOTONIC)",
+            ( double ) monotonicNs / BENCHMARK_ITERATIONS, "0" );
+    printf( "%-28s %10.1f %10ld..%ld\n", "Clock_GetTimeMs(" CLOCK_BENCHMARK_SOURCE_NAME ")",
+            ( double ) clockNs / BENCHMARK_ITERATIONS,
+            ( long ) minError, ( long ) maxError );
+
+    ( void ) sink;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,276 @@
+/*
+ * AWS IoT Device SDK for Embedded C 202103.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file event_benchmark.c
+ * @brief Measures the wakeups and the latency of a loop that waits for work,
+ * when it polls with #Clock_SleepMs and when it blocks in #Clock_WaitEvent.
+ *
+ * A producer thread posts work every #WORK_INTERVAL_MS. The consumer is the
+ * calling thread, and its wakeups are the voluntary context switches it makes
+ * while it waits. The latency is the time from posting the work to the
+ * consumer picking it up.
+ */
+
+/* _GNU_SOURCE for RUSAGE_THREAD. */
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/* POSIX includes. */
+#include <pthread.h>
+#include <sys/resource.h>
+
+/* Platform clock include. */
+#include "clock.h"
+
+/**
+ * @brief Period of the demo loops polling for a change of state.
+ */
+#define POLL_PERIOD_MS          ( 5U )
+
+/**
+ * @brief Time between two work items of the producer.
+ */
+#define WORK_INTERVAL_MS        ( 100U )
+
+/**
+ * @brief Number of work items per variant.
+ */
+#define WORK_ITEMS              ( 30U )
+
+/**
+ * @brief Timeout of #Clock_WaitEvent, after which the consumer checks for the
+ * end of the run.
+ */
+#define WAIT_TIMEOUT_MS         ( 1000U )
+
+/**
+ * @brief Time conversion constants.
+ */
+#define ONE_SEC_TO_US           ( 1000000ULL )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief State shared by the producer and the consumer.
+ */
+typedef struct BenchmarkState
+{
+    ClockEvent_t event;       /**< @brief Signaled by the producer when it posts work, unless polling. */
+    uint8_t useEvent;         /**< @brief Whether the producer signals #BenchmarkState_t.event. */
+    uint64_t postedUs;        /**< @brief Time the pending work was posted; 0 if none is pending. */
+    uint32_t postedItems;     /**< @brief Number of work items posted so far. */
+    pthread_mutex_t mutex;    /**< @brief Protects the fields above. */
+} BenchmarkState_t;
+
+/**
+ * @brief Results of one variant.
+ */
+typedef struct BenchmarkResult
+{
+    uint64_t elapsedUs;       /**< @brief Duration of the run. */
+    long wakeups;             /**< @brief Voluntary context switches of the consumer. */
+    uint64_t totalLatencyUs;  /**< @brief Sum of the latencies of all work items. */
+    uint64_t maxLatencyUs;    /**< @brief Largest latency of a work item. */
+    uint32_t items;           /**< @brief Number of work items picked up. */
+} BenchmarkResult_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Producer thread posting #WORK_ITEMS work items.
+ *
+ * @param[in] pParam The #BenchmarkState_t.
+ */
+static void * producerThread( void * pParam )
+{
+    BenchmarkState_t * pState = ( BenchmarkState_t * ) pParam;
+    uint32_t i;
+
+    for( i = 0U; i < WORK_ITEMS; i++ )
+    {
+        Clock_SleepMs( WORK_INTERVAL_MS );
+
+        ( void ) pthread_mutex_lock( &pState->mutex );
+        pState->postedUs = Clock_GetTimeUs64();
+        pState->postedItems++;
+        ( void ) pthread_mutex_unlock( &pState->mutex );
+
+        if( pState->useEvent == 1U )
+        {
+            ( void ) Clock_SignalEvent( &pState->event );
+        }
+    }
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Take the pending work item, if any.
+ *
+ * @param[in] pState The shared state.
+ * @param[in,out] pResult Updated with the latency of the work item.
+ *
+ * @return 1 once every work item was picked up, 0 otherwise.
+ */
+static uint8_t takeWork( BenchmarkState_t * pState,
+                         BenchmarkResult_t * pResult )
+{
+    uint64_t latencyUs;
+    uint8_t done;
+
+    ( void ) pthread_mutex_lock( &pState->mutex );
+
+    if( pState->postedUs != 0U )
+    {
+        latencyUs = Clock_GetTimeUs64() - pState->postedUs;
+        pState->postedUs = 0U;
+        pResult->totalLatencyUs += latencyUs;
+        pResult->items++;
+
+        if( latencyUs > pResult->maxLatencyUs )
+        {
+            pResult->maxLatencyUs = latencyUs;
+        }
+    }
+
+    done = ( pState->postedItems == WORK_ITEMS ) && ( pState->postedUs == 0U ) ? 1U : 0U;
+
+    ( void ) pthread_mutex_unlock( &pState->mutex );
+
+    return done;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Run the consumer loop for one variant.
+ *
+ * @param[in] useEvent 1 to block in #Clock_WaitEvent, 0 to poll with
+ * #Clock_SleepMs.
+ * @param[out] pResult The results.
+ *
+ * @return EXIT_SUCCESS or EXIT_FAILURE.
+ */
+static int runVariant( uint8_t useEvent,
+                       BenchmarkResult_t * pResult )
+{
+    BenchmarkState_t state = { 0 };
+    pthread_t producer;
+    struct rusage usageStart, usageEnd;
+    uint64_t startUs;
+    int returnStatus = EXIT_SUCCESS;
+
+    state.useEvent = useEvent;
+    ( void ) pthread_mutex_init( &state.mutex, NULL );
+
+    if( Clock_CreateEvent( &state.event ) != CLOCK_EVENT_SUCCESS )
+    {
+        returnStatus = EXIT_FAILURE;
+    }
+    else if( pthread_create( &producer, NULL, producerThread, &state ) != 0 )
+    {
+        returnStatus = EXIT_FAILURE;
+    }
+    else
+    {
+        ( void ) getrusage( RUSAGE_THREAD, &usageStart );
+        startUs = Clock_GetTimeUs64();
+
+        while( takeWork( &state, pResult ) == 0U )
+        {
+            if( useEvent == 1U )
+            {
+                ( void ) Clock_WaitEvent( &state.event, WAIT_TIMEOUT_MS );
+            }
+            else
+            {
+                Clock_SleepMs( POLL_PERIOD_MS );
+            }
+        }
+
+        pResult->elapsedUs = Clock_GetTimeUs64() - startUs;
+        ( void ) getrusage( RUSAGE_THREAD, &usageEnd );
+        pResult->wakeups = usageEnd.ru_nvcsw - usageStart.ru_nvcsw;
+
+        ( void ) pthread_join( producer, NULL );
+    }
+
+    Clock_DestroyEvent( &state.event );
+    ( void ) pthread_mutex_destroy( &state.mutex );
+
+    return returnStatus;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Print the results of one variant.
+ *
+ * @param[in] pName Name of the variant.
+ * @param[in] pResult The results.
+ */
+static void printResult( const char * pName,
+                         const BenchmarkResult_t * pResult )
+{
+    printf( "%-28s %12.1f %18.1f %18lu\n", pName,
+            ( double ) pResult->wakeups * ONE_SEC_TO_US / pResult->elapsedUs,
+            ( double ) pResult->totalLatencyUs / pResult->items,
+            ( unsigned long ) pResult->maxLatencyUs );
+}
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    BenchmarkResult_t pollResult = { 0 };
+    BenchmarkResult_t eventResult = { 0 };
+    int returnStatus;
+
+    returnStatus = runVariant( 0U, &pollResult );
+
+    if( returnStatus == EXIT_SUCCESS )
+    {
+        returnStatus = runVariant( 1U, &eventResult );
+    }
+
+    if( returnStatus == EXIT_SUCCESS )
+    {
+        printf( "%-28s %12s %18s %18s\n", "variant", "wakeups/s", "mean latency (us)", "max latency (us)" );
+        printResult( "Clock_SleepMs(5) polling", &pollResult );
+        printResult( "Clock_WaitEvent", &eventResult );
+    }
+    else
+    {
+        printf( "Failed to set up the benchmark.\n" );
+    }
+
+    return returnStatus;
+}
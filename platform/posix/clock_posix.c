@@ -32,28 +32,245 @@
     #include <time.h>
 #endif
 
+/* Standard includes. */
+#include <stdbool.h>
+
+/* POSIX includes for events. */
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
 /* Platform clock include. */
 #include "clock.h"
 
+/**
+ * @brief Values of #CLOCK_POSIX_SOURCE, which selects how #Clock_GetTimeMs
+ * reads the time.
+ *
+ * - CLOCK_POSIX_SOURCE_MONOTONIC reads CLOCK_MONOTONIC.
+ * - CLOCK_POSIX_SOURCE_COARSE reads CLOCK_MONOTONIC_COARSE, which the vDSO
+ * serves from the time of the last timer tick without reading a hardware
+ * counter. Its resolution is that of the kernel tick, usually 1 to 4 ms.
+ * - CLOCK_POSIX_SOURCE_TSC (x86 only) scales the time stamp counter by a
+ * rate measured against CLOCK_MONOTONIC, which is read again every
+ * #CLOCK_POSIX_TSC_RESYNC_MS to correct any drift. It requires an invariant
+ * TSC, which all x86 processors of the last decade have.
+ *
+ * #Clock_GetTimeUs64 and #Clock_GetTimeNs64 use the TSC as well with the TSC
+ * source, and CLOCK_MONOTONIC otherwise.
+ */
+#define CLOCK_POSIX_SOURCE_MONOTONIC    ( 0 )
+#define CLOCK_POSIX_SOURCE_COARSE       ( 1 )
+#define CLOCK_POSIX_SOURCE_TSC          ( 2 )
+
+/**
+ * @brief The time source of #Clock_GetTimeMs, set with the CLOCK_POSIX_SOURCE
+ * CMake option.
+ */
+#ifndef CLOCK_POSIX_SOURCE
+    #define CLOCK_POSIX_SOURCE    CLOCK_POSIX_SOURCE_MONOTONIC
+#endif
+
+/**
+ * @brief Interval at which the TSC time source measures its rate against
+ * CLOCK_MONOTONIC again.
+ */
+#ifndef CLOCK_POSIX_TSC_RESYNC_MS
+    #define CLOCK_POSIX_TSC_RESYNC_MS    ( 1000U )
+#endif
+
+/**
+ * @brief The clock read by the selected time source.
+ */
+#if ( CLOCK_POSIX_SOURCE == CLOCK_POSIX_SOURCE_COARSE )
+    #define CLOCK_POSIX_CLOCK_ID    CLOCK_MONOTONIC_COARSE
+#else
+    #define CLOCK_POSIX_CLOCK_ID    CLOCK_MONOTONIC
+#endif
+
+#if ( CLOCK_POSIX_SOURCE == CLOCK_POSIX_SOURCE_TSC )
+    #if !defined( __x86_64__ ) && !defined( __i386__ )
+        #error "CLOCK_POSIX_SOURCE_TSC is only supported on x86."
+    #endif
+
+    #include <x86intrin.h>
+#endif
+
 /*
  * Time conversion constants.
  */
-#define NANOSECONDS_PER_MILLISECOND    ( 1000000L )    /**< @brief Nanoseconds per millisecond. */
-#define MILLISECONDS_PER_SECOND        ( 1000L )       /**< @brief Milliseconds per second. */
+#define NANOSECONDS_PER_MILLISECOND    ( 1000000L )     /**< @brief Nanoseconds per millisecond. */
+#define MILLISECONDS_PER_SECOND        ( 1000L )        /**< @brief Milliseconds per second. */
+#define NANOSECONDS_PER_SECOND         ( 1000000000LL ) /**< @brief Nanoseconds per second. */
+#define NANOSECONDS_PER_MICROSECOND    ( 1000L )        /**< @brief Nanoseconds per microsecond. */
+
+/**
+ * @brief The longest timeout that poll accepts, in milliseconds.
+ */
+#define POLL_MAX_TIMEOUT_MS            ( 0x7FFFFFFFU )
+
+/**
+ * @brief Number of fractional bits of #TscState_t.nsPerTick.
+ */
+#define TSC_RATE_SHIFT                 ( 20U )
+
+/**
+ * @brief The shortest interval over which the TSC rate is measured.
+ */
+#define TSC_MIN_CALIBRATION_NS         ( 10LL * NANOSECONDS_PER_MILLISECOND )
+
+/**
+ * @brief The longest interval over which the TSC rate is measured.
+ *
+ * A longer interval would overflow when it is shifted by #TSC_RATE_SHIFT, so a
+ * thread that has not read the time for longer than this only moves its
+ * anchor and keeps the rate it measured before.
+ */
+#define TSC_MAX_CALIBRATION_NS         ( INT64_MAX >> TSC_RATE_SHIFT )
 
 /*-----------------------------------------------------------*/
 
-uint32_t Clock_GetTimeMs( void )
+#if ( CLOCK_POSIX_SOURCE == CLOCK_POSIX_SOURCE_TSC )
+
+/**
+ * @brief Conversion from the TSC to CLOCK_MONOTONIC.
+ *
+ * Each thread keeps its own copy, so no lock is needed. A thread pays for a
+ * few reads of CLOCK_MONOTONIC while it measures the rate of the TSC.
+ */
+    typedef struct TscState
+    {
+        uint64_t anchorTsc; /**< @brief TSC at the last read of CLOCK_MONOTONIC; 0 before the first read. */
+        int64_t anchorNs;   /**< @brief CLOCK_MONOTONIC at the last read, in nanoseconds. */
+        uint64_t nsPerTick; /**< @brief Nanoseconds per TSC tick with #TSC_RATE_SHIFT fractional bits; 0 until measured. */
+        int64_t lastNs;     /**< @brief Last time returned, so that a resync never moves time backwards. */
+    } TscState_t;
+
+    static __thread TscState_t tscState = { 0 };
+
+#endif /* if ( CLOCK_POSIX_SOURCE == CLOCK_POSIX_SOURCE_TSC ) */
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Read CLOCK_MONOTONIC in nanoseconds.
+ *
+ * The COARSE time source is not used here, as its resolution is far too low
+ * for the 64-bit clocks.
+ *
+ * @return Time in nanoseconds.
+ */
+static int64_t readClockNs( void );
+
+#if ( CLOCK_POSIX_SOURCE == CLOCK_POSIX_SOURCE_TSC )
+
+/**
+ * @brief Get the time of CLOCK_MONOTONIC in nanoseconds from the TSC.
+ *
+ * @return Time in nanoseconds.
+ */
+    static int64_t readTscNs( void );
+#endif
+
+/*-----------------------------------------------------------*/
+
+static int64_t readClockNs( void )
 {
-    int64_t timeMs;
     struct timespec timeSpec;
 
-    /* Get the MONOTONIC time. */
     ( void ) clock_gettime( CLOCK_MONOTONIC, &timeSpec );
 
-    /* Calculate the milliseconds from timespec. */
-    timeMs = ( timeSpec.tv_sec * MILLISECONDS_PER_SECOND )
-             + ( timeSpec.tv_nsec / NANOSECONDS_PER_MILLISECOND );
+    return ( ( int64_t ) timeSpec.tv_sec * NANOSECONDS_PER_SECOND ) +
+           ( int64_t ) timeSpec.tv_nsec;
+}
+
+/*-----------------------------------------------------------*/
+
+#if ( CLOCK_POSIX_SOURCE == CLOCK_POSIX_SOURCE_TSC )
+
+    static int64_t readTscNs( void )
+    {
+        uint64_t tsc = ( uint64_t ) __rdtsc();
+        uint64_t elapsedTicks = tsc - tscState.anchorTsc;
+        int64_t timeNs = 0;
+        int64_t clockNs = 0;
+        bool readClock = true;
+
+        /* Scale the ticks only while the product fits in 64 bits. A thread
+         * that has not read the time for hours reads CLOCK_MONOTONIC instead. */
+        if( ( tscState.nsPerTick != 0U ) &&
+            ( elapsedTicks <= ( UINT64_MAX / tscState.nsPerTick ) ) )
+        {
+            timeNs = tscState.anchorNs +
+                     ( int64_t ) ( ( elapsedTicks * tscState.nsPerTick ) >> TSC_RATE_SHIFT );
+
+            readClock = ( ( timeNs - tscState.anchorNs ) >=
+                          ( ( int64_t ) CLOCK_POSIX_TSC_RESYNC_MS * NANOSECONDS_PER_MILLISECOND ) );
+        }
+
+        /* Read CLOCK_MONOTONIC until the rate is known, and then once per
+         * resync interval. */
+        if( readClock == true )
+        {
+            clockNs = readClockNs();
+
+            if( ( tscState.anchorTsc == 0U ) ||
+                ( ( clockNs - tscState.anchorNs ) > TSC_MAX_CALIBRATION_NS ) )
+            {
+                /* First call of this thread, or the interval is too long to
+                 * measure the rate without overflow. Move the anchor and keep
+                 * the rate. */
+                tscState.anchorTsc = tsc;
+                tscState.anchorNs = clockNs;
+            }
+            else if( ( clockNs - tscState.anchorNs ) >= TSC_MIN_CALIBRATION_NS )
+            {
+                tscState.nsPerTick = ( ( uint64_t ) ( clockNs - tscState.anchorNs ) << TSC_RATE_SHIFT ) /
+                                     elapsedTicks;
+                tscState.anchorTsc = tsc;
+                tscState.anchorNs = clockNs;
+            }
+            else
+            {
+                /* Keep the anchor until the interval is long enough to
+                 * measure the rate precisely. */
+            }
+
+            timeNs = clockNs;
+        }
+
+        if( timeNs < tscState.lastNs )
+        {
+            timeNs = tscState.lastNs;
+        }
+
+        tscState.lastNs = timeNs;
+
+        return timeNs;
+    }
+
+#endif /* if ( CLOCK_POSIX_SOURCE == CLOCK_POSIX_SOURCE_TSC ) */
+
+/*-----------------------------------------------------------*/
+
+uint32_t Clock_GetTimeMs( void )
+{
+    int64_t timeMs;
+
+    #if ( CLOCK_POSIX_SOURCE == CLOCK_POSIX_SOURCE_TSC )
+        /* Get the MONOTONIC time from the TSC. */
+        timeMs = readTscNs() / NANOSECONDS_PER_MILLISECOND;
+    #else
+        struct timespec timeSpec;
+
+        /* Get the MONOTONIC time. */
+        ( void ) clock_gettime( CLOCK_POSIX_CLOCK_ID, &timeSpec );
+
+        /* Calculate the milliseconds from timespec. */
+        timeMs = ( timeSpec.tv_sec * MILLISECONDS_PER_SECOND )
+                 + ( timeSpec.tv_nsec / NANOSECONDS_PER_MILLISECOND );
+    #endif
 
     /* Libraries need only the lower 32 bits of the time in milliseconds, since
      * this function is used only for calculating the time difference.
@@ -64,6 +281,28 @@ uint32_t Clock_GetTimeMs( void )
 
 /*-----------------------------------------------------------*/
 
+uint64_t Clock_GetTimeUs64( void )
+{
+    return Clock_GetTimeNs64() / ( uint64_t ) NANOSECONDS_PER_MICROSECOND;
+}
+
+/*-----------------------------------------------------------*/
+
+uint64_t Clock_GetTimeNs64( void )
+{
+    int64_t timeNs;
+
+    #if ( CLOCK_POSIX_SOURCE == CLOCK_POSIX_SOURCE_TSC )
+        timeNs = readTscNs();
+    #else
+        timeNs = readClockNs();
+    #endif
+
+    return ( uint64_t ) timeNs;
+}
+
+/*-----------------------------------------------------------*/
+
 void Clock_SleepMs( uint32_t sleepTimeMs )
 {
     /* Convert parameter to timespec. */
@@ -75,3 +314,152 @@ void Clock_SleepMs( uint32_t sleepTimeMs )
     /* High resolution sleep. */
     ( void ) nanosleep( &sleepTime, NULL );
 }
+
+/*-----------------------------------------------------------*/
+
+ClockEventStatus_t Clock_CreateEvent( ClockEvent_t * pEvent )
+{
+    ClockEventStatus_t returnStatus = CLOCK_EVENT_SUCCESS;
+
+    if( pEvent == NULL )
+    {
+        returnStatus = CLOCK_EVENT_INVALID_PARAMETER;
+    }
+    else
+    {
+        /* The eventfd is non-blocking, so that a thread that loses the race
+         * for a signal goes back to poll instead of blocking in read. */
+        pEvent->handle = eventfd( 0U, EFD_NONBLOCK | EFD_CLOEXEC );
+
+        if( pEvent->handle < 0 )
+        {
+            returnStatus = CLOCK_EVENT_API_ERROR;
+        }
+    }
+
+    return returnStatus;
+}
+
+/*-----------------------------------------------------------*/
+
+ClockEventStatus_t Clock_SignalEvent( const ClockEvent_t * pEvent )
+{
+    ClockEventStatus_t returnStatus = CLOCK_EVENT_SUCCESS;
+    uint64_t increment = 1U;
+
+    if( ( pEvent == NULL ) || ( pEvent->handle < 0 ) )
+    {
+        returnStatus = CLOCK_EVENT_INVALID_PARAMETER;
+    }
+    else if( write( pEvent->handle, &increment, sizeof( increment ) ) !=
+             ( ssize_t ) sizeof( increment ) )
+    {
+        /* EAGAIN means that the counter is saturated, so the event is
+         * signaled already. */
+        if( errno != EAGAIN )
+        {
+            returnStatus = CLOCK_EVENT_API_ERROR;
+        }
+    }
+    else
+    {
+        /* Empty else MISRA 15.7 */
+    }
+
+    return returnStatus;
+}
+
+/*-----------------------------------------------------------*/
+
+ClockEventStatus_t Clock_WaitEvent( const ClockEvent_t * pEvent,
+                                    uint32_t timeoutMs )
+{
+    ClockEventStatus_t returnStatus = CLOCK_EVENT_TIMEOUT;
+    struct pollfd pollFd = { 0 };
+    uint64_t counter = 0U;
+    uint32_t remainingMs = timeoutMs;
+    uint32_t elapsedMs = 0U;
+    int64_t startTimeNs = 0;
+    int pollStatus = 0;
+    uint8_t waiting = 1U;
+
+    if( ( pEvent == NULL ) || ( pEvent->handle < 0 ) )
+    {
+        returnStatus = CLOCK_EVENT_INVALID_PARAMETER;
+        waiting = 0U;
+    }
+    else
+    {
+        pollFd.fd = pEvent->handle;
+        pollFd.events = POLLIN;
+        startTimeNs = readClockNs();
+    }
+
+    while( waiting == 1U )
+    {
+        pollFd.revents = 0;
+        pollStatus = poll( &pollFd,
+                           1U,
+                           ( int ) ( ( remainingMs > POLL_MAX_TIMEOUT_MS ) ? POLL_MAX_TIMEOUT_MS : remainingMs ) );
+
+        if( pollStatus > 0 )
+        {
+            /* Reading resets the counter of the eventfd. */
+            if( read( pEvent->handle, &counter, sizeof( counter ) ) == ( ssize_t ) sizeof( counter ) )
+            {
+                returnStatus = CLOCK_EVENT_SUCCESS;
+                waiting = 0U;
+            }
+            else if( errno != EAGAIN )
+            {
+                returnStatus = CLOCK_EVENT_API_ERROR;
+                waiting = 0U;
+            }
+            else
+            {
+                /* Another thread consumed the signal first. */
+            }
+        }
+        else if( pollStatus == 0 )
+        {
+            waiting = 0U;
+        }
+        else if( errno != EINTR )
+        {
+            returnStatus = CLOCK_EVENT_API_ERROR;
+            waiting = 0U;
+        }
+        else
+        {
+            /* Interrupted by a signal handler. */
+        }
+
+        if( waiting == 1U )
+        {
+            /* Wait again for the rest of the timeout. */
+            elapsedMs = ( uint32_t ) ( ( readClockNs() - startTimeNs ) / NANOSECONDS_PER_MILLISECOND );
+
+            if( elapsedMs >= timeoutMs )
+            {
+                waiting = 0U;
+            }
+            else
+            {
+                remainingMs = timeoutMs - elapsedMs;
+            }
+        }
+    }
+
+    return returnStatus;
+}
+
+/*-----------------------------------------------------------*/
+
+void Clock_DestroyEvent( ClockEvent_t * pEvent )
+{
+    if( ( pEvent != NULL ) && ( pEvent->handle >= 0 ) )
+    {
+        ( void ) close( pEvent->handle );
+        pEvent->handle = -1;
+    }
+}
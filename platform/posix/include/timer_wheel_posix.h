@@ -0,0 +1,262 @@
+/*
+ * AWS IoT Device SDK for Embedded C 202103.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef TIMER_WHEEL_POSIX_H_
+#define TIMER_WHEEL_POSIX_H_
+
+/**************************************************/
+/******* DO NOT CHANGE the following order ********/
+/**************************************************/
+
+/* Logging related header files are required to be included in the following order:
+ * 1. Include the header file "logging_levels.h".
+ * 2. Define LIBRARY_LOG_NAME and  LIBRARY_LOG_LEVEL.
+ * 3. Include the header file "logging_stack.h".
+ */
+
+/* Include header that defines log levels. */
+#include "logging_levels.h"
+
+/* Logging configuration for the timer wheel. */
+#ifndef LIBRARY_LOG_NAME
+    #define LIBRARY_LOG_NAME     "TimerWheel"
+#endif
+#ifndef LIBRARY_LOG_LEVEL
+    #define LIBRARY_LOG_LEVEL    LOG_ERROR
+#endif
+
+#include "logging_stack.h"
+
+/************ End of logging configuration ****************/
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/* POSIX includes. */
+#include <pthread.h>
+
+/**
+ * @brief Number of bits of the tick that index the slots of one level of the
+ * wheel.
+ */
+#define TIMER_WHEEL_SLOT_BITS       ( 6U )
+
+/**
+ * @brief Number of slots in each level of the wheel.
+ */
+#define TIMER_WHEEL_SLOTS           ( 1U << TIMER_WHEEL_SLOT_BITS )
+
+/**
+ * @brief Number of levels of the wheel.
+ *
+ * Level n holds the timers that expire within 64^(n + 1) ticks, so four
+ * levels cover 2^24 ticks, over 46 hours with 10 ms ticks. Timers further
+ * away wait in the last level and are placed again when it turns.
+ */
+#define TIMER_WHEEL_LEVELS          ( 4U )
+
+/**
+ * @brief Timeout to pass to #TimerWheel_Run to wait until a timer expires.
+ */
+#define TIMER_WHEEL_WAIT_FOREVER    ( UINT32_MAX )
+
+/**
+ * @brief Timer wheel return status.
+ */
+typedef enum TimerWheelStatus
+{
+    TIMER_WHEEL_SUCCESS = 0,         /**< Function successfully completed. */
+    TIMER_WHEEL_INVALID_PARAMETER,   /**< At least one parameter was invalid. */
+    TIMER_WHEEL_INSUFFICIENT_MEMORY, /**< Insufficient memory or descriptors to complete the operation. */
+    TIMER_WHEEL_API_ERROR            /**< A call to a system API resulted in an internal error. */
+} TimerWheelStatus_t;
+
+struct TimerWheelTimer;
+
+/**
+ * @brief Callback invoked when a timer expires.
+ *
+ * It is invoked on the thread that calls #TimerWheel_Process or
+ * #TimerWheel_Run, without any lock held, so it may start or cancel timers.
+ *
+ * @param[in] pTimer The timer that expired.
+ * @param[in] pUserData The user data passed to #TimerWheel_Start.
+ */
+typedef void ( * TimerWheelCallback_t )( struct TimerWheelTimer * pTimer,
+                                         void * pUserData );
+
+/**
+ * @brief Link of a doubly linked list of timers.
+ */
+typedef struct TimerWheelLink
+{
+    struct TimerWheelLink * pNext; /**< @brief Next link in the list. */
+    struct TimerWheelLink * pPrev; /**< @brief Previous link in the list. */
+} TimerWheelLink_t;
+
+/**
+ * @brief A timer of a timer wheel.
+ *
+ * @note The memory is provided by the application, zero-initialized before
+ * the first #TimerWheel_Start, and must remain valid while the timer is
+ * pending. Its members are set by #TimerWheel_Start and must not be modified
+ * directly.
+ */
+typedef struct TimerWheelTimer
+{
+    TimerWheelLink_t link;         /**< @brief Link in the list of its slot. Must be the first member. */
+    uint64_t expiryTick;           /**< @brief Tick at which the timer expires. */
+    TimerWheelCallback_t callback; /**< @brief Callback invoked when the timer expires. */
+    void * pUserData;              /**< @brief User data passed to the callback. */
+    uint8_t pending;               /**< @brief Whether the timer is in the wheel. */
+} TimerWheelTimer_t;
+
+/**
+ * @brief A hierarchical timer wheel driven by a timerfd.
+ *
+ * Starting and canceling a timer take constant time. The timerfd ticks only
+ * while timers are pending, so an idle wheel does not wake its thread up.
+ * The functions of the wheel may be called from any thread.
+ */
+typedef struct TimerWheel
+{
+    TimerWheelLink_t slots[ TIMER_WHEEL_LEVELS ][ TIMER_WHEEL_SLOTS ]; /**< @brief Pending timers by level and slot. */
+    TimerWheelLink_t expired;                                          /**< @brief Expired timers whose callbacks are not invoked yet. */
+    uint64_t nextTick;                                                 /**< @brief Next tick to process. */
+    uint32_t tickMs;                                                   /**< @brief Period of a tick, in milliseconds. */
+    size_t numTimers;                                                  /**< @brief Number of pending timers. */
+    int32_t timerDescriptor;                                           /**< @brief The timerfd driving the ticks. */
+    uint8_t ticking;                                                   /**< @brief Whether the timerfd is armed. */
+    pthread_mutex_t mutex;                                             /**< @brief Protects the members above and the timers. */
+} TimerWheel_t;
+
+/**
+ * @brief Create a timer wheel.
+ *
+ * @param[out] pTimerWheel The timer wheel to initialize.
+ * @param[in] tickMs The resolution of the timers, in milliseconds.
+ *
+ * @return #TIMER_WHEEL_SUCCESS if successful; #TIMER_WHEEL_INVALID_PARAMETER,
+ * #TIMER_WHEEL_INSUFFICIENT_MEMORY, #TIMER_WHEEL_API_ERROR on error.
+ */
+TimerWheelStatus_t TimerWheel_Init( TimerWheel_t * pTimerWheel,
+                                    uint32_t tickMs );
+
+/**
+ * @brief Start a timer, or restart it if it is pending.
+ *
+ * The timer expires after @p timeoutMs rounded up to whole ticks, measured
+ * from the last tick processed. It may thus expire up to one tick early if
+ * a tick is due but not processed yet, and up to one tick late otherwise.
+ *
+ * @param[in] pTimerWheel The timer wheel.
+ * @param[in] pTimer The timer to start.
+ * @param[in] timeoutMs Time until the timer expires.
+ * @param[in] callback The callback to invoke when the timer expires.
+ * @param[in] pUserData User data to pass to the callback.
+ *
+ * @return #TIMER_WHEEL_SUCCESS if successful; #TIMER_WHEEL_INVALID_PARAMETER,
+ * #TIMER_WHEEL_API_ERROR on error.
+ */
+TimerWheelStatus_t TimerWheel_Start( TimerWheel_t * pTimerWheel,
+                                     TimerWheelTimer_t * pTimer,
+                                     uint32_t timeoutMs,
+                                     TimerWheelCallback_t callback,
+                                     void * pUserData );
+
+/**
+ * @brief Cancel a timer.
+ *
+ * Canceling a timer that is not pending does nothing.
+ *
+ * @param[in] pTimerWheel The timer wheel.
+ * @param[in] pTimer The timer to cancel.
+ *
+ * @note The callback of the timer may be running on the thread of the wheel
+ * when this function returns.
+ *
+ * @return #TIMER_WHEEL_SUCCESS if successful; #TIMER_WHEEL_INVALID_PARAMETER
+ * on error.
+ */
+TimerWheelStatus_t TimerWheel_Cancel( TimerWheel_t * pTimerWheel,
+                                      TimerWheelTimer_t * pTimer );
+
+/**
+ * @brief Get the descriptor that becomes readable when a tick is due.
+ *
+ * An application that already waits on descriptors, such as with an event
+ * loop, may wait on this one as well and call #TimerWheel_Process when it is
+ * readable, instead of calling #TimerWheel_Run.
+ *
+ * @param[in] pTimerWheel The timer wheel.
+ *
+ * @return The descriptor, or -1 if @p pTimerWheel is NULL.
+ */
+int32_t TimerWheel_GetDescriptor( const TimerWheel_t * pTimerWheel );
+
+/**
+ * @brief Process the ticks that are due and invoke the callbacks of the timers
+ * that expired. This function does not block.
+ *
+ * @param[in] pTimerWheel The timer wheel.
+ * @param[out] pNumExpired Number of callbacks invoked. May be NULL.
+ *
+ * @return #TIMER_WHEEL_SUCCESS if successful; #TIMER_WHEEL_INVALID_PARAMETER,
+ * #TIMER_WHEEL_API_ERROR on error.
+ */
+TimerWheelStatus_t TimerWheel_Process( TimerWheel_t * pTimerWheel,
+                                       size_t * pNumExpired );
+
+/**
+ * @brief Wait for the next tick and invoke the callbacks of the timers that
+ * expired.
+ *
+ * A thread that calls this function in a loop serves the timers of all the
+ * connections that share the wheel.
+ *
+ * @param[in] pTimerWheel The timer wheel.
+ * @param[in] timeoutMs Time to wait for a tick. 0 returns immediately and
+ * #TIMER_WHEEL_WAIT_FOREVER waits without a timeout.
+ * @param[out] pNumExpired Number of callbacks invoked. May be NULL.
+ *
+ * @return #TIMER_WHEEL_SUCCESS if successful, including when the timeout
+ * expired or the wait was interrupted by a signal;
+ * #TIMER_WHEEL_INVALID_PARAMETER, #TIMER_WHEEL_API_ERROR on error.
+ */
+TimerWheelStatus_t TimerWheel_Run( TimerWheel_t * pTimerWheel,
+                                   uint32_t timeoutMs,
+                                   size_t * pNumExpired );
+
+/**
+ * @brief Destroy a timer wheel.
+ *
+ * Pending timers are dropped without invoking their callbacks.
+ *
+ * @param[in] pTimerWheel The timer wheel.
+ *
+ * @return #TIMER_WHEEL_SUCCESS if successful; #TIMER_WHEEL_INVALID_PARAMETER
+ * on error.
+ */
+TimerWheelStatus_t TimerWheel_Deinit( TimerWheel_t * pTimerWheel );
+
+#endif /* ifndef TIMER_WHEEL_POSIX_H_ */
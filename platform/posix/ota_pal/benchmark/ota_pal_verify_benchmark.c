@@ -0,0 +1,312 @@
+/*
+ * OTA PAL V2.0.1 for POSIX
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file ota_pal_verify_benchmark.c
+ * @brief Measures the throughput of the signature check that #otaPal_CloseFile
+ * runs on a received file, for the way of reading the file the PAL was built
+ * with.
+ *
+ * The received file is written and signed by the benchmark. Nothing is
+ * written with #otaPal_WriteBlock, so the signature is never verified while
+ * blocks arrive and #otaPal_CloseFile always reads back the whole file. Each
+ * file is verified once after being dropped from the page cache, and once
+ * more while it is cached.
+ *
+ * The files are created in a temporary directory under the current working
+ * directory, which should be on the storage the PAL is evaluated for, and the
+ * platform image state file is written there too.
+ */
+
+/* Standard includes. */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+/* POSIX includes. */
+#include <fcntl.h>
+#include <unistd.h>
+
+/* OpenSSL includes. */
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+
+/* Platform clock include. */
+#include "clock.h"
+
+/* OTA PAL include. */
+#include "ota_pal_posix.h"
+
+#ifndef SIGNER_CERT_PATH
+    #error "SIGNER_CERT_PATH must be set to the certificate generated by the build."
+#endif
+
+#ifndef SIGNER_KEY_PATH
+    #error "SIGNER_KEY_PATH must be set to the private key generated by the build."
+#endif
+
+/**
+ * @brief Name of the way the PAL reads the file at close, set by CMake.
+ */
+#ifndef OTA_PAL_BENCHMARK_VARIANT_NAME
+    #define OTA_PAL_BENCHMARK_VARIANT_NAME    "MMAP"
+#endif
+
+/**
+ * @brief Number of bytes in one megabyte.
+ */
+#define ONE_MB                      ( 1024U * 1024U )
+
+/**
+ * @brief Number of microseconds in one second.
+ */
+#define ONE_SEC_TO_US               ( 1000000.0 )
+
+/**
+ * @brief Largest file verified when no limit is given on the command line, in megabytes.
+ */
+#define DEFAULT_MAX_FILE_SIZE_MB    ( 1024U )
+
+/**
+ * @brief Name of the received file, in the temporary directory.
+ */
+#define RECEIVED_FILE_NAME          "image.bin"
+
+/**
+ * @brief Name of the file the PAL stores the platform image state in, in the
+ * working directory.
+ */
+#define IMAGE_STATE_FILE_NAME       "PlatformImageState.txt"
+
+/**
+ * @brief Sizes of the received files, in megabytes.
+ */
+static const uint32_t fileSizesMb[] = { 10U, 100U, 1024U };
+
+/**
+ * @brief One megabyte of the content of the received files.
+ */
+static uint8_t fileChunk[ ONE_MB ];
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Write a received file of the given size and sign it.
+ *
+ * @param[in] pPath Path of the file.
+ * @param[in] sizeMb Size of the file in megabytes.
+ * @param[in] pKey Code signing key.
+ * @param[out] pSignature Signature of the file.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+static int writeSignedFile( const char * pPath,
+                            uint32_t sizeMb,
+                            EVP_PKEY * pKey,
+                            Sig256_t * pSignature )
+{
+    int status = -1;
+    FILE * pFile = NULL;
+    EVP_MD_CTX * pSignContext = EVP_MD_CTX_new();
+    size_t signatureSize = sizeof( pSignature->data );
+    uint32_t i;
+
+    pFile = fopen( pPath, "wb" );
+
+    if( ( pFile != NULL ) && ( pSignContext != NULL ) &&
+        ( 1 == EVP_DigestSignInit( pSignContext, NULL, EVP_sha256(), NULL, pKey ) ) )
+    {
+        status = 0;
+
+        for( i = 0U; ( i < sizeMb ) && ( status == 0 ); i++ )
+        {
+            /* Vary the content so that no two megabytes are the same. */
+            ( void ) memcpy( fileChunk, &i, sizeof( i ) );
+
+            if( ( fwrite( fileChunk, 1U, ONE_MB, pFile ) != ONE_MB ) ||
+                ( 1 != EVP_DigestSignUpdate( pSignContext, fileChunk, ONE_MB ) ) )
+            {
+                status = -1;
+            }
+        }
+
+        if( ( status == 0 ) &&
+            ( ( 1 != EVP_DigestSignFinal( pSignContext, pSignature->data, &signatureSize ) ) ||
+              ( 0 != fflush( pFile ) ) ||
+              ( 0 != fsync( fileno( pFile ) ) ) ) )
+        {
+            status = -1;
+        }
+
+        pSignature->size = ( uint16_t ) signatureSize;
+    }
+
+    if( pFile != NULL )
+    {
+        ( void ) fclose( pFile );
+    }
+
+    EVP_MD_CTX_free( pSignContext );
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Verify a received file with #otaPal_CloseFile.
+ *
+ * @param[in] pPath Path of the file.
+ * @param[in] sizeMb Size of the file in megabytes.
+ * @param[in] pSignature Signature of the file.
+ * @param[in] dropCache Drop the file from the page cache first if not 0.
+ *
+ * @return Throughput in MB/s, or a negative value if the signature check failed.
+ */
+static double verifyFile( const char * pPath,
+                          uint32_t sizeMb,
+                          Sig256_t * pSignature,
+                          int dropCache )
+{
+    double throughput = -1.0;
+    OtaFileContext_t fileContext;
+    OtaPalStatus_t result;
+    uint64_t startUs;
+    uint64_t elapsedUs;
+    int fd;
+
+    if( dropCache != 0 )
+    {
+        fd = open( pPath, O_RDONLY );
+
+        if( fd >= 0 )
+        {
+            ( void ) posix_fadvise( fd, 0, 0, POSIX_FADV_DONTNEED );
+            ( void ) close( fd );
+        }
+    }
+
+    ( void ) memset( &fileContext, 0, sizeof( fileContext ) );
+    fileContext.pFilePath = ( uint8_t * ) pPath;
+    fileContext.pCertFilepath = ( uint8_t * ) SIGNER_CERT_PATH;
+    fileContext.pSignature = pSignature;
+    fileContext.fileSize = sizeMb * ONE_MB;
+    fileContext.pFile = fopen( pPath, "r+b" );
+
+    if( fileContext.pFile != NULL )
+    {
+        startUs = Clock_GetTimeUs64();
+        result = otaPal_CloseFile( &fileContext );
+        elapsedUs = Clock_GetTimeUs64() - startUs;
+
+        if( OTA_PAL_MAIN_ERR( result ) == OtaPalSuccess )
+        {
+            throughput = ( ( double ) sizeMb * ONE_SEC_TO_US ) / ( double ) ( elapsedUs + 1U );
+        }
+    }
+
+    return throughput;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    int status = EXIT_SUCCESS;
+    uint32_t maxSizeMb = DEFAULT_MAX_FILE_SIZE_MB;
+    char directory[] = "ota_pal_benchmark.XXXXXX";
+    Sig256_t signature;
+    EVP_PKEY * pKey = NULL;
+    FILE * pKeyFile = NULL;
+    double coldThroughput, warmThroughput;
+    size_t i;
+
+    if( argc > 1 )
+    {
+        maxSizeMb = ( uint32_t ) strtoul( argv[ 1 ], NULL, 10 );
+    }
+
+    pKeyFile = fopen( SIGNER_KEY_PATH, "r" );
+
+    if( pKeyFile != NULL )
+    {
+        pKey = PEM_read_PrivateKey( pKeyFile, NULL, NULL, NULL );
+        ( void ) fclose( pKeyFile );
+    }
+
+    if( pKey == NULL )
+    {
+        fprintf( stderr, "Failed to read the signing key %s.\n", SIGNER_KEY_PATH );
+        status = EXIT_FAILURE;
+    }
+    else if( mkdtemp( directory ) == NULL )
+    {
+        fprintf( stderr, "Failed to create a temporary directory: %s\n", strerror( errno ) );
+        status = EXIT_FAILURE;
+    }
+    else if( chdir( directory ) != 0 )
+    {
+        fprintf( stderr, "Failed to enter the temporary directory: %s\n", strerror( errno ) );
+        status = EXIT_FAILURE;
+    }
+    else
+    {
+        printf( "%-10s %10s %16s %16s\n", "variant", "size (MB)", "uncached (MB/s)", "cached (MB/s)" );
+
+        for( i = 0U; ( i < ( sizeof( fileSizesMb ) / sizeof( fileSizesMb[ 0 ] ) ) ) && ( fileSizesMb[ i ] <= maxSizeMb ); i++ )
+        {
+            if( writeSignedFile( RECEIVED_FILE_NAME, fileSizesMb[ i ], pKey, &signature ) != 0 )
+            {
+                fprintf( stderr, "Failed to write a %u MB file: %s\n", ( unsigned int ) fileSizesMb[ i ], strerror( errno ) );
+                status = EXIT_FAILURE;
+            }
+            else
+            {
+                coldThroughput = verifyFile( RECEIVED_FILE_NAME, fileSizesMb[ i ], &signature, 1 );
+                warmThroughput = verifyFile( RECEIVED_FILE_NAME, fileSizesMb[ i ], &signature, 0 );
+
+                if( ( coldThroughput < 0.0 ) || ( warmThroughput < 0.0 ) )
+                {
+                    fprintf( stderr, "Signature check of the %u MB file failed.\n", ( unsigned int ) fileSizesMb[ i ] );
+                    status = EXIT_FAILURE;
+                }
+
+                printf( "%-10s %10u %16.1f %16.1f\n", OTA_PAL_BENCHMARK_VARIANT_NAME,
+                        ( unsigned int ) fileSizesMb[ i ], coldThroughput, warmThroughput );
+            }
+
+            ( void ) unlink( RECEIVED_FILE_NAME );
+        }
+
+        /* The PAL writes the platform image state file to the working directory. */
+        ( void ) unlink( IMAGE_STATE_FILE_NAME );
+        ( void ) chdir( ".." );
+        ( void ) rmdir( directory );
+    }
+
+    EVP_PKEY_free( pKey );
+
+    return status;
+}
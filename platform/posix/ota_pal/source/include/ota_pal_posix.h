@@ -71,6 +71,10 @@ OtaPalStatus_t otaPal_Abort( OtaFileContext_t * const C );
  * @note The previous image may be present in the designated image download partition or file, so the
  * partition or file must be completely erased or overwritten in this routine.
  *
+ * @note If the receive journal holds blocks of the same transfer from an earlier run, the file
+ * is kept and those blocks are cleared from C->pRxBlockBitmap, so that only the missing blocks
+ * are requested.
+ *
  * @note The input OtaFileContext_t C is checked for NULL by the OTA agent before this
  * function is called.
  * The device file path is a required field in the OTA job document, so C->pFilePath is
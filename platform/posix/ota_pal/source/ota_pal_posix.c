@@ -24,6 +24,11 @@
 
 /* OTA PAL implementation for POSIX platform. */
 
+/* _GNU_SOURCE for fallocate and O_DIRECT. */
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -31,10 +36,17 @@
 #include <assert.h>
 #include <libgen.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "ota.h"
 #include "ota_pal_posix.h"
 
+/* Include clock for timing the signature check. */
+#include "clock.h"
+
 #include <openssl/evp.h>
 #include <openssl/bio.h>
 #include <openssl/x509.h>
@@ -60,16 +72,223 @@ static const char signingcredentialSIGNING_CERTIFICATE_PEM[] = "Paste code signi
  */
 #define OTA_PAL_POSIX_BUF_SIZE           ( ( size_t ) 4096U )
 
+/**
+ * @brief Set to 0 to read the received file with stdio instead of mapping it
+ * when its signature is verified at close.
+ */
+#ifndef OTA_PAL_POSIX_VERIFY_MMAP
+    #define OTA_PAL_POSIX_VERIFY_MMAP    1
+#endif
+
+/**
+ * @brief Number of bytes of the mapped file added to the digest per update.
+ */
+#define OTA_PAL_POSIX_MMAP_CHUNK_SIZE    ( ( size_t ) 1024U * 1024U )
+
+/**
+ * @brief Set to 1 to write blocks to the receive file with O_DIRECT, bypassing
+ * the page cache, as suits eMMC targets.
+ *
+ * Blocks are copied to a buffer aligned to #OTA_PAL_POSIX_DIRECT_IO_ALIGNMENT
+ * before they are written, and the last block is padded to the alignment.
+ * Direct writes are only used when the OTA block size is a multiple of the
+ * alignment.
+ */
+#ifndef OTA_PAL_POSIX_DIRECT_IO
+    #define OTA_PAL_POSIX_DIRECT_IO    0
+#endif
+
+/**
+ * @brief Alignment of the offset, size and buffer of O_DIRECT writes, which
+ * must be a multiple of the logical block size of the storage.
+ */
+#ifndef OTA_PAL_POSIX_DIRECT_IO_ALIGNMENT
+    #define OTA_PAL_POSIX_DIRECT_IO_ALIGNMENT    ( 4096U )
+#endif
+
+/**
+ * @brief Number of blocks that can be queued for a writer thread, so that
+ * otaPal_WriteBlock returns without waiting for the storage. 0 writes blocks
+ * on the calling thread.
+ *
+ * otaPal_WriteBlock only waits when the queue is full. A block that fails to
+ * be written makes the next otaPal_WriteBlock and otaPal_CloseFile fail.
+ */
+#ifndef OTA_PAL_POSIX_WRITE_BEHIND_DEPTH
+    #define OTA_PAL_POSIX_WRITE_BEHIND_DEPTH    0U
+#endif
+
+/**
+ * @brief Sync the receive file to storage after this many blocks. 0 disables it.
+ *
+ * Blocks written before a sync point survive a crash or power loss, while
+ * blocks written after the last one may be lost. The file is always synced
+ * before its signature is verified in otaPal_CloseFile.
+ */
+#ifndef OTA_PAL_POSIX_SYNC_EVERY_BLOCKS
+    #define OTA_PAL_POSIX_SYNC_EVERY_BLOCKS    0U
+#endif
+
+/**
+ * @brief Sync the receive file to storage after this many bytes. 0 disables it.
+ */
+#ifndef OTA_PAL_POSIX_SYNC_EVERY_BYTES
+    #define OTA_PAL_POSIX_SYNC_EVERY_BYTES    ( 1024U * 1024U )
+#endif
+
 /**
  * @brief Name of the file used for storing platform image state.
  */
 #define OTA_PLATFORM_IMAGE_STATE_FILE    "PlatformImageState.txt"
 
+/**
+ * @brief Name of the journal of the blocks that are on storage, which lets a
+ * transfer resume after the process restarts. Stored next to
+ * OTA_PLATFORM_IMAGE_STATE_FILE.
+ */
+#define OTA_PLATFORM_RX_JOURNAL_FILE     "PlatformRxJournal.bin"
+
+/**
+ * @brief Identifies a receive journal written by this version of the PAL.
+ */
+#define OTA_PAL_RX_JOURNAL_MAGIC         0x4F544A31U
+
 /**
  * @brief Specify the OTA signature algorithm we support on this platform.
  */
 const char OTA_JsonFileSignatureKey[ OTA_FILE_SIG_KEY_STR_MAX_LENGTH ] = "sig-sha256-ecdsa";
 
+/**
+ * @brief State of the signature verification that runs while blocks are written.
+ *
+ * Blocks are added to the digest in file order as they arrive. A block that
+ * arrives ahead of a gap is only marked in the bitmap, and is read back from
+ * the file once the gap is filled. When every block is in the digest,
+ * otaPal_CloseFile() only has to run the final verify.
+ */
+typedef struct OtaPalStreamVerify
+{
+    FILE * pFile;             /**< @brief Receive file the digest belongs to. NULL when inactive. */
+    EVP_MD_CTX * pSigContext; /**< @brief Digest verify context, fed in file order. */
+    EVP_PKEY * pPkey;         /**< @brief Public key of the code signer. */
+    uint8_t * pBlockBitmap;   /**< @brief One bit per block, set once the block is written to the file. */
+    uint8_t * pBlockBuf;      /**< @brief Buffer for reading back blocks received out of order. */
+    uint32_t fileSize;        /**< @brief Size of the file being received. */
+    uint32_t blockCount;      /**< @brief Number of blocks in the file. */
+    uint32_t nextBlock;       /**< @brief Index of the first block not yet added to the digest. */
+} OtaPalStreamVerify_t;
+
+/**
+ * @brief Streaming verification state of the file being received.
+ */
+static OtaPalStreamVerify_t streamVerify;
+
+/**
+ * @brief Writes to the receive file since it was last synced to storage.
+ */
+typedef struct OtaPalSyncState
+{
+    uint32_t blocksSinceSync; /**< @brief Blocks written since the last sync. */
+    uint32_t bytesSinceSync;  /**< @brief Bytes written since the last sync. */
+} OtaPalSyncState_t;
+
+/**
+ * @brief Sync state of the file being received.
+ */
+static OtaPalSyncState_t syncState;
+
+/**
+ * @brief Header of the receive journal. It is followed by one bit per block,
+ * set once the block is on storage.
+ *
+ * The header identifies the transfer. A journal whose header does not match
+ * the file being created is discarded.
+ */
+typedef struct OtaPalRxJournalHeader
+{
+    uint32_t magic;     /**< @brief OTA_PAL_RX_JOURNAL_MAGIC. */
+    uint32_t fileSize;  /**< @brief Size of the file being received. */
+    uint32_t blockSize; /**< @brief Size of the blocks the bitmap refers to. */
+    Sig256_t signature; /**< @brief Signature of the file being received. */
+} OtaPalRxJournalHeader_t;
+
+/**
+ * @brief Receive journal of the file being received.
+ *
+ * The bitmap is saved after each sync of the receive file, so every block
+ * marked in the journal is on storage. Bits are only ever set, so a save that
+ * is cut short by a crash still leaves a valid bitmap.
+ */
+typedef struct OtaPalRxJournal
+{
+    FILE * pFile;                              /**< @brief Receive file the journal belongs to. NULL when inactive. */
+    int fd;                                    /**< @brief Descriptor of the journal file, -1 when closed. */
+    uint8_t * pBlockBitmap;                    /**< @brief One bit per block, set once the block is written. */
+    uint32_t fileSize;                         /**< @brief Size of the file being received. */
+    uint32_t blockCount;                       /**< @brief Number of blocks in the file. */
+    bool dirty;                                /**< @brief Blocks were written since the bitmap was last saved. */
+    char filePath[ OTA_FILE_PATH_LENGTH_MAX ]; /**< @brief Absolute path of the journal file. */
+} OtaPalRxJournal_t;
+
+/**
+ * @brief Receive journal of the file being received.
+ */
+static OtaPalRxJournal_t rxJournal = { NULL, -1, NULL, 0U, 0U, false, { 0 } };
+
+#if ( OTA_PAL_POSIX_WRITE_BEHIND_DEPTH > 0U )
+
+/**
+ * @brief A block waiting to be written by the writer thread.
+ */
+    typedef struct OtaPalQueuedBlock
+    {
+        uint32_t offset;                      /**< @brief Byte offset of the block in the file. */
+        uint32_t size;                        /**< @brief Number of bytes in the block. */
+        uint8_t data[ OTA_FILE_BLOCK_SIZE ]; /**< @brief Copy of the block. */
+    } OtaPalQueuedBlock_t;
+
+/**
+ * @brief Queue of blocks written to the receive file by a writer thread.
+ */
+    typedef struct OtaPalWriteBehind
+    {
+        FILE * pFile;            /**< @brief Receive file the blocks are written to. NULL when inactive. */
+        pthread_t thread;        /**< @brief Writer thread. */
+        pthread_mutex_t lock;    /**< @brief Protects the fields below. */
+        pthread_cond_t changed;  /**< @brief Signalled when a block is queued or written, or on stop. */
+        uint32_t head;           /**< @brief Index of the oldest queued block. */
+        uint32_t count;          /**< @brief Number of queued blocks, including the one being written. */
+        bool writing;            /**< @brief The writer thread is writing the oldest block. */
+        bool stop;               /**< @brief The writer thread exits once the queue is empty. */
+        int writeError;          /**< @brief errno of the first failed write or sync, 0 if none. */
+        OtaPalQueuedBlock_t blocks[ OTA_PAL_POSIX_WRITE_BEHIND_DEPTH ]; /**< @brief Ring of queued blocks. */
+    } OtaPalWriteBehind_t;
+
+/**
+ * @brief Writer thread of the file being received.
+ */
+    static OtaPalWriteBehind_t writeBehind;
+#endif /* if ( OTA_PAL_POSIX_WRITE_BEHIND_DEPTH > 0U ) */
+
+#if ( OTA_PAL_POSIX_DIRECT_IO != 0 )
+
+/**
+ * @brief Descriptor the receive file is written through with O_DIRECT.
+ */
+    typedef struct OtaPalDirectWriter
+    {
+        FILE * pFile;      /**< @brief Receive file the descriptor writes to. NULL when inactive. */
+        int fd;            /**< @brief Descriptor of the receive file opened with O_DIRECT. */
+        uint8_t * pBuf;    /**< @brief Aligned buffer blocks are copied to before they are written. */
+        uint32_t fileSize; /**< @brief Size of the file, which the padding of the last block goes past. */
+    } OtaPalDirectWriter_t;
+
+/**
+ * @brief O_DIRECT writer of the file being received.
+ */
+    static OtaPalDirectWriter_t directWriter = { NULL, -1, NULL, 0U };
+#endif /* if ( OTA_PAL_POSIX_DIRECT_IO != 0 ) */
+
 /**
  * @brief Read the specified signer certificate from the filesystem into a local buffer. The allocated
  * memory becomes the property of the caller who is responsible for freeing it.
@@ -84,6 +303,20 @@ static OtaPalMainStatus_t Openssl_DigestVerify( EVP_MD_CTX * pSigContext,
                                                 FILE * pFile,
                                                 Sig256_t * pSignature );
 
+/**
+ * @brief Add the whole file to the digest through a read-only mapping.
+ *
+ * @param[in] pSigContext Digest verify context.
+ * @param[in] pFile File to add, with no buffered writes left in the stream.
+ * @param[out] pDigested Set to true if every byte of the file was added to the digest.
+ *
+ * @return true if the file was mapped, false if it could not be and should be
+ * read instead.
+ */
+static bool Openssl_DigestVerifyUpdateMapped( EVP_MD_CTX * pSigContext,
+                                              FILE * pFile,
+                                              bool * pDigested );
+
 /**
  * @brief Verify the signature of the specified file using OpenSSL.
  */
@@ -98,6 +331,207 @@ static OtaPalStatus_t otaPal_CheckFileSignature( OtaFileContext_t * const C );
 static OtaPalPathGenStatus_t getFilePathFromCWD( char * realFilePath,
                                                  const char * pFilePath );
 
+/**
+ * @brief Allocate the whole receive file, so that a file that does not fit is
+ * rejected before any block is received and the file system can lay it out
+ * contiguously.
+ *
+ * @param[in] C OTA file context information, with the file open.
+ *
+ * @return OtaPalSuccess, or OtaPalRxFileTooLarge after closing the file if
+ * there is not enough space for it.
+ */
+static OtaPalStatus_t reserveFileSpace( OtaFileContext_t * const C );
+
+/**
+ * @brief Write a whole buffer to a file descriptor at the given offset.
+ *
+ * @return true if every byte was written.
+ */
+static bool writeFileAt( int fd,
+                         const uint8_t * pData,
+                         size_t size,
+                         off_t offset );
+
+/**
+ * @brief Write a block to the receive file, with O_DIRECT if it is enabled,
+ * and sync the file if a sync point is reached.
+ *
+ * @return true if the whole block was written, and synced if due.
+ */
+static bool writeBlockToFile( FILE * pFile,
+                              uint32_t offset,
+                              const uint8_t * pData,
+                              uint32_t blockSize );
+
+/**
+ * @brief Sync the data of the receive file to storage.
+ *
+ * @return true on success.
+ */
+static bool syncFile( FILE * pFile );
+
+#if ( OTA_PAL_POSIX_WRITE_BEHIND_DEPTH > 0U )
+
+/**
+ * @brief Start the writer thread of a new receive file. Blocks are written on
+ * the calling thread if it fails.
+ */
+    static void writeBehindStart( FILE * pFile );
+
+/**
+ * @brief Queue a block for the writer thread, waiting while the queue is full.
+ *
+ * @return false if a previous block failed to be written.
+ */
+    static bool writeBehindQueue( uint32_t offset,
+                                  const uint8_t * pData,
+                                  uint32_t blockSize );
+
+/**
+ * @brief Wait until every queued block is written.
+ *
+ * @return errno of the first failed write or sync, 0 if none.
+ */
+    static int writeBehindDrain( void );
+
+/**
+ * @brief Stop the writer thread.
+ *
+ * @param[in] discard Drop the queued blocks instead of writing them.
+ *
+ * @return errno of the first failed write or sync, 0 if none.
+ */
+    static int writeBehindStop( bool discard );
+
+/**
+ * @brief Writer thread, which writes the queued blocks in order.
+ */
+    static void * writeBehindThread( void * pArgs );
+#endif /* if ( OTA_PAL_POSIX_WRITE_BEHIND_DEPTH > 0U ) */
+
+#if ( OTA_PAL_POSIX_DIRECT_IO != 0 )
+
+/**
+ * @brief Open a second descriptor of the receive file with O_DIRECT to write
+ * blocks through. Blocks are written through the page cache if it fails.
+ *
+ * @param[in] C OTA file context information, with the file open.
+ * @param[in] pFilePath Absolute path of the receive file.
+ */
+    static void directWriterStart( OtaFileContext_t * const C,
+                                   const char * pFilePath );
+
+/**
+ * @brief Close the O_DIRECT descriptor and cut off the padding of the last block.
+ *
+ * @return false if the file could not be truncated to its size.
+ */
+    static bool directWriterStop( void );
+#endif /* if ( OTA_PAL_POSIX_DIRECT_IO != 0 ) */
+
+/**
+ * @brief Open the receive journal and load the blocks of an earlier run of
+ * the same transfer.
+ *
+ * Any journal left open by a previous transfer is closed first. A transfer
+ * runs without a journal if it cannot be opened.
+ *
+ * @param[in] C OTA file context information, before the file is opened.
+ * @param[in] resumable false to start a new journal even if there is one for
+ * this transfer.
+ *
+ * @return true if the journal holds blocks of this transfer, so the receive
+ * file must be opened without truncating it.
+ */
+static bool rxJournalOpen( OtaFileContext_t * const C,
+                           bool resumable );
+
+/**
+ * @brief Start journaling the blocks of a receive file that is open.
+ *
+ * A resumed journal has the blocks that are already on storage cleared from
+ * the block bitmap of the OTA agent, so that only the missing blocks are
+ * requested. A new journal is written out with an empty bitmap.
+ *
+ * @param[in] C OTA file context information, with the file open.
+ * @param[in] resume Value returned by rxJournalOpen().
+ */
+static void rxJournalStart( OtaFileContext_t * const C,
+                            bool resume );
+
+/**
+ * @brief Mark a block as written to the receive file. It is saved to the
+ * journal at the next sync.
+ */
+static void rxJournalMarkBlock( FILE * pFile,
+                                uint32_t offset,
+                                uint32_t blockSize );
+
+/**
+ * @brief Save the blocks marked since the last save. Called once the receive
+ * file is synced, so that only blocks on storage are recorded.
+ */
+static void rxJournalSave( FILE * pFile );
+
+/**
+ * @brief Close the receive journal.
+ *
+ * @param[in] remove Delete the journal file, once the transfer is complete.
+ */
+static void rxJournalStop( bool remove );
+
+/**
+ * @brief Start verifying the signature of a new receive file as its blocks are written.
+ *
+ * Streaming verification is skipped, and otaPal_CloseFile() reads back the whole
+ * file instead, when the file size is unknown or the signer certificate cannot
+ * be loaded.
+ */
+static void streamVerifyStart( OtaFileContext_t * const C );
+
+/**
+ * @brief Add a block that has been written to the file to the streaming digest.
+ *
+ * @param[in] C OTA file context information.
+ * @param[in] offset Byte offset of the block in the file.
+ * @param[in] pData Block data.
+ * @param[in] blockSize Number of bytes in the block.
+ */
+static void streamVerifyAddBlock( OtaFileContext_t * const C,
+                                  uint32_t offset,
+                                  const uint8_t * pData,
+                                  uint32_t blockSize );
+
+/**
+ * @brief Add the blocks that are marked in the bitmap and follow the digest,
+ * reading them back from the file.
+ *
+ * @return false if a block could not be read or added to the digest.
+ */
+static bool streamVerifyCatchUp( OtaFileContext_t * const C );
+
+/**
+ * @brief Add the blocks that an earlier run wrote to the file to the streaming digest.
+ *
+ * @param[in] C OTA file context information.
+ * @param[in] pBlockBitmap One bit per block present in the file.
+ */
+static void streamVerifyResume( OtaFileContext_t * const C,
+                                const uint8_t * pBlockBitmap );
+
+/**
+ * @brief Run the final verify of a file whose blocks are all in the streaming digest.
+ *
+ * @return OtaPalSuccess if the signature is valid, OtaPalSignatureCheckFailed otherwise.
+ */
+static OtaPalStatus_t streamVerifyFinish( OtaFileContext_t * const C );
+
+/**
+ * @brief Release the streaming verification state.
+ */
+static void streamVerifyStop( void );
+
 /*-----------------------------------------------------------*/
 
 static EVP_PKEY * Openssl_GetPkeyFromCertificate( uint8_t * pCertFilePath )
@@ -250,6 +684,63 @@ static bool Openssl_DigestVerifyUpdate( EVP_MD_CTX * pSigContext,
     return( 0 != feof( pFile ) ? true : false );
 }
 
+static bool Openssl_DigestVerifyUpdateMapped( EVP_MD_CTX * pSigContext,
+                                              FILE * pFile,
+                                              bool * pDigested )
+{
+    bool mapped = false;
+    struct stat fileStat;
+    uint8_t * pMapping = NULL;
+    size_t fileSize = 0U;
+    size_t offset = 0U;
+    size_t chunkSize;
+
+    ( void ) memset( &fileStat, 0, sizeof( fileStat ) );
+
+    /* POSIX port using standard library */
+    /* coverity[misra_c_2012_rule_21_6_violation] */
+    if( ( OTA_PAL_POSIX_VERIFY_MMAP != 0 ) &&
+        ( 0 == fstat( fileno( pFile ), &fileStat ) ) &&
+        ( fileStat.st_size > 0 ) &&
+        ( ( uintmax_t ) fileStat.st_size <= ( uintmax_t ) SIZE_MAX ) )
+    {
+        fileSize = ( size_t ) fileStat.st_size;
+        pMapping = mmap( NULL, fileSize, PROT_READ, MAP_SHARED, fileno( pFile ), 0 );
+
+        if( pMapping == MAP_FAILED )
+        {
+            LogDebug( ( "Failed to map the file, reading it instead: %s", strerror( errno ) ) );
+            pMapping = NULL;
+        }
+    }
+
+    if( pMapping != NULL )
+    {
+        mapped = true;
+        *pDigested = true;
+
+        /* The mapping is read once from start to end. */
+        ( void ) madvise( pMapping, fileSize, MADV_SEQUENTIAL );
+
+        while( ( offset < fileSize ) && ( *pDigested == true ) )
+        {
+            chunkSize = fileSize - offset;
+
+            if( chunkSize > OTA_PAL_POSIX_MMAP_CHUNK_SIZE )
+            {
+                chunkSize = OTA_PAL_POSIX_MMAP_CHUNK_SIZE;
+            }
+
+            *pDigested = ( 1 == EVP_DigestVerifyUpdate( pSigContext, &pMapping[ offset ], chunkSize ) );
+            offset += chunkSize;
+        }
+
+        ( void ) munmap( pMapping, fileSize );
+    }
+
+    return mapped;
+}
+
 static OtaPalMainStatus_t Openssl_DigestVerify( EVP_MD_CTX * pSigContext,
                                                 EVP_PKEY * pPkey,
                                                 FILE * pFile,
@@ -268,9 +759,15 @@ static OtaPalMainStatus_t Openssl_DigestVerify( EVP_MD_CTX * pSigContext,
         /* coverity[misra_c_2012_rule_21_6_violation] */
         if( fseek( pFile, 0L, SEEK_SET ) == 0 )
         {
-            bool eof = Openssl_DigestVerifyUpdate( pSigContext, pFile, pBuf );
+            bool digested = false;
 
-            if( ( eof == true ) && ( 1 == EVP_DigestVerifyFinal( pSigContext,
+            /* The seek flushed any buffered writes, so the mapping sees the whole file. */
+            if( Openssl_DigestVerifyUpdateMapped( pSigContext, pFile, &digested ) == false )
+            {
+                digested = Openssl_DigestVerifyUpdate( pSigContext, pFile, pBuf );
+            }
+
+            if( ( digested == true ) && ( 1 == EVP_DigestVerifyFinal( pSigContext,
                                                                  pSignature->data,
                                                                  pSignature->size ) ) )
             {
@@ -364,57 +861,823 @@ static OtaPalPathGenStatus_t getFilePathFromCWD( char * pCompleteFilePath,
     return status;
 }
 
-/*-----------------------------------------------------------*/
+static void streamVerifyStart( OtaFileContext_t * const C )
+{
+    assert( streamVerify.pFile == NULL );
 
-OtaPalStatus_t otaPal_Abort( OtaFileContext_t * const C )
+    if( ( C->fileSize > 0U ) && ( C->pCertFilepath != NULL ) )
+    {
+        streamVerify.pPkey = Openssl_GetPkeyFromCertificate( C->pCertFilepath );
+        streamVerify.pSigContext = EVP_MD_CTX_new();
+    }
+
+    if( ( streamVerify.pPkey != NULL ) && ( streamVerify.pSigContext != NULL ) &&
+        ( 1 == EVP_DigestVerifyInit( streamVerify.pSigContext, NULL, EVP_sha256(), NULL, streamVerify.pPkey ) ) )
+    {
+        streamVerify.fileSize = C->fileSize;
+        streamVerify.blockCount = ( uint32_t ) ( ( C->fileSize + ( OTA_FILE_BLOCK_SIZE - 1U ) ) / OTA_FILE_BLOCK_SIZE );
+        streamVerify.nextBlock = 0U;
+        streamVerify.pBlockBitmap = calloc( ( ( size_t ) streamVerify.blockCount + 7U ) / 8U, 1U );
+        streamVerify.pBlockBuf = malloc( OTA_FILE_BLOCK_SIZE );
+    }
+
+    if( ( streamVerify.pBlockBitmap != NULL ) && ( streamVerify.pBlockBuf != NULL ) )
+    {
+        streamVerify.pFile = C->pFile;
+        LogDebug( ( "Verifying the signature of %u blocks as they are received.",
+                    ( unsigned int ) streamVerify.blockCount ) );
+    }
+    else
+    {
+        LogDebug( ( "Signature will be verified when the file is closed." ) );
+        streamVerifyStop();
+    }
+}
+
+static void streamVerifyAddBlock( OtaFileContext_t * const C,
+                                  uint32_t offset,
+                                  const uint8_t * pData,
+                                  uint32_t blockSize )
 {
-    /* Set default return status to uninitialized. */
-    OtaPalMainStatus_t mainErr = OtaPalUninitialized;
-    int32_t subErr = 0;
-    int32_t lFileCloseResult;
+    uint32_t blockIndex = offset / OTA_FILE_BLOCK_SIZE;
+    uint32_t expectedSize = OTA_FILE_BLOCK_SIZE;
+    bool digestOk = true;
 
-    if( NULL != C )
+    if( ( streamVerify.pFile != NULL ) && ( streamVerify.pFile == C->pFile ) )
     {
-        /* Close the OTA update file if it's open. */
-        if( NULL != C->pFile )
+        if( blockIndex == ( streamVerify.blockCount - 1U ) )
         {
-            /* POSIX port using standard library */
-            /* coverity[misra_c_2012_rule_21_6_violation] */
-            lFileCloseResult = fclose( C->pFile );
-            C->pFile = NULL;
+            expectedSize = streamVerify.fileSize - ( blockIndex * OTA_FILE_BLOCK_SIZE );
+        }
 
-            if( 0 == lFileCloseResult )
+        if( ( ( offset % OTA_FILE_BLOCK_SIZE ) != 0U ) ||
+            ( blockIndex >= streamVerify.blockCount ) ||
+            ( blockSize != expectedSize ) )
+        {
+            LogWarn( ( "Block at offset %u does not match the file layout. "
+                       "Signature will be verified when the file is closed.",
+                       ( unsigned int ) offset ) );
+            digestOk = false;
+        }
+        else if( blockIndex == streamVerify.nextBlock )
+        {
+            streamVerify.pBlockBitmap[ blockIndex / 8U ] |= ( uint8_t ) ( 1U << ( blockIndex % 8U ) );
+            digestOk = ( 1 == EVP_DigestVerifyUpdate( streamVerify.pSigContext, pData, blockSize ) );
+            streamVerify.nextBlock++;
+
+            /* Add the blocks that were waiting on this one. */
+            if( digestOk == true )
             {
-                LogInfo( ( "Closed file." ) );
-                mainErr = OtaPalSuccess;
+                digestOk = streamVerifyCatchUp( C );
             }
-            else /* Failed to close file. */
+
+            if( digestOk == false )
             {
-                LogError( ( "Failed to close file." ) );
-                mainErr = OtaPalFileAbort;
-                subErr = errno;
+                LogWarn( ( "Failed to add block %u to the signature digest. "
+                           "Signature will be verified when the file is closed.",
+                           ( unsigned int ) ( streamVerify.nextBlock - 1U ) ) );
             }
         }
         else
         {
-            /* Nothing to do. No open file associated with this context. */
-            mainErr = OtaPalSuccess;
+            /* Ahead of a gap, or a block that was already received. */
+            streamVerify.pBlockBitmap[ blockIndex / 8U ] |= ( uint8_t ) ( 1U << ( blockIndex % 8U ) );
         }
-    }
-    else /* Context was not valid. */
-    {
-        LogError( ( "Parameter check failed: Input is NULL." ) );
-        mainErr = OtaPalFileAbort;
-    }
 
-    return OTA_PAL_COMBINE_ERR( mainErr, subErr );
+        if( digestOk == false )
+        {
+            streamVerifyStop();
+        }
+    }
 }
 
-OtaPalStatus_t otaPal_CreateFileForRx( OtaFileContext_t * const C )
+static bool streamVerifyCatchUp( OtaFileContext_t * const C )
+{
+    uint32_t blockSize;
+    bool digestOk = true;
+
+    #if ( OTA_PAL_POSIX_WRITE_BEHIND_DEPTH > 0U )
+        /* Blocks waiting on the digest may still be queued for the writer thread. */
+        if( ( streamVerify.nextBlock < streamVerify.blockCount ) &&
+            ( ( streamVerify.pBlockBitmap[ streamVerify.nextBlock / 8U ] &
+                ( uint8_t ) ( 1U << ( streamVerify.nextBlock % 8U ) ) ) != 0U ) )
+        {
+            digestOk = ( writeBehindDrain() == 0 );
+        }
+    #endif
+
+    while( ( digestOk == true ) &&
+           ( streamVerify.nextBlock < streamVerify.blockCount ) &&
+           ( ( streamVerify.pBlockBitmap[ streamVerify.nextBlock / 8U ] &
+               ( uint8_t ) ( 1U << ( streamVerify.nextBlock % 8U ) ) ) != 0U ) )
+    {
+        blockSize = OTA_FILE_BLOCK_SIZE;
+
+        if( streamVerify.nextBlock == ( streamVerify.blockCount - 1U ) )
+        {
+            blockSize = streamVerify.fileSize - ( streamVerify.nextBlock * OTA_FILE_BLOCK_SIZE );
+        }
+
+        digestOk = false;
+
+        /* POSIX port using standard library */
+        /* coverity[misra_c_2012_rule_21_6_violation] */
+        if( ( ssize_t ) blockSize == pread( fileno( C->pFile ),
+                                            streamVerify.pBlockBuf,
+                                            blockSize,
+                                            ( off_t ) streamVerify.nextBlock * OTA_FILE_BLOCK_SIZE ) )
+        {
+            digestOk = ( 1 == EVP_DigestVerifyUpdate( streamVerify.pSigContext,
+                                                      streamVerify.pBlockBuf,
+                                                      blockSize ) );
+        }
+
+        streamVerify.nextBlock++;
+    }
+
+    return digestOk;
+}
+
+static void streamVerifyResume( OtaFileContext_t * const C,
+                                const uint8_t * pBlockBitmap )
+{
+    uint32_t i;
+
+    if( ( streamVerify.pFile != NULL ) && ( streamVerify.pFile == C->pFile ) )
+    {
+        for( i = 0U; i < ( ( streamVerify.blockCount + 7U ) / 8U ); i++ )
+        {
+            streamVerify.pBlockBitmap[ i ] |= pBlockBitmap[ i ];
+        }
+
+        if( streamVerifyCatchUp( C ) == false )
+        {
+            LogWarn( ( "Failed to add the blocks already in the file to the signature digest. "
+                       "Signature will be verified when the file is closed." ) );
+            streamVerifyStop();
+        }
+    }
+}
+
+static OtaPalStatus_t streamVerifyFinish( OtaFileContext_t * const C )
+{
+    OtaPalMainStatus_t mainErr = OtaPalSignatureCheckFailed;
+
+    assert( streamVerify.nextBlock == streamVerify.blockCount );
+
+    if( 1 == EVP_DigestVerifyFinal( streamVerify.pSigContext,
+                                    C->pSignature->data,
+                                    C->pSignature->size ) )
+    {
+        mainErr = OtaPalSuccess;
+    }
+    else
+    {
+        LogError( ( "File signature check failed at FINAL" ) );
+    }
+
+    return OTA_PAL_COMBINE_ERR( mainErr, 0 );
+}
+
+static void streamVerifyStop( void )
+{
+    /* Free up objects */
+    EVP_MD_CTX_free( streamVerify.pSigContext );
+    EVP_PKEY_free( streamVerify.pPkey );
+    free( streamVerify.pBlockBitmap );
+    free( streamVerify.pBlockBuf );
+
+    ( void ) memset( &streamVerify, 0, sizeof( streamVerify ) );
+}
+
+static OtaPalStatus_t reserveFileSpace( OtaFileContext_t * const C )
+{
+    OtaPalStatus_t result = OTA_PAL_COMBINE_ERR( OtaPalSuccess, 0 );
+
+    /* POSIX port using standard library */
+    /* coverity[misra_c_2012_rule_21_6_violation] */
+    if( ( C->fileSize > 0U ) && ( 0 != fallocate( fileno( C->pFile ), 0, 0, ( off_t ) C->fileSize ) ) )
+    {
+        if( ( errno == ENOSPC ) || ( errno == EFBIG ) )
+        {
+            LogError( ( "Not enough space for a %u byte file: %s",
+                        ( unsigned int ) C->fileSize, strerror( errno ) ) );
+            result = OTA_PAL_COMBINE_ERR( OtaPalRxFileTooLarge, errno );
+
+            /* POSIX port using standard library */
+            /* coverity[misra_c_2012_rule_21_6_violation] */
+            ( void ) fclose( C->pFile );
+            C->pFile = NULL;
+        }
+        else
+        {
+            /* The file system allocates the blocks as they are written instead. */
+            LogDebug( ( "Failed to allocate the receive file: %s", strerror( errno ) ) );
+        }
+    }
+
+    return result;
+}
+
+static bool writeFileAt( int fd,
+                         const uint8_t * pData,
+                         size_t size,
+                         off_t offset )
+{
+    size_t bytesWritten = 0U;
+    ssize_t writeResult = 1;
+
+    while( ( bytesWritten < size ) && ( writeResult > 0 ) )
+    {
+        writeResult = pwrite( fd, &pData[ bytesWritten ], size - bytesWritten, offset + ( off_t ) bytesWritten );
+
+        if( writeResult > 0 )
+        {
+            bytesWritten += ( size_t ) writeResult;
+        }
+        else if( ( writeResult < 0 ) && ( errno == EINTR ) )
+        {
+            /* Interrupted before anything was written, try again. */
+            writeResult = 1;
+        }
+        else
+        {
+            /* Empty statement. */
+        }
+    }
+
+    return( bytesWritten == size ? true : false );
+}
+
+static bool writeBlockToFile( FILE * pFile,
+                              uint32_t offset,
+                              const uint8_t * pData,
+                              uint32_t blockSize )
+{
+    bool written = false;
+    bool syncDue = false;
+
+    #if ( OTA_PAL_POSIX_DIRECT_IO != 0 )
+        size_t paddedSize;
+
+        if( ( directWriter.pFile != NULL ) && ( directWriter.pFile == pFile ) &&
+            ( ( offset % OTA_PAL_POSIX_DIRECT_IO_ALIGNMENT ) == 0U ) &&
+            ( blockSize <= OTA_FILE_BLOCK_SIZE ) )
+        {
+            /* Only the last block is shorter than the buffer, which is a
+             * multiple of the alignment. Its padding is cut off at close. */
+            paddedSize = ( ( ( size_t ) blockSize + ( OTA_PAL_POSIX_DIRECT_IO_ALIGNMENT - 1U ) ) /
+                           OTA_PAL_POSIX_DIRECT_IO_ALIGNMENT ) * OTA_PAL_POSIX_DIRECT_IO_ALIGNMENT;
+            ( void ) memcpy( directWriter.pBuf, pData, blockSize );
+            ( void ) memset( &directWriter.pBuf[ blockSize ], 0, paddedSize - blockSize );
+
+            written = writeFileAt( directWriter.fd, directWriter.pBuf, paddedSize, ( off_t ) offset );
+        }
+        else
+    #endif /* if ( OTA_PAL_POSIX_DIRECT_IO != 0 ) */
+    {
+        /* POSIX port using standard library */
+        /* coverity[misra_c_2012_rule_21_6_violation] */
+        written = writeFileAt( fileno( pFile ), pData, blockSize, ( off_t ) offset );
+    }
+
+    if( written == true )
+    {
+        rxJournalMarkBlock( pFile, offset, blockSize );
+
+        syncState.blocksSinceSync++;
+        syncState.bytesSinceSync += blockSize;
+
+        #if ( OTA_PAL_POSIX_SYNC_EVERY_BLOCKS > 0U )
+            syncDue = ( syncState.blocksSinceSync >= OTA_PAL_POSIX_SYNC_EVERY_BLOCKS );
+        #endif
+
+        #if ( OTA_PAL_POSIX_SYNC_EVERY_BYTES > 0U )
+            syncDue = syncDue || ( syncState.bytesSinceSync >= OTA_PAL_POSIX_SYNC_EVERY_BYTES );
+        #endif
+
+        if( syncDue == true )
+        {
+            written = syncFile( pFile );
+        }
+    }
+
+    return written;
+}
+
+static bool syncFile( FILE * pFile )
+{
+    bool synced;
+
+    /* POSIX port using standard library */
+    /* coverity[misra_c_2012_rule_21_6_violation] */
+    synced = ( 0 == fdatasync( fileno( pFile ) ) );
+
+    if( synced == true )
+    {
+        syncState.blocksSinceSync = 0U;
+        syncState.bytesSinceSync = 0U;
+        rxJournalSave( pFile );
+    }
+    else
+    {
+        LogError( ( "Failed to sync the receive file: %s", strerror( errno ) ) );
+    }
+
+    return synced;
+}
+
+static bool rxJournalOpen( OtaFileContext_t * const C,
+                           bool resumable )
+{
+    OtaPalRxJournalHeader_t header;
+    OtaPalRxJournalHeader_t expected;
+    size_t bitmapSize;
+    bool resume = false;
+
+    rxJournalStop( false );
+
+    if( ( C->fileSize > 0U ) &&
+        ( getFilePathFromCWD( rxJournal.filePath, OTA_PLATFORM_RX_JOURNAL_FILE ) == OtaPalFileGenSuccess ) )
+    {
+        rxJournal.fileSize = C->fileSize;
+        rxJournal.blockCount = ( uint32_t ) ( ( C->fileSize + ( OTA_FILE_BLOCK_SIZE - 1U ) ) / OTA_FILE_BLOCK_SIZE );
+        bitmapSize = ( ( size_t ) rxJournal.blockCount + 7U ) / 8U;
+        rxJournal.pBlockBitmap = calloc( bitmapSize, 1U );
+
+        /* POSIX port using standard library */
+        /* coverity[misra_c_2012_rule_21_6_violation] */
+        rxJournal.fd = open( rxJournal.filePath, O_RDWR | O_CREAT | O_CLOEXEC, 0600 );
+    }
+
+    if( ( rxJournal.pBlockBitmap != NULL ) && ( rxJournal.fd >= 0 ) )
+    {
+        /* Padding is zeroed, so headers can be compared as a whole. */
+        ( void ) memset( &expected, 0, sizeof( expected ) );
+        expected.magic = OTA_PAL_RX_JOURNAL_MAGIC;
+        expected.fileSize = C->fileSize;
+        expected.blockSize = OTA_FILE_BLOCK_SIZE;
+
+        if( ( C->pSignature != NULL ) && ( C->pSignature->size <= sizeof( expected.signature.data ) ) )
+        {
+            expected.signature.size = C->pSignature->size;
+            ( void ) memcpy( expected.signature.data, C->pSignature->data, C->pSignature->size );
+        }
+
+        /* POSIX port using standard library */
+        /* coverity[misra_c_2012_rule_21_6_violation] */
+        if( ( resumable == true ) &&
+            ( ( ssize_t ) sizeof( header ) == pread( rxJournal.fd, &header, sizeof( header ), 0 ) ) &&
+            ( 0 == memcmp( &header, &expected, sizeof( header ) ) ) &&
+            ( ( ssize_t ) bitmapSize == pread( rxJournal.fd, rxJournal.pBlockBitmap, bitmapSize, ( off_t ) sizeof( header ) ) ) )
+        {
+            resume = true;
+        }
+        else
+        {
+            ( void ) memset( rxJournal.pBlockBitmap, 0, bitmapSize );
+
+            /* Clear the bitmap before the header, so that a crash in between
+             * cannot pair the header of this transfer with blocks of another. */
+            if( ( false == writeFileAt( rxJournal.fd, rxJournal.pBlockBitmap, bitmapSize, ( off_t ) sizeof( header ) ) ) ||
+                ( 0 != fdatasync( rxJournal.fd ) ) ||
+                ( false == writeFileAt( rxJournal.fd, ( const uint8_t * ) &expected, sizeof( expected ), 0 ) ) ||
+                ( 0 != fdatasync( rxJournal.fd ) ) )
+            {
+                LogWarn( ( "Failed to write the receive journal: %s. "
+                           "The transfer cannot be resumed after a restart.", strerror( errno ) ) );
+                rxJournalStop( false );
+            }
+        }
+    }
+    else if( C->fileSize > 0U )
+    {
+        LogWarn( ( "Failed to open the receive journal. "
+                   "The transfer cannot be resumed after a restart." ) );
+        rxJournalStop( false );
+    }
+    else
+    {
+        LogDebug( ( "File size is unknown. The transfer cannot be resumed after a restart." ) );
+    }
+
+    return resume;
+}
+
+static void rxJournalStart( OtaFileContext_t * const C,
+                            bool resume )
+{
+    uint32_t i;
+    uint32_t present = 0U;
+    uint8_t mask;
+
+    if( rxJournal.fd >= 0 )
+    {
+        rxJournal.pFile = C->pFile;
+        rxJournal.dirty = false;
+    }
+
+    if( ( resume == true ) && ( rxJournal.pFile != NULL ) )
+    {
+        for( i = 0U; i < rxJournal.blockCount; i++ )
+        {
+            if( ( rxJournal.pBlockBitmap[ i / 8U ] & ( uint8_t ) ( 1U << ( i % 8U ) ) ) != 0U )
+            {
+                present++;
+            }
+        }
+
+        /* Leave the last block for the OTA agent to request, so that it closes the file. */
+        if( present == rxJournal.blockCount )
+        {
+            i = rxJournal.blockCount - 1U;
+            rxJournal.pBlockBitmap[ i / 8U ] &= ( uint8_t ) ~( 1U << ( i % 8U ) );
+            present--;
+        }
+
+        /* The OTA agent keeps a set bit for each block it still needs. */
+        if( ( C->pRxBlockBitmap != NULL ) &&
+            ( C->blockBitmapMaxSize >= ( ( rxJournal.blockCount + 7U ) / 8U ) ) )
+        {
+            for( i = 0U; i < rxJournal.blockCount; i++ )
+            {
+                mask = ( uint8_t ) ( 1U << ( i % 8U ) );
+
+                if( ( ( rxJournal.pBlockBitmap[ i / 8U ] & mask ) != 0U ) &&
+                    ( ( C->pRxBlockBitmap[ i / 8U ] & mask ) != 0U ) &&
+                    ( C->blocksRemaining > 0U ) )
+                {
+                    C->pRxBlockBitmap[ i / 8U ] &= ( uint8_t ) ~mask;
+                    C->blocksRemaining--;
+                }
+            }
+        }
+
+        LogInfo( ( "Resuming the transfer with %u of %u blocks already received.",
+                   ( unsigned int ) present, ( unsigned int ) rxJournal.blockCount ) );
+
+        streamVerifyResume( C, rxJournal.pBlockBitmap );
+    }
+}
+
+static void rxJournalMarkBlock( FILE * pFile,
+                                uint32_t offset,
+                                uint32_t blockSize )
+{
+    uint32_t blockIndex = offset / OTA_FILE_BLOCK_SIZE;
+    uint32_t expectedSize = OTA_FILE_BLOCK_SIZE;
+
+    if( ( rxJournal.pFile != NULL ) && ( rxJournal.pFile == pFile ) &&
+        ( ( offset % OTA_FILE_BLOCK_SIZE ) == 0U ) && ( blockIndex < rxJournal.blockCount ) )
+    {
+        if( blockIndex == ( rxJournal.blockCount - 1U ) )
+        {
+            expectedSize = rxJournal.fileSize - ( blockIndex * OTA_FILE_BLOCK_SIZE );
+        }
+
+        /* Only whole blocks can be skipped when the transfer resumes. */
+        if( blockSize == expectedSize )
+        {
+            rxJournal.pBlockBitmap[ blockIndex / 8U ] |= ( uint8_t ) ( 1U << ( blockIndex % 8U ) );
+            rxJournal.dirty = true;
+        }
+    }
+}
+
+static void rxJournalSave( FILE * pFile )
+{
+    if( ( rxJournal.pFile != NULL ) && ( rxJournal.pFile == pFile ) && ( rxJournal.dirty == true ) )
+    {
+        if( ( true == writeFileAt( rxJournal.fd,
+                                   rxJournal.pBlockBitmap,
+                                   ( ( size_t ) rxJournal.blockCount + 7U ) / 8U,
+                                   ( off_t ) sizeof( OtaPalRxJournalHeader_t ) ) ) &&
+            ( 0 == fdatasync( rxJournal.fd ) ) )
+        {
+            rxJournal.dirty = false;
+        }
+        else
+        {
+            LogWarn( ( "Failed to save the receive journal: %s. "
+                       "The transfer cannot be resumed after a restart.", strerror( errno ) ) );
+            rxJournalStop( false );
+        }
+    }
+}
+
+static void rxJournalStop( bool remove )
+{
+    if( rxJournal.fd >= 0 )
+    {
+        /* POSIX port using standard library */
+        /* coverity[misra_c_2012_rule_21_6_violation] */
+        ( void ) close( rxJournal.fd );
+
+        if( remove == true )
+        {
+            ( void ) unlink( rxJournal.filePath );
+        }
+    }
+
+    free( rxJournal.pBlockBitmap );
+
+    ( void ) memset( &rxJournal, 0, sizeof( rxJournal ) );
+    rxJournal.fd = -1;
+}
+
+#if ( OTA_PAL_POSIX_WRITE_BEHIND_DEPTH > 0U )
+
+    static void writeBehindStart( FILE * pFile )
+    {
+        assert( writeBehind.pFile == NULL );
+
+        ( void ) memset( &writeBehind, 0, sizeof( writeBehind ) );
+        writeBehind.pFile = pFile;
+
+        if( ( 0 != pthread_mutex_init( &writeBehind.lock, NULL ) ) ||
+            ( 0 != pthread_cond_init( &writeBehind.changed, NULL ) ) ||
+            ( 0 != pthread_create( &writeBehind.thread, NULL, writeBehindThread, NULL ) ) )
+        {
+            writeBehind.pFile = NULL;
+            LogWarn( ( "Failed to start the writer thread. Writing blocks on the OTA agent thread." ) );
+            ( void ) pthread_cond_destroy( &writeBehind.changed );
+            ( void ) pthread_mutex_destroy( &writeBehind.lock );
+        }
+    }
+
+    static bool writeBehindQueue( uint32_t offset,
+                                  const uint8_t * pData,
+                                  uint32_t blockSize )
+    {
+        OtaPalQueuedBlock_t * pBlock;
+        bool queued = false;
+
+        assert( blockSize <= OTA_FILE_BLOCK_SIZE );
+
+        ( void ) pthread_mutex_lock( &writeBehind.lock );
+
+        while( ( writeBehind.count == OTA_PAL_POSIX_WRITE_BEHIND_DEPTH ) && ( writeBehind.writeError == 0 ) )
+        {
+            ( void ) pthread_cond_wait( &writeBehind.changed, &writeBehind.lock );
+        }
+
+        if( writeBehind.writeError == 0 )
+        {
+            pBlock = &writeBehind.blocks[ ( writeBehind.head + writeBehind.count ) % OTA_PAL_POSIX_WRITE_BEHIND_DEPTH ];
+            pBlock->offset = offset;
+            pBlock->size = blockSize;
+            ( void ) memcpy( pBlock->data, pData, blockSize );
+            writeBehind.count++;
+            ( void ) pthread_cond_broadcast( &writeBehind.changed );
+            queued = true;
+        }
+        else
+        {
+            errno = writeBehind.writeError;
+        }
+
+        ( void ) pthread_mutex_unlock( &writeBehind.lock );
+
+        return queued;
+    }
+
+    static int writeBehindDrain( void )
+    {
+        int writeError = 0;
+
+        if( writeBehind.pFile != NULL )
+        {
+            ( void ) pthread_mutex_lock( &writeBehind.lock );
+
+            while( writeBehind.count > 0U )
+            {
+                ( void ) pthread_cond_wait( &writeBehind.changed, &writeBehind.lock );
+            }
+
+            writeError = writeBehind.writeError;
+
+            ( void ) pthread_mutex_unlock( &writeBehind.lock );
+        }
+
+        return writeError;
+    }
+
+    static int writeBehindStop( bool discard )
+    {
+        int writeError = 0;
+
+        if( writeBehind.pFile != NULL )
+        {
+            ( void ) pthread_mutex_lock( &writeBehind.lock );
+
+            if( discard == true )
+            {
+                /* Keep only the block being written, which cannot be taken back. */
+                writeBehind.count = ( writeBehind.writing == true ) ? 1U : 0U;
+            }
+
+            writeBehind.stop = true;
+            ( void ) pthread_cond_broadcast( &writeBehind.changed );
+            ( void ) pthread_mutex_unlock( &writeBehind.lock );
+
+            ( void ) pthread_join( writeBehind.thread, NULL );
+            ( void ) pthread_cond_destroy( &writeBehind.changed );
+            ( void ) pthread_mutex_destroy( &writeBehind.lock );
+
+            writeError = writeBehind.writeError;
+            writeBehind.pFile = NULL;
+        }
+
+        return writeError;
+    }
+
+    static void * writeBehindThread( void * pArgs )
+    {
+        OtaPalQueuedBlock_t * pBlock;
+        bool written;
+
+        ( void ) pArgs;
+
+        ( void ) pthread_mutex_lock( &writeBehind.lock );
+
+        while( ( writeBehind.stop == false ) || ( writeBehind.count > 0U ) )
+        {
+            if( writeBehind.count == 0U )
+            {
+                ( void ) pthread_cond_wait( &writeBehind.changed, &writeBehind.lock );
+            }
+            else
+            {
+                /* The slot stays counted, so it is not reused while it is written. */
+                pBlock = &writeBehind.blocks[ writeBehind.head ];
+                writeBehind.writing = true;
+                ( void ) pthread_mutex_unlock( &writeBehind.lock );
+
+                /* Once a write failed, the remaining blocks are dropped. */
+                written = ( writeBehind.writeError == 0 ) &&
+                          writeBlockToFile( writeBehind.pFile, pBlock->offset, pBlock->data, pBlock->size );
+
+                ( void ) pthread_mutex_lock( &writeBehind.lock );
+
+                if( ( written == false ) && ( writeBehind.writeError == 0 ) )
+                {
+                    LogError( ( "Failed to write the block at offset %u: %s",
+                                ( unsigned int ) pBlock->offset, strerror( errno ) ) );
+                    writeBehind.writeError = ( errno != 0 ) ? errno : EIO;
+                }
+
+                writeBehind.head = ( writeBehind.head + 1U ) % OTA_PAL_POSIX_WRITE_BEHIND_DEPTH;
+                writeBehind.count--;
+                writeBehind.writing = false;
+                ( void ) pthread_cond_broadcast( &writeBehind.changed );
+            }
+        }
+
+        ( void ) pthread_mutex_unlock( &writeBehind.lock );
+
+        return NULL;
+    }
+
+#endif /* if ( OTA_PAL_POSIX_WRITE_BEHIND_DEPTH > 0U ) */
+
+#if ( OTA_PAL_POSIX_DIRECT_IO != 0 )
+
+    static void directWriterStart( OtaFileContext_t * const C,
+                                   const char * pFilePath )
+    {
+        void * pBuf = NULL;
+
+        assert( directWriter.pFile == NULL );
+
+        if( C->fileSize == 0U )
+        {
+            /* The padding of the last block could not be cut off. */
+            LogDebug( ( "File size is unknown. Writing blocks through the page cache." ) );
+        }
+        else if( ( OTA_FILE_BLOCK_SIZE % OTA_PAL_POSIX_DIRECT_IO_ALIGNMENT ) != 0U )
+        {
+            LogWarn( ( "Block size %u is not a multiple of the O_DIRECT alignment %u. "
+                       "Writing blocks through the page cache.",
+                       ( unsigned int ) OTA_FILE_BLOCK_SIZE,
+                       ( unsigned int ) OTA_PAL_POSIX_DIRECT_IO_ALIGNMENT ) );
+        }
+        else if( 0 != posix_memalign( &pBuf, OTA_PAL_POSIX_DIRECT_IO_ALIGNMENT, OTA_FILE_BLOCK_SIZE ) )
+        {
+            LogWarn( ( "Failed to allocate the O_DIRECT buffer. Writing blocks through the page cache." ) );
+        }
+        else
+        {
+            directWriter.fd = open( pFilePath, O_WRONLY | O_DIRECT );
+
+            if( directWriter.fd >= 0 )
+            {
+                directWriter.pFile = C->pFile;
+                directWriter.pBuf = pBuf;
+                directWriter.fileSize = C->fileSize;
+                LogDebug( ( "Writing blocks with O_DIRECT." ) );
+            }
+            else
+            {
+                LogWarn( ( "Failed to open the receive file with O_DIRECT: %s. "
+                           "Writing blocks through the page cache.", strerror( errno ) ) );
+                free( pBuf );
+            }
+        }
+    }
+
+    static bool directWriterStop( void )
+    {
+        bool truncated = true;
+
+        if( directWriter.pFile != NULL )
+        {
+            ( void ) close( directWriter.fd );
+
+            /* POSIX port using standard library */
+            /* coverity[misra_c_2012_rule_21_6_violation] */
+            truncated = ( 0 == ftruncate( fileno( directWriter.pFile ), ( off_t ) directWriter.fileSize ) );
+            free( directWriter.pBuf );
+        }
+
+        directWriter.pFile = NULL;
+        directWriter.fd = -1;
+        directWriter.pBuf = NULL;
+        directWriter.fileSize = 0U;
+
+        return truncated;
+    }
+
+#endif /* if ( OTA_PAL_POSIX_DIRECT_IO != 0 ) */
+
+/*-----------------------------------------------------------*/
+
+OtaPalStatus_t otaPal_Abort( OtaFileContext_t * const C )
+{
+    /* Set default return status to uninitialized. */
+    OtaPalMainStatus_t mainErr = OtaPalUninitialized;
+    int32_t subErr = 0;
+    int32_t lFileCloseResult;
+
+    if( NULL != C )
+    {
+        #if ( OTA_PAL_POSIX_WRITE_BEHIND_DEPTH > 0U )
+            ( void ) writeBehindStop( true );
+        #endif
+
+        /* Keep the journal, so that the transfer resumes if the job is started again. */
+        if( ( rxJournal.pFile != NULL ) && ( rxJournal.pFile == C->pFile ) )
+        {
+            ( void ) syncFile( C->pFile );
+        }
+
+        rxJournalStop( false );
+        streamVerifyStop();
+
+        #if ( OTA_PAL_POSIX_DIRECT_IO != 0 )
+            ( void ) directWriterStop();
+        #endif
+
+        /* Close the OTA update file if it's open. */
+        if( NULL != C->pFile )
+        {
+            /* POSIX port using standard library */
+            /* coverity[misra_c_2012_rule_21_6_violation] */
+            lFileCloseResult = fclose( C->pFile );
+            C->pFile = NULL;
+
+            if( 0 == lFileCloseResult )
+            {
+                LogInfo( ( "Closed file." ) );
+                mainErr = OtaPalSuccess;
+            }
+            else /* Failed to close file. */
+            {
+                LogError( ( "Failed to close file." ) );
+                mainErr = OtaPalFileAbort;
+                subErr = errno;
+            }
+        }
+        else
+        {
+            /* Nothing to do. No open file associated with this context. */
+            mainErr = OtaPalSuccess;
+        }
+    }
+    else /* Context was not valid. */
+    {
+        LogError( ( "Parameter check failed: Input is NULL." ) );
+        mainErr = OtaPalFileAbort;
+    }
+
+    return OTA_PAL_COMBINE_ERR( mainErr, subErr );
+}
+
+OtaPalStatus_t otaPal_CreateFileForRx( OtaFileContext_t * const C )
 {
     OtaPalStatus_t result = OTA_PAL_COMBINE_ERR( OtaPalUninitialized, 0 );
     char realFilePath[ OTA_FILE_PATH_LENGTH_MAX ];
     OtaPalPathGenStatus_t status = OtaPalFileGenSuccess;
+    bool resume = false;
 
     if( C != NULL )
     {
@@ -431,20 +1694,59 @@ OtaPalStatus_t otaPal_CreateFileForRx( OtaFileContext_t * const C )
 
             if( status == OtaPalFileGenSuccess )
             {
+                #if ( OTA_PAL_POSIX_WRITE_BEHIND_DEPTH > 0U )
+                    ( void ) writeBehindStop( true );
+                #endif
+
+                resume = rxJournalOpen( C, true );
+
                 /* POSIX port using standard library */
                 /* coverity[misra_c_2012_rule_21_6_violation] */
-                C->pFile = fopen( ( const char * ) realFilePath, "w+b" );
+                C->pFile = fopen( ( const char * ) realFilePath, ( resume == true ) ? "r+b" : "w+b" );
+
+                if( ( C->pFile == NULL ) && ( resume == true ) )
+                {
+                    LogWarn( ( "Failed to reopen the partially received file. Receiving all of it." ) );
+                    resume = rxJournalOpen( C, false );
+
+                    /* POSIX port using standard library */
+                    /* coverity[misra_c_2012_rule_21_6_violation] */
+                    C->pFile = fopen( ( const char * ) realFilePath, "w+b" );
+                }
 
                 if( C->pFile != NULL )
                 {
-                    result = OTA_PAL_COMBINE_ERR( OtaPalSuccess, 0 );
-                    LogInfo( ( "Receive file created." ) );
+                    result = reserveFileSpace( C );
                 }
                 else
                 {
                     result = OTA_PAL_COMBINE_ERR( OtaPalRxFileCreateFailed, errno );
                     LogError( ( "Failed to start operation: Operation already started. failed to open -- %s Path ", C->pFilePath ) );
                 }
+
+                if( OTA_PAL_MAIN_ERR( result ) == OtaPalSuccess )
+                {
+                    LogInfo( ( "Receive file created." ) );
+
+                    streamVerifyStop();
+                    streamVerifyStart( C );
+
+                    #if ( OTA_PAL_POSIX_DIRECT_IO != 0 )
+                        ( void ) directWriterStop();
+                        directWriterStart( C, realFilePath );
+                    #endif
+
+                    ( void ) memset( &syncState, 0, sizeof( syncState ) );
+                    rxJournalStart( C, resume );
+
+                    #if ( OTA_PAL_POSIX_WRITE_BEHIND_DEPTH > 0U )
+                        writeBehindStart( C->pFile );
+                    #endif
+                }
+                else
+                {
+                    rxJournalStop( false );
+                }
             }
             else
             {
@@ -474,15 +1776,54 @@ OtaPalStatus_t otaPal_CloseFile( OtaFileContext_t * const C )
     OtaPalMainStatus_t mainErr = OtaPalSuccess;
     OtaPalSubStatus_t subErr = 0;
     OtaPalStatus_t result;
+    uint64_t verifyStartUs = 0U;
+    int writeError = 0;
 
     if( C != NULL )
     {
+        #if ( OTA_PAL_POSIX_WRITE_BEHIND_DEPTH > 0U )
+            /* Write the blocks that are still queued. */
+            writeError = writeBehindStop( false );
+        #endif
+
+        #if ( OTA_PAL_POSIX_DIRECT_IO != 0 )
+            if( directWriterStop() == false )
+            {
+                LogError( ( "Failed to truncate the receive file to its size: %s", strerror( errno ) ) );
+                writeError = errno;
+            }
+        #endif
+
+        /* The image is only marked for testing once all of it is on storage. */
+        if( ( writeError == 0 ) && ( syncFile( C->pFile ) == false ) )
+        {
+            writeError = errno;
+        }
+
         if( C->pSignature != NULL )
         {
             /* Verify the file signature, close the file and return the signature verification result. */
-            result = otaPal_CheckFileSignature( C );
+            verifyStartUs = Clock_GetTimeUs64();
+
+            if( ( streamVerify.pFile != NULL ) && ( streamVerify.pFile == C->pFile ) &&
+                ( streamVerify.nextBlock == streamVerify.blockCount ) )
+            {
+                /* Every block is already in the digest. */
+                result = streamVerifyFinish( C );
+            }
+            else
+            {
+                result = otaPal_CheckFileSignature( C );
+            }
+
             mainErr = OTA_PAL_MAIN_ERR( result );
             subErr = OTA_PAL_SUB_ERR( result );
+
+            LogInfo( ( "Signature check of %u byte file took %lu us.",
+                       ( unsigned int ) C->fileSize,
+                       ( unsigned long ) ( Clock_GetTimeUs64() - verifyStartUs ) ) );
+            /* Unused when logs are disabled. */
+            ( void ) verifyStartUs;
         }
         else
         {
@@ -490,6 +1831,17 @@ OtaPalStatus_t otaPal_CloseFile( OtaFileContext_t * const C )
             mainErr = OtaPalSignatureCheckFailed;
         }
 
+        if( writeError != 0 )
+        {
+            LogError( ( "Failed to write the OTA update file to storage." ) );
+            mainErr = OtaPalFileClose;
+            subErr = ( uint32_t ) writeError;
+        }
+
+        /* The transfer is over whether or not the image is valid. */
+        rxJournalStop( true );
+        streamVerifyStop();
+
         /* Close the file. */
         /* POSIX port using standard library */
         /* coverity[misra_c_2012_rule_21_6_violation] */
@@ -535,36 +1887,44 @@ int16_t otaPal_WriteBlock( OtaFileContext_t * const C,
                            uint32_t ulBlockSize )
 {
     int32_t filerc = 0;
-    size_t writeSize = 0;
+    bool written = false;
+    bool writeHere = true;
 
     if( C != NULL )
     {
-        /* POSIX port using standard library */
-        /* coverity[misra_c_2012_rule_21_6_violation] */
-        filerc = fseek( C->pFile, ( int64_t ) ulOffset, SEEK_SET );
+        #if ( OTA_PAL_POSIX_WRITE_BEHIND_DEPTH > 0U )
+            if( ( writeBehind.pFile != NULL ) && ( writeBehind.pFile == C->pFile ) )
+            {
+                if( ulBlockSize <= OTA_FILE_BLOCK_SIZE )
+                {
+                    written = writeBehindQueue( ulOffset, pcData, ulBlockSize );
+                    writeHere = false;
+                }
+                else
+                {
+                    /* Too large to queue. Write it once the writer thread is idle. */
+                    writeHere = ( writeBehindDrain() == 0 );
+                }
+            }
+        #endif /* if ( OTA_PAL_POSIX_WRITE_BEHIND_DEPTH > 0U ) */
 
-        if( 0 == filerc )
+        if( writeHere == true )
         {
-            /* POSIX port using standard library */
-            /* coverity[misra_c_2012_rule_21_6_violation] */
-            writeSize = fwrite( pcData, 1, ulBlockSize, C->pFile );
+            written = writeBlockToFile( C->pFile, ulOffset, pcData, ulBlockSize );
+        }
 
-            if( writeSize != ulBlockSize )
-            {
-                LogError( ( "Failed to write block to file: "
-                            "fwrite returned error: "
-                            "errno=%d", errno ) );
+        if( written == true )
+        {
+            filerc = ( int32_t ) ulBlockSize;
 
-                filerc = -1;
-            }
-            else
-            {
-                filerc = ( int32_t ) writeSize;
-            }
+            streamVerifyAddBlock( C, ulOffset, pcData, ulBlockSize );
         }
         else
         {
-            LogError( ( "fseek failed. fseek returned errno = %d", errno ) );
+            LogError( ( "Failed to write block to file: "
+                        "pwrite returned error: "
+                        "errno=%d", errno ) );
+
             filerc = -1;
         }
     }
@@ -70,4 +70,11 @@ extern size_t fwrite_alias( const void * __restrict __ptr,
                             size_t __n,
                             _STDIO_FILE_TYPE * __restrict __s );
 
+/* The "fileno" function needs to be mocked to test the OTA PAL. This function
+ * can't be directly mocked because it's required by the coverage tools. To get
+ * around this, the "fileno" function is defined as "fileno_alias" in the test
+ * config file. This replaces the calls to fileno in the OTA PAL with calls to
+ * this "fileno_alias" function. */
+extern int fileno_alias( _STDIO_FILE_TYPE * __stream );
+
 #endif /* ifndef STDIO_API_H */
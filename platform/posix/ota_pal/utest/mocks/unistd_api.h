@@ -23,7 +23,25 @@
 #ifndef UNISTD_API_H
 #define UNISTD_API_H
 
+#include <sys/types.h>
+
 extern char * getcwd( char * buf,
                       size_t size );
 
+extern ssize_t pwrite( int fd,
+                       const void * buf,
+                       size_t count,
+                       off_t offset );
+
+extern ssize_t pread( int fd,
+                      void * buf,
+                      size_t count,
+                      off_t offset );
+
+extern int fdatasync( int fd );
+
+extern int close( int fd );
+
+extern int unlink( const char * pathname );
+
 #endif /* ifndef UNISTD_API_H */
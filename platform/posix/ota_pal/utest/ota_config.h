@@ -148,6 +148,12 @@
 
 #define configOTA_PRIMARY_DATA_PROTOCOL    ( OTA_DATA_OVER_MQTT )
 
+/**
+ * @brief Sync the receive file every two blocks, so that the unit tests reach
+ * a sync point with small blocks.
+ */
+#define OTA_PAL_POSIX_SYNC_EVERY_BLOCKS    2U
+
 /* The "fseek" function needs to be mocked to test the OTA PAL. This function
  * can't be directly mocked because it's required by the coverage tools. As an
  * alternative, this define replaces the fseek calls in the OTA PAL
@@ -164,4 +170,20 @@
  * "fwrite". The function declaration for this alias is in "stdio_api.h". */
 #define fwrite                             fwrite_alias
 
+/* The "fileno" function needs to be mocked to test the OTA PAL. This function
+ * can't be directly mocked because it's required by the coverage tools. As an
+ * alternative, this define replaces the fileno calls in the OTA PAL
+ * implementation with "fileno_alias". This "fileno_alias" function is declared
+ * with an identical function signature to "fileno" and is mocked in place of
+ * "fileno". The function declaration for this alias is in "stdio_api.h". */
+#define fileno                             fileno_alias
+
+/* The "open" function needs to be mocked to test the OTA PAL. This function
+ * can't be directly mocked because it takes a variable number of arguments. As
+ * an alternative, this define replaces the open calls in the OTA PAL
+ * implementation with "open_alias". This "open_alias" function is declared
+ * with the three arguments the OTA PAL passes to "open" and is mocked in place
+ * of "open". The function declaration for this alias is in "fcntl_api.h". */
+#define open                               open_alias
+
 #endif /* _OTA_CONFIG_H_ */
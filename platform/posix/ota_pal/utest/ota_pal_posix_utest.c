@@ -38,6 +38,9 @@
 #include "mock_stdio_api.h"
 #include "mock_openssl_api.h"
 #include "mock_unistd_api.h"
+#include "mock_mman_api.h"
+#include "mock_stat_api.h"
+#include "mock_fcntl_api.h"
 
 /* errno error macro. errno.h can't be included in this file due to mocking. */
 #define ENOENT    0x02
@@ -450,6 +453,7 @@ void test_OTAPAL_CreateFileForRx_FailedToCreateFile( void )
     FILE placeholder_file;
     OtaFileContext_t testFile;
 
+    ( void ) memset( &testFile, 0, sizeof( testFile ) );
     testFile.pFilePath = ( uint8_t * ) "placeholder_path";
     testFile.pFile = &placeholder_file;
 
@@ -469,6 +473,7 @@ void test_OTAPAL_CreateFileForRx_ValidFileHandle( void )
     FILE placeholder_file;
     OtaFileContext_t otaFileContext;
 
+    ( void ) memset( &otaFileContext, 0, sizeof( otaFileContext ) );
     otaFileContext.pFilePath = ( uint8_t * ) "placeholder_path";
 
     OTA_PAL_FailSingleMock_unistd( none_fn );
@@ -477,6 +482,146 @@ void test_OTAPAL_CreateFileForRx_ValidFileHandle( void )
     TEST_ASSERT_EQUAL( OtaPalSuccess, result );
 }
 
+/**
+ * @brief Test that otaPal_CreateFileForRx allocates the whole file.
+ */
+void test_OTAPAL_CreateFileForRx_AllocatesFile( void )
+{
+    OtaPalMainStatus_t result;
+    FILE placeholder_file;
+    OtaFileContext_t otaFileContext;
+
+    ( void ) memset( &otaFileContext, 0, sizeof( otaFileContext ) );
+    otaFileContext.pFilePath = ( uint8_t * ) "/placeholder_path";
+    otaFileContext.fileSize = 12345U;
+
+    fopen_ExpectAnyArgsAndReturn( &placeholder_file );
+    fileno_alias_IgnoreAndReturn( 3 );
+    fallocate_ExpectAndReturn( 3, 0, 0, 12345, 0 );
+    result = OTA_PAL_MAIN_ERR( otaPal_CreateFileForRx( &otaFileContext ) );
+    TEST_ASSERT_EQUAL( OtaPalSuccess, result );
+}
+
+/**
+ * @brief Layout of the receive journal header written by the OTA PAL.
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t fileSize;
+    uint32_t blockSize;
+    Sig256_t signature;
+} JournalHeader_t;
+
+/**
+ * @brief Fill in the receive journal header of a transfer.
+ */
+static void OTA_PAL_SetJournalHeader( JournalHeader_t * pHeader,
+                                      const OtaFileContext_t * pFileContext )
+{
+    ( void ) memset( pHeader, 0, sizeof( *pHeader ) );
+    pHeader->magic = 0x4F544A31U;
+    pHeader->fileSize = pFileContext->fileSize;
+    pHeader->blockSize = OTA_FILE_BLOCK_SIZE;
+    pHeader->signature.size = pFileContext->pSignature->size;
+    ( void ) memcpy( pHeader->signature.data, pFileContext->pSignature->data, pFileContext->pSignature->size );
+}
+
+/**
+ * @brief Test that otaPal_CreateFileForRx reports the blocks of an earlier
+ * run of the transfer to the OTA agent, and keeps them in the file.
+ */
+void test_OTAPAL_CreateFileForRx_ResumesTransfer( void )
+{
+    OtaPalMainStatus_t result;
+    FILE placeholder_file;
+    OtaFileContext_t otaFileContext;
+    Sig256_t dummySig;
+    JournalHeader_t header;
+    uint8_t rxBlockBitmap = 0x0FU;
+    uint8_t journalBitmap = 0x05U;
+
+    ( void ) memset( &otaFileContext, 0, sizeof( otaFileContext ) );
+    ( void ) memset( &dummySig, 0xA5, sizeof( dummySig ) );
+    dummySig.size = 4U;
+    otaFileContext.pFilePath = ( uint8_t * ) "/placeholder_path";
+    otaFileContext.pSignature = &dummySig;
+    otaFileContext.fileSize = ( 3U * OTA_FILE_BLOCK_SIZE ) + 1U;
+    otaFileContext.pRxBlockBitmap = &rxBlockBitmap;
+    otaFileContext.blockBitmapMaxSize = sizeof( rxBlockBitmap );
+    otaFileContext.blocksRemaining = 4U;
+    OTA_PAL_SetJournalHeader( &header, &otaFileContext );
+
+    OTA_PAL_FailSingleMock_unistd( none_fn );
+    open_alias_ExpectAnyArgsAndReturn( 5 );
+    pread_ExpectAndReturn( 5, NULL, sizeof( header ), 0, sizeof( header ) );
+    pread_IgnoreArg_buf();
+    pread_ReturnMemThruPtr_buf( &header, sizeof( header ) );
+    pread_ExpectAndReturn( 5, NULL, 1U, sizeof( header ), 1 );
+    pread_IgnoreArg_buf();
+    pread_ReturnMemThruPtr_buf( &journalBitmap, 1U );
+    fopen_ExpectAndReturn( "/placeholder_path", "r+b", &placeholder_file );
+    result = OTA_PAL_MAIN_ERR( otaPal_CreateFileForRx( &otaFileContext ) );
+    TEST_ASSERT_EQUAL( OtaPalSuccess, result );
+
+    /* Blocks 0 and 2 are already in the file. */
+    TEST_ASSERT_EQUAL_HEX8( 0x0AU, rxBlockBitmap );
+    TEST_ASSERT_EQUAL_UINT32( 2U, otaFileContext.blocksRemaining );
+
+    /* Aborting keeps the journal, so the transfer can resume again. */
+    close_ExpectAndReturn( 5, 0 );
+    fclose_ExpectAnyArgsAndReturn( 0 );
+    result = OTA_PAL_MAIN_ERR( otaPal_Abort( &otaFileContext ) );
+    TEST_ASSERT_EQUAL( OtaPalSuccess, result );
+}
+
+/**
+ * @brief Test that otaPal_CreateFileForRx starts a new journal for a new
+ * transfer, and that otaPal_CloseFile removes it.
+ */
+void test_OTAPAL_CreateFileForRx_NewJournal( void )
+{
+    OtaPalMainStatus_t result;
+    FILE placeholder_file;
+    OtaFileContext_t otaFileContext;
+    Sig256_t dummySig;
+    JournalHeader_t header;
+    OtaImageState_t expectedImageState = OtaImageStateTesting;
+
+    ( void ) memset( &otaFileContext, 0, sizeof( otaFileContext ) );
+    ( void ) memset( &dummySig, 0xA5, sizeof( dummySig ) );
+    dummySig.size = 4U;
+    otaFileContext.pFilePath = ( uint8_t * ) "/placeholder_path";
+    otaFileContext.pSignature = &dummySig;
+    otaFileContext.fileSize = OTA_FILE_BLOCK_SIZE;
+    OTA_PAL_SetJournalHeader( &header, &otaFileContext );
+
+    OTA_PAL_FailSingleMock_unistd( none_fn );
+    open_alias_ExpectAnyArgsAndReturn( 5 );
+    /* The journal of another transfer. */
+    header.fileSize++;
+    pread_ExpectAnyArgsAndReturn( sizeof( header ) );
+    pread_ReturnMemThruPtr_buf( &header, sizeof( header ) );
+    header.fileSize--;
+    /* The bitmap is cleared before the header is replaced. */
+    pwrite_ExpectAndReturn( 5, NULL, 1U, sizeof( header ), 1 );
+    pwrite_IgnoreArg_buf();
+    fdatasync_ExpectAndReturn( 5, 0 );
+    pwrite_ExpectWithArrayAndReturn( 5, &header, sizeof( header ), sizeof( header ), 0, sizeof( header ) );
+    fdatasync_ExpectAndReturn( 5, 0 );
+    fopen_ExpectAndReturn( "/placeholder_path", "w+b", &placeholder_file );
+    result = OTA_PAL_MAIN_ERR( otaPal_CreateFileForRx( &otaFileContext ) );
+    TEST_ASSERT_EQUAL( OtaPalSuccess, result );
+
+    /* The journal is deleted once the transfer is over. */
+    OTA_PAL_FailSingleMock( fread_fn, &expectedImageState );
+    fdatasync_ExpectAnyArgsAndReturn( 0 );
+    close_ExpectAndReturn( 5, 0 );
+    unlink_ExpectAnyArgsAndReturn( 0 );
+    result = OTA_PAL_MAIN_ERR( otaPal_CloseFile( &otaFileContext ) );
+    TEST_ASSERT_EQUAL( OtaPalSuccess, result );
+}
+
 /**
  * @brief Test that otaPal_CreateFileForRx will handle the two types of
  * potential paths.
@@ -487,6 +632,8 @@ void test_OTAPAL_CreateFileForRx_PathTypes( void )
     FILE placeholder_file;
     OtaFileContext_t otaFileContext;
 
+    ( void ) memset( &otaFileContext, 0, sizeof( otaFileContext ) );
+
     /* Test for a leading forward slash in the path. */
     otaFileContext.pFilePath = ( uint8_t * ) "/placeholder_path";
     OTA_PAL_FailSingleMock_unistd( none_fn );
@@ -843,6 +990,155 @@ void test_OTAPAL_CloseFile_MaxBlockSize( void )
     TEST_ASSERT_EQUAL( OtaPalSuccess, OTA_PAL_MAIN_ERR( result ) );
 }
 
+/**
+ * @brief Test that otaPal_CloseFile adds a mapped file to the digest in chunks
+ * instead of reading it.
+ */
+void test_OTAPAL_CloseFile_MappedFile( void )
+{
+    OtaPalStatus_t result;
+    OtaFileContext_t otaFileContext;
+    Sig256_t dummySig;
+    OtaImageState_t expectedImageState = OtaImageStateTesting;
+    FILE dummyFile;
+    struct stat fileStat;
+    static uint8_t mapping[ ( 2U * 1024U * 1024U ) + 1U ];
+
+    ( void ) memset( &fileStat, 0, sizeof( fileStat ) );
+    fileStat.st_size = sizeof( mapping );
+    otaFileContext.pSignature = &dummySig;
+    otaFileContext.pFile = &dummyFile;
+
+    /* Reading the file would fail at feof, so success means the mapping was used. */
+    OTA_PAL_FailSingleMock( feof_fn, &expectedImageState );
+    fstat_ExpectAnyArgsAndReturn( 0 );
+    fstat_ReturnThruPtr_buf( &fileStat );
+    mmap_ExpectAnyArgsAndReturn( mapping );
+    madvise_ExpectAnyArgsAndReturn( 0 );
+    EVP_DigestUpdate_ExpectAndReturn( NULL, &mapping[ 0 ], 1024U * 1024U, 1 );
+    EVP_DigestUpdate_IgnoreArg_ctx();
+    EVP_DigestUpdate_ExpectAndReturn( NULL, &mapping[ 1024U * 1024U ], 1024U * 1024U, 1 );
+    EVP_DigestUpdate_IgnoreArg_ctx();
+    EVP_DigestUpdate_ExpectAndReturn( NULL, &mapping[ 2U * 1024U * 1024U ], 1U, 1 );
+    EVP_DigestUpdate_IgnoreArg_ctx();
+    munmap_ExpectAndReturn( mapping, sizeof( mapping ), 0 );
+    result = otaPal_CloseFile( &otaFileContext );
+    TEST_ASSERT_EQUAL( OtaPalSuccess, OTA_PAL_MAIN_ERR( result ) );
+}
+
+/**
+ * @brief Test that otaPal_CloseFile fails when the file cannot be synced to storage.
+ */
+void test_OTAPAL_CloseFile_SyncError( void )
+{
+    OtaPalStatus_t result;
+    OtaFileContext_t otaFileContext;
+    Sig256_t dummySig;
+    OtaImageState_t expectedImageState = OtaImageStateTesting;
+    FILE dummyFile;
+
+    otaFileContext.pSignature = &dummySig;
+    otaFileContext.pFile = &dummyFile;
+
+    OTA_PAL_FailSingleMock( fread_fn, &expectedImageState );
+    fdatasync_ExpectAnyArgsAndReturn( -1 );
+    result = otaPal_CloseFile( &otaFileContext );
+    TEST_ASSERT_EQUAL( OtaPalFileClose, OTA_PAL_MAIN_ERR( result ) );
+}
+
+/**
+ * @brief Test that otaPal_CloseFile reads the file when it cannot be mapped.
+ */
+void test_OTAPAL_CloseFile_mmap_fail( void )
+{
+    OtaPalStatus_t result;
+    OtaFileContext_t otaFileContext;
+    Sig256_t dummySig;
+    OtaImageState_t expectedImageState = OtaImageStateTesting;
+    FILE dummyFile;
+    struct stat fileStat;
+
+    ( void ) memset( &fileStat, 0, sizeof( fileStat ) );
+    fileStat.st_size = 1;
+    otaFileContext.pSignature = &dummySig;
+    otaFileContext.pFile = &dummyFile;
+
+    OTA_PAL_FailSingleMock( fread_fn, &expectedImageState );
+    fstat_ExpectAnyArgsAndReturn( 0 );
+    fstat_ReturnThruPtr_buf( &fileStat );
+    mmap_ExpectAnyArgsAndReturn( MAP_FAILED );
+    result = otaPal_CloseFile( &otaFileContext );
+    TEST_ASSERT_EQUAL( OtaPalSuccess, OTA_PAL_MAIN_ERR( result ) );
+}
+
+/**
+ * @brief Test that otaPal_CloseFile only runs the final verify when every block
+ * was added to the digest as it was written, including blocks that arrived out
+ * of order.
+ */
+void test_OTAPAL_CloseFile_StreamingVerify( void )
+{
+    OtaPalStatus_t result;
+    OtaFileContext_t otaFileContext;
+    Sig256_t dummySig;
+    OtaImageState_t expectedImageState = OtaImageStateTesting;
+    static uint8_t block[ OTA_FILE_BLOCK_SIZE ];
+
+    ( void ) memset( &otaFileContext, 0, sizeof( otaFileContext ) );
+    otaFileContext.pFilePath = ( uint8_t * ) "/placeholder_path";
+    otaFileContext.pCertFilepath = ( uint8_t * ) "placeholder_cert";
+    otaFileContext.pSignature = &dummySig;
+    otaFileContext.fileSize = ( 2U * OTA_FILE_BLOCK_SIZE ) + 1U;
+
+    OTA_PAL_FailSingleMock( none_fn, &expectedImageState );
+    pwrite_IgnoreAndReturn( OTA_FILE_BLOCK_SIZE );
+    pread_IgnoreAndReturn( OTA_FILE_BLOCK_SIZE );
+    result = otaPal_CreateFileForRx( &otaFileContext );
+    TEST_ASSERT_EQUAL( OtaPalSuccess, OTA_PAL_MAIN_ERR( result ) );
+
+    /* The second block arrives first and is read back once the first one is written. */
+    TEST_ASSERT_EQUAL_INT( OTA_FILE_BLOCK_SIZE, otaPal_WriteBlock( &otaFileContext, OTA_FILE_BLOCK_SIZE, block, OTA_FILE_BLOCK_SIZE ) );
+    TEST_ASSERT_EQUAL_INT( OTA_FILE_BLOCK_SIZE, otaPal_WriteBlock( &otaFileContext, 0U, block, OTA_FILE_BLOCK_SIZE ) );
+    pwrite_IgnoreAndReturn( 1 );
+    TEST_ASSERT_EQUAL_INT( 1, otaPal_WriteBlock( &otaFileContext, 2U * OTA_FILE_BLOCK_SIZE, block, 1U ) );
+
+    /* Reading the file back would fail, so success means only the final verify ran. */
+    fseek_alias_IgnoreAndReturn( -1 );
+    result = otaPal_CloseFile( &otaFileContext );
+    TEST_ASSERT_EQUAL( OtaPalSuccess, OTA_PAL_MAIN_ERR( result ) );
+}
+
+/**
+ * @brief Test that otaPal_CloseFile reads back the whole file when a block did
+ * not match the announced file layout.
+ */
+void test_OTAPAL_CloseFile_StreamingVerify_UnexpectedBlock( void )
+{
+    OtaPalStatus_t result;
+    OtaFileContext_t otaFileContext;
+    Sig256_t dummySig;
+    OtaImageState_t expectedImageState = OtaImageStateTesting;
+    uint8_t data = 0xAA;
+
+    ( void ) memset( &otaFileContext, 0, sizeof( otaFileContext ) );
+    otaFileContext.pFilePath = ( uint8_t * ) "/placeholder_path";
+    otaFileContext.pCertFilepath = ( uint8_t * ) "placeholder_cert";
+    otaFileContext.pSignature = &dummySig;
+    otaFileContext.fileSize = OTA_FILE_BLOCK_SIZE;
+
+    OTA_PAL_FailSingleMock( fread_fn, &expectedImageState );
+    result = otaPal_CreateFileForRx( &otaFileContext );
+    TEST_ASSERT_EQUAL( OtaPalSuccess, OTA_PAL_MAIN_ERR( result ) );
+
+    /* A single byte where a full block is expected stops the streaming digest. */
+    pwrite_ExpectAnyArgsAndReturn( 1 );
+    TEST_ASSERT_EQUAL_INT( 1, otaPal_WriteBlock( &otaFileContext, 0U, &data, 1U ) );
+
+    fseek_alias_IgnoreAndReturn( -1 );
+    result = otaPal_CloseFile( &otaFileContext );
+    TEST_ASSERT_EQUAL( OtaPalSignatureCheckFailed, OTA_PAL_MAIN_ERR( result ) );
+}
+
 /* ===================   OTA PAL WRITE BLOCK UNIT TESTS   =================== */
 
 /**
@@ -870,8 +1166,7 @@ void test_OTAPAL_WriteBlock_WriteSingleByte( void )
 
     /* TEST: Write a byte of data. */
     otaFileContext.pFilePath = ( uint8_t * ) "placeholder";
-    fseek_alias_ExpectAnyArgsAndReturn( 0 );
-    fwrite_alias_ExpectAnyArgsAndReturn( blockSize );
+    pwrite_ExpectAnyArgsAndReturn( blockSize );
     numBytesWritten = otaPal_WriteBlock( &otaFileContext, 0, &data, blockSize );
     TEST_ASSERT_EQUAL_INT( blockSize, numBytesWritten );
 }
@@ -890,51 +1185,86 @@ void test_OTAPAL_WriteBlock_WriteMultipleBytes( void )
     /* TEST: Write multiple bytes of data. */
     for( index = 0; index < ( sizeof( pData ) / sizeof( pData[ 0 ] ) ); index++ )
     {
-        fseek_alias_ExpectAnyArgsAndReturn( 0 );
-        fwrite_alias_ExpectAnyArgsAndReturn( blockSize );
+        pwrite_ExpectAnyArgsAndReturn( blockSize );
         numBytesWritten = otaPal_WriteBlock( &otaFileContext, index * blockSize, pData, blockSize );
         TEST_ASSERT_EQUAL_INT( blockSize, numBytesWritten );
     }
 }
 
 /**
- * @brief Test that otaPal_WriteBlock will return correct result code.
+ * @brief Test that otaPal_WriteBlock writes the rest of a block after a short
+ * write.
  */
-void test_OTAPAL_WriteBlock_FseekError( void )
+void test_OTAPAL_WriteBlock_PartialWrite( void )
 {
     int16_t numBytesWritten;
-    uint8_t data = 0xAA;
-    uint32_t blockSize = 1;
-    const int16_t fseek_error_num = 1; /* fseek returns a non-zero number on error. */
+    uint8_t pData[] = { 0xAA, 0xBB, 0xCC, 0xDD, 0xEE };
     OtaFileContext_t validFileContext;
 
-    /* TEST: Write a byte of data. */
-    fseek_alias_ExpectAnyArgsAndReturn( fseek_error_num );
-    numBytesWritten = otaPal_WriteBlock( &validFileContext, 0, &data, blockSize );
-    TEST_ASSERT_EQUAL_INT( -1, numBytesWritten );
+    fileno_alias_IgnoreAndReturn( 3 );
+    pwrite_ExpectAndReturn( 3, &pData[ 0 ], sizeof( pData ), 16, 2 );
+    pwrite_ExpectAndReturn( 3, &pData[ 2 ], sizeof( pData ) - 2U, 18, 3 );
+    numBytesWritten = otaPal_WriteBlock( &validFileContext, 16U, pData, sizeof( pData ) );
+    TEST_ASSERT_EQUAL_INT( sizeof( pData ), numBytesWritten );
 }
 
 /**
  * @brief Test that otaPal_WriteBlock will return correct result code.
  */
-void test_OTAPAL_WriteBlock_FwriteError( void )
+void test_OTAPAL_WriteBlock_PwriteError( void )
 {
     int16_t numBytesWritten;
     uint8_t data = 0xAA;
     uint32_t blockSize = 1;
     OtaFileContext_t validFileContext;
-    const int32_t fseekSuccessReturn = 0; /* fseek returns a zero on success. */
-    const size_t fwriteErrorReturn = 0;   /* fwrite returns a number less than the requested number of bytes to write on error. */
+    const ssize_t pwriteErrorReturn = 0; /* pwrite returns 0 when nothing could be written. */
     const int16_t writeblockErrorReturn = -1;
 
-    fseek_alias_ExpectAnyArgsAndReturn( fseekSuccessReturn );
-    fwrite_alias_ExpectAnyArgsAndReturn( fwriteErrorReturn );
+    pwrite_ExpectAnyArgsAndReturn( pwriteErrorReturn );
 
-    /* fwrite returns a number less than the amount requested to write on error. */
     numBytesWritten = otaPal_WriteBlock( &validFileContext, 0, &data, blockSize );
     TEST_ASSERT_EQUAL_INT( writeblockErrorReturn, numBytesWritten );
 }
 
+/**
+ * @brief Test that otaPal_WriteBlock syncs the file at the sync point, and not
+ * before it.
+ */
+void test_OTAPAL_WriteBlock_SyncPoint( void )
+{
+    OtaPalStatus_t result;
+    int16_t numBytesWritten;
+    uint8_t data = 0xAA;
+    OtaFileContext_t otaFileContext;
+    OtaImageState_t expectedImageState = OtaImageStateTesting;
+
+    /* A file of unknown size has no receive journal, so the only syncs are
+     * those of the receive file. Creating it resets the sync point. */
+    ( void ) memset( &otaFileContext, 0, sizeof( otaFileContext ) );
+    otaFileContext.pFilePath = ( uint8_t * ) "/placeholder_path";
+    OTA_PAL_FailSingleMock( none_fn, &expectedImageState );
+    result = otaPal_CreateFileForRx( &otaFileContext );
+    TEST_ASSERT_EQUAL( OtaPalSuccess, OTA_PAL_MAIN_ERR( result ) );
+
+    /* With strict ordering, a sync after the first block fails the test. */
+    pwrite_ExpectAnyArgsAndReturn( 1 );
+    pwrite_ExpectAnyArgsAndReturn( 1 );
+    fdatasync_ExpectAnyArgsAndReturn( 0 );
+    numBytesWritten = otaPal_WriteBlock( &otaFileContext, 0U, &data, 1U );
+    TEST_ASSERT_EQUAL_INT( 1, numBytesWritten );
+    numBytesWritten = otaPal_WriteBlock( &otaFileContext, 1U, &data, 1U );
+    TEST_ASSERT_EQUAL_INT( 1, numBytesWritten );
+
+    /* A failed sync fails the block, so the OTA agent does not count it as received. */
+    pwrite_ExpectAnyArgsAndReturn( 1 );
+    pwrite_ExpectAnyArgsAndReturn( 1 );
+    fdatasync_ExpectAnyArgsAndReturn( -1 );
+    numBytesWritten = otaPal_WriteBlock( &otaFileContext, 2U, &data, 1U );
+    TEST_ASSERT_EQUAL_INT( 1, numBytesWritten );
+    numBytesWritten = otaPal_WriteBlock( &otaFileContext, 3U, &data, 1U );
+    TEST_ASSERT_EQUAL_INT( -1, numBytesWritten );
+}
+
 /* ===============   OTA PAL ACTIVATE NEW IMAGE UNIT TESTS   ================ */
 
 /**
@@ -9,6 +9,10 @@
 set( SOCKETS_SOURCES
      ${CMAKE_CURRENT_LIST_DIR}/transport/src/sockets_posix.c )
 
+# Transport statistics source files, built into the sockets utility.
+set( TRANSPORT_STATS_SOURCES
+     ${CMAKE_CURRENT_LIST_DIR}/transport/src/transport_stats_posix.c )
+
 # Plaintext transport source files.
 set( PLAINTEXT_TRANSPORT_SOURCES
      ${CMAKE_CURRENT_LIST_DIR}/transport/src/plaintext_posix.c )
@@ -17,6 +21,18 @@ set( PLAINTEXT_TRANSPORT_SOURCES
 set( OPENSSL_TRANSPORT_SOURCES
      ${CMAKE_CURRENT_LIST_DIR}/transport/src/openssl_posix.c )
 
+# Event loop source files.
+set( EVENT_LOOP_SOURCES
+     ${CMAKE_CURRENT_LIST_DIR}/transport/src/event_loop_posix.c )
+
+# Timer wheel source files.
+set( TIMER_WHEEL_SOURCES
+     ${CMAKE_CURRENT_LIST_DIR}/timer_wheel_posix.c )
+
+# Timer wheel Public Include directories.
+set( TIMER_WHEEL_INCLUDE_PUBLIC_DIRS
+     ${CMAKE_CURRENT_LIST_DIR}/include )
+
 # Transport Public Include directories.
 set( COMMON_TRANSPORT_INCLUDE_PUBLIC_DIRS
      ${CMAKE_CURRENT_LIST_DIR}/transport/include
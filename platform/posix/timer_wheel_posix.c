@@ -0,0 +1,627 @@
+/*
+ * AWS IoT Device SDK for Embedded C 202103.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file timer_wheel_posix.c
+ * @brief Implementation of the timer wheel for POSIX systems.
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* POSIX includes. */
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+#include "timer_wheel_posix.h"
+
+/**
+ * @brief Mask of the slot index within a level.
+ */
+#define SLOT_MASK                      ( ( uint64_t ) TIMER_WHEEL_SLOTS - 1U )
+
+/**
+ * @brief Number of ticks covered by all the levels of the wheel.
+ */
+#define WHEEL_RANGE_TICKS              ( ( uint64_t ) 1U << ( TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS ) )
+
+/**
+ * @brief Time conversion constants.
+ */
+#define MILLISECONDS_PER_SECOND        ( 1000U )
+#define NANOSECONDS_PER_MILLISECOND    ( 1000000L )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Make a list empty.
+ *
+ * @param[in] pHead The head of the list.
+ */
+static void listInit( TimerWheelLink_t * pHead );
+
+/**
+ * @brief Append a link at the end of a list.
+ *
+ * @param[in] pHead The head of the list.
+ * @param[in] pLink The link to append.
+ */
+static void listAppend( TimerWheelLink_t * pHead,
+                        TimerWheelLink_t * pLink );
+
+/**
+ * @brief Remove a link from its list.
+ *
+ * @param[in] pLink The link to remove.
+ */
+static void listRemove( TimerWheelLink_t * pLink );
+
+/**
+ * @brief Move all the links of a list at the end of another.
+ *
+ * @param[in] pDestination The head of the list to append to.
+ * @param[in] pSource The head of the list to empty.
+ */
+static void listSplice( TimerWheelLink_t * pDestination,
+                        TimerWheelLink_t * pSource );
+
+/**
+ * @brief Put a timer in the slot of the wheel matching its expiry tick.
+ *
+ * @param[in] pTimerWheel The timer wheel.
+ * @param[in] pTimer The timer.
+ */
+static void placeTimer( TimerWheel_t * pTimerWheel,
+                        TimerWheelTimer_t * pTimer );
+
+/**
+ * @brief Place the timers of a slot of a higher level again, now that they
+ * expire within the range of the lower levels.
+ *
+ * @param[in] pTimerWheel The timer wheel.
+ * @param[in] level The level of the slot.
+ * @param[in] slot The index of the slot.
+ */
+static void cascade( TimerWheel_t * pTimerWheel,
+                     uint32_t level,
+                     uint32_t slot );
+
+/**
+ * @brief Process one tick, moving the timers that expire at it to the list
+ * of expired timers.
+ *
+ * @param[in] pTimerWheel The timer wheel.
+ */
+static void advanceTick( TimerWheel_t * pTimerWheel );
+
+/**
+ * @brief Start or stop the periodic ticks of the timerfd.
+ *
+ * @param[in] pTimerWheel The timer wheel.
+ * @param[in] enable 1 to start the ticks, 0 to stop them.
+ *
+ * @return #TIMER_WHEEL_SUCCESS if successful; #TIMER_WHEEL_API_ERROR on error.
+ */
+static TimerWheelStatus_t armTicks( TimerWheel_t * pTimerWheel,
+                                    uint8_t enable );
+
+/**
+ * @brief Log possible error using errno and return appropriate status.
+ *
+ * @param[in] errorNumber Error number.
+ *
+ * @return #TIMER_WHEEL_API_ERROR, #TIMER_WHEEL_INSUFFICIENT_MEMORY,
+ * #TIMER_WHEEL_INVALID_PARAMETER on error.
+ */
+static TimerWheelStatus_t retrieveError( int32_t errorNumber );
+
+/*-----------------------------------------------------------*/
+
+static void listInit( TimerWheelLink_t * pHead )
+{
+    pHead->pNext = pHead;
+    pHead->pPrev = pHead;
+}
+/*-----------------------------------------------------------*/
+
+static void listAppend( TimerWheelLink_t * pHead,
+                        TimerWheelLink_t * pLink )
+{
+    pLink->pNext = pHead;
+    pLink->pPrev = pHead->pPrev;
+    pHead->pPrev->pNext = pLink;
+    pHead->pPrev = pLink;
+}
+/*-----------------------------------------------------------*/
+
+static void listRemove( TimerWheelLink_t * pLink )
+{
+    pLink->pPrev->pNext = pLink->pNext;
+    pLink->pNext->pPrev = pLink->pPrev;
+    pLink->pNext = pLink;
+    pLink->pPrev = pLink;
+}
+/*-----------------------------------------------------------*/
+
+static void listSplice( TimerWheelLink_t * pDestination,
+                        TimerWheelLink_t * pSource )
+{
+    if( pSource->pNext != pSource )
+    {
+        pSource->pNext->pPrev = pDestination->pPrev;
+        pDestination->pPrev->pNext = pSource->pNext;
+        pSource->pPrev->pNext = pDestination;
+        pDestination->pPrev = pSource->pPrev;
+        listInit( pSource );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void placeTimer( TimerWheel_t * pTimerWheel,
+                        TimerWheelTimer_t * pTimer )
+{
+    uint64_t expiryTick = pTimer->expiryTick;
+    uint32_t level = 0U;
+    uint32_t slot = 0U;
+
+    /* A timer that is already due goes in the slot of the next tick. */
+    if( expiryTick < pTimerWheel->nextTick )
+    {
+        expiryTick = pTimerWheel->nextTick;
+    }
+
+    /* A timer beyond the range of the wheel waits in the furthest slot, and
+     * is placed again from there. */
+    if( ( expiryTick - pTimerWheel->nextTick ) >= WHEEL_RANGE_TICKS )
+    {
+        expiryTick = pTimerWheel->nextTick + WHEEL_RANGE_TICKS - 1U;
+    }
+
+    /* Level n holds the timers that expire within 64^(n + 1) ticks. */
+    while( ( level < ( TIMER_WHEEL_LEVELS - 1U ) ) &&
+           ( ( expiryTick - pTimerWheel->nextTick ) >=
+             ( ( uint64_t ) 1U << ( TIMER_WHEEL_SLOT_BITS * ( level + 1U ) ) ) ) )
+    {
+        level++;
+    }
+
+    slot = ( uint32_t ) ( ( expiryTick >> ( TIMER_WHEEL_SLOT_BITS * level ) ) & SLOT_MASK );
+
+    listAppend( &pTimerWheel->slots[ level ][ slot ], &pTimer->link );
+}
+/*-----------------------------------------------------------*/
+
+static void cascade( TimerWheel_t * pTimerWheel,
+                     uint32_t level,
+                     uint32_t slot )
+{
+    TimerWheelLink_t timers;
+    TimerWheelLink_t * pLink = NULL;
+
+    listInit( &timers );
+    listSplice( &timers, &pTimerWheel->slots[ level ][ slot ] );
+
+    while( timers.pNext != &timers )
+    {
+        pLink = timers.pNext;
+        listRemove( pLink );
+
+        /* The link is the first member of the timer. */
+        placeTimer( pTimerWheel, ( TimerWheelTimer_t * ) pLink );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void advanceTick( TimerWheel_t * pTimerWheel )
+{
+    uint32_t index = ( uint32_t ) ( pTimerWheel->nextTick & SLOT_MASK );
+    uint32_t level = 1U;
+
+    /* When a level turns over, the next slot of the level above is brought
+     * down, and so on up the levels. */
+    while( ( index == 0U ) && ( level < TIMER_WHEEL_LEVELS ) )
+    {
+        index = ( uint32_t ) ( ( pTimerWheel->nextTick >> ( TIMER_WHEEL_SLOT_BITS * level ) ) & SLOT_MASK );
+        cascade( pTimerWheel, level, index );
+        level++;
+    }
+
+    listSplice( &pTimerWheel->expired,
+                &pTimerWheel->slots[ 0 ][ pTimerWheel->nextTick & SLOT_MASK ] );
+    pTimerWheel->nextTick++;
+}
+/*-----------------------------------------------------------*/
+
+static TimerWheelStatus_t armTicks( TimerWheel_t * pTimerWheel,
+                                    uint8_t enable )
+{
+    TimerWheelStatus_t returnStatus = TIMER_WHEEL_SUCCESS;
+    struct itimerspec tickSpec;
+
+    ( void ) memset( &tickSpec, 0, sizeof( tickSpec ) );
+
+    if( enable == 1U )
+    {
+        tickSpec.it_interval.tv_sec = ( time_t ) ( pTimerWheel->tickMs / MILLISECONDS_PER_SECOND );
+        tickSpec.it_interval.tv_nsec = ( long ) ( pTimerWheel->tickMs % MILLISECONDS_PER_SECOND ) *
+                                       NANOSECONDS_PER_MILLISECOND;
+        tickSpec.it_value = tickSpec.it_interval;
+    }
+
+    if( timerfd_settime( pTimerWheel->timerDescriptor, 0, &tickSpec, NULL ) != 0 )
+    {
+        LogError( ( "Failed to %s the ticks of the timer wheel.",
+                    ( enable == 1U ) ? "start" : "stop" ) );
+        returnStatus = retrieveError( errno );
+    }
+    else
+    {
+        pTimerWheel->ticking = enable;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+static TimerWheelStatus_t retrieveError( int32_t errorNumber )
+{
+    TimerWheelStatus_t returnStatus = TIMER_WHEEL_API_ERROR;
+
+    LogError( ( "A timer wheel error occurred: %s.", strerror( errorNumber ) ) );
+
+    if( ( errorNumber == ENOMEM ) || ( errorNumber == ENODEV ) ||
+        ( errorNumber == EMFILE ) || ( errorNumber == ENFILE ) )
+    {
+        returnStatus = TIMER_WHEEL_INSUFFICIENT_MEMORY;
+    }
+    else if( ( errorNumber == EBADF ) || ( errorNumber == EINVAL ) )
+    {
+        returnStatus = TIMER_WHEEL_INVALID_PARAMETER;
+    }
+    else
+    {
+        /* Empty else. */
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+TimerWheelStatus_t TimerWheel_Init( TimerWheel_t * pTimerWheel,
+                                    uint32_t tickMs )
+{
+    TimerWheelStatus_t returnStatus = TIMER_WHEEL_SUCCESS;
+    uint32_t level = 0U, slot = 0U;
+
+    if( pTimerWheel == NULL )
+    {
+        LogError( ( "Parameter check failed: pTimerWheel is NULL." ) );
+        returnStatus = TIMER_WHEEL_INVALID_PARAMETER;
+    }
+    else if( tickMs == 0U )
+    {
+        LogError( ( "Parameter check failed: tickMs is 0." ) );
+        returnStatus = TIMER_WHEEL_INVALID_PARAMETER;
+    }
+    else
+    {
+        for( level = 0U; level < TIMER_WHEEL_LEVELS; level++ )
+        {
+            for( slot = 0U; slot < TIMER_WHEEL_SLOTS; slot++ )
+            {
+                listInit( &pTimerWheel->slots[ level ][ slot ] );
+            }
+        }
+
+        listInit( &pTimerWheel->expired );
+        pTimerWheel->nextTick = 0U;
+        pTimerWheel->tickMs = tickMs;
+        pTimerWheel->numTimers = 0U;
+        pTimerWheel->ticking = 0U;
+
+        /* The timerfd is non-blocking so that TimerWheel_Process never
+         * blocks when no tick is due. */
+        pTimerWheel->timerDescriptor = timerfd_create( CLOCK_MONOTONIC,
+                                                       TFD_NONBLOCK | TFD_CLOEXEC );
+
+        if( pTimerWheel->timerDescriptor < 0 )
+        {
+            LogError( ( "Failed to create timerfd." ) );
+            returnStatus = retrieveError( errno );
+        }
+        else if( pthread_mutex_init( &pTimerWheel->mutex, NULL ) != 0 )
+        {
+            LogError( ( "Failed to initialize the mutex of the timer wheel." ) );
+            ( void ) close( pTimerWheel->timerDescriptor );
+            pTimerWheel->timerDescriptor = -1;
+            returnStatus = TIMER_WHEEL_API_ERROR;
+        }
+        else
+        {
+            /* Empty else. */
+        }
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+TimerWheelStatus_t TimerWheel_Start( TimerWheel_t * pTimerWheel,
+                                     TimerWheelTimer_t * pTimer,
+                                     uint32_t timeoutMs,
+                                     TimerWheelCallback_t callback,
+                                     void * pUserData )
+{
+    TimerWheelStatus_t returnStatus = TIMER_WHEEL_SUCCESS;
+
+    if( ( pTimerWheel == NULL ) || ( pTimerWheel->timerDescriptor < 0 ) )
+    {
+        LogError( ( "Parameter check failed: pTimerWheel is NULL or not initialized." ) );
+        returnStatus = TIMER_WHEEL_INVALID_PARAMETER;
+    }
+    else if( pTimer == NULL )
+    {
+        LogError( ( "Parameter check failed: pTimer is NULL." ) );
+        returnStatus = TIMER_WHEEL_INVALID_PARAMETER;
+    }
+    else if( callback == NULL )
+    {
+        LogError( ( "Parameter check failed: callback is NULL." ) );
+        returnStatus = TIMER_WHEEL_INVALID_PARAMETER;
+    }
+    else
+    {
+        ( void ) pthread_mutex_lock( &pTimerWheel->mutex );
+
+        if( pTimer->pending == 1U )
+        {
+            listRemove( &pTimer->link );
+        }
+        else if( pTimerWheel->ticking == 0U )
+        {
+            /* The ticks are stopped while the wheel is empty. */
+            returnStatus = armTicks( pTimerWheel, 1U );
+        }
+        else
+        {
+            /* Empty else. */
+        }
+
+        if( returnStatus == TIMER_WHEEL_SUCCESS )
+        {
+            /* The next tick is due within one tick, so rounding the timeout
+             * up expires the timer late rather than early, unless that tick
+             * is already due. */
+            pTimer->expiryTick = pTimerWheel->nextTick +
+                                 ( ( ( uint64_t ) timeoutMs + pTimerWheel->tickMs - 1U ) /
+                                   pTimerWheel->tickMs );
+            pTimer->callback = callback;
+            pTimer->pUserData = pUserData;
+            placeTimer( pTimerWheel, pTimer );
+
+            if( pTimer->pending == 0U )
+            {
+                pTimer->pending = 1U;
+                pTimerWheel->numTimers++;
+            }
+        }
+
+        ( void ) pthread_mutex_unlock( &pTimerWheel->mutex );
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+TimerWheelStatus_t TimerWheel_Cancel( TimerWheel_t * pTimerWheel,
+                                      TimerWheelTimer_t * pTimer )
+{
+    TimerWheelStatus_t returnStatus = TIMER_WHEEL_SUCCESS;
+
+    if( ( pTimerWheel == NULL ) || ( pTimerWheel->timerDescriptor < 0 ) )
+    {
+        LogError( ( "Parameter check failed: pTimerWheel is NULL or not initialized." ) );
+        returnStatus = TIMER_WHEEL_INVALID_PARAMETER;
+    }
+    else if( pTimer == NULL )
+    {
+        LogError( ( "Parameter check failed: pTimer is NULL." ) );
+        returnStatus = TIMER_WHEEL_INVALID_PARAMETER;
+    }
+    else
+    {
+        ( void ) pthread_mutex_lock( &pTimerWheel->mutex );
+
+        /* The ticks are stopped by the next tick if the wheel is empty. */
+        if( pTimer->pending == 1U )
+        {
+            listRemove( &pTimer->link );
+            pTimer->pending = 0U;
+            pTimerWheel->numTimers--;
+        }
+
+        ( void ) pthread_mutex_unlock( &pTimerWheel->mutex );
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+int32_t TimerWheel_GetDescriptor( const TimerWheel_t * pTimerWheel )
+{
+    int32_t timerDescriptor = -1;
+
+    if( pTimerWheel != NULL )
+    {
+        timerDescriptor = pTimerWheel->timerDescriptor;
+    }
+
+    return timerDescriptor;
+}
+/*-----------------------------------------------------------*/
+
+TimerWheelStatus_t TimerWheel_Process( TimerWheel_t * pTimerWheel,
+                                       size_t * pNumExpired )
+{
+    TimerWheelStatus_t returnStatus = TIMER_WHEEL_SUCCESS;
+    TimerWheelTimer_t * pTimer = NULL;
+    TimerWheelCallback_t callback = NULL;
+    void * pUserData = NULL;
+    uint64_t expirations = 0U, tick = 0U;
+    size_t numExpired = 0U;
+
+    if( ( pTimerWheel == NULL ) || ( pTimerWheel->timerDescriptor < 0 ) )
+    {
+        LogError( ( "Parameter check failed: pTimerWheel is NULL or not initialized." ) );
+        returnStatus = TIMER_WHEEL_INVALID_PARAMETER;
+    }
+    else
+    {
+        ( void ) pthread_mutex_lock( &pTimerWheel->mutex );
+
+        /* Read the ticks under the lock, so that a timer started meanwhile
+         * is placed from the tick it is started at. */
+        if( read( pTimerWheel->timerDescriptor, &expirations, sizeof( expirations ) ) !=
+            ( ssize_t ) sizeof( expirations ) )
+        {
+            expirations = 0U;
+
+            if( errno != EAGAIN )
+            {
+                LogError( ( "Failed to read the ticks of the timer wheel." ) );
+                returnStatus = retrieveError( errno );
+            }
+        }
+
+        for( tick = 0U; tick < expirations; tick++ )
+        {
+            advanceTick( pTimerWheel );
+        }
+
+        /* Invoke the callbacks without the lock, so that they can start and
+         * cancel timers. A timer canceled meanwhile leaves the list. */
+        while( pTimerWheel->expired.pNext != &pTimerWheel->expired )
+        {
+            /* The link is the first member of the timer. */
+            pTimer = ( TimerWheelTimer_t * ) pTimerWheel->expired.pNext;
+            listRemove( &pTimer->link );
+            pTimer->pending = 0U;
+            pTimerWheel->numTimers--;
+            callback = pTimer->callback;
+            pUserData = pTimer->pUserData;
+
+            ( void ) pthread_mutex_unlock( &pTimerWheel->mutex );
+            callback( pTimer, pUserData );
+            numExpired++;
+            ( void ) pthread_mutex_lock( &pTimerWheel->mutex );
+        }
+
+        /* Stop ticking once the wheel is empty. */
+        if( ( pTimerWheel->ticking == 1U ) && ( pTimerWheel->numTimers == 0U ) )
+        {
+            returnStatus = armTicks( pTimerWheel, 0U );
+        }
+
+        ( void ) pthread_mutex_unlock( &pTimerWheel->mutex );
+    }
+
+    if( pNumExpired != NULL )
+    {
+        *pNumExpired = numExpired;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+TimerWheelStatus_t TimerWheel_Run( TimerWheel_t * pTimerWheel,
+                                   uint32_t timeoutMs,
+                                   size_t * pNumExpired )
+{
+    TimerWheelStatus_t returnStatus = TIMER_WHEEL_SUCCESS;
+    struct pollfd pollFd;
+    int32_t waitTimeMs = -1, pollStatus = 0;
+
+    if( pNumExpired != NULL )
+    {
+        *pNumExpired = 0U;
+    }
+
+    if( ( pTimerWheel == NULL ) || ( pTimerWheel->timerDescriptor < 0 ) )
+    {
+        LogError( ( "Parameter check failed: pTimerWheel is NULL or not initialized." ) );
+        returnStatus = TIMER_WHEEL_INVALID_PARAMETER;
+    }
+    else
+    {
+        if( timeoutMs != TIMER_WHEEL_WAIT_FOREVER )
+        {
+            waitTimeMs = ( timeoutMs > ( uint32_t ) INT32_MAX ) ? INT32_MAX : ( int32_t ) timeoutMs;
+        }
+
+        ( void ) memset( &pollFd, 0, sizeof( pollFd ) );
+        pollFd.fd = pTimerWheel->timerDescriptor;
+        pollFd.events = POLLIN;
+
+        pollStatus = poll( &pollFd, 1U, waitTimeMs );
+
+        if( pollStatus > 0 )
+        {
+            returnStatus = TimerWheel_Process( pTimerWheel, pNumExpired );
+        }
+        else if( ( pollStatus < 0 ) && ( errno != EINTR ) )
+        {
+            LogError( ( "Failed to wait for the ticks of the timer wheel." ) );
+            returnStatus = retrieveError( errno );
+        }
+        else
+        {
+            /* The timeout expired or the wait was interrupted. */
+        }
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+TimerWheelStatus_t TimerWheel_Deinit( TimerWheel_t * pTimerWheel )
+{
+    TimerWheelStatus_t returnStatus = TIMER_WHEEL_SUCCESS;
+
+    if( ( pTimerWheel == NULL ) || ( pTimerWheel->timerDescriptor < 0 ) )
+    {
+        LogError( ( "Parameter check failed: pTimerWheel is NULL or not initialized." ) );
+        returnStatus = TIMER_WHEEL_INVALID_PARAMETER;
+    }
+    else
+    {
+        ( void ) close( pTimerWheel->timerDescriptor );
+        pTimerWheel->timerDescriptor = -1;
+        pTimerWheel->numTimers = 0U;
+        ( void ) pthread_mutex_destroy( &pTimerWheel->mutex );
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
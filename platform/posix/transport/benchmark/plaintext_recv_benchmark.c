@@ -0,0 +1,198 @@
+/*
+ * AWS IoT Device SDK for Embedded C 202103.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file plaintext_recv_benchmark.c
+ * @brief Measures the cost of #Plaintext_Recv against the previous
+ * implementation, which read the receive timeout back from the socket with
+ * #getsockopt before every #select.
+ *
+ * Both variants receive one byte at a time over a connected UNIX socket pair,
+ * so the numbers are dominated by the per-call system call overhead.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+/* POSIX includes. */
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+
+/* Transport includes. */
+#include "plaintext_posix.h"
+
+/**
+ * @brief Number of receives measured for each variant.
+ */
+#define BENCHMARK_ITERATIONS    ( 200000U )
+
+/**
+ * @brief Receive timeout of the connection.
+ */
+#define RECV_TIMEOUT_MS         ( 1000U )
+
+/**
+ * @brief Number of nanoseconds in one second.
+ */
+#define ONE_SEC_TO_NS           ( 1000000000LL )
+
+/* Each compilation unit must define the NetworkContext struct. */
+struct NetworkContext
+{
+    PlaintextParams_t * pParams;
+};
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Read the monotonic clock in nanoseconds.
+ */
+static int64_t getTimeNs( void )
+{
+    struct timespec now;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return ( ( int64_t ) now.tv_sec * ONE_SEC_TO_NS ) + ( int64_t ) now.tv_nsec;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The receive path before the timeouts were cached: #getsockopt,
+ * #select, #recv.
+ */
+static int32_t legacyRecv( int32_t socketDescriptor,
+                           void * pBuffer,
+                           size_t bytesToRecv )
+{
+    int32_t bytesReceived = -1;
+    struct timeval recvTimeout;
+    socklen_t recvTimeoutLen = ( socklen_t ) sizeof( recvTimeout );
+    fd_set readfds;
+
+    if( getsockopt( socketDescriptor, SOL_SOCKET, SO_RCVTIMEO,
+                    &recvTimeout, &recvTimeoutLen ) < 0 )
+    {
+        recvTimeout.tv_sec = 0;
+        recvTimeout.tv_usec = 0;
+    }
+
+    FD_ZERO( &readfds );
+    FD_SET( socketDescriptor, &readfds );
+
+    if( select( socketDescriptor + 1, &readfds, NULL, NULL, &recvTimeout ) > 0 )
+    {
+        bytesReceived = ( int32_t ) recv( socketDescriptor, pBuffer, bytesToRecv, 0 );
+    }
+
+    return bytesReceived;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    int sockets[ 2 ] = { -1, -1 };
+    PlaintextParams_t plaintextParams = { 0 };
+    NetworkContext_t networkContext = { 0 };
+    uint8_t byte = 0U;
+    uint32_t i;
+    int64_t start, legacyNs, cachedNs;
+    int status = EXIT_SUCCESS;
+
+    if( socketpair( AF_UNIX, SOCK_STREAM, 0, sockets ) != 0 )
+    {
+        perror( "socketpair" );
+        status = EXIT_FAILURE;
+    }
+
+    if( status == EXIT_SUCCESS )
+    {
+        plaintextParams.socketDescriptor = sockets[ 0 ];
+        plaintextParams.recvTimeoutMs = RECV_TIMEOUT_MS;
+        networkContext.pParams = &plaintextParams;
+
+        if( Sockets_SetTimeouts( sockets[ 0 ], RECV_TIMEOUT_MS, RECV_TIMEOUT_MS ) != SOCKETS_SUCCESS )
+        {
+            status = EXIT_FAILURE;
+        }
+    }
+
+    if( status == EXIT_SUCCESS )
+    {
+        start = getTimeNs();
+
+        for( i = 0U; ( i < BENCHMARK_ITERATIONS ) && ( status == EXIT_SUCCESS ); i++ )
+        {
+            if( ( write( sockets[ 1 ], &byte, 1U ) != 1 ) ||
+                ( legacyRecv( sockets[ 0 ], &byte, 1U ) != 1 ) )
+            {
+                status = EXIT_FAILURE;
+            }
+        }
+
+        legacyNs = getTimeNs() - start;
+    }
+
+    if( status == EXIT_SUCCESS )
+    {
+        start = getTimeNs();
+
+        for( i = 0U; ( i < BENCHMARK_ITERATIONS ) && ( status == EXIT_SUCCESS ); i++ )
+        {
+            if( ( write( sockets[ 1 ], &byte, 1U ) != 1 ) ||
+                ( Plaintext_Recv( &networkContext, &byte, 1U ) != 1 ) )
+            {
+                status = EXIT_FAILURE;
+            }
+        }
+
+        cachedNs = getTimeNs() - start;
+    }
+
+    if( status == EXIT_SUCCESS )
+    {
+        /* The write on the peer is included in both measurements. */
+        printf( "%-24s %10s %16s\n", "variant", "ns/recv", "syscalls/recv" );
+        printf( "%-24s %10.1f %16d\n", "getsockopt+select+recv",
+                ( double ) legacyNs / BENCHMARK_ITERATIONS, 3 );
+        printf( "%-24s %10.1f %16d\n", "Plaintext_Recv",
+                ( double ) cachedNs / BENCHMARK_ITERATIONS, 2 );
+    }
+    else
+    {
+        fprintf( stderr, "Benchmark failed.\n" );
+    }
+
+    if( sockets[ 0 ] >= 0 )
+    {
+        ( void ) close( sockets[ 0 ] );
+        ( void ) close( sockets[ 1 ] );
+    }
+
+    return status;
+}
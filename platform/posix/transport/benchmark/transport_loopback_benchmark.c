@@ -0,0 +1,729 @@
+/*
+ * AWS IoT Device SDK for Embedded C 202103.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file transport_loopback_benchmark.c
+ * @brief Measures the plaintext and OpenSSL transports against an echo server
+ * running in a thread of the same process, over the loopback interface.
+ *
+ * The benchmark reports connects per second for #Plaintext_Connect,
+ * #Openssl_Connect and #Openssl_ConnectWithContext, then the throughput and
+ * round-trip latency of echoing messages of several sizes with #Plaintext_Send
+ * and #Plaintext_Recv, and with #Openssl_Send and #Openssl_Recv for several
+ * values of #OpensslCredentials_t.maxFragmentLength.
+ *
+ * The server presents the self-signed certificate generated by the build,
+ * which the client trusts as its root CA.
+ */
+
+/* Standard includes. */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+/* POSIX includes. */
+#include <pthread.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+/* OpenSSL include. */
+#include <openssl/ssl.h>
+
+/* Platform clock include. */
+#include "clock.h"
+
+/* Transport includes. */
+#include "openssl_posix.h"
+#include "plaintext_posix.h"
+
+#ifndef LOOPBACK_CERT_PATH
+    #error "LOOPBACK_CERT_PATH must be set to the certificate generated by the build."
+#endif
+
+#ifndef LOOPBACK_KEY_PATH
+    #error "LOOPBACK_KEY_PATH must be set to the private key generated by the build."
+#endif
+
+/**
+ * @brief Host name of the server, which the certificate is issued to.
+ */
+#define LOOPBACK_HOST_NAME        "localhost"
+
+/**
+ * @brief Number of connects measured for each variant.
+ */
+#define BENCHMARK_CONNECTS        ( 200U )
+
+/**
+ * @brief Number of round trips measured for each message size.
+ */
+#define BENCHMARK_ROUND_TRIPS     ( 2000U )
+
+/**
+ * @brief Largest message echoed, which also sizes the buffers.
+ */
+#define BENCHMARK_MAX_MESSAGE     ( 16384U )
+
+/**
+ * @brief Send and receive timeout of the client connections.
+ */
+#define BENCHMARK_TIMEOUT_MS      ( 5000U )
+
+/**
+ * @brief Number of nanoseconds in one microsecond.
+ */
+#define ONE_US_TO_NS              ( 1000.0 )
+
+/**
+ * @brief Number of nanoseconds in one second.
+ */
+#define ONE_SEC_TO_NS             ( 1000000000.0 )
+
+/* The transports only access the parameters through pParams, so a single
+ * definition of the struct serves both of them in this compilation unit. */
+struct NetworkContext
+{
+    void * pParams;
+};
+
+/**
+ * @brief Echo server listening on the loopback interface.
+ */
+typedef struct EchoServer
+{
+    int listenSocket;
+    uint16_t port;
+    SSL_CTX * pSslContext; /**< @brief Context to accept TLS connections with, or NULL for plaintext. */
+    pthread_t thread;
+} EchoServer_t;
+
+/**
+ * @brief A client connection to the echo server.
+ */
+typedef struct BenchmarkClient
+{
+    uint8_t useTls;
+    SSL_CTX * pSharedContext; /**< @brief Context for #Openssl_ConnectWithContext, or NULL for #Openssl_Connect. */
+    ServerInfo_t serverInfo;
+    SocketsOptions_t socketsOptions;
+    OpensslCredentials_t credentials;
+    PlaintextParams_t plaintextParams;
+    OpensslParams_t opensslParams;
+    NetworkContext_t networkContext;
+} BenchmarkClient_t;
+
+/**
+ * @brief Message sizes of the round trip measurements.
+ */
+static const size_t messageSizes[] = { 64U, 1024U, 4096U, BENCHMARK_MAX_MESSAGE };
+
+/**
+ * @brief Values of #OpensslCredentials_t.maxFragmentLength measured, 0 being
+ * the OpenSSL default of 16384 bytes.
+ */
+static const uint16_t maxFragmentLengths[] = { 0U, 512U, 4096U };
+
+/**
+ * @brief Durations of the measured operations of one variant.
+ */
+static uint64_t latenciesNs[ BENCHMARK_ROUND_TRIPS ];
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Write a whole buffer to a socket or a TLS connection of the server.
+ */
+static int serverWriteAll( SSL * pSsl,
+                           int socketDescriptor,
+                           const uint8_t * pBuffer,
+                           size_t length )
+{
+    size_t offset = 0U;
+    int written = 1;
+
+    while( ( offset < length ) && ( written > 0 ) )
+    {
+        if( pSsl != NULL )
+        {
+            written = SSL_write( pSsl, &pBuffer[ offset ], ( int ) ( length - offset ) );
+        }
+        else
+        {
+            written = ( int ) send( socketDescriptor, &pBuffer[ offset ], length - offset, MSG_NOSIGNAL );
+        }
+
+        if( written > 0 )
+        {
+            offset += ( size_t ) written;
+        }
+    }
+
+    return ( offset == length ) ? 0 : -1;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Echo everything received on an accepted connection until the client
+ * disconnects.
+ */
+static void echoConnection( const EchoServer_t * pServer,
+                            int socketDescriptor )
+{
+    static uint8_t buffer[ BENCHMARK_MAX_MESSAGE ];
+    SSL * pSsl = NULL;
+    int received = 1;
+    int noDelay = 1;
+
+    /* Replies must not wait for the ACK of the previous one. */
+    ( void ) setsockopt( socketDescriptor, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof( noDelay ) );
+
+    if( pServer->pSslContext != NULL )
+    {
+        pSsl = SSL_new( pServer->pSslContext );
+
+        if( ( pSsl == NULL ) ||
+            ( SSL_set_fd( pSsl, socketDescriptor ) != 1 ) ||
+            ( SSL_accept( pSsl ) != 1 ) )
+        {
+            received = 0;
+        }
+    }
+
+    while( received > 0 )
+    {
+        if( pSsl != NULL )
+        {
+            received = SSL_read( pSsl, buffer, ( int ) sizeof( buffer ) );
+        }
+        else
+        {
+            received = ( int ) recv( socketDescriptor, buffer, sizeof( buffer ), 0 );
+        }
+
+        if( ( received > 0 ) &&
+            ( serverWriteAll( pSsl, socketDescriptor, buffer, ( size_t ) received ) != 0 ) )
+        {
+            received = 0;
+        }
+    }
+
+    if( pSsl != NULL )
+    {
+        SSL_free( pSsl );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Thread of the echo server, serving one connection at a time until
+ * the listening socket is shut down.
+ */
+static void * serveConnections( void * pArgument )
+{
+    const EchoServer_t * pServer = ( const EchoServer_t * ) pArgument;
+    int socketDescriptor = -1;
+    int stop = 0;
+
+    while( stop == 0 )
+    {
+        socketDescriptor = accept( pServer->listenSocket, NULL, NULL );
+
+        if( socketDescriptor >= 0 )
+        {
+            echoConnection( pServer, socketDescriptor );
+            ( void ) close( socketDescriptor );
+        }
+        else if( errno != EINTR )
+        {
+            stop = 1;
+        }
+        else
+        {
+            /* Retry the interrupted accept. */
+        }
+    }
+
+    return NULL;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Start an echo server on an ephemeral port of the first address of
+ * #LOOPBACK_HOST_NAME, which is the one the client connects to first.
+ *
+ * Plaintext clients connect faster than the server accepts, so the backlog is
+ * as large as allowed: a full backlog drops SYNs, which costs a one second
+ * retransmission.
+ */
+static int startServer( EchoServer_t * pServer,
+                        SSL_CTX * pSslContext )
+{
+    struct addrinfo hints;
+    struct addrinfo * pAddress = NULL;
+    struct sockaddr_storage boundAddress;
+    socklen_t addressLength = ( socklen_t ) sizeof( boundAddress );
+    int status = 0;
+
+    ( void ) memset( pServer, 0, sizeof( EchoServer_t ) );
+    ( void ) memset( &hints, 0, sizeof( hints ) );
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    pServer->pSslContext = pSslContext;
+    pServer->listenSocket = -1;
+
+    if( getaddrinfo( LOOPBACK_HOST_NAME, "0", &hints, &pAddress ) != 0 )
+    {
+        fprintf( stderr, "Failed to resolve %s.\n", LOOPBACK_HOST_NAME );
+        status = -1;
+    }
+    else
+    {
+        pServer->listenSocket = socket( pAddress->ai_family, SOCK_STREAM, 0 );
+
+        if( ( pServer->listenSocket < 0 ) ||
+            ( bind( pServer->listenSocket, pAddress->ai_addr, pAddress->ai_addrlen ) != 0 ) ||
+            ( listen( pServer->listenSocket, SOMAXCONN ) != 0 ) ||
+            ( getsockname( pServer->listenSocket, ( struct sockaddr * ) &boundAddress, &addressLength ) != 0 ) )
+        {
+            perror( "Failed to listen on the loopback interface" );
+            status = -1;
+        }
+
+        freeaddrinfo( pAddress );
+    }
+
+    if( status == 0 )
+    {
+        /* The port is at the same offset in both address families. */
+        pServer->port = ntohs( ( boundAddress.ss_family == AF_INET6 ) ?
+                               ( ( struct sockaddr_in6 * ) &boundAddress )->sin6_port :
+                               ( ( struct sockaddr_in * ) &boundAddress )->sin_port );
+
+        if( pthread_create( &pServer->thread, NULL, serveConnections, pServer ) != 0 )
+        {
+            fprintf( stderr, "Failed to start the echo server thread.\n" );
+            status = -1;
+        }
+    }
+
+    if( ( status != 0 ) && ( pServer->listenSocket >= 0 ) )
+    {
+        ( void ) close( pServer->listenSocket );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Stop an echo server once its client has disconnected.
+ */
+static void stopServer( EchoServer_t * pServer )
+{
+    /* Shutting the listening socket down makes the pending accept fail. */
+    ( void ) shutdown( pServer->listenSocket, SHUT_RDWR );
+    ( void ) pthread_join( pServer->thread, NULL );
+    ( void ) close( pServer->listenSocket );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Create the context the server accepts TLS connections with.
+ */
+static SSL_CTX * createServerContext( void )
+{
+    SSL_CTX * pSslContext = SSL_CTX_new( TLS_server_method() );
+
+    if( ( pSslContext != NULL ) &&
+        ( ( SSL_CTX_use_certificate_file( pSslContext, LOOPBACK_CERT_PATH, SSL_FILETYPE_PEM ) != 1 ) ||
+          ( SSL_CTX_use_PrivateKey_file( pSslContext, LOOPBACK_KEY_PATH, SSL_FILETYPE_PEM ) != 1 ) ) )
+    {
+        SSL_CTX_free( pSslContext );
+        pSslContext = NULL;
+    }
+
+    if( pSslContext == NULL )
+    {
+        fprintf( stderr, "Failed to load %s and %s.\n", LOOPBACK_CERT_PATH, LOOPBACK_KEY_PATH );
+    }
+
+    return pSslContext;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Set up a client of an echo server.
+ */
+static void initClient( BenchmarkClient_t * pClient,
+                        const EchoServer_t * pServer,
+                        uint16_t maxFragmentLength )
+{
+    ( void ) memset( pClient, 0, sizeof( BenchmarkClient_t ) );
+
+    pClient->useTls = ( pServer->pSslContext != NULL ) ? 1U : 0U;
+    pClient->serverInfo.pHostName = LOOPBACK_HOST_NAME;
+    pClient->serverInfo.hostNameLength = strlen( LOOPBACK_HOST_NAME );
+    pClient->serverInfo.port = pServer->port;
+
+    /* As for MQTT, small messages must not wait for the previous ACK. */
+    pClient->socketsOptions.noDelay = 1U;
+
+    pClient->credentials.pRootCaPath = LOOPBACK_CERT_PATH;
+    pClient->credentials.sniHostName = LOOPBACK_HOST_NAME;
+    pClient->credentials.maxFragmentLength = maxFragmentLength;
+    pClient->credentials.pSocketsOptions = &pClient->socketsOptions;
+
+    if( pClient->useTls == 1U )
+    {
+        pClient->networkContext.pParams = &pClient->opensslParams;
+    }
+    else
+    {
+        pClient->networkContext.pParams = &pClient->plaintextParams;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Connect a client to its echo server.
+ */
+static int clientConnect( BenchmarkClient_t * pClient )
+{
+    int status = -1;
+
+    if( pClient->useTls == 0U )
+    {
+        if( Plaintext_ConnectWithOptions( &pClient->networkContext, &pClient->serverInfo,
+                                          BENCHMARK_TIMEOUT_MS, BENCHMARK_TIMEOUT_MS,
+                                          &pClient->socketsOptions ) == SOCKETS_SUCCESS )
+        {
+            status = 0;
+        }
+    }
+    else if( pClient->pSharedContext != NULL )
+    {
+        if( Openssl_ConnectWithContext( &pClient->networkContext, &pClient->serverInfo,
+                                        pClient->pSharedContext, &pClient->credentials,
+                                        BENCHMARK_TIMEOUT_MS, BENCHMARK_TIMEOUT_MS ) == OPENSSL_SUCCESS )
+        {
+            status = 0;
+        }
+    }
+    else
+    {
+        if( Openssl_Connect( &pClient->networkContext, &pClient->serverInfo,
+                             &pClient->credentials,
+                             BENCHMARK_TIMEOUT_MS, BENCHMARK_TIMEOUT_MS ) == OPENSSL_SUCCESS )
+        {
+            status = 0;
+        }
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Disconnect a client from its echo server.
+ */
+static void clientDisconnect( BenchmarkClient_t * pClient )
+{
+    if( pClient->useTls == 0U )
+    {
+        ( void ) Plaintext_Disconnect( &pClient->networkContext );
+    }
+    else
+    {
+        ( void ) Openssl_Disconnect( &pClient->networkContext );
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Send a message and receive its echo through the transport of a
+ * client.
+ */
+static int clientRoundTrip( BenchmarkClient_t * pClient,
+                            const uint8_t * pMessage,
+                            uint8_t * pEcho,
+                            size_t length )
+{
+    size_t sent = 0U, received = 0U;
+    int32_t result = 1;
+
+    while( ( sent < length ) && ( result > 0 ) )
+    {
+        result = ( pClient->useTls == 1U ) ?
+                 Openssl_Send( &pClient->networkContext, &pMessage[ sent ], length - sent ) :
+                 Plaintext_Send( &pClient->networkContext, &pMessage[ sent ], length - sent );
+        sent += ( result > 0 ) ? ( size_t ) result : 0U;
+    }
+
+    while( ( received < length ) && ( result > 0 ) )
+    {
+        result = ( pClient->useTls == 1U ) ?
+                 Openssl_Recv( &pClient->networkContext, &pEcho[ received ], length - received ) :
+                 Plaintext_Recv( &pClient->networkContext, &pEcho[ received ], length - received );
+        received += ( result > 0 ) ? ( size_t ) result : 0U;
+    }
+
+    return ( ( received == length ) && ( memcmp( pMessage, pEcho, length ) == 0 ) ) ? 0 : -1;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Order latencies for #qsort.
+ */
+static int compareLatencies( const void * pLeft,
+                             const void * pRight )
+{
+    uint64_t left = *( const uint64_t * ) pLeft;
+    uint64_t right = *( const uint64_t * ) pRight;
+
+    return ( left > right ) - ( left < right );
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Get a percentile of the first @p count latencies, in microseconds.
+ * The latencies must be sorted.
+ */
+static double getPercentileUs( size_t count,
+                               uint32_t percentile )
+{
+    size_t index = ( ( count * percentile ) + 99U ) / 100U;
+
+    index = ( index > 0U ) ? ( index - 1U ) : 0U;
+
+    return ( double ) latenciesNs[ index ] / ONE_US_TO_NS;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Measure connects and disconnects of a client.
+ */
+static int benchmarkConnects( const char * pName,
+                              BenchmarkClient_t * pClient )
+{
+    uint64_t startNs = 0U, totalNs = 0U;
+    size_t i;
+    int status = 0;
+
+    for( i = 0U; ( i < BENCHMARK_CONNECTS ) && ( status == 0 ); i++ )
+    {
+        startNs = Clock_GetTimeNs64();
+        status = clientConnect( pClient );
+        latenciesNs[ i ] = Clock_GetTimeNs64() - startNs;
+        totalNs += latenciesNs[ i ];
+
+        if( status == 0 )
+        {
+            clientDisconnect( pClient );
+        }
+    }
+
+    if( status == 0 )
+    {
+        qsort( latenciesNs, BENCHMARK_CONNECTS, sizeof( latenciesNs[ 0 ] ), compareLatencies );
+        printf( "%-28s %10.1f %10.1f %10.1f\n", pName,
+                ( double ) BENCHMARK_CONNECTS * ONE_SEC_TO_NS / ( double ) totalNs,
+                getPercentileUs( BENCHMARK_CONNECTS, 50U ),
+                getPercentileUs( BENCHMARK_CONNECTS, 99U ) );
+    }
+    else
+    {
+        fprintf( stderr, "%s: connect failed.\n", pName );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Measure round trips of every message size over one connection of a
+ * client.
+ */
+static int benchmarkRoundTrips( const char * pName,
+                                BenchmarkClient_t * pClient )
+{
+    static uint8_t message[ BENCHMARK_MAX_MESSAGE ];
+    static uint8_t echo[ BENCHMARK_MAX_MESSAGE ];
+    uint64_t startNs = 0U, totalNs = 0U;
+    size_t i, sizeIndex;
+    int status = clientConnect( pClient );
+
+    for( i = 0U; i < sizeof( message ); i++ )
+    {
+        message[ i ] = ( uint8_t ) i;
+    }
+
+    for( sizeIndex = 0U; ( sizeIndex < ( sizeof( messageSizes ) / sizeof( messageSizes[ 0 ] ) ) ) && ( status == 0 ); sizeIndex++ )
+    {
+        totalNs = 0U;
+
+        for( i = 0U; ( i < BENCHMARK_ROUND_TRIPS ) && ( status == 0 ); i++ )
+        {
+            startNs = Clock_GetTimeNs64();
+            status = clientRoundTrip( pClient, message, echo, messageSizes[ sizeIndex ] );
+            latenciesNs[ i ] = Clock_GetTimeNs64() - startNs;
+            totalNs += latenciesNs[ i ];
+        }
+
+        if( status == 0 )
+        {
+            qsort( latenciesNs, BENCHMARK_ROUND_TRIPS, sizeof( latenciesNs[ 0 ] ), compareLatencies );
+            printf( "%-20s %6u %8lu %10.2f %10.1f %10.1f\n",
+                    pName,
+                    ( unsigned int ) pClient->credentials.maxFragmentLength,
+                    ( unsigned long ) messageSizes[ sizeIndex ],
+                    ( double ) messageSizes[ sizeIndex ] * BENCHMARK_ROUND_TRIPS * ( ONE_SEC_TO_NS / 1000000.0 ) / ( double ) totalNs,
+                    getPercentileUs( BENCHMARK_ROUND_TRIPS, 50U ),
+                    getPercentileUs( BENCHMARK_ROUND_TRIPS, 99U ) );
+        }
+    }
+
+    if( status == 0 )
+    {
+        clientDisconnect( pClient );
+    }
+    else
+    {
+        fprintf( stderr, "%s: round trip failed.\n", pName );
+    }
+
+    return status;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    EchoServer_t plaintextServer, tlsServer;
+    BenchmarkClient_t client;
+    SSL_CTX * pServerContext = NULL;
+    SSL_CTX * pClientContext = NULL;
+    size_t i;
+    int status = 0, serversStarted = 0;
+
+    pServerContext = createServerContext();
+    status = ( pServerContext != NULL ) ? 0 : -1;
+
+    if( status == 0 )
+    {
+        status = startServer( &plaintextServer, NULL );
+    }
+
+    if( status == 0 )
+    {
+        status = startServer( &tlsServer, pServerContext );
+
+        if( status != 0 )
+        {
+            stopServer( &plaintextServer );
+        }
+        else
+        {
+            serversStarted = 1;
+        }
+    }
+
+    if( status == 0 )
+    {
+        printf( "Connects (%u each)\n", BENCHMARK_CONNECTS );
+        printf( "%-28s %10s %10s %10s\n", "variant", "conn/s", "p50 us", "p99 us" );
+
+        initClient( &client, &plaintextServer, 0U );
+        status = benchmarkConnects( "Plaintext_Connect", &client );
+    }
+
+    if( status == 0 )
+    {
+        initClient( &client, &tlsServer, 0U );
+        status = benchmarkConnects( "Openssl_Connect", &client );
+    }
+
+    if( status == 0 )
+    {
+        initClient( &client, &tlsServer, 0U );
+
+        if( Openssl_CreateContext( &pClientContext, &client.credentials ) == OPENSSL_SUCCESS )
+        {
+            client.pSharedContext = pClientContext;
+            status = benchmarkConnects( "Openssl_ConnectWithContext", &client );
+        }
+        else
+        {
+            status = -1;
+        }
+    }
+
+    if( status == 0 )
+    {
+        /* MB/s counts the payload of one direction. */
+        printf( "\nEcho round trips (%u each)\n", BENCHMARK_ROUND_TRIPS );
+        printf( "%-20s %6s %8s %10s %10s %10s\n", "transport", "mfl", "size", "MB/s", "p50 us", "p99 us" );
+
+        initClient( &client, &plaintextServer, 0U );
+        status = benchmarkRoundTrips( "plaintext", &client );
+    }
+
+    for( i = 0U; ( i < ( sizeof( maxFragmentLengths ) / sizeof( maxFragmentLengths[ 0 ] ) ) ) && ( status == 0 ); i++ )
+    {
+        initClient( &client, &tlsServer, maxFragmentLengths[ i ] );
+        client.pSharedContext = pClientContext;
+        status = benchmarkRoundTrips( "openssl", &client );
+    }
+
+    if( serversStarted == 1 )
+    {
+        stopServer( &plaintextServer );
+        stopServer( &tlsServer );
+    }
+
+    Openssl_FreeContext( pClientContext );
+    SSL_CTX_free( pServerContext );
+
+    if( status != 0 )
+    {
+        fprintf( stderr, "Benchmark failed.\n" );
+    }
+
+    return ( status == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,235 @@
+/*
+ * AWS IoT Device SDK for Embedded C 202103.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef EVENT_LOOP_POSIX_H_
+#define EVENT_LOOP_POSIX_H_
+
+/**************************************************/
+/******* DO NOT CHANGE the following order ********/
+/**************************************************/
+
+/* Logging related header files are required to be included in the following order:
+ * 1. Include the header file "logging_levels.h".
+ * 2. Define LIBRARY_LOG_NAME and  LIBRARY_LOG_LEVEL.
+ * 3. Include the header file "logging_stack.h".
+ */
+
+/* Include header that defines log levels. */
+#include "logging_levels.h"
+
+/* Logging configuration for the event loop. */
+#ifndef LIBRARY_LOG_NAME
+    #define LIBRARY_LOG_NAME     "EventLoop"
+#endif
+#ifndef LIBRARY_LOG_LEVEL
+    #define LIBRARY_LOG_LEVEL    LOG_ERROR
+#endif
+
+#include "logging_stack.h"
+
+/************ End of logging configuration ****************/
+
+/* Transport interface include. */
+#include "transport_interface.h"
+
+/**
+ * @brief Maximum number of readiness events dispatched by one call to
+ * #EventLoop_Run.
+ */
+#ifndef EVENT_LOOP_MAX_EVENTS
+    #define EVENT_LOOP_MAX_EVENTS    ( 16U )
+#endif
+
+/**
+ * @brief Timeout to pass to #EventLoop_Run to wait until an event occurs.
+ */
+#define EVENT_LOOP_WAIT_FOREVER      ( UINT32_MAX )
+
+/**
+ * @brief The connection has data to read.
+ */
+#define EVENT_LOOP_READABLE          ( 1U << 0 )
+
+/**
+ * @brief The connection can accept data to send.
+ */
+#define EVENT_LOOP_WRITABLE          ( 1U << 1 )
+
+/**
+ * @brief The connection was closed by the peer or is in error.
+ *
+ * @note This event is always reported and does not need to be requested.
+ */
+#define EVENT_LOOP_HANGUP            ( 1U << 2 )
+
+/**
+ * @brief Event loop return status.
+ */
+typedef enum EventLoopStatus
+{
+    EVENT_LOOP_SUCCESS = 0,         /**< Function successfully completed. */
+    EVENT_LOOP_INVALID_PARAMETER,   /**< At least one parameter was invalid. */
+    EVENT_LOOP_INSUFFICIENT_MEMORY, /**< Insufficient memory or descriptors to complete the operation. */
+    EVENT_LOOP_API_ERROR            /**< A call to a system API resulted in an internal error. */
+} EventLoopStatus_t;
+
+/**
+ * @brief Callback invoked when a connection owned by the event loop becomes
+ * ready.
+ *
+ * @param[in] pNetworkContext The network context of the connection.
+ * @param[in] events Bitwise OR of #EVENT_LOOP_READABLE, #EVENT_LOOP_WRITABLE
+ * and #EVENT_LOOP_HANGUP.
+ * @param[in] pUserData The user data passed to #EventLoop_Add.
+ */
+typedef void ( * EventLoopCallback_t )( NetworkContext_t * pNetworkContext,
+                                        uint32_t events,
+                                        void * pUserData );
+
+/**
+ * @brief A connection owned by an event loop.
+ *
+ * @note The memory is provided by the application and must remain valid until
+ * the connection is removed with #EventLoop_Remove. Its members are set by
+ * #EventLoop_Add and must not be modified directly.
+ */
+typedef struct EventLoopConnection
+{
+    NetworkContext_t * pNetworkContext; /**< @brief Network context passed to the callback. */
+    int32_t socketDescriptor;           /**< @brief Socket of the connection. */
+    EventLoopCallback_t callback;       /**< @brief Callback invoked when the connection is ready. */
+    void * pUserData;                   /**< @brief User data passed to the callback. */
+} EventLoopConnection_t;
+
+/**
+ * @brief An event loop that multiplexes many connections on a single thread.
+ */
+typedef struct EventLoop
+{
+    int32_t epollDescriptor; /**< @brief The epoll instance. */
+    size_t numConnections;   /**< @brief Number of connections owned by the event loop. */
+} EventLoop_t;
+
+/**
+ * @brief Create an event loop.
+ *
+ * @param[out] pEventLoop The event loop to initialize.
+ *
+ * @return #EVENT_LOOP_SUCCESS if successful; #EVENT_LOOP_INVALID_PARAMETER,
+ * #EVENT_LOOP_INSUFFICIENT_MEMORY, #EVENT_LOOP_API_ERROR on error.
+ */
+EventLoopStatus_t EventLoop_Init( EventLoop_t * pEventLoop );
+
+/**
+ * @brief Add a connection to the event loop.
+ *
+ * @param[in] pEventLoop The event loop.
+ * @param[out] pConnection Memory to track the connection in.
+ * @param[in] pNetworkContext The network context of the connection.
+ * @param[in] socketDescriptor The socket of the connection, such as the
+ * socketDescriptor member of #PlaintextParams_t or #OpensslParams_t.
+ * @param[in] events The events to wait for. Bitwise OR of #EVENT_LOOP_READABLE
+ * and #EVENT_LOOP_WRITABLE.
+ * @param[in] callback The callback to invoke when the connection is ready.
+ * @param[in] pUserData User data to pass to the callback.
+ *
+ * @note Readiness is level-triggered, so the callback is invoked again on the
+ * next #EventLoop_Run as long as the condition holds. Data already buffered
+ * by a TLS library is not visible to the event loop and must be drained by the
+ * application before waiting again.
+ *
+ * @return #EVENT_LOOP_SUCCESS if successful; #EVENT_LOOP_INVALID_PARAMETER,
+ * #EVENT_LOOP_INSUFFICIENT_MEMORY, #EVENT_LOOP_API_ERROR on error.
+ */
+EventLoopStatus_t EventLoop_Add( EventLoop_t * pEventLoop,
+                                 EventLoopConnection_t * pConnection,
+                                 NetworkContext_t * pNetworkContext,
+                                 int32_t socketDescriptor,
+                                 uint32_t events,
+                                 EventLoopCallback_t callback,
+                                 void * pUserData );
+
+/**
+ * @brief Change the events that a connection waits for.
+ *
+ * @param[in] pEventLoop The event loop.
+ * @param[in] pConnection The connection added with #EventLoop_Add.
+ * @param[in] events The events to wait for. Bitwise OR of #EVENT_LOOP_READABLE
+ * and #EVENT_LOOP_WRITABLE.
+ *
+ * @return #EVENT_LOOP_SUCCESS if successful; #EVENT_LOOP_INVALID_PARAMETER,
+ * #EVENT_LOOP_INSUFFICIENT_MEMORY, #EVENT_LOOP_API_ERROR on error.
+ */
+EventLoopStatus_t EventLoop_Modify( const EventLoop_t * pEventLoop,
+                                    EventLoopConnection_t * pConnection,
+                                    uint32_t events );
+
+/**
+ * @brief Remove a connection from the event loop.
+ *
+ * The connection itself is left open.
+ *
+ * @param[in] pEventLoop The event loop.
+ * @param[in] pConnection The connection added with #EventLoop_Add.
+ *
+ * @note Callbacks may remove connections while #EventLoop_Run is dispatching
+ * events. The memory of a removed connection must then remain valid until
+ * #EventLoop_Run returns.
+ *
+ * @return #EVENT_LOOP_SUCCESS if successful; #EVENT_LOOP_INVALID_PARAMETER,
+ * #EVENT_LOOP_API_ERROR on error.
+ */
+EventLoopStatus_t EventLoop_Remove( EventLoop_t * pEventLoop,
+                                    EventLoopConnection_t * pConnection );
+
+/**
+ * @brief Wait for connections to become ready and invoke their callbacks.
+ *
+ * At most #EVENT_LOOP_MAX_EVENTS callbacks are invoked per call, so this
+ * function is meant to be called in a loop.
+ *
+ * @param[in] pEventLoop The event loop.
+ * @param[in] timeoutMs Time to wait for an event. 0 returns immediately and
+ * #EVENT_LOOP_WAIT_FOREVER waits without a timeout.
+ * @param[out] pNumDispatched Number of callbacks invoked. May be NULL.
+ *
+ * @return #EVENT_LOOP_SUCCESS if successful, including when the timeout
+ * expired or the wait was interrupted by a signal;
+ * #EVENT_LOOP_INVALID_PARAMETER, #EVENT_LOOP_API_ERROR on error.
+ */
+EventLoopStatus_t EventLoop_Run( const EventLoop_t * pEventLoop,
+                                 uint32_t timeoutMs,
+                                 size_t * pNumDispatched );
+
+/**
+ * @brief Destroy an event loop.
+ *
+ * The connections it owns are left open.
+ *
+ * @param[in] pEventLoop The event loop.
+ *
+ * @return #EVENT_LOOP_SUCCESS if successful; #EVENT_LOOP_INVALID_PARAMETER on
+ * error.
+ */
+EventLoopStatus_t EventLoop_Deinit( EventLoop_t * pEventLoop );
+
+#endif /* ifndef EVENT_LOOP_POSIX_H_ */
@@ -49,6 +49,10 @@
 
 /************ End of logging configuration ****************/
 
+/* Standard includes. */
+#include <sys/types.h>
+#include <sys/uio.h>
+
 /* OpenSSL include. */
 #include <openssl/ssl.h>
 
@@ -57,6 +61,41 @@
 
 /* Socket include. */
 #include "sockets_posix.h"
+#include "transport_stats_posix.h"
+
+/**
+ * @brief Size of the stack buffer in which #Openssl_Writev coalesces small
+ * buffers before writing them as one TLS record.
+ *
+ * The default is the maximum plaintext length of a TLS record. Buffers at
+ * least this large are written without being copied.
+ */
+#ifndef OPENSSL_WRITEV_BUFFER_SIZE
+    #define OPENSSL_WRITEV_BUFFER_SIZE    ( 16384U )
+#endif
+
+/**
+ * @brief Counters of the receive path of a TLS connection.
+ *
+ * @note The average number of bytes read from the TLS layer per SSL_read is
+ * bytesReceived / sslReadCalls. With a read-ahead buffer, many small
+ * #Openssl_Recv calls are served from memory and this ratio grows.
+ *
+ * @note These counters are always kept, as they cost one increment per call,
+ * and they measure what the caller sees: every #Openssl_Recv call, including
+ * those served from the read-ahead buffer. The optional #TransportStats_t of
+ * the connection instead counts at the TLS layer, like the plaintext
+ * transport counts at the socket. Its recvCalls counts the same SSL_read
+ * calls as sslReadCalls, and its bytesReceived includes bytes that the
+ * read-ahead buffer still holds. #TransportStats_t keeps counting across
+ * reconnects, while these counters are reset by #Openssl_Connect.
+ */
+typedef struct OpensslRecvStats
+{
+    uint64_t recvCalls;     /**< @brief Calls to #Openssl_Recv. */
+    uint64_t sslReadCalls;  /**< @brief Calls to SSL_read, the only ones that may read from the socket. */
+    uint64_t bytesReceived; /**< @brief Bytes returned by #Openssl_Recv. */
+} OpensslRecvStats_t;
 
 /**
  * @brief Parameters for the transport-interface
@@ -69,6 +108,44 @@ typedef struct OpensslParams
 {
     int32_t socketDescriptor;
     SSL * pSsl;
+
+    /**
+     * @brief Set by #Openssl_Connect to 1 if the TLS session was resumed
+     * from the session stored in #OpensslCredentials_t.ppSession, or to 0
+     * if a full handshake was performed.
+     */
+    uint8_t sessionResumed;
+
+    /**
+     * @brief Read-ahead state set up by #Openssl_Connect from
+     * #OpensslCredentials_t.pReadAheadBuffer. Bytes of the buffer from
+     * readAheadOffset to readAheadOffset + readAheadLength have been
+     * decrypted but not yet returned by #Openssl_Recv.
+     */
+    uint8_t * pReadAheadBuffer;
+    size_t readAheadBufferSize;
+    size_t readAheadOffset;
+    size_t readAheadLength;
+
+    OpensslRecvStats_t recvStats; /**< @brief Reset by #Openssl_Connect. */
+
+    /**
+     * @brief Set by #Openssl_Connect to 1 if kernel TLS took over record
+     * encryption (ktlsSend) or decryption (ktlsRecv) of the connection, or
+     * to 0 if OpenSSL handles it in user space.
+     */
+    uint8_t ktlsSend;
+    uint8_t ktlsRecv;
+
+    /**
+     * @brief Set by #Openssl_Connect to 1 if the socket was switched to
+     * non-blocking mode after the handshake.
+     */
+    uint8_t nonBlocking;
+
+    #if ( TRANSPORT_STATS_ENABLED == 1 )
+        TransportStats_t stats; /**< @brief Statistics of the connection. Read them with #Openssl_GetStats. */
+    #endif
 } OpensslParams_t;
 
 /**
@@ -132,6 +209,78 @@ typedef struct OpensslCredentials
     const char * pRootCaPath;     /**< @brief Filepath string to the trusted server root CA. */
     const char * pClientCertPath; /**< @brief Filepath string to the client certificate. */
     const char * pPrivateKeyPath; /**< @brief Filepath string to the client certificate's private key. */
+
+    /**
+     * @brief Storage for a TLS session to resume on the next connection.
+     * Set to NULL to disable session resumption.
+     *
+     * When this points to an #SSL_SESSION pointer, the session negotiated
+     * with the server is stored in it, and it is offered to the server on
+     * the next connection with the same credentials. This skips the
+     * certificate exchange and verification when the server accepts it.
+     * With TLS 1.3, the session ticket is only sent by the server after the
+     * handshake, so it is stored on the first receive from the server.
+     *
+     * @note The pointed to session must be initialized to NULL, must only be
+     * used with a single server, and must not be shared between concurrent
+     * connections. It must be freed with SSL_SESSION_free once no longer
+     * needed.
+     */
+    SSL_SESSION ** ppSession;
+
+    /**
+     * @brief Options applied to the TCP socket before connecting, such as
+     * TCP_NODELAY for latency sensitive traffic. Set to NULL to keep the
+     * system defaults.
+     */
+    const SocketsOptions_t * pSocketsOptions;
+
+    /**
+     * @brief Buffer into which #Openssl_Recv decrypts ahead of the caller.
+     * Set to NULL to read directly into the buffers of the caller.
+     *
+     * The MQTT and HTTP libraries read a packet a few bytes at a time. With
+     * a read-ahead buffer, each SSL_read fills the buffer and the following
+     * small reads are served from memory. OpenSSL read-ahead is enabled as
+     * well so that it reads as much as is available from the socket at once.
+     *
+     * @note The buffer must stay valid until #Openssl_Disconnect and must not
+     * be shared between connections. Data held in it is not visible to
+     * select or poll on the socket, so a connection must be drained with
+     * #Openssl_Recv before waiting on its socket.
+     */
+    uint8_t * pReadAheadBuffer;
+    size_t readAheadBufferSize; /**< @brief Size of #OpensslCredentials_t.pReadAheadBuffer. */
+
+    /**
+     * @brief Set to 1 to let the kernel encrypt and decrypt TLS records
+     * (kTLS) once the handshake is done. Set to 0 to disable kTLS.
+     *
+     * kTLS is only engaged when OpenSSL is built with it, the kernel has the
+     * tls module loaded and the negotiated cipher is supported by the
+     * kernel. Otherwise the connection silently keeps using OpenSSL for the
+     * record layer. Use #Openssl_GetKtlsStatus to find out which way it went.
+     *
+     * @note With kTLS send offload, #Openssl_SendFile hands file data to the
+     * kernel without copying it through user space.
+     */
+    uint8_t enableKtls;
+
+    /**
+     * @brief Set to 1 to switch the socket to non-blocking mode once the
+     * handshake is done. Set to 0 to keep blocking sends and receives.
+     *
+     * In non-blocking mode, #Openssl_Send and #Openssl_Recv return 0 instead
+     * of waiting when OpenSSL reports SSL_ERROR_WANT_READ or
+     * SSL_ERROR_WANT_WRITE, which the transport interface defines as "retry
+     * later". The socket returned by #Openssl_GetSocketDescriptor can then be
+     * polled, so that a single thread can service many connections.
+     *
+     * @note The handshake itself is still performed in blocking mode with the
+     * send and receive timeouts given to #Openssl_Connect. A send that
+     * returned 0 must be retried with the same data.
+     */
+    uint8_t nonBlocking;
 } OpensslCredentials_t;
 
 /**
@@ -155,6 +304,73 @@ OpensslStatus_t Openssl_Connect( NetworkContext_t * pNetworkContext,
                                  uint32_t sendTimeoutMs,
                                  uint32_t recvTimeoutMs );
 
+/**
+ * @brief Creates an SSL context with the root CA, client certificate and
+ * private key from @p pOpensslCredentials loaded into it.
+ *
+ * The returned context can be passed to #Openssl_ConnectWithContext any number
+ * of times, so that the credential files are only read and parsed once.
+ *
+ * The SSL context is reference counted by OpenSSL. Each TLS session created
+ * from it holds its own reference, which is dropped by #Openssl_Disconnect.
+ * Once no more connections are to be made with it, the caller must drop its
+ * own reference with #Openssl_FreeContext.
+ *
+ * @note Only the credential file paths of @p pOpensslCredentials are used by
+ * this function. Per-connection options such as SNI, ALPN and MFLN are taken
+ * from the credentials passed to #Openssl_ConnectWithContext.
+ *
+ * @param[out] ppSslContext The output parameter to return the created SSL context.
+ * @param[in] pOpensslCredentials Credentials to load into the SSL context.
+ *
+ * @return #OPENSSL_SUCCESS on success;
+ * #OPENSSL_INVALID_PARAMETER, #OPENSSL_API_ERROR, #OPENSSL_INVALID_CREDENTIALS
+ * on failure.
+ */
+OpensslStatus_t Openssl_CreateContext( SSL_CTX ** ppSslContext,
+                                       const OpensslCredentials_t * pOpensslCredentials );
+
+/**
+ * @brief Drops the caller's reference to an SSL context created with
+ * #Openssl_CreateContext.
+ *
+ * Established TLS sessions keep their own reference to the context, so they
+ * remain usable until they are closed with #Openssl_Disconnect.
+ *
+ * @param[in] pSslContext The SSL context to release.
+ */
+void Openssl_FreeContext( SSL_CTX * pSslContext );
+
+/**
+ * @brief Sets up a TLS session on top of a TCP connection using an SSL context
+ * previously created with #Openssl_CreateContext.
+ *
+ * This skips reading and parsing the credential files, which makes it
+ * suitable for frequent reconnections. A single SSL context may be used
+ * concurrently from multiple threads, as long as it is not modified after
+ * creation.
+ *
+ * @param[out] pNetworkContext The output parameter to return the created network context.
+ * @param[in] pServerInfo Server connection info.
+ * @param[in] pSslContext SSL context created with #Openssl_CreateContext.
+ * @param[in] pOpensslCredentials Credentials containing the per-connection
+ * configurations (SNI, ALPN and MFLN) for the TLS connection.
+ * @param[in] sendTimeoutMs Timeout for transport send.
+ * @param[in] recvTimeoutMs Timeout for transport recv.
+ *
+ * @note A timeout of 0 means infinite timeout.
+ *
+ * @return #OPENSSL_SUCCESS on success;
+ * #OPENSSL_INVALID_PARAMETER, #OPENSSL_API_ERROR, #OPENSSL_HANDSHAKE_FAILED,
+ * #OPENSSL_DNS_FAILURE, #OPENSSL_CONNECT_FAILURE on failure.
+ */
+OpensslStatus_t Openssl_ConnectWithContext( NetworkContext_t * pNetworkContext,
+                                            const ServerInfo_t * pServerInfo,
+                                            SSL_CTX * pSslContext,
+                                            const OpensslCredentials_t * pOpensslCredentials,
+                                            uint32_t sendTimeoutMs,
+                                            uint32_t recvTimeoutMs );
+
 /**
  * @brief Closes a TLS session on top of a TCP connection using the OpenSSL API.
  *
@@ -177,11 +393,90 @@ OpensslStatus_t Openssl_Disconnect( const NetworkContext_t * pNetworkContext );
  *
  * @return Number of bytes received if successful; negative value to indicate failure.
  * A return value of zero represents that the receive operation can be retried.
+ *
+ * @note In blocking mode, zero is returned only when OpenSSL needs to read
+ * more from the socket before it can return data. With
+ * #OpensslCredentials_t.nonBlocking set, zero is also returned when the
+ * socket has no data yet; poll the socket of #Openssl_GetSocketDescriptor
+ * for reading before retrying.
  */
 int32_t Openssl_Recv( NetworkContext_t * pNetworkContext,
                       void * pBuffer,
                       size_t bytesToRecv );
 
+/**
+ * @brief Get the receive counters of a TLS connection.
+ *
+ * Use these counters to tell how well the read-ahead buffer saves reads from
+ * the TLS layer. See #OpensslRecvStats_t for how they relate to
+ * #Openssl_GetStats.
+ *
+ * @param[in] pNetworkContext The network context created using Openssl_Connect API.
+ * @param[out] pStats The counters since the connection was established.
+ *
+ * @return #OPENSSL_SUCCESS if successful; #OPENSSL_INVALID_PARAMETER if any
+ * parameter is NULL.
+ */
+OpensslStatus_t Openssl_GetRecvStats( const NetworkContext_t * pNetworkContext,
+                                      OpensslRecvStats_t * pStats );
+
+#if ( TRANSPORT_STATS_ENABLED == 1 )
+
+    /**
+     * @brief Take a snapshot of the statistics of a TLS connection.
+     *
+     * Unlike #Openssl_GetRecvStats, the statistics cover both directions and
+     * are kept across reconnects. This may be called from another thread
+     * while the connection is in use. Receives are counted per SSL_read, so
+     * #Openssl_Recv calls served from the read-ahead buffer are not counted.
+     *
+     * @param[in] pNetworkContext The network context created using Openssl_Connect API.
+     * @param[out] pStats The snapshot of the statistics.
+     *
+     * @return #OPENSSL_SUCCESS if successful; #OPENSSL_INVALID_PARAMETER if any
+     * parameter is NULL.
+     */
+    OpensslStatus_t Openssl_GetStats( const NetworkContext_t * pNetworkContext,
+                                      TransportStats_t * pStats );
+#endif
+
+/**
+ * @brief Get the socket of a TLS connection, so that it can be polled.
+ *
+ * @note Bytes already decrypted by OpenSSL, or held in the read-ahead buffer,
+ * do not make the socket readable. Check #Openssl_HasPendingData before
+ * waiting for the socket to become readable.
+ *
+ * @param[in] pNetworkContext The network context created using Openssl_Connect API.
+ *
+ * @return The socket descriptor; -1 if @p pNetworkContext is NULL.
+ */
+int32_t Openssl_GetSocketDescriptor( const NetworkContext_t * pNetworkContext );
+
+/**
+ * @brief Get whether received data can be returned by #Openssl_Recv without
+ * reading from the socket.
+ *
+ * @param[in] pNetworkContext The network context created using Openssl_Connect API.
+ *
+ * @return 1 if decrypted data is waiting to be received; 0 otherwise.
+ */
+uint8_t Openssl_HasPendingData( const NetworkContext_t * pNetworkContext );
+
+/**
+ * @brief Get whether kernel TLS was engaged on a TLS connection.
+ *
+ * @param[in] pNetworkContext The network context created using Openssl_Connect API.
+ * @param[out] pSendOffload Set to 1 if records are encrypted by the kernel.
+ * @param[out] pRecvOffload Set to 1 if records are decrypted by the kernel.
+ *
+ * @return #OPENSSL_SUCCESS if successful; #OPENSSL_INVALID_PARAMETER if any
+ * parameter is NULL.
+ */
+OpensslStatus_t Openssl_GetKtlsStatus( const NetworkContext_t * pNetworkContext,
+                                       uint8_t * pSendOffload,
+                                       uint8_t * pRecvOffload );
+
 /**
  * @brief Sends data over an established TLS session using the OpenSSL API.
  *
@@ -192,13 +487,70 @@ int32_t Openssl_Recv( NetworkContext_t * pNetworkContext,
  * @param[in] pBuffer Buffer containing the bytes to send over the network stack.
  * @param[in] bytesToSend Number of bytes to send over the network.
  *
- * @return Number of bytes sent if successful; negative value on error.
+ * @return Number of bytes sent if successful; negative value on error. Zero
+ * if nothing was sent and the send can be retried.
  *
- * @note This function does not return zero value because it cannot be retried
- * on send operation failure.
+ * @note In blocking mode, this function does not return zero on a send
+ * failure, as such a failure cannot be retried. With
+ * #OpensslCredentials_t.nonBlocking set, zero is returned when OpenSSL reports
+ * SSL_ERROR_WANT_READ or SSL_ERROR_WANT_WRITE. Poll the socket of
+ * #Openssl_GetSocketDescriptor and then call this function again with the
+ * same data, as OpenSSL may already hold part of it in a pending record.
  */
 int32_t Openssl_Send( NetworkContext_t * pNetworkContext,
                       const void * pBuffer,
                       size_t bytesToSend );
 
+/**
+ * @brief Sends several buffers over an established TLS session in as few TLS
+ * records as possible.
+ *
+ * Consecutive buffers are copied into a buffer of #OPENSSL_WRITEV_BUFFER_SIZE
+ * bytes and written with one SSL_write, so that e.g. the header and the
+ * payload of a small packet share a single TLS record rather than paying the
+ * record overhead twice. The layout of struct iovec matches the
+ * TransportOutVector_t of later versions of the transport interface.
+ *
+ * @param[in] pNetworkContext The network context created using Openssl_Connect API.
+ * @param[in] pIoVec Array of buffers to send, in order.
+ * @param[in] ioVecCount Number of entries in @p pIoVec.
+ *
+ * @return Number of bytes sent if successful; negative value on error. If an
+ * error occurs after some of the bytes were sent, the number of bytes sent is
+ * returned. At most INT32_MAX bytes are sent per call, so a short count is
+ * also returned when the buffers hold more than that.
+ *
+ * @note With #OpensslCredentials_t.nonBlocking set, zero is returned when
+ * nothing could be sent yet, and a short count when a write after the first
+ * had to wait. Retry with the buffers that follow the bytes already sent, as
+ * for #Openssl_Send.
+ */
+int32_t Openssl_Writev( NetworkContext_t * pNetworkContext,
+                        const struct iovec * pIoVec,
+                        size_t ioVecCount );
+
+/**
+ * @brief Sends part of a file over an established TLS session.
+ *
+ * When kTLS send offload is engaged, the file is sent with SSL_sendfile and
+ * its data never enters user space. Otherwise, up to
+ * #OPENSSL_WRITEV_BUFFER_SIZE bytes are read from the file with pread and
+ * written with SSL_write. In both cases the file offset is left unchanged.
+ *
+ * Like #Openssl_Send, this may send fewer bytes than requested, so it
+ * should be called in a loop until the whole range has been sent. In
+ * non-blocking mode it returns zero when the send can be retried.
+ *
+ * @param[in] pNetworkContext The network context created using Openssl_Connect API.
+ * @param[in] fileDescriptor Descriptor of a regular file open for reading.
+ * @param[in] offset Offset in the file of the first byte to send.
+ * @param[in] bytesToSend Number of bytes of the file to send.
+ *
+ * @return Number of bytes sent if successful; negative value on error.
+ */
+int32_t Openssl_SendFile( NetworkContext_t * pNetworkContext,
+                          int32_t fileDescriptor,
+                          off_t offset,
+                          size_t bytesToSend );
+
 #endif /* ifndef OPENSSL_POSIX_H_ */
@@ -49,9 +49,13 @@
 
 /************ End of logging configuration ****************/
 
+/* Standard includes. */
+#include <sys/uio.h>
+
 /* Transport includes. */
 #include "transport_interface.h"
 #include "sockets_posix.h"
+#include "transport_stats_posix.h"
 
 /**
  * @brief Parameters for the transport-interface
@@ -60,6 +64,11 @@
 typedef struct PlaintextParams
 {
     int32_t socketDescriptor;
+    uint32_t sendTimeoutMs; /**< @brief Timeout for socket send. Set by #Plaintext_Connect and #Plaintext_SetTimeouts. */
+    uint32_t recvTimeoutMs; /**< @brief Timeout for socket recv. Set by #Plaintext_Connect and #Plaintext_SetTimeouts. */
+    #if ( TRANSPORT_STATS_ENABLED == 1 )
+        TransportStats_t stats; /**< @brief Statistics of the connection. Read them with #Plaintext_GetStats. */
+    #endif
 } PlaintextParams_t;
 
 /**
@@ -80,6 +89,28 @@ SocketStatus_t Plaintext_Connect( NetworkContext_t * pNetworkContext,
                                   uint32_t sendTimeoutMs,
                                   uint32_t recvTimeoutMs );
 
+/**
+ * @brief Establish TCP connection to server with socket options such as
+ * TCP_NODELAY.
+ *
+ * @param[out] pNetworkContext The output parameter to return the created network context.
+ * @param[in] pServerInfo Server connection info.
+ * @param[in] sendTimeoutMs Timeout for socket send.
+ * @param[in] recvTimeoutMs Timeout for socket recv.
+ * @param[in] pSocketsOptions Options to apply to the socket, or NULL to keep
+ * the system defaults. See #Sockets_ConnectWithOptions.
+ *
+ * @note A timeout of 0 means infinite timeout.
+ *
+ * @return #SOCKETS_SUCCESS if successful;
+ * #SOCKETS_INVALID_PARAMETER, #SOCKETS_DNS_FAILURE, #SOCKETS_CONNECT_FAILURE on error.
+ */
+SocketStatus_t Plaintext_ConnectWithOptions( NetworkContext_t * pNetworkContext,
+                                             const ServerInfo_t * pServerInfo,
+                                             uint32_t sendTimeoutMs,
+                                             uint32_t recvTimeoutMs,
+                                             const SocketsOptions_t * pSocketsOptions );
+
 /**
  * @brief Close TCP connection to server.
  *
@@ -89,6 +120,25 @@ SocketStatus_t Plaintext_Connect( NetworkContext_t * pNetworkContext,
  */
 SocketStatus_t Plaintext_Disconnect( const NetworkContext_t * pNetworkContext );
 
+/**
+ * @brief Change the send and receive timeouts of an established TCP connection.
+ *
+ * For example, an application may use a long timeout while waiting for the
+ * MQTT CONNACK and a short one while calling MQTT_ProcessLoop.
+ *
+ * @param[in] pNetworkContext The network context created using Plaintext_Connect API.
+ * @param[in] sendTimeoutMs Timeout for socket send.
+ * @param[in] recvTimeoutMs Timeout for socket recv.
+ *
+ * @note A timeout of 0 means infinite timeout.
+ *
+ * @return #SOCKETS_SUCCESS if successful; #SOCKETS_INVALID_PARAMETER,
+ * #SOCKETS_INSUFFICIENT_MEMORY, #SOCKETS_API_ERROR on error.
+ */
+SocketStatus_t Plaintext_SetTimeouts( NetworkContext_t * pNetworkContext,
+                                      uint32_t sendTimeoutMs,
+                                      uint32_t recvTimeoutMs );
+
 /**
  * @brief Receives data over an established TCP connection.
  *
@@ -121,4 +171,42 @@ int32_t Plaintext_Send( NetworkContext_t * pNetworkContext,
                         const void * pBuffer,
                         size_t bytesToSend );
 
+/**
+ * @brief Sends several buffers over an established TCP connection with a
+ * single system call.
+ *
+ * Sending e.g. the header and the payload of a packet together lets them share
+ * a TCP segment instead of waiting on Nagle's algorithm and delayed ACKs
+ * between two separate sends. The layout of struct iovec matches the
+ * TransportOutVector_t of later versions of the transport interface.
+ *
+ * @param[in] pNetworkContext The network context created using Plaintext_Connect API.
+ * @param[in] pIoVec Array of buffers to send, in order.
+ * @param[in] ioVecCount Number of entries in @p pIoVec. Entries beyond UIO_MAXIOV
+ * are not sent by this call.
+ *
+ * @return Number of bytes sent, which may be less than the total length of the
+ * buffers; zero if the socket did not become writable within the send timeout;
+ * negative value on error.
+ */
+int32_t Plaintext_Writev( NetworkContext_t * pNetworkContext,
+                          const struct iovec * pIoVec,
+                          size_t ioVecCount );
+
+#if ( TRANSPORT_STATS_ENABLED == 1 )
+
+    /**
+     * @brief Take a snapshot of the statistics of a connection.
+     *
+     * This may be called from another thread while the connection is in use.
+     *
+     * @param[in] pNetworkContext The network context created using Plaintext_Connect API.
+     * @param[out] pStats The snapshot of the statistics.
+     *
+     * @return #SOCKETS_SUCCESS if successful; #SOCKETS_INVALID_PARAMETER on error.
+     */
+    SocketStatus_t Plaintext_GetStats( const NetworkContext_t * pNetworkContext,
+                                       TransportStats_t * pStats );
+#endif
+
 #endif /* ifndef PLAINTEXT_POSIX_H_ */
@@ -51,6 +51,50 @@
 /* Transport interface include. */
 #include "transport_interface.h"
 
+/**
+ * @brief Delay in milliseconds before a connection attempt to the next
+ * resolved address is started while earlier attempts are still in progress.
+ *
+ * @note RFC 8305 recommends a value of 250 milliseconds.
+ */
+#ifndef SOCKETS_CONNECT_ATTEMPT_DELAY_MS
+    #define SOCKETS_CONNECT_ATTEMPT_DELAY_MS    ( 250U )
+#endif
+
+/**
+ * @brief Overall time in milliseconds that #Sockets_Connect may spend
+ * establishing a TCP connection across all resolved addresses.
+ */
+#ifndef SOCKETS_CONNECT_TIMEOUT_MS
+    #define SOCKETS_CONNECT_TIMEOUT_MS    ( 10000U )
+#endif
+
+/**
+ * @brief Maximum number of resolved addresses that #Sockets_Connect will try.
+ */
+#ifndef SOCKETS_MAX_CONNECT_ATTEMPTS
+    #define SOCKETS_MAX_CONNECT_ATTEMPTS    ( 8U )
+#endif
+
+/**
+ * @brief Number of servers whose resolved addresses are cached by
+ * #Sockets_Connect.
+ */
+#ifndef SOCKETS_DNS_CACHE_SIZE
+    #define SOCKETS_DNS_CACHE_SIZE    ( 4U )
+#endif
+
+/**
+ * @brief Time in milliseconds for which #Sockets_Connect reuses the resolved
+ * addresses of a server.
+ *
+ * @note getaddrinfo does not report the TTL of the DNS records, so a fixed
+ * lifetime is used instead. A value of 0 disables the cache.
+ */
+#ifndef SOCKETS_DNS_CACHE_TTL_MS
+    #define SOCKETS_DNS_CACHE_TTL_MS    ( 60000U )
+#endif
+
 /**
  * @brief TCP Connect / Disconnect return status.
  */
@@ -74,6 +118,36 @@ typedef struct ServerInfo
     uint16_t port;          /**< @brief Server port in host-order. */
 } ServerInfo_t;
 
+/**
+ * @brief Counters of the DNS cache used by #Sockets_Connect.
+ */
+typedef struct SocketsDnsCacheStats
+{
+    uint32_t hits;   /**< @brief Connections that reused cached addresses. */
+    uint32_t misses; /**< @brief Connections that had to resolve the host name. */
+} SocketsDnsCacheStats_t;
+
+/**
+ * @brief Options applied to the socket before connecting to the server.
+ *
+ * A value of 0 leaves the system default of the corresponding option in
+ * place, so a zero-initialized structure changes nothing.
+ */
+typedef struct SocketsOptions
+{
+    uint8_t noDelay;               /**< @brief Set TCP_NODELAY to send small packets without Nagle batching. */
+    uint8_t keepAlive;             /**< @brief Set SO_KEEPALIVE to send TCP keepalive probes on an idle connection. */
+    uint32_t keepAliveIdleSec;     /**< @brief TCP_KEEPIDLE: idle time before the first keepalive probe. */
+    uint32_t keepAliveIntervalSec; /**< @brief TCP_KEEPINTVL: time between keepalive probes. */
+    uint32_t keepAliveCount;       /**< @brief TCP_KEEPCNT: unanswered probes before the connection is dropped. */
+    uint32_t userTimeoutMs;        /**< @brief TCP_USER_TIMEOUT: time sent data may stay unacknowledged before the connection is dropped. */
+    uint32_t sendBufferSize;       /**< @brief SO_SNDBUF: size of the socket send buffer in bytes. */
+    uint32_t recvBufferSize;       /**< @brief SO_RCVBUF: size of the socket receive buffer in bytes. */
+    uint8_t fastOpen;              /**< @brief Set TCP_FASTOPEN_CONNECT to send the first data with the SYN.
+                                    * Only applied when the host resolves to a single address, as the SYN of a
+                                    * fast open attempt is deferred and concurrent attempts cannot be raced. */
+} SocketsOptions_t;
+
 /**
  * @brief Establish a connection to server.
  *
@@ -84,6 +158,16 @@ typedef struct ServerInfo
  *
  * @note A timeout of 0 means infinite timeout.
  *
+ * @note Resolved addresses are tried in parallel, alternating between IPv6
+ * and IPv4 as described in RFC 8305. A new attempt is started every
+ * #SOCKETS_CONNECT_ATTEMPT_DELAY_MS milliseconds, or as soon as an earlier
+ * attempt fails, and the first attempt to complete wins. The whole connection
+ * phase is bounded by #SOCKETS_CONNECT_TIMEOUT_MS.
+ *
+ * @note The resolved addresses of the server are cached, keyed by host name
+ * and port, for #SOCKETS_DNS_CACHE_TTL_MS milliseconds. The cache entry is
+ * invalidated when no connection can be established to any of them.
+ *
  * @return #SOCKETS_SUCCESS if successful;
  * #SOCKETS_INVALID_PARAMETER, #SOCKETS_DNS_FAILURE, #SOCKETS_CONNECT_FAILURE on error.
  */
@@ -92,6 +176,63 @@ SocketStatus_t Sockets_Connect( int32_t * pTcpSocket,
                                 uint32_t sendTimeoutMs,
                                 uint32_t recvTimeoutMs );
 
+/**
+ * @brief Establish a connection to server with socket options.
+ *
+ * This behaves like #Sockets_Connect, but additionally applies
+ * @p pSocketsOptions to every socket before its connection attempt. A
+ * connection attempt fails if any of the requested options cannot be set.
+ *
+ * @param[out] pTcpSocket The output parameter to return the created socket descriptor.
+ * @param[in] pServerInfo Server connection info.
+ * @param[in] sendTimeoutMs Timeout for transport send.
+ * @param[in] recvTimeoutMs Timeout for transport recv.
+ * @param[in] pSocketsOptions Options to apply to the socket, or NULL to keep
+ * the system defaults.
+ *
+ * @return #SOCKETS_SUCCESS if successful;
+ * #SOCKETS_INVALID_PARAMETER, #SOCKETS_DNS_FAILURE, #SOCKETS_CONNECT_FAILURE on error.
+ */
+SocketStatus_t Sockets_ConnectWithOptions( int32_t * pTcpSocket,
+                                           const ServerInfo_t * pServerInfo,
+                                           uint32_t sendTimeoutMs,
+                                           uint32_t recvTimeoutMs,
+                                           const SocketsOptions_t * pSocketsOptions );
+
+/**
+ * @brief Set the send and receive timeouts of a connected socket.
+ *
+ * @param[in] tcpSocket The socket descriptor.
+ * @param[in] sendTimeoutMs Timeout for transport send.
+ * @param[in] recvTimeoutMs Timeout for transport recv.
+ *
+ * @note A timeout of 0 means infinite timeout.
+ *
+ * @return #SOCKETS_SUCCESS if successful; #SOCKETS_INVALID_PARAMETER,
+ * #SOCKETS_INSUFFICIENT_MEMORY, #SOCKETS_API_ERROR on error.
+ */
+SocketStatus_t Sockets_SetTimeouts( int32_t tcpSocket,
+                                    uint32_t sendTimeoutMs,
+                                    uint32_t recvTimeoutMs );
+
+/**
+ * @brief Remove cached DNS records so that the host name is resolved again on
+ * the next connection.
+ *
+ * @param[in] pServerInfo Server whose records to remove, or NULL to remove all
+ * records.
+ */
+void Sockets_InvalidateDnsCache( const ServerInfo_t * pServerInfo );
+
+/**
+ * @brief Get the hit and miss counters of the DNS cache.
+ *
+ * @param[out] pStats The counters.
+ *
+ * @return #SOCKETS_SUCCESS if successful; #SOCKETS_INVALID_PARAMETER on error.
+ */
+SocketStatus_t Sockets_GetDnsCacheStats( SocketsDnsCacheStats_t * pStats );
+
 /**
  * @brief End connection to server.
  *
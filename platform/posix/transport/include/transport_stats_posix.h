@@ -0,0 +1,195 @@
+/*
+ * AWS IoT Device SDK for Embedded C 202103.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef TRANSPORT_STATS_POSIX_H_
+#define TRANSPORT_STATS_POSIX_H_
+
+/**
+ * @file transport_stats_posix.h
+ * @brief Optional statistics of the plaintext and OpenSSL transports.
+ *
+ * When the transports are built with TRANSPORT_STATS_ENABLED set to 1, each
+ * #PlaintextParams_t and #OpensslParams_t carries a #TransportStats_t that
+ * counts the traffic of its connection and records the latencies of connect,
+ * handshake, send and receive. The counters are updated with relaxed atomic
+ * operations, so a telemetry thread may take a snapshot with
+ * #Plaintext_GetStats or #Openssl_GetStats while the connection is in use.
+ */
+
+/* Standard includes. */
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Set to 1 to collect statistics for every connection.
+ *
+ * The statistics take about 2 KB per connection and two reads of the
+ * monotonic clock per send and receive.
+ */
+#ifndef TRANSPORT_STATS_ENABLED
+    #define TRANSPORT_STATS_ENABLED    ( 0 )
+#endif
+
+/**
+ * @brief Number of bits of a latency, after its most significant one, that
+ * select the bucket of a #TransportHistogram_t.
+ *
+ * Each power of two is split in 2^TRANSPORT_STATS_SUB_BUCKET_BITS buckets of
+ * equal width, so a latency is recorded with a relative error below 25%.
+ */
+#define TRANSPORT_STATS_SUB_BUCKET_BITS      ( 2U )
+
+/**
+ * @brief Number of buckets in each power of two.
+ */
+#define TRANSPORT_STATS_SUB_BUCKETS          ( 1U << TRANSPORT_STATS_SUB_BUCKET_BITS )
+
+/**
+ * @brief Number of buckets of a #TransportHistogram_t, enough for any 32-bit
+ * latency in microseconds.
+ */
+#define TRANSPORT_STATS_HISTOGRAM_BUCKETS    ( ( 32U - TRANSPORT_STATS_SUB_BUCKET_BITS + 1U ) * TRANSPORT_STATS_SUB_BUCKETS )
+
+/**
+ * @brief Log-linear histogram of latencies in microseconds.
+ *
+ * Latencies below #TRANSPORT_STATS_SUB_BUCKETS have a bucket each. Above,
+ * bucket boundaries grow geometrically. Use #TransportStats_GetBucketLowerBound
+ * to export the boundaries with the counts.
+ */
+typedef struct TransportHistogram
+{
+    uint32_t counts[ TRANSPORT_STATS_HISTOGRAM_BUCKETS ]; /**< @brief Number of latencies in each bucket. */
+    uint64_t sumUs;                                       /**< @brief Sum of all recorded latencies. */
+} TransportHistogram_t;
+
+/**
+ * @brief Counters and latency histograms of one connection.
+ *
+ * @note The statistics accumulate across reconnects of the same parameters, so
+ * connects - 1 is the number of reconnects. Zero-initialize the
+ * transport parameters before their first connect.
+ */
+typedef struct TransportStats
+{
+    uint64_t bytesSent;          /**< @brief Bytes accepted by send calls. */
+    uint64_t bytesReceived;      /**< @brief Bytes read from the socket or the TLS layer. */
+    uint64_t sendCalls;          /**< @brief Calls that wrote to the socket or the TLS layer. */
+    uint64_t recvCalls;          /**< @brief Calls that read from the socket or the TLS layer. */
+    uint64_t partialSends;       /**< @brief Sends of fewer bytes than requested. */
+    uint64_t partialReads;       /**< @brief Receives of fewer bytes than requested. */
+    uint64_t timeouts;           /**< @brief Sends and receives that transferred nothing in time. */
+    uint64_t errors;             /**< @brief Sends and receives that failed. */
+    uint64_t connects;           /**< @brief Successful TCP connects. */
+    uint64_t connectFailures;    /**< @brief Failed TCP connects. */
+    uint64_t handshakeFailures;  /**< @brief Failed TLS handshakes. */
+    TransportHistogram_t connectUs;   /**< @brief Latency of successful TCP connects. */
+    TransportHistogram_t handshakeUs; /**< @brief Latency of successful TLS handshakes. */
+    TransportHistogram_t sendUs;      /**< @brief Latency of send calls. */
+    TransportHistogram_t recvUs;      /**< @brief Latency of receive calls, including the wait for data. */
+} TransportStats_t;
+
+/**
+ * @brief Add a latency to a histogram.
+ *
+ * @param[in] pHistogram The histogram to update.
+ * @param[in] latencyUs The latency in microseconds. Latencies that do not fit
+ * in 32 bits are recorded in the last bucket.
+ */
+void TransportStats_RecordLatency( TransportHistogram_t * pHistogram,
+                                   uint64_t latencyUs );
+
+/**
+ * @brief Record the outcome of a send or a receive.
+ *
+ * @param[in] pStats The statistics of the connection.
+ * @param[in] isSend 1 for a send, 0 for a receive.
+ * @param[in] bytesRequested Number of bytes the call was asked to transfer.
+ * @param[in] result The return value of the call: the number of bytes
+ * transferred, zero on timeout, negative on error.
+ * @param[in] latencyUs Duration of the call in microseconds.
+ */
+void TransportStats_RecordTransfer( TransportStats_t * pStats,
+                                    uint8_t isSend,
+                                    size_t bytesRequested,
+                                    int32_t result,
+                                    uint64_t latencyUs );
+
+/**
+ * @brief Record the outcome of a TCP connect.
+ *
+ * @param[in] pStats The statistics of the connection.
+ * @param[in] success 1 if the connect succeeded, 0 otherwise.
+ * @param[in] latencyUs Duration of the connect in microseconds. Only recorded
+ * if the connect succeeded.
+ */
+void TransportStats_RecordConnect( TransportStats_t * pStats,
+                                   uint8_t success,
+                                   uint64_t latencyUs );
+
+/**
+ * @brief Record the outcome of a TLS handshake.
+ *
+ * @param[in] pStats The statistics of the connection.
+ * @param[in] success 1 if the handshake succeeded, 0 otherwise.
+ * @param[in] latencyUs Duration of the handshake in microseconds. Only
+ * recorded if the handshake succeeded.
+ */
+void TransportStats_RecordHandshake( TransportStats_t * pStats,
+                                     uint8_t success,
+                                     uint64_t latencyUs );
+
+/**
+ * @brief Copy the statistics of a connection that may be in use by another
+ * thread.
+ *
+ * Each counter is read atomically, but the snapshot as a whole is not: a
+ * transfer that completes during the copy may be counted in some fields only.
+ *
+ * @param[in] pStats The statistics to copy.
+ * @param[out] pSnapshot The copy.
+ */
+void TransportStats_Snapshot( const TransportStats_t * pStats,
+                              TransportStats_t * pSnapshot );
+
+/**
+ * @brief Get the smallest latency of a histogram bucket.
+ *
+ * @param[in] bucket Index of the bucket, below #TRANSPORT_STATS_HISTOGRAM_BUCKETS.
+ *
+ * @return The smallest latency in microseconds recorded in @p bucket.
+ */
+uint32_t TransportStats_GetBucketLowerBound( size_t bucket );
+
+/**
+ * @brief Estimate a percentile of the latencies in a histogram.
+ *
+ * @param[in] pHistogram The histogram, usually taken from a snapshot.
+ * @param[in] percentile The percentile, from 0 to 100.
+ *
+ * @return The largest latency of the bucket that holds the percentile, or
+ * 0 if the histogram is empty.
+ */
+uint32_t TransportStats_GetPercentile( const TransportHistogram_t * pHistogram,
+                                       uint32_t percentile );
+
+#endif /* ifndef TRANSPORT_STATS_POSIX_H_ */
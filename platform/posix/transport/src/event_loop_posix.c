@@ -0,0 +1,376 @@
+/*
+ * AWS IoT Device SDK for Embedded C 202103.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Standard includes. */
+#include <assert.h>
+#include <string.h>
+
+/* POSIX includes. */
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+#include "event_loop_posix.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Convert a set of event loop events to epoll events.
+ *
+ * @param[in] events Bitwise OR of #EVENT_LOOP_READABLE and #EVENT_LOOP_WRITABLE.
+ *
+ * @return The epoll events.
+ */
+static uint32_t toEpollEvents( uint32_t events );
+
+/**
+ * @brief Convert a set of epoll events to event loop events.
+ *
+ * @param[in] epollEvents The epoll events.
+ *
+ * @return Bitwise OR of #EVENT_LOOP_READABLE, #EVENT_LOOP_WRITABLE and
+ * #EVENT_LOOP_HANGUP.
+ */
+static uint32_t fromEpollEvents( uint32_t epollEvents );
+
+/**
+ * @brief Log possible error using errno and return appropriate status.
+ *
+ * @param[in] errorNumber Error number.
+ *
+ * @return #EVENT_LOOP_API_ERROR, #EVENT_LOOP_INSUFFICIENT_MEMORY,
+ * #EVENT_LOOP_INVALID_PARAMETER on error.
+ */
+static EventLoopStatus_t retrieveError( int32_t errorNumber );
+
+/*-----------------------------------------------------------*/
+
+static uint32_t toEpollEvents( uint32_t events )
+{
+    /* Peer shutdown is always reported, as are errors and hang-ups by epoll. */
+    uint32_t epollEvents = ( uint32_t ) EPOLLRDHUP;
+
+    if( ( events & EVENT_LOOP_READABLE ) != 0U )
+    {
+        epollEvents |= ( uint32_t ) EPOLLIN;
+    }
+
+    if( ( events & EVENT_LOOP_WRITABLE ) != 0U )
+    {
+        epollEvents |= ( uint32_t ) EPOLLOUT;
+    }
+
+    return epollEvents;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t fromEpollEvents( uint32_t epollEvents )
+{
+    uint32_t events = 0U;
+
+    if( ( epollEvents & ( uint32_t ) EPOLLIN ) != 0U )
+    {
+        events |= EVENT_LOOP_READABLE;
+    }
+
+    if( ( epollEvents & ( uint32_t ) EPOLLOUT ) != 0U )
+    {
+        events |= EVENT_LOOP_WRITABLE;
+    }
+
+    if( ( epollEvents & ( ( uint32_t ) EPOLLRDHUP | ( uint32_t ) EPOLLHUP | ( uint32_t ) EPOLLERR ) ) != 0U )
+    {
+        events |= EVENT_LOOP_HANGUP;
+    }
+
+    return events;
+}
+/*-----------------------------------------------------------*/
+
+static EventLoopStatus_t retrieveError( int32_t errorNumber )
+{
+    EventLoopStatus_t returnStatus = EVENT_LOOP_API_ERROR;
+
+    LogError( ( "An event loop error occurred: %s.", strerror( errorNumber ) ) );
+
+    if( ( errorNumber == ENOMEM ) || ( errorNumber == ENOSPC ) ||
+        ( errorNumber == EMFILE ) || ( errorNumber == ENFILE ) )
+    {
+        returnStatus = EVENT_LOOP_INSUFFICIENT_MEMORY;
+    }
+    else if( ( errorNumber == EBADF ) || ( errorNumber == EEXIST ) ||
+             ( errorNumber == ENOENT ) || ( errorNumber == EPERM ) )
+    {
+        returnStatus = EVENT_LOOP_INVALID_PARAMETER;
+    }
+    else
+    {
+        /* Empty else. */
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+EventLoopStatus_t EventLoop_Init( EventLoop_t * pEventLoop )
+{
+    EventLoopStatus_t returnStatus = EVENT_LOOP_SUCCESS;
+
+    if( pEventLoop == NULL )
+    {
+        LogError( ( "Parameter check failed: pEventLoop is NULL." ) );
+        returnStatus = EVENT_LOOP_INVALID_PARAMETER;
+    }
+    else
+    {
+        pEventLoop->numConnections = 0U;
+        pEventLoop->epollDescriptor = epoll_create1( EPOLL_CLOEXEC );
+
+        if( pEventLoop->epollDescriptor < 0 )
+        {
+            LogError( ( "Failed to create epoll instance." ) );
+            returnStatus = retrieveError( errno );
+        }
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+EventLoopStatus_t EventLoop_Add( EventLoop_t * pEventLoop,
+                                 EventLoopConnection_t * pConnection,
+                                 NetworkContext_t * pNetworkContext,
+                                 int32_t socketDescriptor,
+                                 uint32_t events,
+                                 EventLoopCallback_t callback,
+                                 void * pUserData )
+{
+    EventLoopStatus_t returnStatus = EVENT_LOOP_SUCCESS;
+    struct epoll_event epollEvent;
+
+    if( ( pEventLoop == NULL ) || ( pEventLoop->epollDescriptor < 0 ) )
+    {
+        LogError( ( "Parameter check failed: pEventLoop is NULL or not initialized." ) );
+        returnStatus = EVENT_LOOP_INVALID_PARAMETER;
+    }
+    else if( pConnection == NULL )
+    {
+        LogError( ( "Parameter check failed: pConnection is NULL." ) );
+        returnStatus = EVENT_LOOP_INVALID_PARAMETER;
+    }
+    else if( socketDescriptor < 0 )
+    {
+        LogError( ( "Parameter check failed: socketDescriptor is negative." ) );
+        returnStatus = EVENT_LOOP_INVALID_PARAMETER;
+    }
+    else if( callback == NULL )
+    {
+        LogError( ( "Parameter check failed: callback is NULL." ) );
+        returnStatus = EVENT_LOOP_INVALID_PARAMETER;
+    }
+    else
+    {
+        pConnection->pNetworkContext = pNetworkContext;
+        pConnection->socketDescriptor = socketDescriptor;
+        pConnection->callback = callback;
+        pConnection->pUserData = pUserData;
+
+        ( void ) memset( &epollEvent, 0, sizeof( epollEvent ) );
+        epollEvent.events = toEpollEvents( events );
+        epollEvent.data.ptr = pConnection;
+
+        if( epoll_ctl( pEventLoop->epollDescriptor,
+                       EPOLL_CTL_ADD,
+                       socketDescriptor,
+                       &epollEvent ) != 0 )
+        {
+            LogError( ( "Failed to add socket %d to the event loop.",
+                        ( int ) socketDescriptor ) );
+            returnStatus = retrieveError( errno );
+        }
+        else
+        {
+            pEventLoop->numConnections++;
+        }
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+EventLoopStatus_t EventLoop_Modify( const EventLoop_t * pEventLoop,
+                                    EventLoopConnection_t * pConnection,
+                                    uint32_t events )
+{
+    EventLoopStatus_t returnStatus = EVENT_LOOP_SUCCESS;
+    struct epoll_event epollEvent;
+
+    if( ( pEventLoop == NULL ) || ( pEventLoop->epollDescriptor < 0 ) )
+    {
+        LogError( ( "Parameter check failed: pEventLoop is NULL or not initialized." ) );
+        returnStatus = EVENT_LOOP_INVALID_PARAMETER;
+    }
+    else if( pConnection == NULL )
+    {
+        LogError( ( "Parameter check failed: pConnection is NULL." ) );
+        returnStatus = EVENT_LOOP_INVALID_PARAMETER;
+    }
+    else
+    {
+        ( void ) memset( &epollEvent, 0, sizeof( epollEvent ) );
+        epollEvent.events = toEpollEvents( events );
+        epollEvent.data.ptr = pConnection;
+
+        if( epoll_ctl( pEventLoop->epollDescriptor,
+                       EPOLL_CTL_MOD,
+                       pConnection->socketDescriptor,
+                       &epollEvent ) != 0 )
+        {
+            LogError( ( "Failed to modify socket %d in the event loop.",
+                        ( int ) pConnection->socketDescriptor ) );
+            returnStatus = retrieveError( errno );
+        }
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+EventLoopStatus_t EventLoop_Remove( EventLoop_t * pEventLoop,
+                                    EventLoopConnection_t * pConnection )
+{
+    EventLoopStatus_t returnStatus = EVENT_LOOP_SUCCESS;
+    struct epoll_event epollEvent;
+
+    if( ( pEventLoop == NULL ) || ( pEventLoop->epollDescriptor < 0 ) )
+    {
+        LogError( ( "Parameter check failed: pEventLoop is NULL or not initialized." ) );
+        returnStatus = EVENT_LOOP_INVALID_PARAMETER;
+    }
+    else if( pConnection == NULL )
+    {
+        LogError( ( "Parameter check failed: pConnection is NULL." ) );
+        returnStatus = EVENT_LOOP_INVALID_PARAMETER;
+    }
+    else
+    {
+        /* Kernels before 2.6.9 require a non-NULL event for EPOLL_CTL_DEL. */
+        ( void ) memset( &epollEvent, 0, sizeof( epollEvent ) );
+
+        if( epoll_ctl( pEventLoop->epollDescriptor,
+                       EPOLL_CTL_DEL,
+                       pConnection->socketDescriptor,
+                       &epollEvent ) != 0 )
+        {
+            LogError( ( "Failed to remove socket %d from the event loop.",
+                        ( int ) pConnection->socketDescriptor ) );
+            returnStatus = retrieveError( errno );
+        }
+        else
+        {
+            /* Stop dispatching events that are already pending for the connection. */
+            pConnection->callback = NULL;
+            pEventLoop->numConnections--;
+        }
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+EventLoopStatus_t EventLoop_Run( const EventLoop_t * pEventLoop,
+                                 uint32_t timeoutMs,
+                                 size_t * pNumDispatched )
+{
+    EventLoopStatus_t returnStatus = EVENT_LOOP_SUCCESS;
+    struct epoll_event epollEvents[ EVENT_LOOP_MAX_EVENTS ];
+    EventLoopConnection_t * pConnection = NULL;
+    int32_t numEvents = 0, index = 0, waitTimeMs = -1;
+    size_t numDispatched = 0U;
+
+    if( ( pEventLoop == NULL ) || ( pEventLoop->epollDescriptor < 0 ) )
+    {
+        LogError( ( "Parameter check failed: pEventLoop is NULL or not initialized." ) );
+        returnStatus = EVENT_LOOP_INVALID_PARAMETER;
+    }
+    else
+    {
+        if( timeoutMs != EVENT_LOOP_WAIT_FOREVER )
+        {
+            waitTimeMs = ( timeoutMs > ( uint32_t ) INT32_MAX ) ? INT32_MAX : ( int32_t ) timeoutMs;
+        }
+
+        numEvents = epoll_wait( pEventLoop->epollDescriptor,
+                                epollEvents,
+                                ( int32_t ) EVENT_LOOP_MAX_EVENTS,
+                                waitTimeMs );
+
+        if( ( numEvents < 0 ) && ( errno != EINTR ) )
+        {
+            LogError( ( "Failed to wait for events." ) );
+            returnStatus = retrieveError( errno );
+        }
+
+        for( index = 0; index < numEvents; index++ )
+        {
+            pConnection = ( EventLoopConnection_t * ) epollEvents[ index ].data.ptr;
+
+            /* The callback is cleared if the connection was removed by an
+             * earlier callback of this batch. */
+            if( pConnection->callback != NULL )
+            {
+                pConnection->callback( pConnection->pNetworkContext,
+                                       fromEpollEvents( epollEvents[ index ].events ),
+                                       pConnection->pUserData );
+                numDispatched++;
+            }
+        }
+    }
+
+    if( pNumDispatched != NULL )
+    {
+        *pNumDispatched = numDispatched;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+EventLoopStatus_t EventLoop_Deinit( EventLoop_t * pEventLoop )
+{
+    EventLoopStatus_t returnStatus = EVENT_LOOP_SUCCESS;
+
+    if( ( pEventLoop == NULL ) || ( pEventLoop->epollDescriptor < 0 ) )
+    {
+        LogError( ( "Parameter check failed: pEventLoop is NULL or not initialized." ) );
+        returnStatus = EVENT_LOOP_INVALID_PARAMETER;
+    }
+    else
+    {
+        ( void ) close( pEventLoop->epollDescriptor );
+        pEventLoop->epollDescriptor = -1;
+        pEventLoop->numConnections = 0U;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
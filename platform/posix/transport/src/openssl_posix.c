@@ -26,6 +26,7 @@
 
 /* POSIX socket include. */
 #include <unistd.h>
+#include <fcntl.h>
 
 /* Transport interface include. */
 #include "transport_interface.h"
@@ -33,6 +34,9 @@
 #include "openssl_posix.h"
 #include <openssl/err.h>
 
+/* Platform clock include. */
+#include "clock.h"
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -50,6 +54,16 @@
  */
 #define CLIENT_KEY_LABEL     "client's key"
 
+/**
+ * @brief Defined when OpenSSL can hand the record layer over to the kernel.
+ *
+ * SSL_OP_ENABLE_KTLS first appeared in OpenSSL 3.0, and distributions may
+ * build OpenSSL without kTLS.
+ */
+#if defined( SSL_OP_ENABLE_KTLS ) && !defined( OPENSSL_NO_KTLS )
+    #define OPENSSL_KTLS_SUPPORTED
+#endif
+
 /*-----------------------------------------------------------*/
 
 /* Each compilation unit must define the NetworkContext struct. */
@@ -126,7 +140,8 @@ static int32_t setCredentials( SSL_CTX * pSslContext,
 /**
  * @brief Set optional configurations for the TLS connection.
  *
- * This function is used to set SNI, MFLN, and ALPN protocols.
+ * This function is used to set SNI, MFLN, ALPN protocols, and the TLS session
+ * to resume.
  *
  * @param[in] pSsl SSL context to which the optional configurations are to be set.
  * @param[in] pOpensslCredentials TLS credentials containing configurations.
@@ -157,6 +172,169 @@ static OpensslStatus_t tlsHandshake( const ServerInfo_t * pServerInfo,
                                      OpensslParams_t * pOpensslParams,
                                      const OpensslCredentials_t * pOpensslCredentials );
 
+/**
+ * @brief Store a new TLS session negotiated with the server so that it can be
+ * resumed on the next connection.
+ *
+ * This is registered as the new session callback of every SSL context. The
+ * storage for the session is retrieved from the application data of the SSL
+ * object, which is set from #OpensslCredentials_t.ppSession.
+ *
+ * @param[in] pSsl SSL object for which a new session was negotiated.
+ * @param[in] pSession The new session.
+ *
+ * @return 1 if a reference to the session was kept; 0 otherwise.
+ */
+static int storeNewSession( SSL * pSsl,
+                            SSL_SESSION * pSession );
+
+/**
+ * @brief Create an SSL context and import the TLS credentials into it.
+ *
+ * @param[out] ppSslContext The output parameter to return the created SSL context.
+ * @param[in] pOpensslCredentials TLS credentials to be imported.
+ *
+ * @return #OPENSSL_SUCCESS, #OPENSSL_API_ERROR, and #OPENSSL_INVALID_CREDENTIALS.
+ */
+static OpensslStatus_t createSslContext( SSL_CTX ** ppSslContext,
+                                         const OpensslCredentials_t * pOpensslCredentials );
+
+/**
+ * @brief Create a new SSL object from an SSL context and perform the TLS
+ * handshake with it.
+ *
+ * @param[in] pServerInfo Server connection info.
+ * @param[in, out] pOpensslParams Parameters holding the connected socket. The
+ * created SSL object is returned in it, or NULL if it could not be created.
+ * @param[in] pSslContext SSL context from which to create the SSL object.
+ * @param[in] pOpensslCredentials TLS credentials containing configurations.
+ *
+ * @return #OPENSSL_SUCCESS, #OPENSSL_API_ERROR, and #OPENSSL_HANDSHAKE_FAILED.
+ */
+static OpensslStatus_t createSslSession( const ServerInfo_t * pServerInfo,
+                                         OpensslParams_t * pOpensslParams,
+                                         SSL_CTX * pSslContext,
+                                         const OpensslCredentials_t * pOpensslCredentials );
+
+/**
+ * @brief Switch an established TLS connection to non-blocking mode.
+ *
+ * @param[in, out] pOpensslParams Parameters of the connection.
+ *
+ * @return #OPENSSL_SUCCESS, and #OPENSSL_API_ERROR.
+ */
+static OpensslStatus_t setNonBlocking( OpensslParams_t * pOpensslParams );
+
+/**
+ * @brief Get whether an SSL error only asks for the operation to be retried
+ * once the socket is ready, which is only expected in non-blocking mode.
+ *
+ * @param[in] pOpensslParams Parameters of the connection.
+ * @param[in] sslError The error returned by SSL_get_error.
+ *
+ * @return 1 if the operation can be retried; 0 otherwise.
+ */
+static uint8_t isRetryableError( const OpensslParams_t * pOpensslParams,
+                                 int32_t sslError );
+
+/**
+ * @brief Write a buffer with SSL_write and log any failure.
+ *
+ * @param[in] pOpensslParams Parameters of the connection.
+ * @param[in] pBuffer Buffer containing the bytes to send.
+ * @param[in] bytesToSend Number of bytes to send.
+ *
+ * @return Number of bytes sent if successful; zero if the write can be
+ * retried, which only happens in non-blocking mode; negative value on error.
+ */
+static int32_t sslWrite( OpensslParams_t * pOpensslParams,
+                         const void * pBuffer,
+                         size_t bytesToSend );
+
+/**
+ * @brief Write one buffer of #Openssl_Writev, sending no more than the bytes
+ * left before the total sent by the call reaches INT32_MAX.
+ *
+ * @param[in] pOpensslParams Parameters of the connection.
+ * @param[in] pBuffer Buffer containing the bytes to send.
+ * @param[in] bytesToSend Number of bytes to send.
+ * @param[in, out] pTotalBytesSent Total bytes sent by the call so far.
+ * @param[out] pBytesSent Return value of #sslWrite, left unchanged when
+ * nothing could be written.
+ *
+ * @return 1U if every byte of @p pBuffer was sent; 0U otherwise.
+ */
+static uint8_t writevBuffer( OpensslParams_t * pOpensslParams,
+                             const void * pBuffer,
+                             size_t bytesToSend,
+                             int32_t * pTotalBytesSent,
+                             int32_t * pBytesSent );
+
+/**
+ * @brief Read from the TLS connection with SSL_read and convert the result
+ * to the return value of the transport interface.
+ *
+ * @param[in, out] pOpensslParams Parameters of the connection.
+ * @param[out] pBuffer Buffer to receive the decrypted bytes into.
+ * @param[in] bytesToRecv Size of @p pBuffer.
+ *
+ * @return Number of bytes received; zero if the read can be retried; negative
+ * value on error.
+ */
+static int32_t sslRead( OpensslParams_t * pOpensslParams,
+                        void * pBuffer,
+                        size_t bytesToRecv );
+
+/**
+ * @brief Receive through the read-ahead buffer of the connection.
+ *
+ * Bytes left in the buffer are returned first. Once it is empty, requests
+ * smaller than the buffer refill it with a single SSL_read, while larger
+ * requests are read directly into @p pBuffer.
+ *
+ * @param[in, out] pOpensslParams Parameters of the connection.
+ * @param[out] pBuffer Buffer to receive the decrypted bytes into.
+ * @param[in] bytesToRecv Number of bytes requested.
+ *
+ * @return Number of bytes received; zero if the read can be retried; negative
+ * value on error.
+ */
+static int32_t recvReadAhead( OpensslParams_t * pOpensslParams,
+                              void * pBuffer,
+                              size_t bytesToRecv );
+
+/**
+ * @brief Send part of a file with SSL_sendfile once kTLS send offload is
+ * engaged.
+ *
+ * @param[in] pOpensslParams Parameters of the connection.
+ * @param[in] fileDescriptor Descriptor of the file to send.
+ * @param[in] offset Offset in the file of the first byte to send.
+ * @param[in] bytesToSend Number of bytes of the file to send.
+ *
+ * @return Number of bytes sent if successful; negative value on error.
+ */
+static int32_t sendFileKtls( OpensslParams_t * pOpensslParams,
+                             int32_t fileDescriptor,
+                             off_t offset,
+                             size_t bytesToSend );
+
+/**
+ * @brief Send part of a file by reading it into a stack buffer and writing
+ * the buffer with SSL_write.
+ *
+ * @param[in] pOpensslParams Parameters of the connection.
+ * @param[in] fileDescriptor Descriptor of the file to send.
+ * @param[in] offset Offset in the file of the first byte to send.
+ * @param[in] bytesToSend Number of bytes of the file to send.
+ *
+ * @return Number of bytes sent if successful; negative value on error.
+ */
+static int32_t sendFileCopy( OpensslParams_t * pOpensslParams,
+                             int32_t fileDescriptor,
+                             off_t offset,
+                             size_t bytesToSend );
+
 /*-----------------------------------------------------------*/
 
 #if ( LIBRARY_LOG_LEVEL == LOG_DEBUG )
@@ -231,6 +409,10 @@ static OpensslStatus_t tlsHandshake( const ServerInfo_t * pServerInfo,
 {
     OpensslStatus_t returnStatus = OPENSSL_SUCCESS;
     int32_t sslStatus = -1, verifyPeerCertStatus = X509_V_OK;
+    uint64_t handshakeStartUs = 0U;
+
+    /* Unused when logs are disabled. */
+    ( void ) handshakeStartUs;
 
     /* Validate the hostname against the server's certificate. */
     sslStatus = SSL_set1_host( pOpensslParams->pSsl,
@@ -262,13 +444,25 @@ static OpensslStatus_t tlsHandshake( const ServerInfo_t * pServerInfo,
     {
         setOptionalConfigurations( pOpensslParams->pSsl, pOpensslCredentials );
 
+        handshakeStartUs = Clock_GetTimeUs64();
         sslStatus = SSL_connect( pOpensslParams->pSsl );
 
+        #if ( TRANSPORT_STATS_ENABLED == 1 )
+            TransportStats_RecordHandshake( &pOpensslParams->stats,
+                                            ( sslStatus == 1 ) ? 1U : 0U,
+                                            Clock_GetTimeUs64() - handshakeStartUs );
+        #endif
+
         if( sslStatus != 1 )
         {
             LogError( ( "SSL_connect failed to perform TLS handshake." ) );
             returnStatus = OPENSSL_HANDSHAKE_FAILED;
         }
+        else
+        {
+            LogDebug( ( "TLS handshake completed in %lu us.",
+                        ( unsigned long ) ( Clock_GetTimeUs64() - handshakeStartUs ) ) );
+        }
     }
 
     /* Verify X509 certificate from peer. */
@@ -284,8 +478,255 @@ static OpensslStatus_t tlsHandshake( const ServerInfo_t * pServerInfo,
         }
     }
 
+    /* Report whether the offered session was accepted by the server. */
+    pOpensslParams->sessionResumed = 0U;
+
+    if( ( returnStatus == OPENSSL_SUCCESS ) &&
+        ( pOpensslCredentials->ppSession != NULL ) )
+    {
+        if( SSL_session_reused( pOpensslParams->pSsl ) == 1 )
+        {
+            pOpensslParams->sessionResumed = 1U;
+        }
+
+        LogDebug( ( "TLS session resumed: %u.",
+                    ( unsigned int ) pOpensslParams->sessionResumed ) );
+    }
+
+    /* Report whether the kernel took over the record layer. OpenSSL falls
+     * back to user space on its own when the kernel or the negotiated cipher
+     * does not support kTLS. */
+    pOpensslParams->ktlsSend = 0U;
+    pOpensslParams->ktlsRecv = 0U;
+
+    #ifdef OPENSSL_KTLS_SUPPORTED
+        if( ( returnStatus == OPENSSL_SUCCESS ) &&
+            ( pOpensslCredentials->enableKtls != 0U ) )
+        {
+            if( BIO_get_ktls_send( SSL_get_wbio( pOpensslParams->pSsl ) ) )
+            {
+                pOpensslParams->ktlsSend = 1U;
+            }
+
+            if( BIO_get_ktls_recv( SSL_get_rbio( pOpensslParams->pSsl ) ) )
+            {
+                pOpensslParams->ktlsRecv = 1U;
+            }
+
+            LogInfo( ( "kTLS offload: send=%u, receive=%u.",
+                       ( unsigned int ) pOpensslParams->ktlsSend,
+                       ( unsigned int ) pOpensslParams->ktlsRecv ) );
+        }
+    #endif /* ifdef OPENSSL_KTLS_SUPPORTED */
+
+    /* Only switch to non-blocking mode once the handshake is done, so that
+     * the handshake is still bounded by the socket timeouts. */
+    pOpensslParams->nonBlocking = 0U;
+
+    if( ( returnStatus == OPENSSL_SUCCESS ) &&
+        ( pOpensslCredentials->nonBlocking != 0U ) )
+    {
+        returnStatus = setNonBlocking( pOpensslParams );
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+static OpensslStatus_t setNonBlocking( OpensslParams_t * pOpensslParams )
+{
+    OpensslStatus_t returnStatus = OPENSSL_SUCCESS;
+    int32_t socketFlags = 0;
+
+    assert( pOpensslParams != NULL );
+    assert( pOpensslParams->pSsl != NULL );
+
+    /* A send that has to be retried may be given the same bytes from a
+     * different address, e.g. from the coalescing buffer of #Openssl_Writev.
+     * The mask returned by SSL_set_mode does not need to be checked. */
+
+    /* MISRA Directive 4.6 flags the following line for using basic
+     * numerical type long. This directive is suppressed because openssl
+     * function #SSL_set_mode takes an argument of type long. */
+    /* coverity[misra_c_2012_directive_4_6_violation] */
+    ( void ) SSL_set_mode( pOpensslParams->pSsl,
+                           ( long ) SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER );
+
+    socketFlags = ( int32_t ) fcntl( pOpensslParams->socketDescriptor, F_GETFL );
+
+    if( socketFlags != -1 )
+    {
+        socketFlags = ( int32_t ) fcntl( pOpensslParams->socketDescriptor,
+                                         F_SETFL,
+                                         socketFlags | O_NONBLOCK );
+    }
+
+    if( socketFlags == -1 )
+    {
+        LogError( ( "Failed to switch the socket to non-blocking mode." ) );
+        returnStatus = OPENSSL_API_ERROR;
+    }
+    else
+    {
+        pOpensslParams->nonBlocking = 1U;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t isRetryableError( const OpensslParams_t * pOpensslParams,
+                                 int32_t sslError )
+{
+    uint8_t retryable = 0U;
+
+    if( ( pOpensslParams->nonBlocking != 0U ) &&
+        ( ( sslError == SSL_ERROR_WANT_READ ) ||
+          ( sslError == SSL_ERROR_WANT_WRITE ) ) )
+    {
+        retryable = 1U;
+    }
+
+    return retryable;
+}
+/*-----------------------------------------------------------*/
+
+/* MISRA Directive 4.6 flags the following line for using basic numerical
+ * type int. This directive is suppressed because the signature is required by
+ * openssl function #SSL_CTX_sess_set_new_cb. */
+/* coverity[misra_c_2012_directive_4_6_violation] */
+static int storeNewSession( SSL * pSsl,
+                            SSL_SESSION * pSession )
+{
+    int keptReference = 0;
+    SSL_SESSION ** ppSession = NULL;
+
+    ppSession = ( SSL_SESSION ** ) SSL_get_app_data( pSsl );
+
+    if( ppSession != NULL )
+    {
+        /* Replace the previously stored session, if any. */
+        if( *ppSession != NULL )
+        {
+            SSL_SESSION_free( *ppSession );
+        }
+
+        *ppSession = pSession;
+        keptReference = 1;
+
+        LogDebug( ( "Stored a new TLS session for resumption." ) );
+    }
+
+    return keptReference;
+}
+/*-----------------------------------------------------------*/
+
+static OpensslStatus_t createSslContext( SSL_CTX ** ppSslContext,
+                                         const OpensslCredentials_t * pOpensslCredentials )
+{
+    OpensslStatus_t returnStatus = OPENSSL_SUCCESS;
+    int32_t sslStatus = 0;
+    SSL_CTX * pSslContext = NULL;
+
+    assert( ppSslContext != NULL );
+    assert( pOpensslCredentials != NULL );
+
+    pSslContext = SSL_CTX_new( TLS_client_method() );
+
+    if( pSslContext == NULL )
+    {
+        LogError( ( "Creation of a new SSL_CTX object failed." ) );
+        returnStatus = OPENSSL_API_ERROR;
+    }
+
+    /* Setup credentials. */
+    if( returnStatus == OPENSSL_SUCCESS )
+    {
+        /* Enable partial writes for blocking calls to SSL_write to allow a
+         * payload larger than the maximum fragment length.
+         * The mask returned by SSL_CTX_set_mode does not need to be checked. */
+
+        /* MISRA Directive 4.6 flags the following line for using basic
+        * numerical type long. This directive is suppressed because openssl
+        * function #SSL_CTX_set_mode takes an argument of type long. */
+        /* coverity[misra_c_2012_directive_4_6_violation] */
+        ( void ) SSL_CTX_set_mode( pSslContext,
+                                   ( long ) SSL_MODE_ENABLE_PARTIAL_WRITE );
+
+        /* Hand new client sessions to #storeNewSession instead of keeping
+         * them in the internal cache, so that they can be resumed by a later
+         * connection that has storage for them.
+         * The previous mode returned by SSL_CTX_set_session_cache_mode does
+         * not need to be checked. */
+        /* coverity[misra_c_2012_directive_4_6_violation] */
+        ( void ) SSL_CTX_set_session_cache_mode( pSslContext,
+                                                 ( long ) ( SSL_SESS_CACHE_CLIENT |
+                                                            SSL_SESS_CACHE_NO_INTERNAL_STORE ) );
+        SSL_CTX_sess_set_new_cb( pSslContext, storeNewSession );
+
+        sslStatus = setCredentials( pSslContext,
+                                    pOpensslCredentials );
+
+        if( sslStatus != 1 )
+        {
+            LogError( ( "Setting up credentials failed." ) );
+            returnStatus = OPENSSL_INVALID_CREDENTIALS;
+        }
+    }
+
+    /* Do not hand out a partially configured context. */
+    if( ( returnStatus != OPENSSL_SUCCESS ) && ( pSslContext != NULL ) )
+    {
+        SSL_CTX_free( pSslContext );
+        pSslContext = NULL;
+    }
+
+    *ppSslContext = pSslContext;
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+static OpensslStatus_t createSslSession( const ServerInfo_t * pServerInfo,
+                                         OpensslParams_t * pOpensslParams,
+                                         SSL_CTX * pSslContext,
+                                         const OpensslCredentials_t * pOpensslCredentials )
+{
+    OpensslStatus_t returnStatus = OPENSSL_SUCCESS;
+
+    assert( pOpensslParams != NULL );
+    assert( pSslContext != NULL );
+    assert( pOpensslCredentials != NULL );
+
+    /* Start the connection with an empty read-ahead buffer and no counts. */
+    pOpensslParams->pReadAheadBuffer = pOpensslCredentials->pReadAheadBuffer;
+    pOpensslParams->readAheadBufferSize = ( pOpensslCredentials->pReadAheadBuffer != NULL ) ?
+                                          pOpensslCredentials->readAheadBufferSize : 0U;
+    pOpensslParams->readAheadOffset = 0U;
+    pOpensslParams->readAheadLength = 0U;
+    ( void ) memset( &pOpensslParams->recvStats, 0, sizeof( OpensslRecvStats_t ) );
+
+    /* Create a new SSL session. The SSL object takes a reference on the
+     * SSL context, which is released when the SSL object is freed. */
+    pOpensslParams->pSsl = SSL_new( pSslContext );
+
+    if( pOpensslParams->pSsl == NULL )
+    {
+        LogError( ( "SSL_new failed to create a new SSL context." ) );
+        returnStatus = OPENSSL_API_ERROR;
+    }
+
+    /* Setup the socket to use for communication. */
+    if( returnStatus == OPENSSL_SUCCESS )
+    {
+        returnStatus = tlsHandshake( pServerInfo,
+                                     pOpensslParams,
+                                     pOpensslCredentials );
+    }
+
     return returnStatus;
 }
+/*-----------------------------------------------------------*/
 
 static int32_t setRootCa( const SSL_CTX * pSslContext,
                           const char * pRootCaPath )
@@ -529,6 +970,50 @@ static void setOptionalConfigurations( SSL * pSsl,
         }
     }
 
+    /* Let OpenSSL read as much as is available from the socket when the
+     * decrypted data is buffered as well. */
+    if( ( pOpensslCredentials->pReadAheadBuffer != NULL ) &&
+        ( pOpensslCredentials->readAheadBufferSize > 0U ) )
+    {
+        LogDebug( ( "Enabling read-ahead with a %lu byte buffer.",
+                    ( unsigned long ) pOpensslCredentials->readAheadBufferSize ) );
+        SSL_set_read_ahead( pSsl, 1 );
+    }
+
+    /* kTLS must be requested before the handshake, so that OpenSSL hands the
+     * keys to the kernel as soon as they are derived. */
+    if( pOpensslCredentials->enableKtls != 0U )
+    {
+        #ifdef OPENSSL_KTLS_SUPPORTED
+            LogDebug( ( "Enabling kernel TLS offload." ) );
+
+            /* The returned options do not need to be checked. */
+            ( void ) SSL_set_options( pSsl, SSL_OP_ENABLE_KTLS );
+        #else
+            LogWarn( ( "kTLS is not supported by this OpenSSL build. "
+                       "Records are processed by OpenSSL." ) );
+        #endif
+    }
+
+    /* Offer the stored session for resumption if requested. */
+    if( pOpensslCredentials->ppSession != NULL )
+    {
+        /* Allow #storeNewSession to find the storage for new sessions. */
+        ( void ) SSL_set_app_data( pSsl, pOpensslCredentials->ppSession );
+
+        if( *pOpensslCredentials->ppSession != NULL )
+        {
+            LogDebug( ( "Offering stored TLS session for resumption." ) );
+
+            sslStatus = SSL_set_session( pSsl, *pOpensslCredentials->ppSession );
+
+            if( sslStatus != 1 )
+            {
+                LogError( ( "Failed to set the TLS session to resume." ) );
+            }
+        }
+    }
+
     /* Enable SNI if requested. */
     if( pOpensslCredentials->sniHostName != NULL )
     {
@@ -561,10 +1046,13 @@ OpensslStatus_t Openssl_Connect( NetworkContext_t * pNetworkContext,
     OpensslParams_t * pOpensslParams = NULL;
     SocketStatus_t socketStatus = SOCKETS_SUCCESS;
     OpensslStatus_t returnStatus = OPENSSL_SUCCESS;
-    int32_t sslStatus = 0;
     uint8_t sslObjectCreated = 0;
     SSL_CTX * pSslContext = NULL;
 
+    #if ( TRANSPORT_STATS_ENABLED == 1 )
+        uint64_t connectStartUs = 0U;
+    #endif
+
     /* Validate parameters. */
     if( ( pNetworkContext == NULL ) || ( pNetworkContext->pParams == NULL ) )
     {
@@ -585,87 +1073,197 @@ OpensslStatus_t Openssl_Connect( NetworkContext_t * pNetworkContext,
     if( returnStatus == OPENSSL_SUCCESS )
     {
         pOpensslParams = pNetworkContext->pParams;
-        socketStatus = Sockets_Connect( &pOpensslParams->socketDescriptor,
-                                        pServerInfo,
-                                        sendTimeoutMs,
-                                        recvTimeoutMs );
+
+        #if ( TRANSPORT_STATS_ENABLED == 1 )
+            connectStartUs = Clock_GetTimeUs64();
+        #endif
+
+        socketStatus = Sockets_ConnectWithOptions( &pOpensslParams->socketDescriptor,
+                                                   pServerInfo,
+                                                   sendTimeoutMs,
+                                                   recvTimeoutMs,
+                                                   pOpensslCredentials->pSocketsOptions );
+
+        #if ( TRANSPORT_STATS_ENABLED == 1 )
+            TransportStats_RecordConnect( &pOpensslParams->stats,
+                                          ( socketStatus == SOCKETS_SUCCESS ) ? 1U : 0U,
+                                          Clock_GetTimeUs64() - connectStartUs );
+        #endif
 
         /* Convert socket wrapper status to openssl status. */
         returnStatus = convertToOpensslStatus( socketStatus );
     }
 
-    /* Create SSL context. */
+    /* Create SSL context and setup credentials. */
     if( returnStatus == OPENSSL_SUCCESS )
     {
-        pSslContext = SSL_CTX_new( TLS_client_method() );
-
-        if( pSslContext == NULL )
-        {
-            LogError( ( "Creation of a new SSL_CTX object failed." ) );
-            returnStatus = OPENSSL_API_ERROR;
-        }
+        returnStatus = createSslContext( &pSslContext,
+                                         pOpensslCredentials );
     }
 
-    /* Setup credentials. */
+    /* Create a new SSL session and perform the TLS handshake. */
     if( returnStatus == OPENSSL_SUCCESS )
     {
-        /* Enable partial writes for blocking calls to SSL_write to allow a
-         * payload larger than the maximum fragment length.
-         * The mask returned by SSL_CTX_set_mode does not need to be checked. */
-
-        /* MISRA Directive 4.6 flags the following line for using basic
-        * numerical type long. This directive is suppressed because openssl
-        * function #SSL_CTX_set_mode takes an argument of type long. */
-        /* coverity[misra_c_2012_directive_4_6_violation] */
-        ( void ) SSL_CTX_set_mode( pSslContext,
-                                   ( long ) SSL_MODE_ENABLE_PARTIAL_WRITE );
+        returnStatus = createSslSession( pServerInfo,
+                                         pOpensslParams,
+                                         pSslContext,
+                                         pOpensslCredentials );
 
-        sslStatus = setCredentials( pSslContext,
-                                    pOpensslCredentials );
-
-        if( sslStatus != 1 )
+        if( pOpensslParams->pSsl != NULL )
         {
-            LogError( ( "Setting up credentials failed." ) );
-            returnStatus = OPENSSL_INVALID_CREDENTIALS;
+            sslObjectCreated = 1u;
         }
     }
 
-    /* Create a new SSL session. */
-    if( returnStatus == OPENSSL_SUCCESS )
+    /* Free the SSL context. The SSL object holds its own reference to it. */
+    if( pSslContext != NULL )
     {
-        pOpensslParams->pSsl = SSL_new( pSslContext );
-
-        if( pOpensslParams->pSsl == NULL )
-        {
-            LogError( ( "SSL_new failed to create a new SSL context." ) );
-            returnStatus = OPENSSL_API_ERROR;
-        }
-        else
-        {
-            sslObjectCreated = 1u;
-        }
+        SSL_CTX_free( pSslContext );
+        pSslContext = NULL;
     }
 
-    /* Setup the socket to use for communication. */
-    if( returnStatus == OPENSSL_SUCCESS )
+    /* Clean up on error. */
+    if( ( returnStatus != OPENSSL_SUCCESS ) && ( sslObjectCreated == 1u ) )
     {
-        returnStatus = tlsHandshake( pServerInfo,
-                                     pOpensslParams,
-                                     pOpensslCredentials );
+        SSL_free( pOpensslParams->pSsl );
+        pOpensslParams->pSsl = NULL;
+    }
+
+    /* Log failure or success depending on status. */
+    if( returnStatus != OPENSSL_SUCCESS )
+    {
+        LogError( ( "Failed to establish a TLS connection." ) );
+    }
+    else
+    {
+        LogDebug( ( "Established a TLS connection." ) );
     }
 
-    /* Free the SSL context. */
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+OpensslStatus_t Openssl_CreateContext( SSL_CTX ** ppSslContext,
+                                       const OpensslCredentials_t * pOpensslCredentials )
+{
+    OpensslStatus_t returnStatus = OPENSSL_SUCCESS;
+
+    /* Validate parameters. */
+    if( ppSslContext == NULL )
+    {
+        LogError( ( "Parameter check failed: ppSslContext is NULL." ) );
+        returnStatus = OPENSSL_INVALID_PARAMETER;
+    }
+    else if( pOpensslCredentials == NULL )
+    {
+        LogError( ( "Parameter check failed: pOpensslCredentials is NULL." ) );
+        returnStatus = OPENSSL_INVALID_PARAMETER;
+    }
+    else
+    {
+        returnStatus = createSslContext( ppSslContext,
+                                         pOpensslCredentials );
+    }
+
+    if( returnStatus != OPENSSL_SUCCESS )
+    {
+        LogError( ( "Failed to create an SSL context." ) );
+    }
+    else
+    {
+        LogDebug( ( "Created an SSL context." ) );
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+void Openssl_FreeContext( SSL_CTX * pSslContext )
+{
+    /* SSL_CTX_free only frees the context once every SSL object created
+     * from it has been freed as well. */
     if( pSslContext != NULL )
     {
         SSL_CTX_free( pSslContext );
-        pSslContext = NULL;
     }
+}
+/*-----------------------------------------------------------*/
 
-    /* Clean up on error. */
-    if( ( returnStatus != OPENSSL_SUCCESS ) && ( sslObjectCreated == 1u ) )
+OpensslStatus_t Openssl_ConnectWithContext( NetworkContext_t * pNetworkContext,
+                                            const ServerInfo_t * pServerInfo,
+                                            SSL_CTX * pSslContext,
+                                            const OpensslCredentials_t * pOpensslCredentials,
+                                            uint32_t sendTimeoutMs,
+                                            uint32_t recvTimeoutMs )
+{
+    OpensslParams_t * pOpensslParams = NULL;
+    SocketStatus_t socketStatus = SOCKETS_SUCCESS;
+    OpensslStatus_t returnStatus = OPENSSL_SUCCESS;
+
+    #if ( TRANSPORT_STATS_ENABLED == 1 )
+        uint64_t connectStartUs = 0U;
+    #endif
+
+    /* Validate parameters. */
+    if( ( pNetworkContext == NULL ) || ( pNetworkContext->pParams == NULL ) )
     {
-        SSL_free( pOpensslParams->pSsl );
-        pOpensslParams->pSsl = NULL;
+        LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
+        returnStatus = OPENSSL_INVALID_PARAMETER;
+    }
+    else if( pSslContext == NULL )
+    {
+        LogError( ( "Parameter check failed: pSslContext is NULL." ) );
+        returnStatus = OPENSSL_INVALID_PARAMETER;
+    }
+    else if( pOpensslCredentials == NULL )
+    {
+        LogError( ( "Parameter check failed: pOpensslCredentials is NULL." ) );
+        returnStatus = OPENSSL_INVALID_PARAMETER;
+    }
+    else
+    {
+        /* Empty else. */
+    }
+
+    /* Establish the TCP connection. */
+    if( returnStatus == OPENSSL_SUCCESS )
+    {
+        pOpensslParams = pNetworkContext->pParams;
+
+        #if ( TRANSPORT_STATS_ENABLED == 1 )
+            connectStartUs = Clock_GetTimeUs64();
+        #endif
+
+        socketStatus = Sockets_ConnectWithOptions( &pOpensslParams->socketDescriptor,
+                                                   pServerInfo,
+                                                   sendTimeoutMs,
+                                                   recvTimeoutMs,
+                                                   pOpensslCredentials->pSocketsOptions );
+
+        #if ( TRANSPORT_STATS_ENABLED == 1 )
+            TransportStats_RecordConnect( &pOpensslParams->stats,
+                                          ( socketStatus == SOCKETS_SUCCESS ) ? 1U : 0U,
+                                          Clock_GetTimeUs64() - connectStartUs );
+        #endif
+
+        /* Convert socket wrapper status to openssl status. */
+        returnStatus = convertToOpensslStatus( socketStatus );
+    }
+
+    /* Create a new SSL session and perform the TLS handshake. */
+    if( returnStatus == OPENSSL_SUCCESS )
+    {
+        returnStatus = createSslSession( pServerInfo,
+                                         pOpensslParams,
+                                         pSslContext,
+                                         pOpensslCredentials );
+
+        /* Clean up on error. */
+        if( ( returnStatus != OPENSSL_SUCCESS ) && ( pOpensslParams->pSsl != NULL ) )
+        {
+            SSL_free( pOpensslParams->pSsl );
+            pOpensslParams->pSsl = NULL;
+        }
     }
 
     /* Log failure or success depending on status. */
@@ -729,7 +1327,6 @@ int32_t Openssl_Recv( NetworkContext_t * pNetworkContext,
 {
     OpensslParams_t * pOpensslParams = NULL;
     int32_t bytesReceived = 0;
-    int32_t sslError = 0;
 
     if( ( pNetworkContext == NULL ) || ( pNetworkContext->pParams == NULL ) )
     {
@@ -738,39 +1335,20 @@ int32_t Openssl_Recv( NetworkContext_t * pNetworkContext,
     else if( pNetworkContext->pParams->pSsl != NULL )
     {
         pOpensslParams = pNetworkContext->pParams;
-        /* SSL read of data. */
-        bytesReceived = ( int32_t ) SSL_read( pOpensslParams->pSsl,
-                                              pBuffer,
-                                              ( int32_t ) bytesToRecv );
+        pOpensslParams->recvStats.recvCalls++;
 
-        /* Handle error return status if transport read did not succeed. */
-        if( bytesReceived <= 0 )
+        if( pOpensslParams->readAheadBufferSize > 0U )
         {
-            sslError = SSL_get_error( pOpensslParams->pSsl, bytesReceived );
-
-            if( sslError == SSL_ERROR_WANT_READ )
-            {
-                /* The OpenSSL documentation mentions that SSL_Read can provide a return code of
-                 * SSL_ERROR_WANT_READ in blocking mode, if the SSL context is not configured with
-                 * with the SSL_MODE_AUTO_RETRY. This error code means that the SSL_read()
-                 * operation needs to be retried to complete the read operation.
-                 * Thus, setting the return value of this function as zero to represent that no
-                 * data was received from the network. */
-                bytesReceived = 0;
-            }
-            else
-            {
-                LogError( ( "Failed to receive data over network: SSL_read failed: "
-                            "ErrorStatus=%s.", ERR_reason_error_string( sslError ) ) );
+            bytesReceived = recvReadAhead( pOpensslParams, pBuffer, bytesToRecv );
+        }
+        else
+        {
+            bytesReceived = sslRead( pOpensslParams, pBuffer, bytesToRecv );
+        }
 
-                /* The transport interface requires zero return code only when the receive operation can
-                 * be retried to achieve success. Thus, convert a zero error code to a negative return
-                 * value as this cannot be retried. */
-                if( bytesReceived == 0 )
-                {
-                    bytesReceived = -1;
-                }
-            }
+        if( bytesReceived > 0 )
+        {
+            pOpensslParams->recvStats.bytesReceived += ( uint64_t ) bytesReceived;
         }
     }
     else
@@ -783,6 +1361,315 @@ int32_t Openssl_Recv( NetworkContext_t * pNetworkContext,
 }
 /*-----------------------------------------------------------*/
 
+int32_t Openssl_GetSocketDescriptor( const NetworkContext_t * pNetworkContext )
+{
+    int32_t socketDescriptor = -1;
+
+    if( ( pNetworkContext == NULL ) || ( pNetworkContext->pParams == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
+    }
+    else
+    {
+        socketDescriptor = pNetworkContext->pParams->socketDescriptor;
+    }
+
+    return socketDescriptor;
+}
+/*-----------------------------------------------------------*/
+
+uint8_t Openssl_HasPendingData( const NetworkContext_t * pNetworkContext )
+{
+    uint8_t hasPendingData = 0U;
+
+    if( ( pNetworkContext == NULL ) || ( pNetworkContext->pParams == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
+    }
+    else if( pNetworkContext->pParams->readAheadLength > 0U )
+    {
+        hasPendingData = 1U;
+    }
+    else if( ( pNetworkContext->pParams->pSsl != NULL ) &&
+             ( SSL_has_pending( pNetworkContext->pParams->pSsl ) == 1 ) )
+    {
+        /* Unlike SSL_pending, this also counts records that were read from
+         * the socket but not decrypted yet, which read-ahead may leave. */
+        hasPendingData = 1U;
+    }
+    else
+    {
+        /* Nothing is buffered. */
+    }
+
+    return hasPendingData;
+}
+/*-----------------------------------------------------------*/
+
+OpensslStatus_t Openssl_GetKtlsStatus( const NetworkContext_t * pNetworkContext,
+                                       uint8_t * pSendOffload,
+                                       uint8_t * pRecvOffload )
+{
+    OpensslStatus_t returnStatus = OPENSSL_SUCCESS;
+
+    if( ( pNetworkContext == NULL ) || ( pNetworkContext->pParams == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
+        returnStatus = OPENSSL_INVALID_PARAMETER;
+    }
+    else if( ( pSendOffload == NULL ) || ( pRecvOffload == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pSendOffload or pRecvOffload is NULL." ) );
+        returnStatus = OPENSSL_INVALID_PARAMETER;
+    }
+    else
+    {
+        *pSendOffload = pNetworkContext->pParams->ktlsSend;
+        *pRecvOffload = pNetworkContext->pParams->ktlsRecv;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+OpensslStatus_t Openssl_GetRecvStats( const NetworkContext_t * pNetworkContext,
+                                      OpensslRecvStats_t * pStats )
+{
+    OpensslStatus_t returnStatus = OPENSSL_SUCCESS;
+
+    if( ( pNetworkContext == NULL ) || ( pNetworkContext->pParams == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
+        returnStatus = OPENSSL_INVALID_PARAMETER;
+    }
+    else if( pStats == NULL )
+    {
+        LogError( ( "Parameter check failed: pStats is NULL." ) );
+        returnStatus = OPENSSL_INVALID_PARAMETER;
+    }
+    else
+    {
+        *pStats = pNetworkContext->pParams->recvStats;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+#if ( TRANSPORT_STATS_ENABLED == 1 )
+    OpensslStatus_t Openssl_GetStats( const NetworkContext_t * pNetworkContext,
+                                      TransportStats_t * pStats )
+    {
+        OpensslStatus_t returnStatus = OPENSSL_SUCCESS;
+
+        if( ( pNetworkContext == NULL ) || ( pNetworkContext->pParams == NULL ) )
+        {
+            LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
+            returnStatus = OPENSSL_INVALID_PARAMETER;
+        }
+        else if( pStats == NULL )
+        {
+            LogError( ( "Parameter check failed: pStats is NULL." ) );
+            returnStatus = OPENSSL_INVALID_PARAMETER;
+        }
+        else
+        {
+            TransportStats_Snapshot( &pNetworkContext->pParams->stats, pStats );
+        }
+
+        return returnStatus;
+    }
+/*-----------------------------------------------------------*/
+#endif /* if ( TRANSPORT_STATS_ENABLED == 1 ) */
+
+static int32_t sslRead( OpensslParams_t * pOpensslParams,
+                        void * pBuffer,
+                        size_t bytesToRecv )
+{
+    int32_t bytesReceived = 0;
+    int32_t sslError = 0;
+
+    #if ( TRANSPORT_STATS_ENABLED == 1 )
+        uint64_t startUs = Clock_GetTimeUs64();
+    #endif
+
+    assert( pOpensslParams != NULL );
+    assert( pOpensslParams->pSsl != NULL );
+
+    pOpensslParams->recvStats.sslReadCalls++;
+
+    /* SSL read of data. */
+    bytesReceived = ( int32_t ) SSL_read( pOpensslParams->pSsl,
+                                          pBuffer,
+                                          ( int32_t ) bytesToRecv );
+
+    /* Handle error return status if transport read did not succeed. */
+    if( bytesReceived <= 0 )
+    {
+        sslError = SSL_get_error( pOpensslParams->pSsl, bytesReceived );
+
+        if( ( sslError == SSL_ERROR_WANT_READ ) ||
+            ( isRetryableError( pOpensslParams, sslError ) == 1U ) )
+        {
+            /* The OpenSSL documentation mentions that SSL_Read can provide a return code of
+             * SSL_ERROR_WANT_READ in blocking mode, if the SSL context is not configured with
+             * with the SSL_MODE_AUTO_RETRY. This error code means that the SSL_read()
+             * operation needs to be retried to complete the read operation.
+             * Thus, setting the return value of this function as zero to represent that no
+             * data was received from the network. */
+            bytesReceived = 0;
+        }
+        else
+        {
+            LogError( ( "Failed to receive data over network: SSL_read failed: "
+                        "ErrorStatus=%s.", ERR_reason_error_string( sslError ) ) );
+
+            /* The transport interface requires zero return code only when the receive operation can
+             * be retried to achieve success. The retryable errors were handled above, so convert a
+             * zero error code to a negative return value as this error cannot be retried. */
+            if( bytesReceived == 0 )
+            {
+                bytesReceived = -1;
+            }
+        }
+    }
+
+    #if ( TRANSPORT_STATS_ENABLED == 1 )
+        TransportStats_RecordTransfer( &pOpensslParams->stats, 0U, bytesToRecv,
+                                       bytesReceived, Clock_GetTimeUs64() - startUs );
+    #endif
+
+    return bytesReceived;
+}
+/*-----------------------------------------------------------*/
+
+static int32_t recvReadAhead( OpensslParams_t * pOpensslParams,
+                              void * pBuffer,
+                              size_t bytesToRecv )
+{
+    int32_t bytesReceived = 0;
+    size_t bytesToCopy = 0U;
+    size_t refillSize = 0U;
+
+    assert( pOpensslParams != NULL );
+    assert( pOpensslParams->pReadAheadBuffer != NULL );
+
+    if( pOpensslParams->readAheadLength > 0U )
+    {
+        /* Serve the request from the bytes decrypted earlier. */
+    }
+    else if( bytesToRecv >= pOpensslParams->readAheadBufferSize )
+    {
+        /* The request would not fit the buffer, so there is nothing to gain
+         * from copying it. */
+        bytesReceived = sslRead( pOpensslParams, pBuffer, bytesToRecv );
+    }
+    else
+    {
+        /* SSL_read takes an int length. */
+        refillSize = pOpensslParams->readAheadBufferSize;
+
+        if( refillSize > ( size_t ) INT32_MAX )
+        {
+            refillSize = ( size_t ) INT32_MAX;
+        }
+
+        bytesReceived = sslRead( pOpensslParams,
+                                 pOpensslParams->pReadAheadBuffer,
+                                 refillSize );
+
+        if( bytesReceived > 0 )
+        {
+            pOpensslParams->readAheadOffset = 0U;
+            pOpensslParams->readAheadLength = ( size_t ) bytesReceived;
+        }
+    }
+
+    if( pOpensslParams->readAheadLength > 0U )
+    {
+        bytesToCopy = ( bytesToRecv < pOpensslParams->readAheadLength ) ?
+                      bytesToRecv : pOpensslParams->readAheadLength;
+
+        ( void ) memcpy( pBuffer,
+                         &pOpensslParams->pReadAheadBuffer[ pOpensslParams->readAheadOffset ],
+                         bytesToCopy );
+
+        pOpensslParams->readAheadOffset += bytesToCopy;
+        pOpensslParams->readAheadLength -= bytesToCopy;
+        bytesReceived = ( int32_t ) bytesToCopy;
+    }
+
+    return bytesReceived;
+}
+/*-----------------------------------------------------------*/
+
+static int32_t sslWrite( OpensslParams_t * pOpensslParams,
+                         const void * pBuffer,
+                         size_t bytesToSend )
+{
+    size_t sendSize = bytesToSend;
+    int32_t bytesSent = 0;
+    int32_t sslError = 0;
+
+    #if ( TRANSPORT_STATS_ENABLED == 1 )
+        uint64_t startUs = Clock_GetTimeUs64();
+    #endif
+
+    assert( pOpensslParams != NULL );
+    assert( pOpensslParams->pSsl != NULL );
+
+    /* SSL_write takes an int, and the bytes sent must fit the return value
+     * of this function. The caller sends the rest with the next call. */
+    if( sendSize > ( size_t ) INT32_MAX )
+    {
+        sendSize = ( size_t ) INT32_MAX;
+    }
+
+    /* SSL write of data. */
+    bytesSent = ( int32_t ) SSL_write( pOpensslParams->pSsl,
+                                       pBuffer,
+                                       ( int32_t ) sendSize );
+
+    if( bytesSent <= 0 )
+    {
+        sslError = SSL_get_error( pOpensslParams->pSsl, bytesSent );
+
+        if( isRetryableError( pOpensslParams, sslError ) == 1U )
+        {
+            /* The socket buffer is full, or OpenSSL must read from the socket
+             * first. Report that nothing was sent so that the caller retries
+             * with the same data. */
+            bytesSent = 0;
+        }
+        else
+        {
+            LogError( ( "Failed to send data over network: SSL_write of OpenSSL failed: "
+                        "ErrorStatus=%s.", ERR_reason_error_string( sslError ) ) );
+
+            /* In blocking mode, the SSL_write() function does not return an
+             * SSL_ERROR_WANT_READ or SSL_ERROR_WANT_WRITE error code, and in
+             * non-blocking mode those were handled above. Any other failure
+             * cannot be retried. */
+
+            /* The transport interface requires zero return code only when the send operation can
+             * be retried to achieve success. Thus, convert a zero error code to a negative return
+             * value as this error cannot be retried. */
+            if( bytesSent == 0 )
+            {
+                bytesSent = -1;
+            }
+        }
+    }
+
+    #if ( TRANSPORT_STATS_ENABLED == 1 )
+        TransportStats_RecordTransfer( &pOpensslParams->stats, 1U, sendSize,
+                                       bytesSent, Clock_GetTimeUs64() - startUs );
+    #endif
+
+    return bytesSent;
+}
+/*-----------------------------------------------------------*/
+
 /* MISRA Rule 8.13 flags the following line for not using the const qualifier
  * on `pNetworkContext`. Indeed, the object pointed by it is not modified
  * by OpenSSL, but other implementations of `TransportSend_t` may do so. */
@@ -790,55 +1677,278 @@ int32_t Openssl_Send( NetworkContext_t * pNetworkContext,
                       const void * pBuffer,
                       size_t bytesToSend )
 {
-    OpensslParams_t * pOpensslParams = NULL;
     int32_t bytesSent = 0;
-    int32_t sslError = 0;
-
-    /* Unused parameter when logs are disabled. */
-    ( void ) sslError;
 
     if( ( pNetworkContext == NULL ) || ( pNetworkContext->pParams == NULL ) )
     {
         LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
     }
     else if( pNetworkContext->pParams->pSsl != NULL )
+    {
+        bytesSent = sslWrite( pNetworkContext->pParams,
+                              pBuffer,
+                              bytesToSend );
+    }
+    else
+    {
+        LogError( ( "Failed to send data over network: "
+                    "SSL object in network context is NULL." ) );
+    }
+
+    return bytesSent;
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t writevBuffer( OpensslParams_t * pOpensslParams,
+                             const void * pBuffer,
+                             size_t bytesToSend,
+                             int32_t * pTotalBytesSent,
+                             int32_t * pBytesSent )
+{
+    size_t bytesLeft = ( size_t ) INT32_MAX - ( size_t ) *pTotalBytesSent;
+    size_t sendSize = ( bytesToSend < bytesLeft ) ? bytesToSend : bytesLeft;
+    uint8_t writeComplete = 0U;
+
+    assert( *pTotalBytesSent >= 0 );
+
+    /* Once INT32_MAX bytes were sent, stop without writing so that the
+     * total still fits the return value of #Openssl_Writev. */
+    if( sendSize > 0U )
+    {
+        *pBytesSent = sslWrite( pOpensslParams, pBuffer, sendSize );
+
+        if( *pBytesSent > 0 )
+        {
+            *pTotalBytesSent += *pBytesSent;
+        }
+
+        if( ( sendSize == bytesToSend ) && ( *pBytesSent == ( int32_t ) sendSize ) )
+        {
+            writeComplete = 1U;
+        }
+    }
+
+    return writeComplete;
+}
+/*-----------------------------------------------------------*/
+
+int32_t Openssl_Writev( NetworkContext_t * pNetworkContext,
+                        const struct iovec * pIoVec,
+                        size_t ioVecCount )
+{
+    uint8_t coalesceBuffer[ OPENSSL_WRITEV_BUFFER_SIZE ];
+    OpensslParams_t * pOpensslParams = NULL;
+    size_t i = 0U, bufferedBytes = 0U;
+    int32_t totalBytesSent = 0, bytesSent = 0;
+    uint8_t writeComplete = 1U;
+
+    if( ( pNetworkContext == NULL ) || ( pNetworkContext->pParams == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
+        bytesSent = -1;
+    }
+    else if( ( pIoVec == NULL ) || ( ioVecCount == 0U ) )
+    {
+        LogError( ( "Parameter check failed: pIoVec is NULL or ioVecCount is 0." ) );
+        bytesSent = -1;
+    }
+    else if( pNetworkContext->pParams->pSsl == NULL )
+    {
+        LogError( ( "Failed to send data over network: "
+                    "SSL object in network context is NULL." ) );
+        bytesSent = -1;
+    }
+    else
     {
         pOpensslParams = pNetworkContext->pParams;
-        /* SSL write of data. */
-        bytesSent = ( int32_t ) SSL_write( pOpensslParams->pSsl,
-                                           pBuffer,
-                                           ( int32_t ) bytesToSend );
+    }
 
-        if( bytesSent <= 0 )
+    /* Stop at the first write that did not send everything, whether it
+     * failed or has to be retried, so that no byte is sent out of order. */
+    for( i = 0U; ( pOpensslParams != NULL ) && ( writeComplete == 1U ) && ( i < ioVecCount ); i++ )
+    {
+        /* Write out the coalesced bytes once the next buffer does not fit. */
+        if( ( bufferedBytes > 0U ) &&
+            ( ( bufferedBytes + pIoVec[ i ].iov_len ) > OPENSSL_WRITEV_BUFFER_SIZE ) )
         {
-            sslError = SSL_get_error( pOpensslParams->pSsl, bytesSent );
+            writeComplete = writevBuffer( pOpensslParams, coalesceBuffer, bufferedBytes,
+                                          &totalBytesSent, &bytesSent );
+            bufferedBytes = 0U;
+        }
 
-            LogError( ( "Failed to send data over network: SSL_write of OpenSSL failed: "
-                        "ErrorStatus=%s.", ERR_reason_error_string( sslError ) ) );
+        if( ( writeComplete == 0U ) || ( pIoVec[ i ].iov_len == 0U ) )
+        {
+            /* Skip empty buffers. */
+        }
+        else if( pIoVec[ i ].iov_len >= OPENSSL_WRITEV_BUFFER_SIZE )
+        {
+            /* A buffer of at least a full record gains nothing from a copy. */
+            writeComplete = writevBuffer( pOpensslParams, pIoVec[ i ].iov_base, pIoVec[ i ].iov_len,
+                                          &totalBytesSent, &bytesSent );
+        }
+        else
+        {
+            ( void ) memcpy( &coalesceBuffer[ bufferedBytes ],
+                             pIoVec[ i ].iov_base,
+                             pIoVec[ i ].iov_len );
+            bufferedBytes += pIoVec[ i ].iov_len;
+        }
+    }
 
-            /* As the SSL context is configured for blocking mode, the SSL_write() function
-             * does not return an SSL_ERROR_WANT_READ or SSL_ERROR_WANT_WRITE error code.
-             * The SSL_ERROR_WANT_READ and SSL_ERROR_WANT_WRITE error codes signify that
-             * the write operation can be retried.
-             * However, in the blocking mode, as the SSL_write() function does not return
-             * either of the error codes, we cannot retry the operation on failure, and thus,
-             * this function will never return a zero error code.
-             */
+    if( ( writeComplete == 1U ) && ( bufferedBytes > 0U ) )
+    {
+        ( void ) writevBuffer( pOpensslParams, coalesceBuffer, bufferedBytes,
+                               &totalBytesSent, &bytesSent );
+    }
 
-            /* The transport interface requires zero return code only when the send operation can
-             * be retried to achieve success. Thus, convert a zero error code to a negative return
-             * value as this cannot be retried. */
-            if( bytesSent == 0 )
+    /* Report the bytes that made it out before a failure so that the caller
+     * does not send them again. */
+    if( totalBytesSent > 0 )
+    {
+        bytesSent = totalBytesSent;
+    }
+
+    return bytesSent;
+}
+/*-----------------------------------------------------------*/
+
+static int32_t sendFileKtls( OpensslParams_t * pOpensslParams,
+                             int32_t fileDescriptor,
+                             off_t offset,
+                             size_t bytesToSend )
+{
+    size_t sendSize = bytesToSend;
+    int32_t bytesSent = -1;
+    int32_t sslError = 0;
+
+    #if defined( OPENSSL_KTLS_SUPPORTED ) && ( TRANSPORT_STATS_ENABLED == 1 )
+        uint64_t startUs = Clock_GetTimeUs64();
+    #endif
+
+    assert( pOpensslParams != NULL );
+    assert( pOpensslParams->pSsl != NULL );
+
+    #ifdef OPENSSL_KTLS_SUPPORTED
+        /* SSL_sendfile reports the bytes sent in an ossl_ssize_t, which
+         * must fit the return value of this function. */
+        if( sendSize > ( size_t ) INT32_MAX )
+        {
+            sendSize = ( size_t ) INT32_MAX;
+        }
+
+        bytesSent = ( int32_t ) SSL_sendfile( pOpensslParams->pSsl,
+                                              fileDescriptor,
+                                              offset,
+                                              sendSize,
+                                              0 );
+
+        if( bytesSent <= 0 )
+        {
+            sslError = SSL_get_error( pOpensslParams->pSsl, bytesSent );
+
+            if( isRetryableError( pOpensslParams, sslError ) == 1U )
             {
+                bytesSent = 0;
+            }
+            else
+            {
+                LogError( ( "Failed to send file over network: SSL_sendfile failed: "
+                            "ErrorStatus=%s.", ERR_reason_error_string( sslError ) ) );
                 bytesSent = -1;
             }
         }
+
+        #if ( TRANSPORT_STATS_ENABLED == 1 )
+            TransportStats_RecordTransfer( &pOpensslParams->stats, 1U, sendSize,
+                                           bytesSent, Clock_GetTimeUs64() - startUs );
+        #endif
+    #else /* ifdef OPENSSL_KTLS_SUPPORTED */
+        ( void ) sslError;
+        ( void ) fileDescriptor;
+        ( void ) offset;
+        ( void ) sendSize;
+        LogError( ( "kTLS is not supported by this OpenSSL build." ) );
+    #endif /* ifdef OPENSSL_KTLS_SUPPORTED */
+
+    return bytesSent;
+}
+/*-----------------------------------------------------------*/
+
+static int32_t sendFileCopy( OpensslParams_t * pOpensslParams,
+                             int32_t fileDescriptor,
+                             off_t offset,
+                             size_t bytesToSend )
+{
+    uint8_t fileBuffer[ OPENSSL_WRITEV_BUFFER_SIZE ];
+    size_t readSize = bytesToSend;
+    ssize_t bytesRead = 0;
+    int32_t bytesSent = -1;
+
+    assert( pOpensslParams != NULL );
+
+    if( readSize > sizeof( fileBuffer ) )
+    {
+        readSize = sizeof( fileBuffer );
+    }
+
+    bytesRead = pread( fileDescriptor, fileBuffer, readSize, offset );
+
+    if( bytesRead < 0 )
+    {
+        LogError( ( "Failed to read file to send: pread failed." ) );
+    }
+    else if( bytesRead == 0 )
+    {
+        LogError( ( "Failed to read file to send: offset %ld is past the end of the file.",
+                    ( long ) offset ) );
     }
     else
     {
-        LogError( ( "Failed to send data over network: "
+        bytesSent = sslWrite( pOpensslParams, fileBuffer, ( size_t ) bytesRead );
+    }
+
+    return bytesSent;
+}
+/*-----------------------------------------------------------*/
+
+int32_t Openssl_SendFile( NetworkContext_t * pNetworkContext,
+                          int32_t fileDescriptor,
+                          off_t offset,
+                          size_t bytesToSend )
+{
+    int32_t bytesSent = -1;
+
+    if( ( pNetworkContext == NULL ) || ( pNetworkContext->pParams == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
+    }
+    else if( ( fileDescriptor < 0 ) || ( offset < 0 ) )
+    {
+        LogError( ( "Parameter check failed: fileDescriptor or offset is negative." ) );
+    }
+    else if( pNetworkContext->pParams->pSsl == NULL )
+    {
+        LogError( ( "Failed to send file over network: "
                     "SSL object in network context is NULL." ) );
     }
+    else if( bytesToSend == 0U )
+    {
+        bytesSent = 0;
+    }
+    else if( pNetworkContext->pParams->ktlsSend != 0U )
+    {
+        bytesSent = sendFileKtls( pNetworkContext->pParams,
+                                  fileDescriptor,
+                                  offset,
+                                  bytesToSend );
+    }
+    else
+    {
+        bytesSent = sendFileCopy( pNetworkContext->pParams,
+                                  fileDescriptor,
+                                  offset,
+                                  bytesToSend );
+    }
 
     return bytesSent;
 }
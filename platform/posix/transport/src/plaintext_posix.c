@@ -27,10 +27,21 @@
 /* POSIX socket includes. */
 #include <errno.h>
 #include <sys/socket.h>
-#include <sys/select.h>
+#include <poll.h>
+#include <sys/uio.h>
 
 #include "plaintext_posix.h"
 
+/* Platform clock include. */
+#include "clock.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The longest timeout that poll accepts, in milliseconds.
+ */
+#define POLL_MAX_TIMEOUT_MS    ( 0x7FFFFFFFU )
+
 /*-----------------------------------------------------------*/
 
 /* Each compilation unit must define the NetworkContext struct. */
@@ -48,6 +59,37 @@ struct NetworkContext
  */
 static void logTransportError( int32_t errorNumber );
 
+/**
+ * @brief Wait until the socket of a connection is ready.
+ *
+ * poll is used rather than select, as select cannot watch descriptors of
+ * FD_SETSIZE or above, which a process with many connections reaches.
+ *
+ * @param[in] socketDescriptor The socket to wait for.
+ * @param[in] events POLLIN to wait for data to read, POLLOUT to wait until
+ * data can be written.
+ * @param[in] timeoutMs Timeout in milliseconds.
+ *
+ * @return The status returned by #poll: positive if the socket is ready,
+ * zero on timeout and negative on error.
+ */
+static int32_t waitForSocket( int32_t socketDescriptor,
+                              int16_t events,
+                              uint32_t timeoutMs );
+
+/**
+ * @brief Convert the result of a send on a writable socket to the return
+ * value of the transport interface.
+ *
+ * @param[in] pollStatus The status returned by #waitForSocket.
+ * @param[in] bytesSent The number of bytes sent; only valid if the socket was
+ * writable.
+ *
+ * @return Number of bytes sent; zero on timeout; negative value on error.
+ */
+static int32_t checkSendStatus( int32_t pollStatus,
+                                int32_t bytesSent );
+
 /*-----------------------------------------------------------*/
 
 static void logTransportError( int32_t errorNumber )
@@ -59,14 +101,85 @@ static void logTransportError( int32_t errorNumber )
 }
 /*-----------------------------------------------------------*/
 
+static int32_t waitForSocket( int32_t socketDescriptor,
+                              int16_t events,
+                              uint32_t timeoutMs )
+{
+    struct pollfd pollDescriptor;
+    uint32_t pollTimeoutMs = timeoutMs;
+
+    pollDescriptor.fd = socketDescriptor;
+    pollDescriptor.events = events;
+    pollDescriptor.revents = 0;
+
+    if( pollTimeoutMs > POLL_MAX_TIMEOUT_MS )
+    {
+        pollTimeoutMs = POLL_MAX_TIMEOUT_MS;
+    }
+
+    return ( int32_t ) poll( &pollDescriptor, 1, ( int32_t ) pollTimeoutMs );
+}
+/*-----------------------------------------------------------*/
+
+static int32_t checkSendStatus( int32_t pollStatus,
+                                int32_t bytesSent )
+{
+    int32_t returnStatus = bytesSent;
+
+    if( pollStatus < 0 )
+    {
+        /* An error occurred while polling. */
+        returnStatus = -1;
+    }
+    else if( pollStatus == 0 )
+    {
+        /* Timed out waiting for data to be sent. */
+        returnStatus = 0;
+    }
+    else if( bytesSent == 0 )
+    {
+        /* Peer has closed the connection. Treat as an error. */
+        returnStatus = -1;
+    }
+    else if( bytesSent < 0 )
+    {
+        logTransportError( errno );
+    }
+    else
+    {
+        /* Empty else MISRA 15.7 */
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
 SocketStatus_t Plaintext_Connect( NetworkContext_t * pNetworkContext,
                                   const ServerInfo_t * pServerInfo,
                                   uint32_t sendTimeoutMs,
                                   uint32_t recvTimeoutMs )
+{
+    return Plaintext_ConnectWithOptions( pNetworkContext,
+                                         pServerInfo,
+                                         sendTimeoutMs,
+                                         recvTimeoutMs,
+                                         NULL );
+}
+/*-----------------------------------------------------------*/
+
+SocketStatus_t Plaintext_ConnectWithOptions( NetworkContext_t * pNetworkContext,
+                                             const ServerInfo_t * pServerInfo,
+                                             uint32_t sendTimeoutMs,
+                                             uint32_t recvTimeoutMs,
+                                             const SocketsOptions_t * pSocketsOptions )
 {
     SocketStatus_t returnStatus = SOCKETS_SUCCESS;
     PlaintextParams_t * pPlaintextParams = NULL;
 
+    #if ( TRANSPORT_STATS_ENABLED == 1 )
+        uint64_t startUs = Clock_GetTimeUs64();
+    #endif
+
     /* Validate parameters. */
     if( ( pNetworkContext == NULL ) || ( pNetworkContext->pParams == NULL ) )
     {
@@ -76,10 +189,25 @@ SocketStatus_t Plaintext_Connect( NetworkContext_t * pNetworkContext,
     else
     {
         pPlaintextParams = pNetworkContext->pParams;
-        returnStatus = Sockets_Connect( &pPlaintextParams->socketDescriptor,
-                                        pServerInfo,
-                                        sendTimeoutMs,
-                                        recvTimeoutMs );
+        returnStatus = Sockets_ConnectWithOptions( &pPlaintextParams->socketDescriptor,
+                                                   pServerInfo,
+                                                   sendTimeoutMs,
+                                                   recvTimeoutMs,
+                                                   pSocketsOptions );
+
+        #if ( TRANSPORT_STATS_ENABLED == 1 )
+            TransportStats_RecordConnect( &pPlaintextParams->stats,
+                                          ( returnStatus == SOCKETS_SUCCESS ) ? 1U : 0U,
+                                          Clock_GetTimeUs64() - startUs );
+        #endif
+    }
+
+    /* Keep the timeouts so that they need not be read back from the socket
+     * on every send and receive. */
+    if( returnStatus == SOCKETS_SUCCESS )
+    {
+        pPlaintextParams->sendTimeoutMs = sendTimeoutMs;
+        pPlaintextParams->recvTimeoutMs = recvTimeoutMs;
     }
 
     return returnStatus;
@@ -107,6 +235,37 @@ SocketStatus_t Plaintext_Disconnect( const NetworkContext_t * pNetworkContext )
 }
 /*-----------------------------------------------------------*/
 
+SocketStatus_t Plaintext_SetTimeouts( NetworkContext_t * pNetworkContext,
+                                      uint32_t sendTimeoutMs,
+                                      uint32_t recvTimeoutMs )
+{
+    SocketStatus_t returnStatus = SOCKETS_SUCCESS;
+    PlaintextParams_t * pPlaintextParams = NULL;
+
+    /* Validate parameters. */
+    if( ( pNetworkContext == NULL ) || ( pNetworkContext->pParams == NULL ) )
+    {
+        LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
+        returnStatus = SOCKETS_INVALID_PARAMETER;
+    }
+    else
+    {
+        pPlaintextParams = pNetworkContext->pParams;
+        returnStatus = Sockets_SetTimeouts( pPlaintextParams->socketDescriptor,
+                                            sendTimeoutMs,
+                                            recvTimeoutMs );
+    }
+
+    if( returnStatus == SOCKETS_SUCCESS )
+    {
+        pPlaintextParams->sendTimeoutMs = sendTimeoutMs;
+        pPlaintextParams->recvTimeoutMs = recvTimeoutMs;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
 /* MISRA Rule 8.13 flags the following line for not using the const qualifier
  * on `pNetworkContext`. Indeed, the object pointed by it is not modified
  * by POSIX sockets, but other implementations of `TransportRecv_t` may do so. */
@@ -115,71 +274,25 @@ int32_t Plaintext_Recv( NetworkContext_t * pNetworkContext,
                         size_t bytesToRecv )
 {
     PlaintextParams_t * pPlaintextParams = NULL;
-    int32_t bytesReceived = -1, selectStatus = -1, getTimeoutStatus = -1;
-    struct timeval recvTimeout;
-    socklen_t recvTimeoutLen;
-    fd_set readfds;
+    int32_t bytesReceived = -1, pollStatus = -1;
+
+    #if ( TRANSPORT_STATS_ENABLED == 1 )
+        uint64_t startUs = Clock_GetTimeUs64();
+    #endif
 
     assert( pNetworkContext != NULL && pNetworkContext->pParams != NULL );
     assert( pBuffer != NULL );
     assert( bytesToRecv > 0 );
 
-    /* Get receive timeout from the socket to use as the timeout for #select. */
     pPlaintextParams = pNetworkContext->pParams;
-    recvTimeoutLen = ( socklen_t ) sizeof( recvTimeout );
-    getTimeoutStatus = getsockopt( pPlaintextParams->socketDescriptor,
-                                   SOL_SOCKET,
-                                   SO_RCVTIMEO,
-                                   &recvTimeout,
-                                   &recvTimeoutLen );
-
-    /* Make #select return immediately if getting the timeout failed. */
-    if( getTimeoutStatus < 0 )
-    {
-        recvTimeout.tv_sec = 0;
-        recvTimeout.tv_usec = 0;
-    }
 
-    /* MISRA Directive 4.6 flags the following line for a violation of using a
-     * basic type "int" rather than a type that includes size and signedness information.
-     * We suppress the violation as the flagged type, "fd_set", is a POSIX
-     * system-specific type, and is used for the call to "select()". */
-
-    /* MISRA Rule 14.4 flags the following line for using condition expression "0"
-     * as a boolean type. We suppress the violation as the "FD_ZERO" is a POSIX
-     * specific macro utility whose implementation is supplied by the system.
-     * The "FD_ZERO" macro is called as specified by the POSIX manual here:
-     * https://pubs.opengroup.org/onlinepubs/009695399/basedefs/sys/select.h.html */
-    /* coverity[misra_c_2012_directive_4_6_violation] */
-    /* coverity[misra_c_2012_rule_14_4_violation] */
-    FD_ZERO( &readfds );
-
-    /* MISRA Directive 4.6 flags the following line for a violation of using a
-     * basic type "int" rather than a type that includes size and signedness information.
-     * We suppress the violation as the flagged type, "fd_set", is a POSIX
-     * system-specific type, and is used for the call to "select()". */
-    /* coverity[misra_c_2012_directive_4_6_violation] */
-
-    /* MISRA Rule 10.1, Rule 10.8 and Rule 13.4 flag the following line for
-     * implementation of the "FD_SET()" POSIX macro. We suppress these violations
-     * "FD_SET" is a POSIX specific macro utility whose implementation
-     * is supplied by the system.
-     * The "FD_SET" macro is used as specified by the POSIX manual here:
-     * https://pubs.opengroup.org/onlinepubs/009695399/basedefs/sys/select.h.html */
-    /* coverity[misra_c_2012_directive_4_6_violation] */
-    /* coverity[misra_c_2012_rule_10_1_violation] */
-    /* coverity[misra_c_2012_rule_13_4_violation] */
-    /* coverity[misra_c_2012_rule_10_8_violation] */
-    FD_SET( pPlaintextParams->socketDescriptor, &readfds );
-
-    /* Check if there is data to read from the socket. */
-    selectStatus = select( pPlaintextParams->socketDescriptor + 1,
-                           &readfds,
-                           NULL,
-                           NULL,
-                           &recvTimeout );
-
-    if( selectStatus > 0 )
+    /* Check if there is data to read from the socket, waiting at most the
+     * receive timeout of the connection. */
+    pollStatus = waitForSocket( pPlaintextParams->socketDescriptor,
+                                POLLIN,
+                                pPlaintextParams->recvTimeoutMs );
+
+    if( pollStatus > 0 )
     {
         /* The socket is available for receiving data. */
         bytesReceived = ( int32_t ) recv( pPlaintextParams->socketDescriptor,
@@ -187,7 +300,7 @@ int32_t Plaintext_Recv( NetworkContext_t * pNetworkContext,
                                           bytesToRecv,
                                           0 );
     }
-    else if( selectStatus < 0 )
+    else if( pollStatus < 0 )
     {
         /* An error occurred while polling. */
         bytesReceived = -1;
@@ -198,7 +311,7 @@ int32_t Plaintext_Recv( NetworkContext_t * pNetworkContext,
         bytesReceived = 0;
     }
 
-    if( ( selectStatus > 0 ) && ( bytesReceived == 0 ) )
+    if( ( pollStatus > 0 ) && ( bytesReceived == 0 ) )
     {
         /* Peer has closed the connection. Treat as an error. */
         bytesReceived = -1;
@@ -212,6 +325,11 @@ int32_t Plaintext_Recv( NetworkContext_t * pNetworkContext,
         /* Empty else MISRA 15.7 */
     }
 
+    #if ( TRANSPORT_STATS_ENABLED == 1 )
+        TransportStats_RecordTransfer( &pPlaintextParams->stats, 0U, bytesToRecv,
+                                       bytesReceived, Clock_GetTimeUs64() - startUs );
+    #endif
+
     return bytesReceived;
 }
 /*-----------------------------------------------------------*/
@@ -224,69 +342,22 @@ int32_t Plaintext_Send( NetworkContext_t * pNetworkContext,
                         size_t bytesToSend )
 {
     PlaintextParams_t * pPlaintextParams = NULL;
-    int32_t bytesSent = -1, selectStatus = -1, getTimeoutStatus = -1;
-    struct timeval sendTimeout;
-    socklen_t sendTimeoutLen;
-    fd_set writefds;
+    int32_t bytesSent = -1, pollStatus = -1;
+
+    #if ( TRANSPORT_STATS_ENABLED == 1 )
+        uint64_t startUs = Clock_GetTimeUs64();
+    #endif
 
     assert( pNetworkContext != NULL && pNetworkContext->pParams != NULL );
     assert( pBuffer != NULL );
     assert( bytesToSend > 0 );
 
-    /* Get send timeout from the socket to use as the timeout for #select. */
     pPlaintextParams = pNetworkContext->pParams;
-    sendTimeoutLen = ( socklen_t ) sizeof( sendTimeout );
-    getTimeoutStatus = getsockopt( pPlaintextParams->socketDescriptor,
-                                   SOL_SOCKET,
-                                   SO_SNDTIMEO,
-                                   &sendTimeout,
-                                   &sendTimeoutLen );
-
-    /* Make #select return immediately if getting the timeout failed. */
-    if( getTimeoutStatus < 0 )
-    {
-        sendTimeout.tv_sec = 0;
-        sendTimeout.tv_usec = 0;
-    }
+    pollStatus = waitForSocket( pPlaintextParams->socketDescriptor,
+                                POLLOUT,
+                                pPlaintextParams->sendTimeoutMs );
 
-    /* MISRA Directive 4.6 flags the following line for a violation of using a
-     * basic type "int" rather than a type that includes size and signedness information.
-     * We suppress the violation as the flagged type, "fd_set", is a POSIX
-     * system-specific type, and is used for the call to "select()". */
-
-    /* MISRA Rule 14.4 flags the following line for using condition expression "0"
-     * as a boolean type. We suppress the violation as the "FD_ZERO" is a POSIX
-     * specific macro utility whose implementation is supplied by the system.
-     * The "FD_ZERO" macro is called as specified by the POSIX manual here:
-     * https://pubs.opengroup.org/onlinepubs/009695399/basedefs/sys/select.h.html */
-    /* coverity[misra_c_2012_directive_4_6_violation] */
-    /* coverity[misra_c_2012_rule_14_4_violation] */
-    FD_ZERO( &writefds );
-
-    /* MISRA Directive 4.6 flags the following line for a violation of using a
-     * basic type "int" rather than a type that includes size and signedness information.
-     * We suppress the violation as the flagged type, "fd_set", is a POSIX
-     * system-specific type, and is used for the call to "select()". */
-
-    /* MISRA Rule 10.1, Rule 10.8 and Rule 13.4 flag the following line for
-     * implementation of the "FD_SET()" POSIX macro. We suppress these violations
-     * as "FD_SET" is a POSIX specific macro utility whose implementation
-     * is supplied by the system.
-     * The "FD_ZERO" macro is used as specified by the POSIX manual here:
-     * https://pubs.opengroup.org/onlinepubs/009695399/basedefs/sys/select.h.html */
-    /* coverity[misra_c_2012_directive_4_6_violation] */
-    /* coverity[misra_c_2012_rule_10_1_violation] */
-    /* coverity[misra_c_2012_rule_13_4_violation] */
-    /* coverity[misra_c_2012_rule_10_8_violation] */
-    FD_SET( pPlaintextParams->socketDescriptor, &writefds );
-    /* Check if data can be written to the socket. */
-    selectStatus = select( pPlaintextParams->socketDescriptor + 1,
-                           NULL,
-                           &writefds,
-                           NULL,
-                           &sendTimeout );
-
-    if( selectStatus > 0 )
+    if( pollStatus > 0 )
     {
         /* The socket is available for sending data. */
         bytesSent = ( int32_t ) send( pPlaintextParams->socketDescriptor,
@@ -294,31 +365,93 @@ int32_t Plaintext_Send( NetworkContext_t * pNetworkContext,
                                       bytesToSend,
                                       0 );
     }
-    else if( selectStatus < 0 )
-    {
-        /* An error occurred while polling. */
-        bytesSent = -1;
-    }
-    else
-    {
-        /* Timed out waiting for data to be sent. */
-        bytesSent = 0;
-    }
 
-    if( ( selectStatus > 0 ) && ( bytesSent == 0 ) )
-    {
-        /* Peer has closed the connection. Treat as an error. */
-        bytesSent = -1;
-    }
-    else if( bytesSent < 0 )
+    bytesSent = checkSendStatus( pollStatus, bytesSent );
+
+    #if ( TRANSPORT_STATS_ENABLED == 1 )
+        TransportStats_RecordTransfer( &pPlaintextParams->stats, 1U, bytesToSend,
+                                       bytesSent, Clock_GetTimeUs64() - startUs );
+    #endif
+
+    return bytesSent;
+}
+/*-----------------------------------------------------------*/
+
+int32_t Plaintext_Writev( NetworkContext_t * pNetworkContext,
+                          const struct iovec * pIoVec,
+                          size_t ioVecCount )
+{
+    PlaintextParams_t * pPlaintextParams = NULL;
+    int32_t bytesSent = -1, pollStatus = -1;
+
+    #if ( TRANSPORT_STATS_ENABLED == 1 )
+        uint64_t startUs = Clock_GetTimeUs64();
+        size_t bytesToSend = 0, i = 0;
+    #endif
+
+    assert( pNetworkContext != NULL && pNetworkContext->pParams != NULL );
+    assert( pIoVec != NULL );
+    assert( ioVecCount > 0 );
+
+    /* Any vectors beyond the limit of the system are left for the next call,
+     * as for any other partial send. */
+    if( ioVecCount > ( size_t ) UIO_MAXIOV )
     {
-        logTransportError( errno );
+        ioVecCount = ( size_t ) UIO_MAXIOV;
     }
-    else
+
+    pPlaintextParams = pNetworkContext->pParams;
+    pollStatus = waitForSocket( pPlaintextParams->socketDescriptor,
+                                POLLOUT,
+                                pPlaintextParams->sendTimeoutMs );
+
+    if( pollStatus > 0 )
     {
-        /* Empty else MISRA 15.7 */
+        /* Send all vectors with a single system call so that they can share
+         * a TCP segment. */
+        bytesSent = ( int32_t ) writev( pPlaintextParams->socketDescriptor,
+                                        pIoVec,
+                                        ( int ) ioVecCount );
     }
 
+    bytesSent = checkSendStatus( pollStatus, bytesSent );
+
+    #if ( TRANSPORT_STATS_ENABLED == 1 )
+        for( i = 0; i < ioVecCount; i++ )
+        {
+            bytesToSend += pIoVec[ i ].iov_len;
+        }
+
+        TransportStats_RecordTransfer( &pPlaintextParams->stats, 1U, bytesToSend,
+                                       bytesSent, Clock_GetTimeUs64() - startUs );
+    #endif
+
     return bytesSent;
 }
 /*-----------------------------------------------------------*/
+
+#if ( TRANSPORT_STATS_ENABLED == 1 )
+    SocketStatus_t Plaintext_GetStats( const NetworkContext_t * pNetworkContext,
+                                       TransportStats_t * pStats )
+    {
+        SocketStatus_t returnStatus = SOCKETS_SUCCESS;
+
+        if( ( pNetworkContext == NULL ) || ( pNetworkContext->pParams == NULL ) )
+        {
+            LogError( ( "Parameter check failed: pNetworkContext is NULL." ) );
+            returnStatus = SOCKETS_INVALID_PARAMETER;
+        }
+        else if( pStats == NULL )
+        {
+            LogError( ( "Parameter check failed: pStats is NULL." ) );
+            returnStatus = SOCKETS_INVALID_PARAMETER;
+        }
+        else
+        {
+            TransportStats_Snapshot( &pNetworkContext->pParams->stats, pStats );
+        }
+
+        return returnStatus;
+    }
+/*-----------------------------------------------------------*/
+#endif /* if ( TRANSPORT_STATS_ENABLED == 1 ) */
@@ -22,19 +22,28 @@
 
 /* Standard includes. */
 #include <assert.h>
+#include <stdbool.h>
 #include <string.h>
 
 /* POSIX sockets includes. */
 #include <errno.h>
+#include <fcntl.h>
 #include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
 #include <time.h>
 #include <unistd.h>
 #include <sys/time.h>
 #include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/socket.h>
 
 #include "sockets_posix.h"
 
+/* Platform clock include. */
+#include "clock.h"
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -47,6 +56,67 @@
  */
 #define ONE_MS_TO_US     ( 1000 )
 
+/**
+ * @brief Number of nanoseconds in one millisecond.
+ */
+#define ONE_MS_TO_NS     ( 1000000 )
+
+/**
+ * @brief Maximum length of a host name stored in the DNS cache.
+ */
+#define DNS_CACHE_MAX_HOSTNAME_LENGTH    ( 253U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A resolved address of the server.
+ */
+typedef struct ResolvedAddress
+{
+    int32_t family;                  /**< @brief Address family of the socket. */
+    int32_t socketType;              /**< @brief Type of the socket. */
+    int32_t protocol;                /**< @brief Protocol of the socket. */
+    struct sockaddr_storage address; /**< @brief Address of the server. */
+} ResolvedAddress_t;
+
+/**
+ * @brief The resolved addresses of the server in the order they are attempted.
+ */
+typedef struct ResolvedAddressList
+{
+    size_t numAddresses;                                         /**< @brief Number of entries in addresses. */
+    ResolvedAddress_t addresses[ SOCKETS_MAX_CONNECT_ATTEMPTS ]; /**< @brief The resolved addresses. */
+} ResolvedAddressList_t;
+
+/**
+ * @brief An entry of the DNS cache.
+ */
+typedef struct DnsCacheEntry
+{
+    char hostName[ DNS_CACHE_MAX_HOSTNAME_LENGTH ]; /**< @brief Server host name. Not NULL-terminated. */
+    size_t hostNameLength;                          /**< @brief Length of hostName, or 0 if the entry is unused. */
+    uint16_t port;                                  /**< @brief Server port in host-order. */
+    uint64_t expiryTimeMs;                          /**< @brief Time after which the entry is stale. */
+    ResolvedAddressList_t addressList;              /**< @brief The resolved addresses of the server. */
+} DnsCacheEntry_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Resolved addresses of recently connected servers.
+ */
+static DnsCacheEntry_t dnsCache[ SOCKETS_DNS_CACHE_SIZE ];
+
+/**
+ * @brief Hit and miss counters of #dnsCache.
+ */
+static SocketsDnsCacheStats_t dnsCacheStats = { 0 };
+
+/**
+ * @brief Mutex protecting #dnsCache and #dnsCacheStats.
+ */
+static pthread_mutex_t dnsCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+
 /*-----------------------------------------------------------*/
 
 /**
@@ -54,45 +124,163 @@
  *
  * @param[in] pHostName Server host name.
  * @param[in] hostNameLength Length associated with host name.
- * @param[out] pListHead The output parameter to return the list containing
- * resolved DNS records.
+ * @param[out] pAddressList The output parameter to return the resolved
+ * addresses in the order they should be attempted.
  *
  * @return #SOCKETS_SUCCESS if successful; #SOCKETS_DNS_FAILURE, #SOCKETS_CONNECT_FAILURE on error.
  */
 static SocketStatus_t resolveHostName( const char * pHostName,
                                        size_t hostNameLength,
-                                       struct addrinfo ** pListHead );
+                                       ResolvedAddressList_t * pAddressList );
 
 /**
- * @brief Traverse list of DNS records until a connection is established.
+ * @brief Order the resolved DNS records for connection attempts.
+ *
+ * Records are interleaved by address family, starting with the family of the
+ * first record returned by the resolver, as described in RFC 8305.
  *
  * @param[in] pListHead List containing resolved DNS records.
+ * @param[out] pAddressList The ordered addresses.
+ */
+static void sortAddresses( const struct addrinfo * pListHead,
+                           ResolvedAddressList_t * pAddressList );
+
+/**
+ * @brief Find the next DNS record whose address family matches, or does not
+ * match, the given family.
+ *
+ * @param[in] pIndex The record from which to start searching.
+ * @param[in] family The address family to compare against.
+ * @param[in] sameFamily Whether to look for a record of the same family.
+ *
+ * @return The record found, or NULL if there is none.
+ */
+static const struct addrinfo * nextAddressOfFamily( const struct addrinfo * pIndex,
+                                                    int32_t family,
+                                                    bool sameFamily );
+
+/**
+ * @brief Race connection attempts to the resolved addresses until a
+ * connection is established.
+ *
+ * @param[in] pAddressList The resolved addresses.
  * @param[in] pHostName Server host name.
  * @param[in] hostNameLength Length associated with host name.
  * @param[in] port Server port in host-order.
+ * @param[in] pSocketsOptions Options to apply to each socket, or NULL.
  * @param[out] pTcpSocket The output parameter to return the created socket.
  *
  * @return #SOCKETS_SUCCESS if successful; #SOCKETS_CONNECT_FAILURE on error.
  */
-static SocketStatus_t attemptConnection( struct addrinfo * pListHead,
+static SocketStatus_t attemptConnection( ResolvedAddressList_t * pAddressList,
                                          const char * pHostName,
                                          size_t hostNameLength,
                                          uint16_t port,
+                                         const SocketsOptions_t * pSocketsOptions,
                                          int32_t * pTcpSocket );
 
 /**
- * @brief Connect to server using the provided address record.
+ * @brief Set an integer socket option.
+ *
+ * @param[in] tcpSocket Socket handle.
+ * @param[in] level Protocol level of the option.
+ * @param[in] optionName Name of the option.
+ * @param[in] value Value of the option.
+ * @param[in] pOptionLabel Name of the option to log on failure.
+ *
+ * @return #SOCKETS_SUCCESS if successful; #SOCKETS_API_ERROR on error.
+ */
+static SocketStatus_t setIntOption( int32_t tcpSocket,
+                                    int32_t level,
+                                    int32_t optionName,
+                                    uint32_t value,
+                                    const char * pOptionLabel );
+
+/**
+ * @brief Apply the socket options requested by the application.
+ *
+ * @param[in] tcpSocket Socket handle.
+ * @param[in] pSocketsOptions Options to apply. Options with a value of 0 are
+ * left unchanged.
+ *
+ * @return #SOCKETS_SUCCESS if all options were applied; #SOCKETS_API_ERROR on
+ * error.
+ */
+static SocketStatus_t applySocketOptions( int32_t tcpSocket,
+                                          const SocketsOptions_t * pSocketsOptions );
+
+/**
+ * @brief Start a non-blocking connection to the server using the provided
+ * address record.
  *
  * @param[in, out] pAddrInfo Address record of the server.
  * @param[in] port Server port in host-order.
+ * @param[in] pSocketsOptions Options to apply to the socket, or NULL.
  * @param[in] pTcpSocket Socket handle.
  *
- * @return #SOCKETS_SUCCESS if successful; #SOCKETS_CONNECT_FAILURE on error.
+ * @note The socket is closed if the connection cannot be started.
+ *
+ * @return #SOCKETS_SUCCESS if the connection was established or is in
+ * progress; #SOCKETS_CONNECT_FAILURE on error.
  */
 static SocketStatus_t connectToAddress( struct sockaddr * pAddrInfo,
                                         uint16_t port,
+                                        const SocketsOptions_t * pSocketsOptions,
                                         int32_t tcpSocket );
 
+/**
+ * @brief Check the connection attempts reported as complete by poll.
+ *
+ * Failed attempts are closed and removed from @p pPendingSockets.
+ *
+ * @param[in, out] pPendingSockets Sockets with a connection in progress.
+ * @param[in, out] pNumPending Number of entries in @p pPendingSockets.
+ *
+ * @return The socket of the first successful attempt, which is removed from
+ * @p pPendingSockets, or -1 if none succeeded.
+ */
+static int32_t checkPendingConnections( struct pollfd * pPendingSockets,
+                                        size_t * pNumPending );
+
+/**
+ * @brief Find the DNS cache entry of a server.
+ *
+ * @note #dnsCacheMutex must be held by the caller.
+ *
+ * @param[in] pServerInfo Server connection info.
+ *
+ * @return The cache entry, or NULL if the server is not cached.
+ */
+static DnsCacheEntry_t * findDnsCacheEntry( const ServerInfo_t * pServerInfo );
+
+/**
+ * @brief Get the cached addresses of a server.
+ *
+ * @param[in] pServerInfo Server connection info.
+ * @param[out] pAddressList The cached addresses.
+ *
+ * @return true if the addresses were found in the cache; false otherwise.
+ */
+static bool lookupDnsCache( const ServerInfo_t * pServerInfo,
+                            ResolvedAddressList_t * pAddressList );
+
+/**
+ * @brief Add the resolved addresses of a server to the cache, replacing the
+ * entry closest to expiry if the cache is full.
+ *
+ * @param[in] pServerInfo Server connection info.
+ * @param[in] pAddressList The resolved addresses.
+ */
+static void storeDnsCache( const ServerInfo_t * pServerInfo,
+                           const ResolvedAddressList_t * pAddressList );
+
+/**
+ * @brief Get the value of a monotonic clock.
+ *
+ * @return Time in milliseconds.
+ */
+static uint64_t getTimeMs( void );
+
 /**
  * @brief Log possible error using errno and return appropriate status.
  *
@@ -106,11 +294,12 @@ static SocketStatus_t retrieveError( int32_t errorNumber );
 
 static SocketStatus_t resolveHostName( const char * pHostName,
                                        size_t hostNameLength,
-                                       struct addrinfo ** pListHead )
+                                       ResolvedAddressList_t * pAddressList )
 {
     SocketStatus_t returnStatus = SOCKETS_SUCCESS;
     int32_t dnsStatus = -1;
     struct addrinfo hints;
+    struct addrinfo * pListHead = NULL;
 
     assert( pHostName != NULL );
     assert( hostNameLength > 0 );
@@ -128,7 +317,7 @@ static SocketStatus_t resolveHostName( const char * pHostName,
     hints.ai_protocol = IPPROTO_TCP;
 
     /* Perform a DNS lookup on the given host name. */
-    dnsStatus = getaddrinfo( pHostName, NULL, &hints, pListHead );
+    dnsStatus = getaddrinfo( pHostName, NULL, &hints, &pListHead );
 
     if( dnsStatus != 0 )
     {
@@ -138,6 +327,110 @@ static SocketStatus_t resolveHostName( const char * pHostName,
                     dnsStatus ) );
         returnStatus = SOCKETS_DNS_FAILURE;
     }
+    else
+    {
+        sortAddresses( pListHead, pAddressList );
+        freeaddrinfo( pListHead );
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+static SocketStatus_t setIntOption( int32_t tcpSocket,
+                                    int32_t level,
+                                    int32_t optionName,
+                                    uint32_t value,
+                                    const char * pOptionLabel )
+{
+    SocketStatus_t returnStatus = SOCKETS_SUCCESS;
+    int32_t optionValue = ( int32_t ) value;
+
+    /* Unused parameter when logs are disabled. */
+    ( void ) pOptionLabel;
+
+    if( setsockopt( tcpSocket,
+                    level,
+                    optionName,
+                    &optionValue,
+                    ( socklen_t ) sizeof( optionValue ) ) < 0 )
+    {
+        LogError( ( "Setting socket option %s to %u failed: %s.",
+                    pOptionLabel,
+                    ( unsigned int ) value,
+                    strerror( errno ) ) );
+        returnStatus = SOCKETS_API_ERROR;
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+static SocketStatus_t applySocketOptions( int32_t tcpSocket,
+                                          const SocketsOptions_t * pSocketsOptions )
+{
+    SocketStatus_t returnStatus = SOCKETS_SUCCESS;
+
+    assert( pSocketsOptions != NULL );
+
+    if( pSocketsOptions->noDelay != 0U )
+    {
+        returnStatus = setIntOption( tcpSocket, IPPROTO_TCP, TCP_NODELAY, 1U, "TCP_NODELAY" );
+    }
+
+    if( ( returnStatus == SOCKETS_SUCCESS ) && ( pSocketsOptions->keepAlive != 0U ) )
+    {
+        returnStatus = setIntOption( tcpSocket, SOL_SOCKET, SO_KEEPALIVE, 1U, "SO_KEEPALIVE" );
+    }
+
+    if( ( returnStatus == SOCKETS_SUCCESS ) && ( pSocketsOptions->keepAliveIdleSec != 0U ) )
+    {
+        returnStatus = setIntOption( tcpSocket, IPPROTO_TCP, TCP_KEEPIDLE,
+                                     pSocketsOptions->keepAliveIdleSec, "TCP_KEEPIDLE" );
+    }
+
+    if( ( returnStatus == SOCKETS_SUCCESS ) && ( pSocketsOptions->keepAliveIntervalSec != 0U ) )
+    {
+        returnStatus = setIntOption( tcpSocket, IPPROTO_TCP, TCP_KEEPINTVL,
+                                     pSocketsOptions->keepAliveIntervalSec, "TCP_KEEPINTVL" );
+    }
+
+    if( ( returnStatus == SOCKETS_SUCCESS ) && ( pSocketsOptions->keepAliveCount != 0U ) )
+    {
+        returnStatus = setIntOption( tcpSocket, IPPROTO_TCP, TCP_KEEPCNT,
+                                     pSocketsOptions->keepAliveCount, "TCP_KEEPCNT" );
+    }
+
+    if( ( returnStatus == SOCKETS_SUCCESS ) && ( pSocketsOptions->userTimeoutMs != 0U ) )
+    {
+        returnStatus = setIntOption( tcpSocket, IPPROTO_TCP, TCP_USER_TIMEOUT,
+                                     pSocketsOptions->userTimeoutMs, "TCP_USER_TIMEOUT" );
+    }
+
+    /* The buffer sizes must be set before connecting for the TCP window scale
+     * to be negotiated accordingly. */
+    if( ( returnStatus == SOCKETS_SUCCESS ) && ( pSocketsOptions->sendBufferSize != 0U ) )
+    {
+        returnStatus = setIntOption( tcpSocket, SOL_SOCKET, SO_SNDBUF,
+                                     pSocketsOptions->sendBufferSize, "SO_SNDBUF" );
+    }
+
+    if( ( returnStatus == SOCKETS_SUCCESS ) && ( pSocketsOptions->recvBufferSize != 0U ) )
+    {
+        returnStatus = setIntOption( tcpSocket, SOL_SOCKET, SO_RCVBUF,
+                                     pSocketsOptions->recvBufferSize, "SO_RCVBUF" );
+    }
+
+    if( ( returnStatus == SOCKETS_SUCCESS ) && ( pSocketsOptions->fastOpen != 0U ) )
+    {
+        #ifdef TCP_FASTOPEN_CONNECT
+            returnStatus = setIntOption( tcpSocket, IPPROTO_TCP, TCP_FASTOPEN_CONNECT,
+                                         1U, "TCP_FASTOPEN_CONNECT" );
+        #else
+            LogError( ( "TCP_FASTOPEN_CONNECT is not supported by the system headers." ) );
+            returnStatus = SOCKETS_API_ERROR;
+        #endif
+    }
 
     return returnStatus;
 }
@@ -145,10 +438,12 @@ static SocketStatus_t resolveHostName( const char * pHostName,
 
 static SocketStatus_t connectToAddress( struct sockaddr * pAddrInfo,
                                         uint16_t port,
+                                        const SocketsOptions_t * pSocketsOptions,
                                         int32_t tcpSocket )
 {
     SocketStatus_t returnStatus = SOCKETS_SUCCESS;
-    int32_t connectStatus = 0;
+    int32_t connectStatus = -1;
+    int32_t socketFlags = -1;
     char resolvedIpAddr[ INET6_ADDRSTRLEN ];
     socklen_t addrInfoLength;
     uint16_t netPort = 0;
@@ -201,8 +496,37 @@ static SocketStatus_t connectToAddress( struct sockaddr * pAddrInfo,
                 " IP address=%s.",
                 resolvedIpAddr ) );
 
-    /* Attempt to connect. */
-    connectStatus = connect( tcpSocket, pAddrInfo, addrInfoLength );
+    /* Socket options such as the buffer sizes only take full effect when
+     * they are set before connecting. */
+    if( ( pSocketsOptions == NULL ) ||
+        ( applySocketOptions( tcpSocket, pSocketsOptions ) == SOCKETS_SUCCESS ) )
+    {
+        /* Make the socket non-blocking so that the connection attempt can be
+         * raced against attempts to the other resolved addresses. */
+        socketFlags = fcntl( tcpSocket, F_GETFL );
+
+        if( socketFlags != -1 )
+        {
+            socketFlags = fcntl( tcpSocket, F_SETFL, socketFlags | O_NONBLOCK );
+        }
+
+        if( socketFlags == -1 )
+        {
+            LogError( ( "Failed to set socket to non-blocking mode." ) );
+        }
+    }
+
+    if( socketFlags != -1 )
+    {
+        /* Attempt to connect. */
+        connectStatus = connect( tcpSocket, pAddrInfo, addrInfoLength );
+
+        /* The connection is still in progress. Its result is reported by poll. */
+        if( ( connectStatus == -1 ) && ( errno == EINPROGRESS ) )
+        {
+            connectStatus = 0;
+        }
+    }
 
     if( connectStatus == -1 )
     {
@@ -216,16 +540,271 @@ static SocketStatus_t connectToAddress( struct sockaddr * pAddrInfo,
 }
 /*-----------------------------------------------------------*/
 
-static SocketStatus_t attemptConnection( struct addrinfo * pListHead,
+static const struct addrinfo * nextAddressOfFamily( const struct addrinfo * pIndex,
+                                                    int32_t family,
+                                                    bool sameFamily )
+{
+    const struct addrinfo * pAddress = pIndex;
+
+    while( ( pAddress != NULL ) &&
+           ( ( pAddress->ai_family == family ) != sameFamily ) )
+    {
+        pAddress = pAddress->ai_next;
+    }
+
+    return pAddress;
+}
+/*-----------------------------------------------------------*/
+
+static void sortAddresses( const struct addrinfo * pListHead,
+                           ResolvedAddressList_t * pAddressList )
+{
+    const struct addrinfo * pPreferred = NULL;
+    const struct addrinfo * pOther = NULL;
+    const struct addrinfo * pSelected = NULL;
+    ResolvedAddress_t * pAddress = NULL;
+    int32_t preferredFamily = 0;
+    size_t numCandidates = 0U;
+    size_t addressLength = 0U;
+    bool usePreferred = true;
+
+    assert( pListHead != NULL );
+    assert( pAddressList != NULL );
+
+    /* The resolver has already ordered the records by preference, so the
+     * family of the first record is attempted first. */
+    preferredFamily = pListHead->ai_family;
+    pPreferred = pListHead;
+    pOther = nextAddressOfFamily( pListHead, preferredFamily, false );
+
+    while( ( numCandidates < SOCKETS_MAX_CONNECT_ATTEMPTS ) &&
+           ( ( pPreferred != NULL ) || ( pOther != NULL ) ) )
+    {
+        if( ( pOther == NULL ) || ( ( usePreferred == true ) && ( pPreferred != NULL ) ) )
+        {
+            pSelected = pPreferred;
+            pPreferred = nextAddressOfFamily( pPreferred->ai_next, preferredFamily, true );
+        }
+        else
+        {
+            pSelected = pOther;
+            pOther = nextAddressOfFamily( pOther->ai_next, preferredFamily, false );
+        }
+
+        /* Copy the record so that it outlives the list returned by getaddrinfo. */
+        pAddress = &pAddressList->addresses[ numCandidates ];
+        pAddress->family = pSelected->ai_family;
+        pAddress->socketType = pSelected->ai_socktype;
+        pAddress->protocol = pSelected->ai_protocol;
+
+        addressLength = ( size_t ) pSelected->ai_addrlen;
+
+        if( addressLength > sizeof( pAddress->address ) )
+        {
+            addressLength = sizeof( pAddress->address );
+        }
+
+        ( void ) memset( &pAddress->address, 0, sizeof( pAddress->address ) );
+        ( void ) memcpy( &pAddress->address, pSelected->ai_addr, addressLength );
+
+        numCandidates++;
+        usePreferred = ( usePreferred == true ) ? false : true;
+    }
+
+    if( ( pPreferred != NULL ) || ( pOther != NULL ) )
+    {
+        LogDebug( ( "Only the first %u resolved addresses will be attempted.",
+                    ( unsigned int ) SOCKETS_MAX_CONNECT_ATTEMPTS ) );
+    }
+
+    pAddressList->numAddresses = numCandidates;
+}
+/*-----------------------------------------------------------*/
+
+static int32_t checkPendingConnections( struct pollfd * pPendingSockets,
+                                        size_t * pNumPending )
+{
+    int32_t tcpSocket = -1;
+    int32_t socketError = 0;
+    int32_t getOptStatus = -1;
+    socklen_t socketErrorLength;
+    size_t index = 0U;
+
+    assert( pPendingSockets != NULL );
+    assert( pNumPending != NULL );
+
+    while( ( tcpSocket == -1 ) && ( index < *pNumPending ) )
+    {
+        if( pPendingSockets[ index ].revents != 0 )
+        {
+            /* The attempt has completed. SO_ERROR reports whether it succeeded. */
+            socketError = 0;
+            socketErrorLength = ( socklen_t ) sizeof( socketError );
+            getOptStatus = getsockopt( pPendingSockets[ index ].fd,
+                                       SOL_SOCKET,
+                                       SO_ERROR,
+                                       &socketError,
+                                       &socketErrorLength );
+
+            if( ( getOptStatus == 0 ) && ( socketError == 0 ) )
+            {
+                tcpSocket = pPendingSockets[ index ].fd;
+            }
+            else
+            {
+                LogWarn( ( "Connection attempt failed: %s.",
+                           strerror( ( getOptStatus == 0 ) ? socketError : errno ) ) );
+                ( void ) close( pPendingSockets[ index ].fd );
+            }
+
+            /* Remove the completed attempt by moving the last entry into its place. */
+            ( *pNumPending )--;
+            pPendingSockets[ index ] = pPendingSockets[ *pNumPending ];
+        }
+        else
+        {
+            index++;
+        }
+    }
+
+    return tcpSocket;
+}
+/*-----------------------------------------------------------*/
+
+static DnsCacheEntry_t * findDnsCacheEntry( const ServerInfo_t * pServerInfo )
+{
+    DnsCacheEntry_t * pEntry = NULL;
+    size_t index = 0U;
+
+    assert( pServerInfo != NULL );
+
+    for( index = 0U; ( pEntry == NULL ) && ( index < SOCKETS_DNS_CACHE_SIZE ); index++ )
+    {
+        if( ( dnsCache[ index ].hostNameLength == pServerInfo->hostNameLength ) &&
+            ( dnsCache[ index ].port == pServerInfo->port ) &&
+            ( memcmp( dnsCache[ index ].hostName,
+                      pServerInfo->pHostName,
+                      pServerInfo->hostNameLength ) == 0 ) )
+        {
+            pEntry = &dnsCache[ index ];
+        }
+    }
+
+    return pEntry;
+}
+/*-----------------------------------------------------------*/
+
+static bool lookupDnsCache( const ServerInfo_t * pServerInfo,
+                            ResolvedAddressList_t * pAddressList )
+{
+    DnsCacheEntry_t * pEntry = NULL;
+    bool cacheHit = false;
+    uint64_t nowMs = getTimeMs();
+
+    assert( pServerInfo != NULL );
+    assert( pAddressList != NULL );
+
+    ( void ) pthread_mutex_lock( &dnsCacheMutex );
+
+    pEntry = findDnsCacheEntry( pServerInfo );
+
+    if( ( pEntry != NULL ) && ( nowMs >= pEntry->expiryTimeMs ) )
+    {
+        /* The entry is stale, so free it. */
+        pEntry->hostNameLength = 0U;
+        pEntry = NULL;
+    }
+
+    if( pEntry != NULL )
+    {
+        *pAddressList = pEntry->addressList;
+        dnsCacheStats.hits++;
+        cacheHit = true;
+    }
+    else
+    {
+        dnsCacheStats.misses++;
+    }
+
+    ( void ) pthread_mutex_unlock( &dnsCacheMutex );
+
+    return cacheHit;
+}
+/*-----------------------------------------------------------*/
+
+static void storeDnsCache( const ServerInfo_t * pServerInfo,
+                           const ResolvedAddressList_t * pAddressList )
+{
+    DnsCacheEntry_t * pEntry = NULL;
+    size_t index = 0U;
+    uint64_t nowMs = getTimeMs();
+
+    assert( pServerInfo != NULL );
+    assert( pAddressList != NULL );
+
+    ( void ) pthread_mutex_lock( &dnsCacheMutex );
+
+    pEntry = findDnsCacheEntry( pServerInfo );
+
+    /* Otherwise use a free entry, or replace the one closest to expiry. */
+    for( index = 0U; ( pEntry == NULL ) && ( index < SOCKETS_DNS_CACHE_SIZE ); index++ )
+    {
+        if( dnsCache[ index ].hostNameLength == 0U )
+        {
+            pEntry = &dnsCache[ index ];
+        }
+    }
+
+    if( pEntry == NULL )
+    {
+        pEntry = &dnsCache[ 0 ];
+
+        for( index = 1U; index < SOCKETS_DNS_CACHE_SIZE; index++ )
+        {
+            if( dnsCache[ index ].expiryTimeMs < pEntry->expiryTimeMs )
+            {
+                pEntry = &dnsCache[ index ];
+            }
+        }
+    }
+
+    ( void ) memcpy( pEntry->hostName, pServerInfo->pHostName, pServerInfo->hostNameLength );
+    pEntry->hostNameLength = pServerInfo->hostNameLength;
+    pEntry->port = pServerInfo->port;
+    pEntry->expiryTimeMs = nowMs + SOCKETS_DNS_CACHE_TTL_MS;
+    pEntry->addressList = *pAddressList;
+
+    ( void ) pthread_mutex_unlock( &dnsCacheMutex );
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t getTimeMs( void )
+{
+    /* Unlike Clock_GetTimeMs, the 64-bit clock does not wrap around, so
+     * deadlines can be compared directly. */
+    return Clock_GetTimeNs64() / ( uint64_t ) ONE_MS_TO_NS;
+}
+/*-----------------------------------------------------------*/
+
+static SocketStatus_t attemptConnection( ResolvedAddressList_t * pAddressList,
                                          const char * pHostName,
                                          size_t hostNameLength,
                                          uint16_t port,
+                                         const SocketsOptions_t * pSocketsOptions,
                                          int32_t * pTcpSocket )
 {
     SocketStatus_t returnStatus = SOCKETS_CONNECT_FAILURE;
-    const struct addrinfo * pIndex = NULL;
+    struct pollfd pendingSockets[ SOCKETS_MAX_CONNECT_ATTEMPTS ];
+    ResolvedAddress_t * pIndex = NULL;
+    struct sockaddr * pAddress = NULL;
+    size_t numCandidates = 0U, nextCandidate = 0U, numPending = 0U;
+    int32_t tcpSocket = -1, newSocket = -1, pollStatus = 0, socketFlags = -1;
+    uint64_t nowMs = 0U, deadlineMs = 0U, waitTimeMs = 0U;
+    bool startNextAttempt = true;
+    SocketsOptions_t racedOptions;
+    const SocketsOptions_t * pAttemptOptions = pSocketsOptions;
 
-    assert( pListHead != NULL );
+    assert( pAddressList != NULL );
     assert( pHostName != NULL );
     assert( hostNameLength > 0 );
     assert( pTcpSocket != NULL );
@@ -238,34 +817,148 @@ static SocketStatus_t attemptConnection( struct addrinfo * pListHead,
                 ( int32_t ) hostNameLength,
                 pHostName ) );
 
-    /* Attempt to connect to one of the retrieved DNS records. */
-    for( pIndex = pListHead; pIndex != NULL; pIndex = pIndex->ai_next )
+    numCandidates = pAddressList->numAddresses;
+
+    /* With TCP Fast Open, connect() returns at once and the SYN is deferred
+     * until the first write, so every raced attempt would look established
+     * straight away. Only use it when there is nothing to race. */
+    if( ( pSocketsOptions != NULL ) && ( pSocketsOptions->fastOpen != 0U ) &&
+        ( numCandidates > 1U ) )
     {
-        *pTcpSocket = socket( pIndex->ai_family,
-                              pIndex->ai_socktype,
-                              pIndex->ai_protocol );
+        LogDebug( ( "Not using TCP Fast Open: Host resolved to %lu addresses.",
+                    ( unsigned long ) numCandidates ) );
+        racedOptions = *pSocketsOptions;
+        racedOptions.fastOpen = 0U;
+        pAttemptOptions = &racedOptions;
+    }
+
+    nowMs = getTimeMs();
+    deadlineMs = nowMs + SOCKETS_CONNECT_TIMEOUT_MS;
 
-        if( *pTcpSocket == -1 )
+    /* Race connection attempts to the retrieved DNS records until one of them
+     * succeeds, all of them fail, or the connect deadline expires. */
+    while( ( tcpSocket == -1 ) && ( pollStatus >= 0 ) && ( nowMs < deadlineMs ) &&
+           ( ( nextCandidate < numCandidates ) || ( numPending > 0U ) ) )
+    {
+        if( ( nextCandidate < numCandidates ) &&
+            ( ( startNextAttempt == true ) || ( numPending == 0U ) ) )
         {
-            continue;
+            pIndex = &pAddressList->addresses[ nextCandidate ];
+            nextCandidate++;
+
+            newSocket = socket( pIndex->family,
+                                pIndex->socketType,
+                                pIndex->protocol );
+
+            /* MISRA Rule 11.3 flags the following line for casting a pointer of
+             * a object type to a pointer of a different object type. This rule
+             * is suppressed because casting from a struct sockaddr_storage
+             * pointer to a struct sockaddr pointer is supported in POSIX. */
+            /* coverity[misra_c_2012_rule_11_3_violation] */
+            pAddress = ( struct sockaddr * ) &pIndex->address;
+
+            /* Attempt to connect to a resolved DNS address of the host. */
+            if( ( newSocket != -1 ) &&
+                ( connectToAddress( pAddress, port, pAttemptOptions, newSocket ) == SOCKETS_SUCCESS ) )
+            {
+                pendingSockets[ numPending ].fd = newSocket;
+                pendingSockets[ numPending ].events = POLLOUT;
+                pendingSockets[ numPending ].revents = 0;
+                numPending++;
+
+                /* Give this attempt a head start before trying the next address. */
+                startNextAttempt = false;
+            }
+            else
+            {
+                /* Move on to the next address without waiting. */
+                startNextAttempt = true;
+            }
+        }
+        else
+        {
+            /* Wait for an attempt to complete, the attempt delay to elapse or
+             * the connect deadline to expire, whichever comes first. */
+            waitTimeMs = deadlineMs - nowMs;
+
+            if( ( nextCandidate < numCandidates ) &&
+                ( waitTimeMs > SOCKETS_CONNECT_ATTEMPT_DELAY_MS ) )
+            {
+                waitTimeMs = SOCKETS_CONNECT_ATTEMPT_DELAY_MS;
+            }
+
+            pollStatus = poll( pendingSockets, ( nfds_t ) numPending, ( int32_t ) waitTimeMs );
+
+            if( pollStatus > 0 )
+            {
+                tcpSocket = checkPendingConnections( pendingSockets, &numPending );
+
+                /* A failed attempt lets the next address be tried straight away. */
+                startNextAttempt = true;
+            }
+            else if( pollStatus == 0 )
+            {
+                /* The attempt delay elapsed. */
+                startNextAttempt = true;
+            }
+            else if( errno == EINTR )
+            {
+                pollStatus = 0;
+            }
+            else
+            {
+                LogError( ( "Waiting for connection attempts failed: %s.",
+                            strerror( errno ) ) );
+            }
         }
 
-        /* Attempt to connect to a resolved DNS address of the host. */
-        returnStatus = connectToAddress( pIndex->ai_addr, port, *pTcpSocket );
+        nowMs = getTimeMs();
+    }
+
+    /* Abandon the attempts that are still in progress. */
+    while( numPending > 0U )
+    {
+        numPending--;
+        ( void ) close( pendingSockets[ numPending ].fd );
+    }
+
+    if( tcpSocket != -1 )
+    {
+        /* Restore blocking mode as the send and receive timeouts rely on it. */
+        socketFlags = fcntl( tcpSocket, F_GETFL );
 
-        /* If connected to an IP address successfully, exit from the loop. */
-        if( returnStatus == SOCKETS_SUCCESS )
+        if( socketFlags != -1 )
         {
-            break;
+            socketFlags = fcntl( tcpSocket, F_SETFL, socketFlags & ~O_NONBLOCK );
+        }
+
+        if( socketFlags == -1 )
+        {
+            LogError( ( "Failed to restore socket to blocking mode." ) );
+            ( void ) close( tcpSocket );
+            tcpSocket = -1;
+        }
+        else
+        {
+            returnStatus = SOCKETS_SUCCESS;
         }
     }
 
+    *pTcpSocket = tcpSocket;
+
     if( returnStatus == SOCKETS_SUCCESS )
     {
         LogDebug( ( "Established TCP connection: Server=%.*s.\n",
                     ( int32_t ) hostNameLength,
                     pHostName ) );
     }
+    else if( nowMs >= deadlineMs )
+    {
+        LogError( ( "Timed out connecting to %.*s after %u ms.",
+                    ( int32_t ) hostNameLength,
+                    pHostName,
+                    ( unsigned int ) SOCKETS_CONNECT_TIMEOUT_MS ) );
+    }
     else
     {
         LogError( ( "Could not connect to any resolved IP address from %.*s.",
@@ -273,8 +966,6 @@ static SocketStatus_t attemptConnection( struct addrinfo * pListHead,
                     pHostName ) );
     }
 
-    freeaddrinfo( pListHead );
-
     return returnStatus;
 }
 /*-----------------------------------------------------------*/
@@ -306,11 +997,28 @@ SocketStatus_t Sockets_Connect( int32_t * pTcpSocket,
                                 const ServerInfo_t * pServerInfo,
                                 uint32_t sendTimeoutMs,
                                 uint32_t recvTimeoutMs )
+{
+    return Sockets_ConnectWithOptions( pTcpSocket,
+                                       pServerInfo,
+                                       sendTimeoutMs,
+                                       recvTimeoutMs,
+                                       NULL );
+}
+/*-----------------------------------------------------------*/
+
+SocketStatus_t Sockets_ConnectWithOptions( int32_t * pTcpSocket,
+                                           const ServerInfo_t * pServerInfo,
+                                           uint32_t sendTimeoutMs,
+                                           uint32_t recvTimeoutMs,
+                                           const SocketsOptions_t * pSocketsOptions )
 {
     SocketStatus_t returnStatus = SOCKETS_SUCCESS;
-    struct addrinfo * pListHead = NULL;
-    struct timeval transportTimeout;
-    int32_t setTimeoutStatus = -1;
+    ResolvedAddressList_t addressList;
+    bool useDnsCache = false;
+    uint64_t startTimeUs = Clock_GetTimeUs64();
+
+    /* Unused when logs are disabled. */
+    ( void ) startTimeUs;
 
     if( pServerInfo == NULL )
     {
@@ -339,18 +1047,71 @@ SocketStatus_t Sockets_Connect( int32_t * pTcpSocket,
 
     if( returnStatus == SOCKETS_SUCCESS )
     {
-        returnStatus = resolveHostName( pServerInfo->pHostName,
-                                        pServerInfo->hostNameLength,
-                                        &pListHead );
+        useDnsCache = ( ( SOCKETS_DNS_CACHE_TTL_MS > 0U ) &&
+                        ( pServerInfo->hostNameLength <= DNS_CACHE_MAX_HOSTNAME_LENGTH ) );
+
+        if( ( useDnsCache == false ) ||
+            ( lookupDnsCache( pServerInfo, &addressList ) == false ) )
+        {
+            returnStatus = resolveHostName( pServerInfo->pHostName,
+                                            pServerInfo->hostNameLength,
+                                            &addressList );
+
+            if( ( returnStatus == SOCKETS_SUCCESS ) && ( useDnsCache == true ) )
+            {
+                storeDnsCache( pServerInfo, &addressList );
+            }
+        }
     }
 
     if( returnStatus == SOCKETS_SUCCESS )
     {
-        returnStatus = attemptConnection( pListHead,
+        returnStatus = attemptConnection( &addressList,
                                           pServerInfo->pHostName,
                                           pServerInfo->hostNameLength,
                                           pServerInfo->port,
+                                          pSocketsOptions,
                                           pTcpSocket );
+
+        /* The cached addresses may be stale, so resolve the host name again
+         * on the next connection. */
+        if( ( returnStatus != SOCKETS_SUCCESS ) && ( useDnsCache == true ) )
+        {
+            Sockets_InvalidateDnsCache( pServerInfo );
+        }
+    }
+
+    /* Set the send and receive timeouts. */
+    if( returnStatus == SOCKETS_SUCCESS )
+    {
+        returnStatus = Sockets_SetTimeouts( *pTcpSocket, sendTimeoutMs, recvTimeoutMs );
+    }
+
+    if( returnStatus == SOCKETS_SUCCESS )
+    {
+        LogDebug( ( "Connected to %.*s:%u in %lu us.",
+                    ( int32_t ) pServerInfo->hostNameLength,
+                    pServerInfo->pHostName,
+                    ( unsigned int ) pServerInfo->port,
+                    ( unsigned long ) ( Clock_GetTimeUs64() - startTimeUs ) ) );
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
+
+SocketStatus_t Sockets_SetTimeouts( int32_t tcpSocket,
+                                    uint32_t sendTimeoutMs,
+                                    uint32_t recvTimeoutMs )
+{
+    SocketStatus_t returnStatus = SOCKETS_SUCCESS;
+    struct timeval transportTimeout;
+    int32_t setTimeoutStatus = -1;
+
+    if( tcpSocket < 0 )
+    {
+        LogError( ( "Parameter check failed: tcpSocket was negative." ) );
+        returnStatus = SOCKETS_INVALID_PARAMETER;
     }
 
     /* Set the send timeout. */
@@ -359,7 +1120,7 @@ SocketStatus_t Sockets_Connect( int32_t * pTcpSocket,
         transportTimeout.tv_sec = ( ( ( int64_t ) sendTimeoutMs ) / ONE_SEC_TO_MS );
         transportTimeout.tv_usec = ( ONE_MS_TO_US * ( ( ( int64_t ) sendTimeoutMs ) % ONE_SEC_TO_MS ) );
 
-        setTimeoutStatus = setsockopt( *pTcpSocket,
+        setTimeoutStatus = setsockopt( tcpSocket,
                                        SOL_SOCKET,
                                        SO_SNDTIMEO,
                                        &transportTimeout,
@@ -378,7 +1139,7 @@ SocketStatus_t Sockets_Connect( int32_t * pTcpSocket,
         transportTimeout.tv_sec = ( ( ( int64_t ) recvTimeoutMs ) / ONE_SEC_TO_MS );
         transportTimeout.tv_usec = ( ONE_MS_TO_US * ( ( ( int64_t ) recvTimeoutMs ) % ONE_SEC_TO_MS ) );
 
-        setTimeoutStatus = setsockopt( *pTcpSocket,
+        setTimeoutStatus = setsockopt( tcpSocket,
                                        SOL_SOCKET,
                                        SO_RCVTIMEO,
                                        &transportTimeout,
@@ -413,3 +1174,55 @@ SocketStatus_t Sockets_Disconnect( int32_t tcpSocket )
     return returnStatus;
 }
 /*-----------------------------------------------------------*/
+
+void Sockets_InvalidateDnsCache( const ServerInfo_t * pServerInfo )
+{
+    DnsCacheEntry_t * pEntry = NULL;
+    size_t index = 0U;
+
+    ( void ) pthread_mutex_lock( &dnsCacheMutex );
+
+    if( pServerInfo == NULL )
+    {
+        for( index = 0U; index < SOCKETS_DNS_CACHE_SIZE; index++ )
+        {
+            dnsCache[ index ].hostNameLength = 0U;
+        }
+    }
+    else if( pServerInfo->pHostName != NULL )
+    {
+        pEntry = findDnsCacheEntry( pServerInfo );
+
+        if( pEntry != NULL )
+        {
+            pEntry->hostNameLength = 0U;
+        }
+    }
+    else
+    {
+        /* Empty else. */
+    }
+
+    ( void ) pthread_mutex_unlock( &dnsCacheMutex );
+}
+/*-----------------------------------------------------------*/
+
+SocketStatus_t Sockets_GetDnsCacheStats( SocketsDnsCacheStats_t * pStats )
+{
+    SocketStatus_t returnStatus = SOCKETS_SUCCESS;
+
+    if( pStats == NULL )
+    {
+        LogError( ( "Parameter check failed: pStats is NULL." ) );
+        returnStatus = SOCKETS_INVALID_PARAMETER;
+    }
+    else
+    {
+        ( void ) pthread_mutex_lock( &dnsCacheMutex );
+        *pStats = dnsCacheStats;
+        ( void ) pthread_mutex_unlock( &dnsCacheMutex );
+    }
+
+    return returnStatus;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,293 @@
+/*
+ * AWS IoT Device SDK for Embedded C 202103.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Standard includes. */
+#include <assert.h>
+
+#include "transport_stats_posix.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Increment a counter that other threads may read.
+ *
+ * Relaxed ordering suffices as the counters do not guard other data.
+ */
+#define STATS_ADD( pCounter, value )    ( ( void ) __atomic_fetch_add( ( pCounter ), ( value ), __ATOMIC_RELAXED ) )
+
+/**
+ * @brief Read a counter that other threads may update.
+ */
+#define STATS_LOAD( pCounter )          __atomic_load_n( ( pCounter ), __ATOMIC_RELAXED )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Copy a histogram counter by counter.
+ *
+ * @param[in] pHistogram The histogram to copy.
+ * @param[out] pSnapshot The copy.
+ */
+static void snapshotHistogram( const TransportHistogram_t * pHistogram,
+                               TransportHistogram_t * pSnapshot );
+
+/**
+ * @brief Get the bucket of a histogram in which a latency is recorded.
+ *
+ * @param[in] latencyUs The latency in microseconds.
+ *
+ * @return Index of the bucket.
+ */
+static size_t getBucketIndex( uint32_t latencyUs );
+
+/*-----------------------------------------------------------*/
+
+static void snapshotHistogram( const TransportHistogram_t * pHistogram,
+                               TransportHistogram_t * pSnapshot )
+{
+    size_t i = 0;
+
+    for( i = 0; i < TRANSPORT_STATS_HISTOGRAM_BUCKETS; i++ )
+    {
+        pSnapshot->counts[ i ] = STATS_LOAD( &pHistogram->counts[ i ] );
+    }
+
+    pSnapshot->sumUs = STATS_LOAD( &pHistogram->sumUs );
+}
+/*-----------------------------------------------------------*/
+
+static size_t getBucketIndex( uint32_t latencyUs )
+{
+    size_t index = 0;
+    uint32_t msb = 0;
+
+    if( latencyUs < TRANSPORT_STATS_SUB_BUCKETS )
+    {
+        index = ( size_t ) latencyUs;
+    }
+    else
+    {
+        /* The position of the most significant bit selects the power of two,
+         * and the bits that follow it the bucket within that power. */
+        msb = 31U - ( uint32_t ) __builtin_clz( latencyUs );
+        index = ( ( size_t ) ( msb - TRANSPORT_STATS_SUB_BUCKET_BITS + 1U ) << TRANSPORT_STATS_SUB_BUCKET_BITS ) +
+                ( size_t ) ( ( latencyUs >> ( msb - TRANSPORT_STATS_SUB_BUCKET_BITS ) ) & ( TRANSPORT_STATS_SUB_BUCKETS - 1U ) );
+    }
+
+    return index;
+}
+/*-----------------------------------------------------------*/
+
+void TransportStats_RecordLatency( TransportHistogram_t * pHistogram,
+                                   uint64_t latencyUs )
+{
+    uint32_t clampedUs = UINT32_MAX;
+
+    assert( pHistogram != NULL );
+
+    if( latencyUs < ( uint64_t ) UINT32_MAX )
+    {
+        clampedUs = ( uint32_t ) latencyUs;
+    }
+
+    STATS_ADD( &pHistogram->counts[ getBucketIndex( clampedUs ) ], 1U );
+    STATS_ADD( &pHistogram->sumUs, latencyUs );
+}
+/*-----------------------------------------------------------*/
+
+void TransportStats_RecordTransfer( TransportStats_t * pStats,
+                                    uint8_t isSend,
+                                    size_t bytesRequested,
+                                    int32_t result,
+                                    uint64_t latencyUs )
+{
+    assert( pStats != NULL );
+
+    if( isSend == 1U )
+    {
+        STATS_ADD( &pStats->sendCalls, 1U );
+        TransportStats_RecordLatency( &pStats->sendUs, latencyUs );
+    }
+    else
+    {
+        STATS_ADD( &pStats->recvCalls, 1U );
+        TransportStats_RecordLatency( &pStats->recvUs, latencyUs );
+    }
+
+    if( result < 0 )
+    {
+        STATS_ADD( &pStats->errors, 1U );
+    }
+    else if( result == 0 )
+    {
+        STATS_ADD( &pStats->timeouts, 1U );
+    }
+    else if( isSend == 1U )
+    {
+        STATS_ADD( &pStats->bytesSent, ( uint64_t ) result );
+
+        if( ( size_t ) result < bytesRequested )
+        {
+            STATS_ADD( &pStats->partialSends, 1U );
+        }
+    }
+    else
+    {
+        STATS_ADD( &pStats->bytesReceived, ( uint64_t ) result );
+
+        if( ( size_t ) result < bytesRequested )
+        {
+            STATS_ADD( &pStats->partialReads, 1U );
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+void TransportStats_RecordConnect( TransportStats_t * pStats,
+                                   uint8_t success,
+                                   uint64_t latencyUs )
+{
+    assert( pStats != NULL );
+
+    /* Only successful connects are timed, as failures mostly last as long
+     * as the timeout. */
+    if( success == 1U )
+    {
+        STATS_ADD( &pStats->connects, 1U );
+        TransportStats_RecordLatency( &pStats->connectUs, latencyUs );
+    }
+    else
+    {
+        STATS_ADD( &pStats->connectFailures, 1U );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void TransportStats_RecordHandshake( TransportStats_t * pStats,
+                                     uint8_t success,
+                                     uint64_t latencyUs )
+{
+    assert( pStats != NULL );
+
+    if( success == 1U )
+    {
+        TransportStats_RecordLatency( &pStats->handshakeUs, latencyUs );
+    }
+    else
+    {
+        STATS_ADD( &pStats->handshakeFailures, 1U );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void TransportStats_Snapshot( const TransportStats_t * pStats,
+                              TransportStats_t * pSnapshot )
+{
+    assert( pStats != NULL );
+    assert( pSnapshot != NULL );
+
+    pSnapshot->bytesSent = STATS_LOAD( &pStats->bytesSent );
+    pSnapshot->bytesReceived = STATS_LOAD( &pStats->bytesReceived );
+    pSnapshot->sendCalls = STATS_LOAD( &pStats->sendCalls );
+    pSnapshot->recvCalls = STATS_LOAD( &pStats->recvCalls );
+    pSnapshot->partialSends = STATS_LOAD( &pStats->partialSends );
+    pSnapshot->partialReads = STATS_LOAD( &pStats->partialReads );
+    pSnapshot->timeouts = STATS_LOAD( &pStats->timeouts );
+    pSnapshot->errors = STATS_LOAD( &pStats->errors );
+    pSnapshot->connects = STATS_LOAD( &pStats->connects );
+    pSnapshot->connectFailures = STATS_LOAD( &pStats->connectFailures );
+    pSnapshot->handshakeFailures = STATS_LOAD( &pStats->handshakeFailures );
+
+    snapshotHistogram( &pStats->connectUs, &pSnapshot->connectUs );
+    snapshotHistogram( &pStats->handshakeUs, &pSnapshot->handshakeUs );
+    snapshotHistogram( &pStats->sendUs, &pSnapshot->sendUs );
+    snapshotHistogram( &pStats->recvUs, &pSnapshot->recvUs );
+}
+/*-----------------------------------------------------------*/
+
+uint32_t TransportStats_GetBucketLowerBound( size_t bucket )
+{
+    uint32_t lowerBound = 0;
+    uint32_t msb = 0;
+
+    assert( bucket < TRANSPORT_STATS_HISTOGRAM_BUCKETS );
+
+    if( bucket < TRANSPORT_STATS_SUB_BUCKETS )
+    {
+        lowerBound = ( uint32_t ) bucket;
+    }
+    else
+    {
+        msb = ( uint32_t ) ( bucket >> TRANSPORT_STATS_SUB_BUCKET_BITS ) + TRANSPORT_STATS_SUB_BUCKET_BITS - 1U;
+        lowerBound = ( TRANSPORT_STATS_SUB_BUCKETS + ( ( uint32_t ) bucket & ( TRANSPORT_STATS_SUB_BUCKETS - 1U ) ) ) <<
+                     ( msb - TRANSPORT_STATS_SUB_BUCKET_BITS );
+    }
+
+    return lowerBound;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t TransportStats_GetPercentile( const TransportHistogram_t * pHistogram,
+                                       uint32_t percentile )
+{
+    uint64_t total = 0, target = 0, seen = 0;
+    uint32_t latencyUs = 0;
+    size_t i = 0;
+
+    assert( pHistogram != NULL );
+    assert( percentile <= 100U );
+
+    for( i = 0; i < TRANSPORT_STATS_HISTOGRAM_BUCKETS; i++ )
+    {
+        total += pHistogram->counts[ i ];
+    }
+
+    if( total > 0U )
+    {
+        /* Rank of the percentile, rounded up and at least the first latency. */
+        target = ( ( total * percentile ) + 99U ) / 100U;
+
+        if( target == 0U )
+        {
+            target = 1U;
+        }
+
+        for( i = 0; seen < target; i++ )
+        {
+            seen += pHistogram->counts[ i ];
+        }
+
+        /* Bucket i - 1 holds the percentile; its upper bound is just below
+         * the lower bound of the next bucket. */
+        if( i < TRANSPORT_STATS_HISTOGRAM_BUCKETS )
+        {
+            latencyUs = TransportStats_GetBucketLowerBound( i ) - 1U;
+        }
+        else
+        {
+            latencyUs = UINT32_MAX;
+        }
+    }
+
+    return latencyUs;
+}
+/*-----------------------------------------------------------*/
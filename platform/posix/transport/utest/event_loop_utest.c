@@ -0,0 +1,396 @@
+/*
+ * AWS IoT Device SDK for Embedded C 202103.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "/usr/include/errno.h"
+
+#include "unity.h"
+
+/* Include paths for public enums, structures, and macros. */
+#include "event_loop_posix.h"
+
+#include "mock_epoll_api.h"
+#include "mock_unistd_api.h"
+
+/* The descriptor returned for the epoll instance. */
+#define EPOLL_DESCRIPTOR     ( 3 )
+
+/* The socket descriptors of the connections. */
+#define SOCKET_DESCRIPTOR    ( 4 )
+
+/* The number of connections used by the tests. */
+#define NUM_CONNECTIONS      ( 2 )
+
+/* Each compilation unit must define the NetworkContext struct. */
+struct NetworkContext
+{
+    int32_t * pParams;
+};
+
+static EventLoop_t eventLoop = { 0 };
+static EventLoopConnection_t connections[ NUM_CONNECTIONS ];
+static NetworkContext_t networkContexts[ NUM_CONNECTIONS ];
+
+/* The events passed to #eventCallback for each connection. */
+static uint32_t callbackEvents[ NUM_CONNECTIONS ];
+
+/* The number of times #eventCallback was invoked for each connection. */
+static uint32_t callbackCount[ NUM_CONNECTIONS ];
+
+/* Whether #eventCallback removes the other connection. */
+static bool removeOtherConnection;
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp()
+{
+    eventLoop.epollDescriptor = EPOLL_DESCRIPTOR;
+    eventLoop.numConnections = 0U;
+    memset( connections, 0, sizeof( connections ) );
+    memset( callbackEvents, 0, sizeof( callbackEvents ) );
+    memset( callbackCount, 0, sizeof( callbackCount ) );
+    removeOtherConnection = false;
+}
+
+/* Called after each test method. */
+void tearDown()
+{
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Callback that records the events of each connection.
+ */
+static void eventCallback( NetworkContext_t * pNetworkContext,
+                           uint32_t events,
+                           void * pUserData )
+{
+    size_t index = ( size_t ) ( pNetworkContext - networkContexts );
+
+    TEST_ASSERT_EQUAL_PTR( &connections[ index ], pUserData );
+
+    callbackEvents[ index ] = events;
+    callbackCount[ index ]++;
+
+    if( removeOtherConnection == true )
+    {
+        epoll_ctl_ExpectAnyArgsAndReturn( 0 );
+        TEST_ASSERT_EQUAL( EVENT_LOOP_SUCCESS,
+                           EventLoop_Remove( &eventLoop,
+                                             &connections[ ( index + 1U ) % NUM_CONNECTIONS ] ) );
+    }
+}
+
+/**
+ * @brief Add every connection to #eventLoop.
+ */
+static void addConnections( void )
+{
+    size_t i;
+
+    for( i = 0; i < NUM_CONNECTIONS; i++ )
+    {
+        epoll_ctl_ExpectAndReturn( EPOLL_DESCRIPTOR,
+                                   EPOLL_CTL_ADD,
+                                   SOCKET_DESCRIPTOR + ( int ) i,
+                                   NULL,
+                                   0 );
+        epoll_ctl_IgnoreArg___event();
+
+        TEST_ASSERT_EQUAL( EVENT_LOOP_SUCCESS,
+                           EventLoop_Add( &eventLoop,
+                                          &connections[ i ],
+                                          &networkContexts[ i ],
+                                          SOCKET_DESCRIPTOR + ( int32_t ) i,
+                                          EVENT_LOOP_READABLE | EVENT_LOOP_WRITABLE,
+                                          eventCallback,
+                                          &connections[ i ] ) );
+    }
+}
+
+/**
+ * @brief Test that #EventLoop_Init creates an epoll instance.
+ */
+void test_EventLoop_Init( void )
+{
+    EventLoop_t newEventLoop;
+
+    TEST_ASSERT_EQUAL( EVENT_LOOP_INVALID_PARAMETER, EventLoop_Init( NULL ) );
+
+    epoll_create1_ExpectAndReturn( EPOLL_CLOEXEC, EPOLL_DESCRIPTOR );
+    TEST_ASSERT_EQUAL( EVENT_LOOP_SUCCESS, EventLoop_Init( &newEventLoop ) );
+    TEST_ASSERT_EQUAL( EPOLL_DESCRIPTOR, newEventLoop.epollDescriptor );
+    TEST_ASSERT_EQUAL( 0U, newEventLoop.numConnections );
+
+    /* Running out of descriptors is reported as insufficient memory. */
+    errno = EMFILE;
+    epoll_create1_ExpectAndReturn( EPOLL_CLOEXEC, -1 );
+    TEST_ASSERT_EQUAL( EVENT_LOOP_INSUFFICIENT_MEMORY, EventLoop_Init( &newEventLoop ) );
+
+    errno = EINVAL;
+    epoll_create1_ExpectAndReturn( EPOLL_CLOEXEC, -1 );
+    TEST_ASSERT_EQUAL( EVENT_LOOP_API_ERROR, EventLoop_Init( &newEventLoop ) );
+}
+
+/**
+ * @brief Test that #EventLoop_Add fails when invalid parameters are passed
+ * to the function.
+ */
+void test_EventLoop_Add_Invalid_Params( void )
+{
+    EventLoop_t uninitializedEventLoop = { -1, 0U };
+
+    TEST_ASSERT_EQUAL( EVENT_LOOP_INVALID_PARAMETER,
+                       EventLoop_Add( NULL, &connections[ 0 ], &networkContexts[ 0 ],
+                                      SOCKET_DESCRIPTOR, EVENT_LOOP_READABLE,
+                                      eventCallback, NULL ) );
+    TEST_ASSERT_EQUAL( EVENT_LOOP_INVALID_PARAMETER,
+                       EventLoop_Add( &uninitializedEventLoop, &connections[ 0 ], &networkContexts[ 0 ],
+                                      SOCKET_DESCRIPTOR, EVENT_LOOP_READABLE,
+                                      eventCallback, NULL ) );
+    TEST_ASSERT_EQUAL( EVENT_LOOP_INVALID_PARAMETER,
+                       EventLoop_Add( &eventLoop, NULL, &networkContexts[ 0 ],
+                                      SOCKET_DESCRIPTOR, EVENT_LOOP_READABLE,
+                                      eventCallback, NULL ) );
+    TEST_ASSERT_EQUAL( EVENT_LOOP_INVALID_PARAMETER,
+                       EventLoop_Add( &eventLoop, &connections[ 0 ], &networkContexts[ 0 ],
+                                      -1, EVENT_LOOP_READABLE,
+                                      eventCallback, NULL ) );
+    TEST_ASSERT_EQUAL( EVENT_LOOP_INVALID_PARAMETER,
+                       EventLoop_Add( &eventLoop, &connections[ 0 ], &networkContexts[ 0 ],
+                                      SOCKET_DESCRIPTOR, EVENT_LOOP_READABLE,
+                                      NULL, NULL ) );
+}
+
+/**
+ * @brief Test that #EventLoop_Add registers the connection with epoll and
+ * reports the errors of epoll_ctl.
+ */
+void test_EventLoop_Add( void )
+{
+    addConnections();
+    TEST_ASSERT_EQUAL( NUM_CONNECTIONS, eventLoop.numConnections );
+    TEST_ASSERT_EQUAL( SOCKET_DESCRIPTOR, connections[ 0 ].socketDescriptor );
+    TEST_ASSERT_EQUAL_PTR( &networkContexts[ 0 ], connections[ 0 ].pNetworkContext );
+
+    /* Adding a socket twice is an invalid parameter. */
+    errno = EEXIST;
+    epoll_ctl_ExpectAnyArgsAndReturn( -1 );
+    TEST_ASSERT_EQUAL( EVENT_LOOP_INVALID_PARAMETER,
+                       EventLoop_Add( &eventLoop, &connections[ 0 ], &networkContexts[ 0 ],
+                                      SOCKET_DESCRIPTOR, EVENT_LOOP_READABLE,
+                                      eventCallback, NULL ) );
+
+    errno = ENOSPC;
+    epoll_ctl_ExpectAnyArgsAndReturn( -1 );
+    TEST_ASSERT_EQUAL( EVENT_LOOP_INSUFFICIENT_MEMORY,
+                       EventLoop_Add( &eventLoop, &connections[ 0 ], &networkContexts[ 0 ],
+                                      SOCKET_DESCRIPTOR, EVENT_LOOP_READABLE,
+                                      eventCallback, NULL ) );
+    TEST_ASSERT_EQUAL( NUM_CONNECTIONS, eventLoop.numConnections );
+}
+
+/**
+ * @brief Test that #EventLoop_Modify changes the events of a connection.
+ */
+void test_EventLoop_Modify( void )
+{
+    TEST_ASSERT_EQUAL( EVENT_LOOP_INVALID_PARAMETER,
+                       EventLoop_Modify( NULL, &connections[ 0 ], EVENT_LOOP_READABLE ) );
+    TEST_ASSERT_EQUAL( EVENT_LOOP_INVALID_PARAMETER,
+                       EventLoop_Modify( &eventLoop, NULL, EVENT_LOOP_READABLE ) );
+
+    addConnections();
+
+    epoll_ctl_ExpectAndReturn( EPOLL_DESCRIPTOR, EPOLL_CTL_MOD, SOCKET_DESCRIPTOR, NULL, 0 );
+    epoll_ctl_IgnoreArg___event();
+    TEST_ASSERT_EQUAL( EVENT_LOOP_SUCCESS,
+                       EventLoop_Modify( &eventLoop, &connections[ 0 ], EVENT_LOOP_WRITABLE ) );
+
+    errno = ENOENT;
+    epoll_ctl_ExpectAnyArgsAndReturn( -1 );
+    TEST_ASSERT_EQUAL( EVENT_LOOP_INVALID_PARAMETER,
+                       EventLoop_Modify( &eventLoop, &connections[ 0 ], EVENT_LOOP_WRITABLE ) );
+}
+
+/**
+ * @brief Test that #EventLoop_Remove unregisters a connection.
+ */
+void test_EventLoop_Remove( void )
+{
+    TEST_ASSERT_EQUAL( EVENT_LOOP_INVALID_PARAMETER,
+                       EventLoop_Remove( NULL, &connections[ 0 ] ) );
+    TEST_ASSERT_EQUAL( EVENT_LOOP_INVALID_PARAMETER,
+                       EventLoop_Remove( &eventLoop, NULL ) );
+
+    addConnections();
+
+    errno = EIO;
+    epoll_ctl_ExpectAnyArgsAndReturn( -1 );
+    TEST_ASSERT_EQUAL( EVENT_LOOP_API_ERROR,
+                       EventLoop_Remove( &eventLoop, &connections[ 0 ] ) );
+    TEST_ASSERT_EQUAL( NUM_CONNECTIONS, eventLoop.numConnections );
+
+    epoll_ctl_ExpectAndReturn( EPOLL_DESCRIPTOR, EPOLL_CTL_DEL, SOCKET_DESCRIPTOR, NULL, 0 );
+    epoll_ctl_IgnoreArg___event();
+    TEST_ASSERT_EQUAL( EVENT_LOOP_SUCCESS,
+                       EventLoop_Remove( &eventLoop, &connections[ 0 ] ) );
+    TEST_ASSERT_EQUAL( NUM_CONNECTIONS - 1, eventLoop.numConnections );
+    TEST_ASSERT_NULL( connections[ 0 ].callback );
+}
+
+/**
+ * @brief Test that #EventLoop_Run invokes the callback of every ready
+ * connection with the events that occurred.
+ */
+void test_EventLoop_Run_Dispatches_Events( void )
+{
+    struct epoll_event readyEvents[ NUM_CONNECTIONS ];
+    size_t numDispatched = 0U;
+
+    addConnections();
+
+    memset( readyEvents, 0, sizeof( readyEvents ) );
+    readyEvents[ 0 ].events = EPOLLIN | EPOLLOUT;
+    readyEvents[ 0 ].data.ptr = &connections[ 0 ];
+    readyEvents[ 1 ].events = EPOLLIN | EPOLLRDHUP;
+    readyEvents[ 1 ].data.ptr = &connections[ 1 ];
+
+    epoll_wait_ExpectAndReturn( EPOLL_DESCRIPTOR, NULL, EVENT_LOOP_MAX_EVENTS, 100, NUM_CONNECTIONS );
+    epoll_wait_IgnoreArg___events();
+    epoll_wait_ReturnArrayThruPtr___events( readyEvents, NUM_CONNECTIONS );
+
+    TEST_ASSERT_EQUAL( EVENT_LOOP_SUCCESS, EventLoop_Run( &eventLoop, 100U, &numDispatched ) );
+    TEST_ASSERT_EQUAL( NUM_CONNECTIONS, numDispatched );
+    TEST_ASSERT_EQUAL( EVENT_LOOP_READABLE | EVENT_LOOP_WRITABLE, callbackEvents[ 0 ] );
+    TEST_ASSERT_EQUAL( EVENT_LOOP_READABLE | EVENT_LOOP_HANGUP, callbackEvents[ 1 ] );
+
+    /* Errors are reported as a hang-up and a wait without timeout uses -1. */
+    readyEvents[ 0 ].events = EPOLLERR;
+    epoll_wait_ExpectAndReturn( EPOLL_DESCRIPTOR, NULL, EVENT_LOOP_MAX_EVENTS, -1, 1 );
+    epoll_wait_IgnoreArg___events();
+    epoll_wait_ReturnArrayThruPtr___events( readyEvents, 1 );
+
+    TEST_ASSERT_EQUAL( EVENT_LOOP_SUCCESS,
+                       EventLoop_Run( &eventLoop, EVENT_LOOP_WAIT_FOREVER, NULL ) );
+    TEST_ASSERT_EQUAL( EVENT_LOOP_HANGUP, callbackEvents[ 0 ] );
+    TEST_ASSERT_EQUAL( 2U, callbackCount[ 0 ] );
+    TEST_ASSERT_EQUAL( 1U, callbackCount[ 1 ] );
+}
+
+/**
+ * @brief Test that #EventLoop_Run does not invoke the callback of a connection
+ * removed by an earlier callback of the same batch.
+ */
+void test_EventLoop_Run_Skips_Removed_Connection( void )
+{
+    struct epoll_event readyEvents[ NUM_CONNECTIONS ];
+    size_t numDispatched = 0U;
+
+    addConnections();
+
+    memset( readyEvents, 0, sizeof( readyEvents ) );
+    readyEvents[ 0 ].events = EPOLLIN;
+    readyEvents[ 0 ].data.ptr = &connections[ 0 ];
+    readyEvents[ 1 ].events = EPOLLIN;
+    readyEvents[ 1 ].data.ptr = &connections[ 1 ];
+
+    removeOtherConnection = true;
+    epoll_wait_ExpectAnyArgsAndReturn( NUM_CONNECTIONS );
+    epoll_wait_ReturnArrayThruPtr___events( readyEvents, NUM_CONNECTIONS );
+
+    TEST_ASSERT_EQUAL( EVENT_LOOP_SUCCESS, EventLoop_Run( &eventLoop, 0U, &numDispatched ) );
+    TEST_ASSERT_EQUAL( 1U, numDispatched );
+    TEST_ASSERT_EQUAL( 1U, callbackCount[ 0 ] );
+    TEST_ASSERT_EQUAL( 0U, callbackCount[ 1 ] );
+    TEST_ASSERT_EQUAL( NUM_CONNECTIONS - 1, eventLoop.numConnections );
+}
+
+/**
+ * @brief Test that #EventLoop_Run handles timeouts, signals and errors from
+ * epoll_wait.
+ */
+void test_EventLoop_Run_Wait_Results( void )
+{
+    size_t numDispatched = 1U;
+    EventLoop_t uninitializedEventLoop = { -1, 0U };
+
+    TEST_ASSERT_EQUAL( EVENT_LOOP_INVALID_PARAMETER, EventLoop_Run( NULL, 0U, &numDispatched ) );
+    TEST_ASSERT_EQUAL( 0U, numDispatched );
+    TEST_ASSERT_EQUAL( EVENT_LOOP_INVALID_PARAMETER,
+                       EventLoop_Run( &uninitializedEventLoop, 0U, NULL ) );
+
+    /* Timeout. */
+    epoll_wait_ExpectAnyArgsAndReturn( 0 );
+    TEST_ASSERT_EQUAL( EVENT_LOOP_SUCCESS, EventLoop_Run( &eventLoop, 0U, &numDispatched ) );
+    TEST_ASSERT_EQUAL( 0U, numDispatched );
+
+    /* Interrupted by a signal. */
+    errno = EINTR;
+    epoll_wait_ExpectAnyArgsAndReturn( -1 );
+    TEST_ASSERT_EQUAL( EVENT_LOOP_SUCCESS, EventLoop_Run( &eventLoop, 0U, &numDispatched ) );
+    TEST_ASSERT_EQUAL( 0U, numDispatched );
+
+    errno = EBADF;
+    epoll_wait_ExpectAnyArgsAndReturn( -1 );
+    TEST_ASSERT_EQUAL( EVENT_LOOP_INVALID_PARAMETER, EventLoop_Run( &eventLoop, 0U, &numDispatched ) );
+
+    errno = EFAULT;
+    epoll_wait_ExpectAnyArgsAndReturn( -1 );
+    TEST_ASSERT_EQUAL( EVENT_LOOP_API_ERROR, EventLoop_Run( &eventLoop, 0U, &numDispatched ) );
+
+    /* Timeouts that do not fit the epoll_wait argument are clamped. */
+    epoll_wait_ExpectAndReturn( EPOLL_DESCRIPTOR, NULL, EVENT_LOOP_MAX_EVENTS, INT32_MAX, 0 );
+    epoll_wait_IgnoreArg___events();
+    TEST_ASSERT_EQUAL( EVENT_LOOP_SUCCESS,
+                       EventLoop_Run( &eventLoop, EVENT_LOOP_WAIT_FOREVER - 1U, NULL ) );
+}
+
+/**
+ * @brief Test that #EventLoop_Deinit closes the epoll instance.
+ */
+void test_EventLoop_Deinit( void )
+{
+    TEST_ASSERT_EQUAL( EVENT_LOOP_INVALID_PARAMETER, EventLoop_Deinit( NULL ) );
+
+    close_ExpectAndReturn( EPOLL_DESCRIPTOR, 0 );
+    TEST_ASSERT_EQUAL( EVENT_LOOP_SUCCESS, EventLoop_Deinit( &eventLoop ) );
+    TEST_ASSERT_EQUAL( -1, eventLoop.epollDescriptor );
+
+    /* The event loop can no longer be used. */
+    TEST_ASSERT_EQUAL( EVENT_LOOP_INVALID_PARAMETER, EventLoop_Deinit( &eventLoop ) );
+}
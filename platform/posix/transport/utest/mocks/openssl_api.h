@@ -59,6 +59,16 @@ struct ssl_method_st
     int filler;
 };
 
+struct bio_st
+{
+    int filler;
+};
+
+struct ssl_session_st
+{
+    int filler;
+};
+
 /* The functions prototypes below are used by CMock to generate mocks
  * for any OpenSSL API calls used by the OpenSSL transport wrapper.
  *
@@ -89,6 +99,9 @@ extern int SSL_set_alpn_protos( SSL * ssl,
 extern void SSL_set_default_read_buffer_len( SSL * s,
                                              size_t len );
 
+extern void SSL_set_read_ahead( SSL * s,
+                                int yes );
+
 extern SSL_CTX * SSL_CTX_new( const SSL_METHOD * meth );
 
 extern const SSL_METHOD * TLS_client_method( void );
@@ -119,7 +132,8 @@ extern void SSL_CTX_free( SSL_CTX * );
 extern void SSL_free( SSL * ssl );
 
 /* Macro wrappers:
- * SSL_CTX_set_mode */
+ * SSL_CTX_set_mode
+ * SSL_CTX_set_session_cache_mode */
 extern long SSL_CTX_ctrl( SSL_CTX * ctx,
                           int cmd,
                           long larg,
@@ -127,7 +141,8 @@ extern long SSL_CTX_ctrl( SSL_CTX * ctx,
 
 /* Macro wrappers:
  * SSL_set_tlsext_host_name
- * SSL_set_max_send_fragment */
+ * SSL_set_max_send_fragment
+ * SSL_set_mode */
 extern long SSL_ctrl( SSL * ssl,
                       int cmd,
                       long larg,
@@ -139,6 +154,8 @@ extern int SSL_read( SSL * ssl,
                      void * buf,
                      int num );
 
+extern int SSL_has_pending( const SSL * s );
+
 extern int SSL_get_error( const SSL * s,
                           int ret_code );
 
@@ -150,4 +167,51 @@ const char * ERR_reason_error_string( unsigned long e );
 
 void X509_free( X509 * a );
 
+/* CMock cannot parse function pointer parameters, so the type of the new
+ * session callback is given a name. */
+typedef int ( * NewSessionCallback_t )( SSL *,
+                                        SSL_SESSION * );
+
+extern void SSL_CTX_sess_set_new_cb( SSL_CTX * ctx,
+                                     NewSessionCallback_t new_session_cb );
+
+extern int SSL_set_session( SSL * to,
+                            SSL_SESSION * session );
+
+extern int SSL_session_reused( const SSL * s );
+
+extern void SSL_SESSION_free( SSL_SESSION * ses );
+
+/* Macro wrappers:
+ * SSL_set_app_data */
+extern int SSL_set_ex_data( SSL * ssl,
+                            int idx,
+                            void * data );
+
+/* Macro wrappers:
+ * SSL_get_app_data */
+extern void * SSL_get_ex_data( const SSL * ssl,
+                               int idx );
+
+extern uint64_t SSL_set_options( SSL * s,
+                                 uint64_t op );
+
+extern BIO * SSL_get_rbio( const SSL * s );
+
+extern BIO * SSL_get_wbio( const SSL * s );
+
+/* Macro wrappers:
+ * BIO_get_ktls_send
+ * BIO_get_ktls_recv */
+extern long BIO_ctrl( BIO * bp,
+                      int cmd,
+                      long larg,
+                      void * parg );
+
+extern ossl_ssize_t SSL_sendfile( SSL * s,
+                                  int fd,
+                                  off_t offset,
+                                  size_t size,
+                                  int flags );
+
 #endif /* ifndef OPENSSL_API_H_ */
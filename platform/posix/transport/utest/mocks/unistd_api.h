@@ -46,4 +46,15 @@ extern int close( int __fd );
 extern char * getcwd( char * __buf,
                       size_t __size );
 
+/* Read NBYTES into BUF from FD at the given position OFFSET without
+ * changing the file pointer.  Return the number read, -1 for errors
+ * or 0 for EOF.
+ *
+ * This function is a cancellation point and therefore not marked with
+ * __THROW.  */
+extern ssize_t pread( int __fd,
+                      void * __buf,
+                      size_t __nbytes,
+                      __off_t __offset );
+
 #endif /* ifndef UNISTD_API_H_ */
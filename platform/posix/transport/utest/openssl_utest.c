@@ -34,6 +34,7 @@
 #include "mock_openssl_api.h"
 #include "mock_sockets_posix.h"
 #include "mock_stdio_api.h"
+#include "mock_fcntl_api.h"
 
 /* The send and receive timeout to set for the socket. */
 #define SEND_RECV_TIMEOUT       0
@@ -79,6 +80,45 @@ static SSL_CTX sslCtx;
 static FILE rootCaFile;
 static X509 rootCa;
 static X509_STORE CaStore;
+static SSL_SESSION sslSession;
+static SSL_SESSION newSslSession;
+
+/* Storage for the TLS session to resume. */
+static SSL_SESSION * pStoredSession = NULL;
+
+/* Value returned by the mocked #SSL_session_reused. */
+static int sslSessionReused = 0;
+
+/* New session callback registered by the OpenSSL transport. */
+static NewSessionCallback_t newSessionCallback = NULL;
+
+/* A buffer of the size above which #Openssl_Writev does not coalesce. */
+static uint8_t largeBuffer[ OPENSSL_WRITEV_BUFFER_SIZE ];
+
+/* Lengths and contents of the buffers passed to #sslWriteStub. */
+static int sslWriteLengths[ 4 ];
+static uint8_t sslWriteData[ BUFFER_LEN * 2 ];
+static int sslWriteCount = 0;
+
+/* The call to #sslWriteStub that fails, or -1 if none does. */
+static int sslWriteFailingCall = -1;
+
+/* Read-ahead buffer of the connection and the decrypted bytes returned by
+ * #sslReadStub. */
+static uint8_t readAheadBuffer[ 16 ];
+static const uint8_t decryptedData[ 10 ] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+/* The BIO of the connection and whether #BIO_ctrl reports kTLS send offload
+ * on it. */
+static BIO bio;
+static long ktlsSendEngaged = 0;
+
+/* The return value of #fcntl when switching to non-blocking mode. */
+static int fcntlReturnValue = 0;
+
+/* File descriptor and offset passed to #Openssl_SendFile. */
+#define FILE_DESCRIPTOR         3
+#define FILE_OFFSET             100
 
 /**
  * @brief OpenSSL Connect / Disconnect return status.
@@ -102,6 +142,54 @@ typedef enum FunctionNames
     SSL_get_verify_result_fn
 } FunctionNames_t;
 
+/**
+ * @brief Stub for #SSL_write that records what is written and fails on
+ * #sslWriteFailingCall.
+ */
+static int sslWriteStub( SSL * pSsl,
+                         const void * pBuf,
+                         int num,
+                         int numCalls )
+{
+    int returnStatus = num;
+
+    TEST_ASSERT_EQUAL_PTR( &ssl, pSsl );
+    TEST_ASSERT_TRUE( sslWriteCount < ( int ) ( sizeof( sslWriteLengths ) / sizeof( int ) ) );
+
+    sslWriteLengths[ sslWriteCount ] = num;
+    sslWriteCount++;
+
+    if( num <= ( int ) sizeof( sslWriteData ) )
+    {
+        memcpy( sslWriteData, pBuf, ( size_t ) num );
+    }
+
+    if( numCalls == sslWriteFailingCall )
+    {
+        returnStatus = SSL_READ_WRITE_ERROR;
+    }
+
+    return returnStatus;
+}
+
+/**
+ * @brief Stub for #SSL_read that returns #decryptedData.
+ */
+static int sslReadStub( SSL * pSsl,
+                        void * pBuf,
+                        int num,
+                        int numCalls )
+{
+    ( void ) numCalls;
+
+    TEST_ASSERT_EQUAL_PTR( &ssl, pSsl );
+    TEST_ASSERT_TRUE( num >= ( int ) sizeof( decryptedData ) );
+
+    memcpy( pBuf, decryptedData, sizeof( decryptedData ) );
+
+    return ( int ) sizeof( decryptedData );
+}
+
 /* ============================   UNITY FIXTURES ============================ */
 
 /* Called before each test method. */
@@ -121,6 +209,17 @@ void setUp()
     opensslCredentials.alpnProtosLen = strlen( ALPN_PROTOS );
     opensslCredentials.maxFragmentLength = MFLN;
     opensslCredentials.sniHostName = HOSTNAME;
+
+    pStoredSession = NULL;
+    sslSessionReused = 0;
+    newSessionCallback = NULL;
+
+    sslWriteCount = 0;
+    sslWriteFailingCall = -1;
+    ktlsSendEngaged = 0;
+    fcntlReturnValue = 0;
+
+    memset( &opensslParams, 0, sizeof( OpensslParams_t ) );
 }
 
 /* Called after each test method. */
@@ -207,12 +306,12 @@ static OpensslStatus_t failFunctionFrom_Openssl_Connect( FunctionNames_t functio
     {
         TEST_ASSERT_NOT_NULL( retValue );
         socketStatus = *( ( SocketStatus_t * ) retValue );
-        Sockets_Connect_ExpectAnyArgsAndReturn( socketStatus );
+        Sockets_ConnectWithOptions_ExpectAnyArgsAndReturn( socketStatus );
         returnStatus = convertToOpensslStatus( socketStatus );
     }
     else if( returnStatus == OPENSSL_SUCCESS )
     {
-        Sockets_Connect_ExpectAnyArgsAndReturn( SOCKETS_SUCCESS );
+        Sockets_ConnectWithOptions_ExpectAnyArgsAndReturn( SOCKETS_SUCCESS );
     }
 
     /* Calls like this can't fail no matter what you return. */
@@ -232,11 +331,14 @@ static OpensslStatus_t failFunctionFrom_Openssl_Connect( FunctionNames_t functio
         sslCtxCreated = true;
     }
 
-    /* SSL_CTX_set_mode is actually what the API uses, but CMock expects the
-     * actual method rather than the macro wrapper. */
+    /* SSL_CTX_set_mode and SSL_CTX_set_session_cache_mode are actually what
+     * the API uses, but CMock expects the actual method rather than the macro
+     * wrapper. */
     if( returnStatus == OPENSSL_SUCCESS )
     {
         SSL_CTX_ctrl_ExpectAnyArgsAndReturn( 1 );
+        SSL_CTX_ctrl_ExpectAnyArgsAndReturn( 1 );
+        SSL_CTX_sess_set_new_cb_ExpectAnyArgs();
     }
 
     /* Path to Root CA must be set for handshake to succeed. */
@@ -396,6 +498,30 @@ static OpensslStatus_t failFunctionFrom_Openssl_Connect( FunctionNames_t functio
         }
     }
 
+    if( ( opensslCredentials.pReadAheadBuffer != NULL ) &&
+        ( opensslCredentials.readAheadBufferSize > 0U ) &&
+        ( returnStatus == OPENSSL_SUCCESS ) )
+    {
+        SSL_set_read_ahead_Expect( &ssl, 1 );
+    }
+
+    if( ( opensslCredentials.enableKtls != 0U ) &&
+        ( returnStatus == OPENSSL_SUCCESS ) )
+    {
+        SSL_set_options_ExpectAndReturn( &ssl, SSL_OP_ENABLE_KTLS, SSL_OP_ENABLE_KTLS );
+    }
+
+    if( ( opensslCredentials.ppSession != NULL ) &&
+        ( returnStatus == OPENSSL_SUCCESS ) )
+    {
+        SSL_set_ex_data_ExpectAnyArgsAndReturn( 1 );
+
+        if( *opensslCredentials.ppSession != NULL )
+        {
+            SSL_set_session_ExpectAndReturn( &ssl, *opensslCredentials.ppSession, 1 );
+        }
+    }
+
     if( opensslCredentials.sniHostName != NULL )
     {
         if( functionToFail == SSL_set_tlsext_host_name_fn )
@@ -428,6 +554,39 @@ static OpensslStatus_t failFunctionFrom_Openssl_Connect( FunctionNames_t functio
         SSL_get_verify_result_ExpectAnyArgsAndReturn( X509_V_OK );
     }
 
+    if( ( returnStatus == OPENSSL_SUCCESS ) &&
+        ( opensslCredentials.ppSession != NULL ) )
+    {
+        SSL_session_reused_ExpectAnyArgsAndReturn( sslSessionReused );
+    }
+
+    if( ( returnStatus == OPENSSL_SUCCESS ) &&
+        ( opensslCredentials.enableKtls != 0U ) )
+    {
+        SSL_get_wbio_ExpectAndReturn( &ssl, &bio );
+        BIO_ctrl_ExpectAndReturn( &bio, BIO_CTRL_GET_KTLS_SEND, 0, NULL, ktlsSendEngaged );
+        SSL_get_rbio_ExpectAndReturn( &ssl, &bio );
+        BIO_ctrl_ExpectAndReturn( &bio, BIO_CTRL_GET_KTLS_RECV, 0, NULL, 0 );
+    }
+
+    /* SSL_set_mode is a macro wrapper of SSL_ctrl. */
+    if( ( returnStatus == OPENSSL_SUCCESS ) &&
+        ( opensslCredentials.nonBlocking != 0U ) )
+    {
+        SSL_ctrl_ExpectAndReturn( &ssl, SSL_CTRL_MODE, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER,
+                                  NULL, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER );
+        fcntl_ExpectAnyArgsAndReturn( fcntlReturnValue );
+
+        if( fcntlReturnValue == -1 )
+        {
+            returnStatus = OPENSSL_API_ERROR;
+        }
+        else
+        {
+            fcntl_ExpectAnyArgsAndReturn( 0 );
+        }
+    }
+
     /* Expect objects to be freed depending upon whether they were created. */
     if( sslCtxCreated )
     {
@@ -682,6 +841,33 @@ void test_Openssl_Connect_Succeeds( void )
     TEST_ASSERT_EQUAL( OPENSSL_SUCCESS, returnStatus );
 }
 
+/**
+ * @brief Test that #Openssl_Connect enables read-ahead when a read-ahead
+ * buffer is given and starts the connection with an empty buffer.
+ */
+void test_Openssl_Connect_Read_Ahead( void )
+{
+    OpensslStatus_t returnStatus;
+
+    opensslCredentials.pReadAheadBuffer = readAheadBuffer;
+    opensslCredentials.readAheadBufferSize = sizeof( readAheadBuffer );
+    opensslParams.readAheadLength = 1U;
+    opensslParams.recvStats.recvCalls = 1U;
+
+    ( void ) failFunctionFrom_Openssl_Connect( SSL_get_verify_result_fn + 1,
+                                               NULL );
+    returnStatus = Openssl_Connect( &networkContext,
+                                    &serverInfo,
+                                    &opensslCredentials,
+                                    SEND_RECV_TIMEOUT,
+                                    SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( OPENSSL_SUCCESS, returnStatus );
+    TEST_ASSERT_EQUAL_PTR( readAheadBuffer, opensslParams.pReadAheadBuffer );
+    TEST_ASSERT_EQUAL( sizeof( readAheadBuffer ), opensslParams.readAheadBufferSize );
+    TEST_ASSERT_EQUAL( 0U, opensslParams.readAheadLength );
+    TEST_ASSERT_EQUAL( 0U, opensslParams.recvStats.recvCalls );
+}
+
 /**
  * @brief Test that #Openssl_Disconnect is able to return
  * #OPENSSL_INVALID_PARAMETER when #NetworkContext_t is NULL.
@@ -870,3 +1056,849 @@ void test_Openssl_Recv_Zero_Return_Value( void )
     bytesReceived = Openssl_Recv( &networkContext, opensslBuffer, BYTES_TO_RECV );
     TEST_ASSERT_EQUAL( 0, bytesReceived );
 }
+
+/**
+ * @brief Test that #Openssl_CreateContext is able to fail on NULL parameters.
+ */
+void test_Openssl_CreateContext_Invalid_Params( void )
+{
+    OpensslStatus_t returnStatus;
+    SSL_CTX * pSslContext = NULL;
+
+    returnStatus = Openssl_CreateContext( NULL, &opensslCredentials );
+    TEST_ASSERT_EQUAL( OPENSSL_INVALID_PARAMETER, returnStatus );
+
+    returnStatus = Openssl_CreateContext( &pSslContext, NULL );
+    TEST_ASSERT_EQUAL( OPENSSL_INVALID_PARAMETER, returnStatus );
+    TEST_ASSERT_NULL( pSslContext );
+}
+
+/**
+ * @brief Test that #Openssl_CreateContext returns an error and frees the
+ * partially configured SSL context when creating it or importing the
+ * credentials fails.
+ */
+void test_Openssl_CreateContext_Fails( void )
+{
+    OpensslStatus_t returnStatus;
+    SSL_CTX * pSslContext = &sslCtx;
+
+    /* Fail SSL_CTX_new. */
+    TLS_client_method_ExpectAndReturn( &sslMethod );
+    SSL_CTX_new_ExpectAnyArgsAndReturn( NULL );
+    returnStatus = Openssl_CreateContext( &pSslContext, &opensslCredentials );
+    TEST_ASSERT_EQUAL( OPENSSL_API_ERROR, returnStatus );
+    TEST_ASSERT_NULL( pSslContext );
+
+    /* Fail to open the root CA file. */
+    pSslContext = &sslCtx;
+    TLS_client_method_ExpectAndReturn( &sslMethod );
+    SSL_CTX_new_ExpectAnyArgsAndReturn( &sslCtx );
+    SSL_CTX_ctrl_ExpectAnyArgsAndReturn( 1 );
+    SSL_CTX_ctrl_ExpectAnyArgsAndReturn( 1 );
+    SSL_CTX_sess_set_new_cb_ExpectAnyArgs();
+    fopen_ExpectAnyArgsAndReturn( NULL );
+    SSL_CTX_free_ExpectAnyArgs();
+    returnStatus = Openssl_CreateContext( &pSslContext, &opensslCredentials );
+    TEST_ASSERT_EQUAL( OPENSSL_INVALID_CREDENTIALS, returnStatus );
+    TEST_ASSERT_NULL( pSslContext );
+}
+
+/**
+ * @brief Test the happy path case in which an SSL context is created with all
+ * credentials imported, and that it is released by #Openssl_FreeContext.
+ */
+void test_Openssl_CreateContext_Succeeds( void )
+{
+    OpensslStatus_t returnStatus;
+    SSL_CTX * pSslContext = NULL;
+
+    TLS_client_method_ExpectAndReturn( &sslMethod );
+    SSL_CTX_new_ExpectAnyArgsAndReturn( &sslCtx );
+    SSL_CTX_ctrl_ExpectAnyArgsAndReturn( 1 );
+    SSL_CTX_ctrl_ExpectAnyArgsAndReturn( 1 );
+    SSL_CTX_sess_set_new_cb_ExpectAnyArgs();
+    fopen_ExpectAnyArgsAndReturn( &rootCaFile );
+    PEM_read_X509_ExpectAnyArgsAndReturn( &rootCa );
+    SSL_CTX_get_cert_store_ExpectAnyArgsAndReturn( &CaStore );
+    X509_STORE_add_cert_ExpectAnyArgsAndReturn( 1 );
+    X509_free_ExpectAnyArgs();
+    fclose_ExpectAnyArgsAndReturn( 0 );
+    SSL_CTX_use_certificate_chain_file_ExpectAnyArgsAndReturn( 1 );
+    SSL_CTX_use_PrivateKey_file_ExpectAnyArgsAndReturn( 1 );
+    returnStatus = Openssl_CreateContext( &pSslContext, &opensslCredentials );
+    TEST_ASSERT_EQUAL( OPENSSL_SUCCESS, returnStatus );
+    TEST_ASSERT_EQUAL_PTR( &sslCtx, pSslContext );
+
+    SSL_CTX_free_Expect( &sslCtx );
+    Openssl_FreeContext( pSslContext );
+
+    /* Freeing a NULL context is a no-op. */
+    Openssl_FreeContext( NULL );
+}
+
+/**
+ * @brief Test that #Openssl_ConnectWithContext is able to fail on NULL
+ * parameters without touching the network.
+ */
+void test_Openssl_ConnectWithContext_Invalid_Params( void )
+{
+    OpensslStatus_t returnStatus;
+
+    returnStatus = Openssl_ConnectWithContext( NULL,
+                                               &serverInfo,
+                                               &sslCtx,
+                                               &opensslCredentials,
+                                               SEND_RECV_TIMEOUT,
+                                               SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( OPENSSL_INVALID_PARAMETER, returnStatus );
+
+    returnStatus = Openssl_ConnectWithContext( &networkContext,
+                                               &serverInfo,
+                                               NULL,
+                                               &opensslCredentials,
+                                               SEND_RECV_TIMEOUT,
+                                               SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( OPENSSL_INVALID_PARAMETER, returnStatus );
+
+    returnStatus = Openssl_ConnectWithContext( &networkContext,
+                                               &serverInfo,
+                                               &sslCtx,
+                                               NULL,
+                                               SEND_RECV_TIMEOUT,
+                                               SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( OPENSSL_INVALID_PARAMETER, returnStatus );
+}
+
+/**
+ * @brief Test that #Openssl_ConnectWithContext neither reads credentials nor
+ * frees the shared SSL context, and frees the SSL object when the handshake
+ * fails.
+ */
+void test_Openssl_ConnectWithContext_Handshake_Fails( void )
+{
+    OpensslStatus_t returnStatus;
+
+    /* Per-connection options are not needed for this test. */
+    memset( &opensslCredentials, 0, sizeof( OpensslCredentials_t ) );
+
+    /* Fail SSL_new. */
+    Sockets_ConnectWithOptions_ExpectAnyArgsAndReturn( SOCKETS_SUCCESS );
+    SSL_new_ExpectAnyArgsAndReturn( NULL );
+    returnStatus = Openssl_ConnectWithContext( &networkContext,
+                                               &serverInfo,
+                                               &sslCtx,
+                                               &opensslCredentials,
+                                               SEND_RECV_TIMEOUT,
+                                               SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( OPENSSL_API_ERROR, returnStatus );
+
+    /* Fail SSL_connect. */
+    Sockets_ConnectWithOptions_ExpectAnyArgsAndReturn( SOCKETS_SUCCESS );
+    SSL_new_ExpectAnyArgsAndReturn( &ssl );
+    SSL_set1_host_ExpectAnyArgsAndReturn( 1 );
+    SSL_set_verify_ExpectAnyArgs();
+    SSL_set_fd_ExpectAnyArgsAndReturn( 1 );
+    SSL_connect_ExpectAnyArgsAndReturn( -1 );
+    SSL_free_ExpectAnyArgs();
+    returnStatus = Openssl_ConnectWithContext( &networkContext,
+                                               &serverInfo,
+                                               &sslCtx,
+                                               &opensslCredentials,
+                                               SEND_RECV_TIMEOUT,
+                                               SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( OPENSSL_HANDSHAKE_FAILED, returnStatus );
+    TEST_ASSERT_NULL( opensslParams.pSsl );
+}
+
+/**
+ * @brief Test the happy path case in which a TLS connection is established
+ * from a shared SSL context.
+ */
+void test_Openssl_ConnectWithContext_Succeeds( void )
+{
+    OpensslStatus_t returnStatus;
+
+    memset( &opensslCredentials, 0, sizeof( OpensslCredentials_t ) );
+
+    Sockets_ConnectWithOptions_ExpectAnyArgsAndReturn( SOCKETS_SUCCESS );
+    SSL_new_ExpectAnyArgsAndReturn( &ssl );
+    SSL_set1_host_ExpectAnyArgsAndReturn( 1 );
+    SSL_set_verify_ExpectAnyArgs();
+    SSL_set_fd_ExpectAnyArgsAndReturn( 1 );
+    SSL_connect_ExpectAnyArgsAndReturn( 1 );
+    SSL_get_verify_result_ExpectAnyArgsAndReturn( X509_V_OK );
+    returnStatus = Openssl_ConnectWithContext( &networkContext,
+                                               &serverInfo,
+                                               &sslCtx,
+                                               &opensslCredentials,
+                                               SEND_RECV_TIMEOUT,
+                                               SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( OPENSSL_SUCCESS, returnStatus );
+    TEST_ASSERT_EQUAL_PTR( &ssl, opensslParams.pSsl );
+}
+
+/**
+ * @brief Test that #Openssl_Connect offers a stored TLS session to the server
+ * and reports whether it was resumed.
+ */
+void test_Openssl_Connect_Session_Resumption( void )
+{
+    OpensslStatus_t returnStatus;
+
+    opensslCredentials.ppSession = &pStoredSession;
+
+    /* First connection: no session is stored yet, so none is offered. */
+    opensslParams.sessionResumed = 1U;
+    sslSessionReused = 0;
+    ( void ) failFunctionFrom_Openssl_Connect( SSL_get_verify_result_fn + 1,
+                                               NULL );
+    returnStatus = Openssl_Connect( &networkContext,
+                                    &serverInfo,
+                                    &opensslCredentials,
+                                    SEND_RECV_TIMEOUT,
+                                    SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( OPENSSL_SUCCESS, returnStatus );
+    TEST_ASSERT_EQUAL( 0U, opensslParams.sessionResumed );
+
+    /* Reconnection: the stored session is offered and accepted. */
+    pStoredSession = &sslSession;
+    sslSessionReused = 1;
+    ( void ) failFunctionFrom_Openssl_Connect( SSL_get_verify_result_fn + 1,
+                                               NULL );
+    returnStatus = Openssl_Connect( &networkContext,
+                                    &serverInfo,
+                                    &opensslCredentials,
+                                    SEND_RECV_TIMEOUT,
+                                    SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( OPENSSL_SUCCESS, returnStatus );
+    TEST_ASSERT_EQUAL( 1U, opensslParams.sessionResumed );
+}
+
+/**
+ * @brief Used to capture the new session callback registered on the SSL
+ * context by the OpenSSL transport.
+ */
+static void captureNewSessionCallback( SSL_CTX * ctx,
+                                       NewSessionCallback_t new_session_cb,
+                                       int numCalls )
+{
+    ( void ) ctx;
+    ( void ) numCalls;
+
+    newSessionCallback = new_session_cb;
+}
+
+/**
+ * @brief Test that new sessions from the server are stored only when storage
+ * was provided, replacing and freeing the previously stored session.
+ */
+void test_Openssl_New_Session_Is_Stored( void )
+{
+    OpensslStatus_t returnStatus;
+    SSL_CTX * pSslContext = NULL;
+
+    SSL_CTX_sess_set_new_cb_Stub( captureNewSessionCallback );
+
+    TLS_client_method_ExpectAndReturn( &sslMethod );
+    SSL_CTX_new_ExpectAnyArgsAndReturn( &sslCtx );
+    SSL_CTX_ctrl_ExpectAnyArgsAndReturn( 1 );
+    SSL_CTX_ctrl_ExpectAnyArgsAndReturn( 1 );
+    fopen_ExpectAnyArgsAndReturn( &rootCaFile );
+    PEM_read_X509_ExpectAnyArgsAndReturn( &rootCa );
+    SSL_CTX_get_cert_store_ExpectAnyArgsAndReturn( &CaStore );
+    X509_STORE_add_cert_ExpectAnyArgsAndReturn( 1 );
+    X509_free_ExpectAnyArgs();
+    fclose_ExpectAnyArgsAndReturn( 0 );
+    SSL_CTX_use_certificate_chain_file_ExpectAnyArgsAndReturn( 1 );
+    SSL_CTX_use_PrivateKey_file_ExpectAnyArgsAndReturn( 1 );
+    returnStatus = Openssl_CreateContext( &pSslContext, &opensslCredentials );
+    TEST_ASSERT_EQUAL( OPENSSL_SUCCESS, returnStatus );
+    TEST_ASSERT_NOT_NULL( newSessionCallback );
+
+    /* No storage was set on the SSL object, so the session is not kept. */
+    SSL_get_ex_data_ExpectAnyArgsAndReturn( NULL );
+    TEST_ASSERT_EQUAL( 0, newSessionCallback( &ssl, &newSslSession ) );
+
+    /* The new session replaces the stored one. */
+    pStoredSession = &sslSession;
+    SSL_get_ex_data_ExpectAnyArgsAndReturn( &pStoredSession );
+    SSL_SESSION_free_Expect( &sslSession );
+    TEST_ASSERT_EQUAL( 1, newSessionCallback( &ssl, &newSslSession ) );
+    TEST_ASSERT_EQUAL_PTR( &newSslSession, pStoredSession );
+}
+
+/**
+ * @brief Test that #Openssl_Writev coalesces small buffers into one #SSL_write.
+ */
+void test_Openssl_Writev_Coalesces_Small_Buffers( void )
+{
+    int32_t bytesSent;
+    uint8_t header[ 2 ] = { 0x30, 0x02 };
+    uint8_t payload[ BUFFER_LEN ] = { 'a', 'b', 'c', 'd' };
+    uint8_t expected[ 2 + BUFFER_LEN ] = { 0x30, 0x02, 'a', 'b', 'c', 'd' };
+    struct iovec ioVec[ 3 ];
+
+    ioVec[ 0 ].iov_base = header;
+    ioVec[ 0 ].iov_len = sizeof( header );
+    ioVec[ 1 ].iov_base = NULL;
+    ioVec[ 1 ].iov_len = 0U;
+    ioVec[ 2 ].iov_base = payload;
+    ioVec[ 2 ].iov_len = sizeof( payload );
+
+    opensslParams.pSsl = &ssl;
+    SSL_write_Stub( sslWriteStub );
+    bytesSent = Openssl_Writev( &networkContext, ioVec, 3 );
+
+    TEST_ASSERT_EQUAL( sizeof( expected ), bytesSent );
+    TEST_ASSERT_EQUAL( 1, sslWriteCount );
+    TEST_ASSERT_EQUAL( sizeof( expected ), sslWriteLengths[ 0 ] );
+    TEST_ASSERT_EQUAL_UINT8_ARRAY( expected, sslWriteData, sizeof( expected ) );
+}
+
+/**
+ * @brief Test that #Openssl_Writev writes buffers of at least a full record
+ * directly, flushing any coalesced bytes first.
+ */
+void test_Openssl_Writev_Large_Buffer( void )
+{
+    int32_t bytesSent;
+    struct iovec ioVec[ 3 ];
+
+    ioVec[ 0 ].iov_base = opensslBuffer;
+    ioVec[ 0 ].iov_len = BUFFER_LEN;
+    ioVec[ 1 ].iov_base = largeBuffer;
+    ioVec[ 1 ].iov_len = sizeof( largeBuffer );
+    ioVec[ 2 ].iov_base = opensslBuffer;
+    ioVec[ 2 ].iov_len = BUFFER_LEN;
+
+    opensslParams.pSsl = &ssl;
+    SSL_write_Stub( sslWriteStub );
+    bytesSent = Openssl_Writev( &networkContext, ioVec, 3 );
+
+    TEST_ASSERT_EQUAL( ( 2 * BUFFER_LEN ) + sizeof( largeBuffer ), bytesSent );
+    TEST_ASSERT_EQUAL( 3, sslWriteCount );
+    TEST_ASSERT_EQUAL( BUFFER_LEN, sslWriteLengths[ 0 ] );
+    TEST_ASSERT_EQUAL( sizeof( largeBuffer ), sslWriteLengths[ 1 ] );
+    TEST_ASSERT_EQUAL( BUFFER_LEN, sslWriteLengths[ 2 ] );
+}
+
+/**
+ * @brief Test that #Openssl_Writev stops at the first failed #SSL_write and
+ * reports the bytes sent before it.
+ */
+void test_Openssl_Writev_Network_Error( void )
+{
+    int32_t bytesSent;
+    struct iovec ioVec[ 2 ];
+
+    ioVec[ 0 ].iov_base = largeBuffer;
+    ioVec[ 0 ].iov_len = sizeof( largeBuffer );
+    ioVec[ 1 ].iov_base = opensslBuffer;
+    ioVec[ 1 ].iov_len = BUFFER_LEN;
+
+    opensslParams.pSsl = &ssl;
+    SSL_write_Stub( sslWriteStub );
+
+    /* Nothing was sent before the failure. */
+    sslWriteFailingCall = 0;
+    SSL_get_error_ExpectAnyArgsAndReturn( SSL_ERROR_SSL );
+    bytesSent = Openssl_Writev( &networkContext, ioVec, 2 );
+    TEST_ASSERT_EQUAL( SSL_READ_WRITE_ERROR, bytesSent );
+    TEST_ASSERT_EQUAL( 1, sslWriteCount );
+
+    /* The first buffer was sent before the failure. */
+    sslWriteFailingCall = 2;
+    SSL_get_error_ExpectAnyArgsAndReturn( SSL_ERROR_SSL );
+    bytesSent = Openssl_Writev( &networkContext, ioVec, 2 );
+    TEST_ASSERT_EQUAL( sizeof( largeBuffer ), bytesSent );
+    TEST_ASSERT_EQUAL( 3, sslWriteCount );
+}
+
+/**
+ * @brief Test that #Openssl_Writev fails when invalid parameters are passed.
+ */
+void test_Openssl_Writev_Invalid_Params( void )
+{
+    int32_t bytesSent;
+    struct iovec ioVec;
+    NetworkContext_t networkContext = { 0 };
+
+    ioVec.iov_base = opensslBuffer;
+    ioVec.iov_len = BUFFER_LEN;
+
+    bytesSent = Openssl_Writev( NULL, &ioVec, 1 );
+    TEST_ASSERT_EQUAL( -1, bytesSent );
+
+    bytesSent = Openssl_Writev( &networkContext, &ioVec, 1 );
+    TEST_ASSERT_EQUAL( -1, bytesSent );
+
+    networkContext.pParams = &opensslParams;
+    opensslParams.pSsl = &ssl;
+    bytesSent = Openssl_Writev( &networkContext, NULL, 1 );
+    TEST_ASSERT_EQUAL( -1, bytesSent );
+
+    bytesSent = Openssl_Writev( &networkContext, &ioVec, 0 );
+    TEST_ASSERT_EQUAL( -1, bytesSent );
+
+    opensslParams.pSsl = NULL;
+    bytesSent = Openssl_Writev( &networkContext, &ioVec, 1 );
+    TEST_ASSERT_EQUAL( -1, bytesSent );
+}
+
+/**
+ * @brief Test that #Openssl_Recv serves small reads from the read-ahead
+ * buffer with a single #SSL_read and counts them.
+ */
+void test_Openssl_Recv_Read_Ahead( void )
+{
+    int32_t bytesReceived;
+    uint8_t buffer[ 8 ];
+    OpensslRecvStats_t stats;
+
+    opensslParams.pSsl = &ssl;
+    opensslParams.pReadAheadBuffer = readAheadBuffer;
+    opensslParams.readAheadBufferSize = sizeof( readAheadBuffer );
+
+    SSL_read_Stub( sslReadStub );
+
+    bytesReceived = Openssl_Recv( &networkContext, buffer, 2 );
+    TEST_ASSERT_EQUAL( 2, bytesReceived );
+    TEST_ASSERT_EQUAL_UINT8_ARRAY( decryptedData, buffer, 2 );
+
+    bytesReceived = Openssl_Recv( &networkContext, buffer, 5 );
+    TEST_ASSERT_EQUAL( 5, bytesReceived );
+    TEST_ASSERT_EQUAL_UINT8_ARRAY( &decryptedData[ 2 ], buffer, 5 );
+
+    /* Only the bytes left in the buffer are returned. */
+    bytesReceived = Openssl_Recv( &networkContext, buffer, sizeof( buffer ) );
+    TEST_ASSERT_EQUAL( 3, bytesReceived );
+    TEST_ASSERT_EQUAL_UINT8_ARRAY( &decryptedData[ 7 ], buffer, 3 );
+
+    TEST_ASSERT_EQUAL( OPENSSL_SUCCESS, Openssl_GetRecvStats( &networkContext, &stats ) );
+    TEST_ASSERT_EQUAL( 3, stats.recvCalls );
+    TEST_ASSERT_EQUAL( 1, stats.sslReadCalls );
+    TEST_ASSERT_EQUAL( sizeof( decryptedData ), stats.bytesReceived );
+}
+
+/**
+ * @brief Test that #Openssl_Recv reads requests at least as large as the
+ * read-ahead buffer directly, and forwards retryable and fatal errors.
+ */
+void test_Openssl_Recv_Read_Ahead_Direct_And_Errors( void )
+{
+    int32_t bytesReceived;
+    uint8_t buffer[ sizeof( readAheadBuffer ) ];
+
+    opensslParams.pSsl = &ssl;
+    opensslParams.pReadAheadBuffer = readAheadBuffer;
+    opensslParams.readAheadBufferSize = sizeof( readAheadBuffer );
+
+    SSL_read_ExpectAndReturn( &ssl, buffer, sizeof( buffer ), sizeof( buffer ) );
+    SSL_read_IgnoreArg_buf();
+    bytesReceived = Openssl_Recv( &networkContext, buffer, sizeof( buffer ) );
+    TEST_ASSERT_EQUAL( sizeof( buffer ), bytesReceived );
+    TEST_ASSERT_EQUAL( 0U, opensslParams.readAheadLength );
+
+    SSL_read_ExpectAnyArgsAndReturn( -1 );
+    SSL_get_error_ExpectAnyArgsAndReturn( SSL_ERROR_WANT_READ );
+    bytesReceived = Openssl_Recv( &networkContext, buffer, 1 );
+    TEST_ASSERT_EQUAL( 0, bytesReceived );
+
+    SSL_read_ExpectAnyArgsAndReturn( 0 );
+    SSL_get_error_ExpectAnyArgsAndReturn( SSL_ERROR_ZERO_RETURN );
+    bytesReceived = Openssl_Recv( &networkContext, buffer, 1 );
+    TEST_ASSERT_EQUAL( -1, bytesReceived );
+    TEST_ASSERT_EQUAL( 0U, opensslParams.readAheadLength );
+}
+
+/**
+ * @brief Test that #Openssl_GetRecvStats fails when invalid parameters are
+ * passed.
+ */
+void test_Openssl_GetRecvStats_Invalid_Params( void )
+{
+    OpensslRecvStats_t stats;
+    NetworkContext_t networkContext = { 0 };
+
+    TEST_ASSERT_EQUAL( OPENSSL_INVALID_PARAMETER, Openssl_GetRecvStats( NULL, &stats ) );
+    TEST_ASSERT_EQUAL( OPENSSL_INVALID_PARAMETER, Openssl_GetRecvStats( &networkContext, &stats ) );
+
+    networkContext.pParams = &opensslParams;
+    TEST_ASSERT_EQUAL( OPENSSL_INVALID_PARAMETER, Openssl_GetRecvStats( &networkContext, NULL ) );
+}
+
+/**
+ * @brief Test that #Openssl_Connect requests kTLS before the handshake and
+ * reports which directions the kernel took over.
+ */
+void test_Openssl_Connect_Ktls( void )
+{
+    OpensslStatus_t returnStatus;
+    uint8_t sendOffload = 0U, recvOffload = 1U;
+
+    opensslCredentials.enableKtls = 1U;
+    ktlsSendEngaged = 1;
+    opensslParams.ktlsRecv = 1U;
+
+    ( void ) failFunctionFrom_Openssl_Connect( SSL_get_verify_result_fn + 1,
+                                               NULL );
+    returnStatus = Openssl_Connect( &networkContext,
+                                    &serverInfo,
+                                    &opensslCredentials,
+                                    SEND_RECV_TIMEOUT,
+                                    SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( OPENSSL_SUCCESS, returnStatus );
+
+    returnStatus = Openssl_GetKtlsStatus( &networkContext, &sendOffload, &recvOffload );
+    TEST_ASSERT_EQUAL( OPENSSL_SUCCESS, returnStatus );
+    TEST_ASSERT_EQUAL( 1U, sendOffload );
+    TEST_ASSERT_EQUAL( 0U, recvOffload );
+}
+
+/**
+ * @brief Test that a failed handshake does not query or report kTLS.
+ */
+void test_Openssl_Connect_Ktls_Handshake_Fails( void )
+{
+    OpensslStatus_t returnStatus, expectedStatus;
+
+    opensslCredentials.enableKtls = 1U;
+    opensslParams.ktlsSend = 1U;
+
+    expectedStatus = failFunctionFrom_Openssl_Connect( SSL_connect_fn, NULL );
+    returnStatus = Openssl_Connect( &networkContext,
+                                    &serverInfo,
+                                    &opensslCredentials,
+                                    SEND_RECV_TIMEOUT,
+                                    SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( expectedStatus, returnStatus );
+    TEST_ASSERT_EQUAL( 0U, opensslParams.ktlsSend );
+}
+
+/**
+ * @brief Test that #Openssl_GetKtlsStatus fails when invalid parameters are
+ * passed.
+ */
+void test_Openssl_GetKtlsStatus_Invalid_Params( void )
+{
+    uint8_t sendOffload, recvOffload;
+    NetworkContext_t networkContext = { 0 };
+
+    TEST_ASSERT_EQUAL( OPENSSL_INVALID_PARAMETER,
+                       Openssl_GetKtlsStatus( NULL, &sendOffload, &recvOffload ) );
+    TEST_ASSERT_EQUAL( OPENSSL_INVALID_PARAMETER,
+                       Openssl_GetKtlsStatus( &networkContext, &sendOffload, &recvOffload ) );
+
+    networkContext.pParams = &opensslParams;
+    TEST_ASSERT_EQUAL( OPENSSL_INVALID_PARAMETER,
+                       Openssl_GetKtlsStatus( &networkContext, NULL, &recvOffload ) );
+    TEST_ASSERT_EQUAL( OPENSSL_INVALID_PARAMETER,
+                       Openssl_GetKtlsStatus( &networkContext, &sendOffload, NULL ) );
+}
+
+/**
+ * @brief Test that #Openssl_SendFile hands the file to #SSL_sendfile when
+ * kTLS send offload is engaged.
+ */
+void test_Openssl_SendFile_Ktls( void )
+{
+    int32_t bytesSent;
+
+    opensslParams.pSsl = &ssl;
+    opensslParams.ktlsSend = 1U;
+
+    SSL_sendfile_ExpectAndReturn( &ssl, FILE_DESCRIPTOR, FILE_OFFSET,
+                                  OPENSSL_WRITEV_BUFFER_SIZE * 2U, 0,
+                                  OPENSSL_WRITEV_BUFFER_SIZE );
+    bytesSent = Openssl_SendFile( &networkContext, FILE_DESCRIPTOR, FILE_OFFSET,
+                                  OPENSSL_WRITEV_BUFFER_SIZE * 2U );
+    TEST_ASSERT_EQUAL( OPENSSL_WRITEV_BUFFER_SIZE, bytesSent );
+
+    SSL_sendfile_ExpectAnyArgsAndReturn( -1 );
+    SSL_get_error_ExpectAnyArgsAndReturn( SSL_ERROR_SYSCALL );
+    bytesSent = Openssl_SendFile( &networkContext, FILE_DESCRIPTOR, FILE_OFFSET, 1U );
+    TEST_ASSERT_EQUAL( -1, bytesSent );
+}
+
+/**
+ * @brief Test that #Openssl_SendFile reads the file into memory and writes
+ * it with #SSL_write when kTLS is not engaged.
+ */
+void test_Openssl_SendFile_Copy( void )
+{
+    int32_t bytesSent;
+
+    opensslParams.pSsl = &ssl;
+    SSL_write_Stub( sslWriteStub );
+
+    /* At most one buffer is read per call. */
+    pread_ExpectAndReturn( FILE_DESCRIPTOR, NULL, OPENSSL_WRITEV_BUFFER_SIZE,
+                           FILE_OFFSET, BUFFER_LEN );
+    pread_IgnoreArg___buf();
+    pread_ReturnArrayThruPtr___buf( opensslBuffer, BUFFER_LEN );
+    bytesSent = Openssl_SendFile( &networkContext, FILE_DESCRIPTOR, FILE_OFFSET,
+                                  OPENSSL_WRITEV_BUFFER_SIZE + 1U );
+    TEST_ASSERT_EQUAL( BUFFER_LEN, bytesSent );
+    TEST_ASSERT_EQUAL( 1, sslWriteCount );
+    TEST_ASSERT_EQUAL( BUFFER_LEN, sslWriteLengths[ 0 ] );
+    TEST_ASSERT_EQUAL_UINT8_ARRAY( opensslBuffer, sslWriteData, BUFFER_LEN );
+
+    /* Reading past the end of the file and read errors fail the send. */
+    pread_ExpectAnyArgsAndReturn( 0 );
+    TEST_ASSERT_EQUAL( -1, Openssl_SendFile( &networkContext, FILE_DESCRIPTOR,
+                                             FILE_OFFSET, BUFFER_LEN ) );
+
+    pread_ExpectAnyArgsAndReturn( -1 );
+    TEST_ASSERT_EQUAL( -1, Openssl_SendFile( &networkContext, FILE_DESCRIPTOR,
+                                             FILE_OFFSET, BUFFER_LEN ) );
+    TEST_ASSERT_EQUAL( 1, sslWriteCount );
+}
+
+/**
+ * @brief Test that #Openssl_SendFile fails when invalid parameters are
+ * passed, and sends nothing for an empty range.
+ */
+void test_Openssl_SendFile_Invalid_Params( void )
+{
+    NetworkContext_t networkContext = { 0 };
+
+    TEST_ASSERT_EQUAL( -1, Openssl_SendFile( NULL, FILE_DESCRIPTOR, 0, BUFFER_LEN ) );
+    TEST_ASSERT_EQUAL( -1, Openssl_SendFile( &networkContext, FILE_DESCRIPTOR, 0, BUFFER_LEN ) );
+
+    networkContext.pParams = &opensslParams;
+    TEST_ASSERT_EQUAL( -1, Openssl_SendFile( &networkContext, FILE_DESCRIPTOR, 0, BUFFER_LEN ) );
+
+    opensslParams.pSsl = &ssl;
+    TEST_ASSERT_EQUAL( -1, Openssl_SendFile( &networkContext, -1, 0, BUFFER_LEN ) );
+    TEST_ASSERT_EQUAL( -1, Openssl_SendFile( &networkContext, FILE_DESCRIPTOR, -1, BUFFER_LEN ) );
+    TEST_ASSERT_EQUAL( 0, Openssl_SendFile( &networkContext, FILE_DESCRIPTOR, 0, 0U ) );
+}
+
+/**
+ * @brief Test that #Openssl_Connect switches the socket to non-blocking mode
+ * after the handshake when requested, and fails when it cannot.
+ */
+void test_Openssl_Connect_Non_Blocking( void )
+{
+    OpensslStatus_t returnStatus, expectedStatus;
+
+    opensslCredentials.nonBlocking = 1U;
+
+    ( void ) failFunctionFrom_Openssl_Connect( SSL_get_verify_result_fn + 1,
+                                               NULL );
+    returnStatus = Openssl_Connect( &networkContext,
+                                    &serverInfo,
+                                    &opensslCredentials,
+                                    SEND_RECV_TIMEOUT,
+                                    SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( OPENSSL_SUCCESS, returnStatus );
+    TEST_ASSERT_EQUAL( 1U, opensslParams.nonBlocking );
+
+    fcntlReturnValue = -1;
+    expectedStatus = failFunctionFrom_Openssl_Connect( SSL_get_verify_result_fn + 1,
+                                                       NULL );
+    returnStatus = Openssl_Connect( &networkContext,
+                                    &serverInfo,
+                                    &opensslCredentials,
+                                    SEND_RECV_TIMEOUT,
+                                    SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( OPENSSL_API_ERROR, expectedStatus );
+    TEST_ASSERT_EQUAL( expectedStatus, returnStatus );
+    TEST_ASSERT_EQUAL( 0U, opensslParams.nonBlocking );
+    TEST_ASSERT_NULL( opensslParams.pSsl );
+}
+
+/**
+ * @brief Test that #Openssl_Send and #Openssl_Recv return 0 on
+ * #SSL_ERROR_WANT_READ and #SSL_ERROR_WANT_WRITE only in non-blocking mode.
+ */
+void test_Openssl_Send_Recv_Non_Blocking_Retry( void )
+{
+    opensslParams.pSsl = &ssl;
+
+    /* Blocking mode cannot retry a send. */
+    SSL_write_ExpectAnyArgsAndReturn( -1 );
+    SSL_get_error_ExpectAnyArgsAndReturn( SSL_ERROR_WANT_WRITE );
+    TEST_ASSERT_EQUAL( -1, Openssl_Send( &networkContext, opensslBuffer, BYTES_TO_SEND ) );
+
+    SSL_read_ExpectAnyArgsAndReturn( -1 );
+    SSL_get_error_ExpectAnyArgsAndReturn( SSL_ERROR_WANT_WRITE );
+    TEST_ASSERT_EQUAL( -1, Openssl_Recv( &networkContext, opensslBuffer, BYTES_TO_RECV ) );
+
+    opensslParams.nonBlocking = 1U;
+
+    SSL_write_ExpectAnyArgsAndReturn( -1 );
+    SSL_get_error_ExpectAnyArgsAndReturn( SSL_ERROR_WANT_WRITE );
+    TEST_ASSERT_EQUAL( 0, Openssl_Send( &networkContext, opensslBuffer, BYTES_TO_SEND ) );
+
+    SSL_write_ExpectAnyArgsAndReturn( -1 );
+    SSL_get_error_ExpectAnyArgsAndReturn( SSL_ERROR_WANT_READ );
+    TEST_ASSERT_EQUAL( 0, Openssl_Send( &networkContext, opensslBuffer, BYTES_TO_SEND ) );
+
+    SSL_write_ExpectAnyArgsAndReturn( -1 );
+    SSL_get_error_ExpectAnyArgsAndReturn( SSL_ERROR_SYSCALL );
+    TEST_ASSERT_EQUAL( -1, Openssl_Send( &networkContext, opensslBuffer, BYTES_TO_SEND ) );
+
+    SSL_read_ExpectAnyArgsAndReturn( -1 );
+    SSL_get_error_ExpectAnyArgsAndReturn( SSL_ERROR_WANT_WRITE );
+    TEST_ASSERT_EQUAL( 0, Openssl_Recv( &networkContext, opensslBuffer, BYTES_TO_RECV ) );
+}
+
+/**
+ * @brief Test that #Openssl_Writev stops at a write that did not send all of
+ * its bytes, so that no later buffer is sent ahead of them.
+ */
+void test_Openssl_Writev_Stops_At_Short_Write( void )
+{
+    int32_t bytesSent;
+    struct iovec ioVec[ 2 ];
+
+    opensslParams.pSsl = &ssl;
+    opensslParams.nonBlocking = 1U;
+
+    ioVec[ 0 ].iov_base = largeBuffer;
+    ioVec[ 0 ].iov_len = sizeof( largeBuffer );
+    ioVec[ 1 ].iov_base = opensslBuffer;
+    ioVec[ 1 ].iov_len = BUFFER_LEN;
+
+    SSL_write_ExpectAndReturn( &ssl, largeBuffer, sizeof( largeBuffer ), 100 );
+    bytesSent = Openssl_Writev( &networkContext, ioVec, 2U );
+    TEST_ASSERT_EQUAL( 100, bytesSent );
+
+    SSL_write_ExpectAndReturn( &ssl, largeBuffer, sizeof( largeBuffer ), -1 );
+    SSL_get_error_ExpectAnyArgsAndReturn( SSL_ERROR_WANT_WRITE );
+    bytesSent = Openssl_Writev( &networkContext, ioVec, 2U );
+    TEST_ASSERT_EQUAL( 0, bytesSent );
+}
+
+/**
+ * @brief Test that #Openssl_Writev and #Openssl_Send stop once INT32_MAX bytes
+ * were sent, so that the count fits the return value.
+ */
+void test_Openssl_Writev_Caps_Bytes_Sent( void )
+{
+    int32_t bytesSent;
+    struct iovec ioVec[ 3 ];
+
+    /* #sslWriteStub does not read buffers larger than #sslWriteData. */
+    ioVec[ 0 ].iov_base = largeBuffer;
+    ioVec[ 0 ].iov_len = ( size_t ) INT32_MAX - 10U;
+    ioVec[ 1 ].iov_base = largeBuffer;
+    ioVec[ 1 ].iov_len = sizeof( largeBuffer );
+    ioVec[ 2 ].iov_base = opensslBuffer;
+    ioVec[ 2 ].iov_len = BUFFER_LEN;
+
+    opensslParams.pSsl = &ssl;
+    SSL_write_Stub( sslWriteStub );
+    bytesSent = Openssl_Writev( &networkContext, ioVec, 3U );
+
+    TEST_ASSERT_EQUAL( INT32_MAX, bytesSent );
+    TEST_ASSERT_EQUAL( 2, sslWriteCount );
+    TEST_ASSERT_EQUAL( INT32_MAX - 10, sslWriteLengths[ 0 ] );
+    TEST_ASSERT_EQUAL( 10, sslWriteLengths[ 1 ] );
+
+    bytesSent = Openssl_Send( &networkContext, largeBuffer, ( size_t ) INT32_MAX + 1U );
+    TEST_ASSERT_EQUAL( INT32_MAX, bytesSent );
+    TEST_ASSERT_EQUAL( INT32_MAX, sslWriteLengths[ 2 ] );
+}
+
+/**
+ * @brief Test that #Openssl_GetSocketDescriptor and #Openssl_HasPendingData
+ * report the state of the connection.
+ */
+void test_Openssl_GetSocketDescriptor_HasPendingData( void )
+{
+    NetworkContext_t invalidContext = { 0 };
+
+    TEST_ASSERT_EQUAL( -1, Openssl_GetSocketDescriptor( NULL ) );
+    TEST_ASSERT_EQUAL( -1, Openssl_GetSocketDescriptor( &invalidContext ) );
+    TEST_ASSERT_EQUAL( 0U, Openssl_HasPendingData( NULL ) );
+    TEST_ASSERT_EQUAL( 0U, Openssl_HasPendingData( &invalidContext ) );
+
+    opensslParams.socketDescriptor = 7;
+    TEST_ASSERT_EQUAL( 7, Openssl_GetSocketDescriptor( &networkContext ) );
+
+    /* No SSL object. */
+    TEST_ASSERT_EQUAL( 0U, Openssl_HasPendingData( &networkContext ) );
+
+    opensslParams.pSsl = &ssl;
+    SSL_has_pending_ExpectAndReturn( &ssl, 0 );
+    TEST_ASSERT_EQUAL( 0U, Openssl_HasPendingData( &networkContext ) );
+
+    SSL_has_pending_ExpectAndReturn( &ssl, 1 );
+    TEST_ASSERT_EQUAL( 1U, Openssl_HasPendingData( &networkContext ) );
+
+    /* Data in the read-ahead buffer is pending without asking OpenSSL. */
+    opensslParams.readAheadLength = 1U;
+    TEST_ASSERT_EQUAL( 1U, Openssl_HasPendingData( &networkContext ) );
+}
+
+/**
+ * @brief Test that the statistics of a TLS connection count connects, failed
+ * handshakes and the outcome of each SSL_write and SSL_read.
+ */
+void test_Openssl_GetStats_Counts_Transfers( void )
+{
+    OpensslStatus_t returnStatus;
+    TransportStats_t stats = { 0 };
+    size_t i;
+    uint32_t handshakes = 0;
+
+    ( void ) failFunctionFrom_Openssl_Connect( SSL_connect_fn, NULL );
+    returnStatus = Openssl_Connect( &networkContext,
+                                    &serverInfo,
+                                    &opensslCredentials,
+                                    SEND_RECV_TIMEOUT,
+                                    SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( OPENSSL_HANDSHAKE_FAILED, returnStatus );
+
+    ( void ) failFunctionFrom_Openssl_Connect( SSL_get_verify_result_fn + 1, NULL );
+    returnStatus = Openssl_Connect( &networkContext,
+                                    &serverInfo,
+                                    &opensslCredentials,
+                                    SEND_RECV_TIMEOUT,
+                                    SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( OPENSSL_SUCCESS, returnStatus );
+
+    /* A partial write and a read that must be retried. */
+    opensslParams.pSsl = &ssl;
+    SSL_write_ExpectAnyArgsAndReturn( BYTES_TO_SEND - 1 );
+    ( void ) Openssl_Send( &networkContext, opensslBuffer, BYTES_TO_SEND );
+    SSL_read_ExpectAnyArgsAndReturn( SSL_READ_WRITE_ERROR );
+    SSL_get_error_ExpectAnyArgsAndReturn( SSL_ERROR_WANT_READ );
+    ( void ) Openssl_Recv( &networkContext, opensslBuffer, BYTES_TO_RECV );
+
+    returnStatus = Openssl_GetStats( &networkContext, &stats );
+    TEST_ASSERT_EQUAL( OPENSSL_SUCCESS, returnStatus );
+    TEST_ASSERT_EQUAL( 2, stats.connects );
+    TEST_ASSERT_EQUAL( 0, stats.connectFailures );
+    TEST_ASSERT_EQUAL( 1, stats.handshakeFailures );
+    TEST_ASSERT_EQUAL( 1, stats.sendCalls );
+    TEST_ASSERT_EQUAL( BYTES_TO_SEND - 1, stats.bytesSent );
+    TEST_ASSERT_EQUAL( 1, stats.partialSends );
+    TEST_ASSERT_EQUAL( 1, stats.recvCalls );
+    TEST_ASSERT_EQUAL( 1, stats.timeouts );
+
+    for( i = 0; i < TRANSPORT_STATS_HISTOGRAM_BUCKETS; i++ )
+    {
+        handshakes += stats.handshakeUs.counts[ i ];
+    }
+
+    TEST_ASSERT_EQUAL( 1, handshakes );
+}
+
+/**
+ * @brief Test that #Openssl_GetStats fails when invalid parameters are passed.
+ */
+void test_Openssl_GetStats_Invalid_Params( void )
+{
+    TransportStats_t stats;
+    NetworkContext_t networkContext = { 0 };
+
+    TEST_ASSERT_EQUAL( OPENSSL_INVALID_PARAMETER, Openssl_GetStats( NULL, &stats ) );
+    TEST_ASSERT_EQUAL( OPENSSL_INVALID_PARAMETER, Openssl_GetStats( &networkContext, &stats ) );
+
+    networkContext.pParams = &opensslParams;
+    TEST_ASSERT_EQUAL( OPENSSL_INVALID_PARAMETER, Openssl_GetStats( &networkContext, NULL ) );
+}
@@ -32,12 +32,20 @@
 
 #include "mock_sockets_posix.h"
 #include "mock_stdio_api.h"
-#include "mock_select_api.h"
+#include "mock_poll_api.h"
 #include "mock_socket.h"
+#include "mock_uio_api.h"
 
 /* The send and receive timeout to set for the socket. */
 #define SEND_RECV_TIMEOUT    0
 
+/* The timeouts to pass to #Plaintext_SetTimeouts. */
+#define SEND_TIMEOUT_MS      1500U
+#define RECV_TIMEOUT_MS      250U
+
+/* A socket that select could not watch, as it is above FD_SETSIZE. */
+#define LARGE_SOCKET_DESCRIPTOR    4096
+
 /* The host and port from which to establish the connection. */
 #define HOSTNAME             "amazon.com"
 #define PORT                 80
@@ -76,6 +84,12 @@ static uint8_t errorNumbers[] =
     EAGAIN,    EWOULDBLOCK, UNKNOWN_ERRNO
 };
 
+/* The descriptor most recently passed to #poll. */
+static struct pollfd pollDescriptor;
+
+/* The timeout most recently passed to #poll. */
+static int pollTimeout;
+
 /* ============================   UNITY FIXTURES ============================ */
 
 /* Called before each test method. */
@@ -86,6 +100,9 @@ void setUp()
     serverInfo.port = PORT;
 
     networkContext.pParams = &plaintextParams;
+    plaintextParams.sendTimeoutMs = SEND_RECV_TIMEOUT;
+    plaintextParams.recvTimeoutMs = SEND_RECV_TIMEOUT;
+    ( void ) memset( &plaintextParams.stats, 0, sizeof( plaintextParams.stats ) );
 }
 
 /* Called after each test method. */
@@ -107,15 +124,50 @@ int suiteTearDown( int numFailures )
 /* ========================================================================== */
 
 /**
- * @brief Test that #Plaintext_Connect forwards the status from #Sockets_Connect.
+ * @brief Get the number of latencies recorded in a histogram.
+ */
+static uint32_t histogramCount( const TransportHistogram_t * pHistogram )
+{
+    uint32_t count = 0;
+    size_t i;
+
+    for( i = 0; i < TRANSPORT_STATS_HISTOGRAM_BUCKETS; i++ )
+    {
+        count += pHistogram->counts[ i ];
+    }
+
+    return count;
+}
+
+/**
+ * @brief Stub for #poll that records the descriptor and the timeout it is
+ * called with.
+ */
+static int pollStub( struct pollfd * fds,
+                     nfds_t nfds,
+                     int timeout,
+                     int numCalls )
+{
+    ( void ) numCalls;
+
+    TEST_ASSERT_NOT_NULL( fds );
+    TEST_ASSERT_EQUAL( 1, nfds );
+    pollDescriptor = *fds;
+    pollTimeout = timeout;
+
+    return 1;
+}
+
+/**
+ * @brief Test that #Plaintext_Connect forwards the status from #Sockets_ConnectWithOptions.
  *
- * @note #Plaintext_Connect is just a wrapper function to #Sockets_Connect.
+ * @note #Plaintext_Connect is just a wrapper function to #Sockets_ConnectWithOptions.
  */
 void test_Plaintext_Connect_Forwards_From_Sockets_Connect( void )
 {
     SocketStatus_t socketStatus;
 
-    Sockets_Connect_ExpectAnyArgsAndReturn( SOCKETS_SUCCESS );
+    Sockets_ConnectWithOptions_ExpectAnyArgsAndReturn( SOCKETS_SUCCESS );
     socketStatus = Plaintext_Connect( &networkContext,
                                       &serverInfo,
                                       SEND_RECV_TIMEOUT,
@@ -123,6 +175,108 @@ void test_Plaintext_Connect_Forwards_From_Sockets_Connect( void )
     TEST_ASSERT_EQUAL( SOCKETS_SUCCESS, socketStatus );
 }
 
+/**
+ * @brief Test that #Plaintext_ConnectWithOptions passes the socket options to
+ * #Sockets_ConnectWithOptions.
+ */
+void test_Plaintext_ConnectWithOptions_Forwards_Options( void )
+{
+    SocketStatus_t socketStatus;
+    SocketsOptions_t options = { 0 };
+
+    options.noDelay = 1U;
+
+    Sockets_ConnectWithOptions_ExpectAndReturn( &plaintextParams.socketDescriptor,
+                                                &serverInfo,
+                                                SEND_TIMEOUT_MS,
+                                                RECV_TIMEOUT_MS,
+                                                &options,
+                                                SOCKETS_SUCCESS );
+    socketStatus = Plaintext_ConnectWithOptions( &networkContext,
+                                                 &serverInfo,
+                                                 SEND_TIMEOUT_MS,
+                                                 RECV_TIMEOUT_MS,
+                                                 &options );
+    TEST_ASSERT_EQUAL( SOCKETS_SUCCESS, socketStatus );
+}
+
+/**
+ * @brief Test that #Plaintext_Connect caches the timeouts only on success.
+ */
+void test_Plaintext_Connect_Caches_Timeouts( void )
+{
+    SocketStatus_t socketStatus;
+
+    Sockets_ConnectWithOptions_ExpectAnyArgsAndReturn( SOCKETS_CONNECT_FAILURE );
+    socketStatus = Plaintext_Connect( &networkContext,
+                                      &serverInfo,
+                                      SEND_TIMEOUT_MS,
+                                      RECV_TIMEOUT_MS );
+    TEST_ASSERT_EQUAL( SOCKETS_CONNECT_FAILURE, socketStatus );
+    TEST_ASSERT_EQUAL( SEND_RECV_TIMEOUT, plaintextParams.sendTimeoutMs );
+    TEST_ASSERT_EQUAL( SEND_RECV_TIMEOUT, plaintextParams.recvTimeoutMs );
+
+    Sockets_ConnectWithOptions_ExpectAnyArgsAndReturn( SOCKETS_SUCCESS );
+    socketStatus = Plaintext_Connect( &networkContext,
+                                      &serverInfo,
+                                      SEND_TIMEOUT_MS,
+                                      RECV_TIMEOUT_MS );
+    TEST_ASSERT_EQUAL( SOCKETS_SUCCESS, socketStatus );
+    TEST_ASSERT_EQUAL( SEND_TIMEOUT_MS, plaintextParams.sendTimeoutMs );
+    TEST_ASSERT_EQUAL( RECV_TIMEOUT_MS, plaintextParams.recvTimeoutMs );
+}
+
+/**
+ * @brief Test that #Plaintext_SetTimeouts forwards the status from
+ * #Sockets_SetTimeouts and caches the timeouts only on success.
+ */
+void test_Plaintext_SetTimeouts_Forwards_From_Sockets_SetTimeouts( void )
+{
+    SocketStatus_t socketStatus;
+
+    Sockets_SetTimeouts_ExpectAndReturn( plaintextParams.socketDescriptor,
+                                         SEND_TIMEOUT_MS,
+                                         RECV_TIMEOUT_MS,
+                                         SOCKETS_API_ERROR );
+    socketStatus = Plaintext_SetTimeouts( &networkContext,
+                                          SEND_TIMEOUT_MS,
+                                          RECV_TIMEOUT_MS );
+    TEST_ASSERT_EQUAL( SOCKETS_API_ERROR, socketStatus );
+    TEST_ASSERT_EQUAL( SEND_RECV_TIMEOUT, plaintextParams.sendTimeoutMs );
+    TEST_ASSERT_EQUAL( SEND_RECV_TIMEOUT, plaintextParams.recvTimeoutMs );
+
+    Sockets_SetTimeouts_ExpectAndReturn( plaintextParams.socketDescriptor,
+                                         SEND_TIMEOUT_MS,
+                                         RECV_TIMEOUT_MS,
+                                         SOCKETS_SUCCESS );
+    socketStatus = Plaintext_SetTimeouts( &networkContext,
+                                          SEND_TIMEOUT_MS,
+                                          RECV_TIMEOUT_MS );
+    TEST_ASSERT_EQUAL( SOCKETS_SUCCESS, socketStatus );
+    TEST_ASSERT_EQUAL( SEND_TIMEOUT_MS, plaintextParams.sendTimeoutMs );
+    TEST_ASSERT_EQUAL( RECV_TIMEOUT_MS, plaintextParams.recvTimeoutMs );
+}
+
+/**
+ * @brief Test that a NULL network context returns an error.
+ */
+void test_Plaintext_SetTimeouts_Invalid_Params( void )
+{
+    SocketStatus_t socketStatus = SOCKETS_SUCCESS;
+    NetworkContext_t networkContext = { 0 };
+
+    socketStatus = Plaintext_SetTimeouts( NULL,
+                                          SEND_TIMEOUT_MS,
+                                          RECV_TIMEOUT_MS );
+    TEST_ASSERT_EQUAL( SOCKETS_INVALID_PARAMETER, socketStatus );
+
+    networkContext.pParams = NULL;
+    socketStatus = Plaintext_SetTimeouts( &networkContext,
+                                          SEND_TIMEOUT_MS,
+                                          RECV_TIMEOUT_MS );
+    TEST_ASSERT_EQUAL( SOCKETS_INVALID_PARAMETER, socketStatus );
+}
+
 /**
  * @brief Test that a NULL network context returns an error.
  */
@@ -183,8 +337,7 @@ void test_Plaintext_Recv_All_Bytes_Received_Successfully( void )
 {
     int32_t bytesReceived;
 
-    getsockopt_ExpectAnyArgsAndReturn( 0 );
-    select_ExpectAnyArgsAndReturn( 1 );
+    poll_ExpectAnyArgsAndReturn( 1 );
     recv_ExpectAnyArgsAndReturn( BYTES_TO_RECV );
     bytesReceived = Plaintext_Recv( &networkContext,
                                     plaintextBuffer,
@@ -200,8 +353,7 @@ void test_Plaintext_Recv_Zero_Bytes_Received( void )
 {
     int32_t bytesReceived;
 
-    getsockopt_ExpectAnyArgsAndReturn( -1 );
-    select_ExpectAnyArgsAndReturn( 1 );
+    poll_ExpectAnyArgsAndReturn( 1 );
     recv_ExpectAnyArgsAndReturn( 0 );
     bytesReceived = Plaintext_Recv( &networkContext,
                                     plaintextBuffer,
@@ -216,8 +368,7 @@ void test_Plaintext_Recv_Socket_Timeout( void )
 {
     int32_t bytesReceived;
 
-    getsockopt_ExpectAnyArgsAndReturn( 0 );
-    select_ExpectAnyArgsAndReturn( 0 );
+    poll_ExpectAnyArgsAndReturn( 0 );
     bytesReceived = Plaintext_Recv( &networkContext,
                                     plaintextBuffer,
                                     BYTES_TO_RECV );
@@ -225,15 +376,14 @@ void test_Plaintext_Recv_Socket_Timeout( void )
 }
 
 /**
- * @brief Test that #Plaintext_Recv returns an error when calling #select on the
+ * @brief Test that #Plaintext_Recv returns an error when calling #poll on the
  * socket fails.
  */
 void test_Plaintext_Recv_Poll_Error( void )
 {
     int32_t bytesReceived;
 
-    getsockopt_ExpectAnyArgsAndReturn( 0 );
-    select_ExpectAnyArgsAndReturn( -1 );
+    poll_ExpectAnyArgsAndReturn( -1 );
     bytesReceived = Plaintext_Recv( &networkContext,
                                     plaintextBuffer,
                                     BYTES_TO_RECV );
@@ -251,8 +401,7 @@ void test_Plaintext_Recv_Network_Error( void )
 
     for( i = 0; i < sizeof( errorNumbers ); i++ )
     {
-        getsockopt_ExpectAnyArgsAndReturn( 0 );
-        select_ExpectAnyArgsAndReturn( 1 );
+        poll_ExpectAnyArgsAndReturn( 1 );
         recv_ExpectAnyArgsAndReturn( SEND_RECV_ERROR );
         errno = errorNumbers[ i ];
         bytesReceived = Plaintext_Recv( &networkContext,
@@ -271,8 +420,7 @@ void test_Plaintext_Send_All_Bytes_Sent_Successfully( void )
 {
     int32_t bytesSent;
 
-    getsockopt_ExpectAnyArgsAndReturn( 0 );
-    select_ExpectAnyArgsAndReturn( 1 );
+    poll_ExpectAnyArgsAndReturn( 1 );
     send_ExpectAnyArgsAndReturn( BYTES_TO_SEND );
     bytesSent = Plaintext_Send( &networkContext,
                                 plaintextBuffer,
@@ -291,8 +439,7 @@ void test_Plaintext_Send_Network_Error( void )
 
     for( i = 0; i < sizeof( errorNumbers ); i++ )
     {
-        getsockopt_ExpectAnyArgsAndReturn( 0 );
-        select_ExpectAnyArgsAndReturn( 1 );
+        poll_ExpectAnyArgsAndReturn( 1 );
         send_ExpectAnyArgsAndReturn( SEND_RECV_ERROR );
         errno = errorNumbers[ i ];
         bytesSent = Plaintext_Send( &networkContext,
@@ -311,8 +458,7 @@ void test_Plaintext_Send_Zero_Bytes_Received( void )
 {
     int32_t bytesSent;
 
-    getsockopt_ExpectAnyArgsAndReturn( -1 );
-    select_ExpectAnyArgsAndReturn( 1 );
+    poll_ExpectAnyArgsAndReturn( 1 );
     send_ExpectAnyArgsAndReturn( 0 );
     bytesSent = Plaintext_Send( &networkContext,
                                 plaintextBuffer,
@@ -327,8 +473,7 @@ void test_Plaintext_Send_Socket_Timeout( void )
 {
     int32_t bytesSent;
 
-    getsockopt_ExpectAnyArgsAndReturn( 0 );
-    select_ExpectAnyArgsAndReturn( 0 );
+    poll_ExpectAnyArgsAndReturn( 0 );
     bytesSent = Plaintext_Send( &networkContext,
                                 plaintextBuffer,
                                 BYTES_TO_SEND );
@@ -336,17 +481,165 @@ void test_Plaintext_Send_Socket_Timeout( void )
 }
 
 /**
- * @brief Test that #Plaintext_Send returns an error when calling #select on the
+ * @brief Test that #Plaintext_Send returns an error when calling #poll on the
  * socket fails.
  */
 void test_Plaintext_Send_Poll_Error( void )
 {
     int32_t bytesSent;
 
-    getsockopt_ExpectAnyArgsAndReturn( 0 );
-    select_ExpectAnyArgsAndReturn( -1 );
+    poll_ExpectAnyArgsAndReturn( -1 );
     bytesSent = Plaintext_Send( &networkContext,
                                 plaintextBuffer,
                                 BYTES_TO_SEND );
     TEST_ASSERT_EQUAL( SEND_RECV_ERROR, bytesSent );
 }
+
+/**
+ * @brief Test that #Plaintext_Recv and #Plaintext_Send wait in #poll for the
+ * cached timeouts without querying the socket, even for a socket above
+ * FD_SETSIZE.
+ */
+void test_Plaintext_Send_Recv_Use_Cached_Timeouts( void )
+{
+    int32_t bytesTransferred;
+
+    plaintextParams.socketDescriptor = LARGE_SOCKET_DESCRIPTOR;
+    plaintextParams.sendTimeoutMs = SEND_TIMEOUT_MS;
+    plaintextParams.recvTimeoutMs = RECV_TIMEOUT_MS;
+
+    poll_Stub( pollStub );
+    recv_ExpectAnyArgsAndReturn( BYTES_TO_RECV );
+    bytesTransferred = Plaintext_Recv( &networkContext,
+                                       plaintextBuffer,
+                                       BYTES_TO_RECV );
+    TEST_ASSERT_EQUAL( BYTES_TO_RECV, bytesTransferred );
+    TEST_ASSERT_EQUAL( LARGE_SOCKET_DESCRIPTOR, pollDescriptor.fd );
+    TEST_ASSERT_EQUAL( POLLIN, pollDescriptor.events );
+    TEST_ASSERT_EQUAL( RECV_TIMEOUT_MS, pollTimeout );
+
+    send_ExpectAnyArgsAndReturn( BYTES_TO_SEND );
+    bytesTransferred = Plaintext_Send( &networkContext,
+                                       plaintextBuffer,
+                                       BYTES_TO_SEND );
+    TEST_ASSERT_EQUAL( BYTES_TO_SEND, bytesTransferred );
+    TEST_ASSERT_EQUAL( LARGE_SOCKET_DESCRIPTOR, pollDescriptor.fd );
+    TEST_ASSERT_EQUAL( POLLOUT, pollDescriptor.events );
+    TEST_ASSERT_EQUAL( SEND_TIMEOUT_MS, pollTimeout );
+}
+
+/**
+ * @brief Test that #Plaintext_Writev sends all vectors with one #writev once
+ * the socket is writable.
+ */
+void test_Plaintext_Writev_All_Bytes_Sent_Successfully( void )
+{
+    int32_t bytesSent;
+    struct iovec ioVec[ 2 ];
+
+    ioVec[ 0 ].iov_base = plaintextBuffer;
+    ioVec[ 0 ].iov_len = BYTES_TO_SEND / 2;
+    ioVec[ 1 ].iov_base = &plaintextBuffer[ BYTES_TO_SEND / 2 ];
+    ioVec[ 1 ].iov_len = BYTES_TO_SEND / 2;
+
+    poll_ExpectAnyArgsAndReturn( 1 );
+    writev_ExpectAndReturn( plaintextParams.socketDescriptor, ioVec, 2, BYTES_TO_SEND );
+    bytesSent = Plaintext_Writev( &networkContext, ioVec, 2 );
+    TEST_ASSERT_EQUAL( BYTES_TO_SEND, bytesSent );
+}
+
+/**
+ * @brief Test that #Plaintext_Writev reports timeouts, #poll failures, a
+ * closed peer and #writev failures like #Plaintext_Send.
+ */
+void test_Plaintext_Writev_Errors( void )
+{
+    int32_t bytesSent;
+    struct iovec ioVec;
+
+    ioVec.iov_base = plaintextBuffer;
+    ioVec.iov_len = BYTES_TO_SEND;
+
+    poll_ExpectAnyArgsAndReturn( 0 );
+    bytesSent = Plaintext_Writev( &networkContext, &ioVec, 1 );
+    TEST_ASSERT_EQUAL( 0, bytesSent );
+
+    poll_ExpectAnyArgsAndReturn( -1 );
+    bytesSent = Plaintext_Writev( &networkContext, &ioVec, 1 );
+    TEST_ASSERT_EQUAL( SEND_RECV_ERROR, bytesSent );
+
+    poll_ExpectAnyArgsAndReturn( 1 );
+    writev_ExpectAnyArgsAndReturn( 0 );
+    bytesSent = Plaintext_Writev( &networkContext, &ioVec, 1 );
+    TEST_ASSERT_EQUAL( SEND_RECV_ERROR, bytesSent );
+
+    poll_ExpectAnyArgsAndReturn( 1 );
+    writev_ExpectAnyArgsAndReturn( SEND_RECV_ERROR );
+    errno = EPIPE;
+    bytesSent = Plaintext_Writev( &networkContext, &ioVec, 1 );
+    TEST_ASSERT_EQUAL( SEND_RECV_ERROR, bytesSent );
+}
+
+/**
+ * @brief Test that the statistics count connects and the outcome of each
+ * send and receive.
+ */
+void test_Plaintext_GetStats_Counts_Transfers( void )
+{
+    SocketStatus_t socketStatus;
+    TransportStats_t stats = { 0 };
+
+    Sockets_ConnectWithOptions_ExpectAnyArgsAndReturn( SOCKETS_CONNECT_FAILURE );
+    ( void ) Plaintext_Connect( &networkContext, &serverInfo, SEND_RECV_TIMEOUT, SEND_RECV_TIMEOUT );
+    Sockets_ConnectWithOptions_ExpectAnyArgsAndReturn( SOCKETS_SUCCESS );
+    ( void ) Plaintext_Connect( &networkContext, &serverInfo, SEND_RECV_TIMEOUT, SEND_RECV_TIMEOUT );
+
+    /* A partial read, a timeout and a failed send. */
+    poll_ExpectAnyArgsAndReturn( 1 );
+    recv_ExpectAnyArgsAndReturn( BYTES_TO_RECV - 1 );
+    ( void ) Plaintext_Recv( &networkContext, plaintextBuffer, BYTES_TO_RECV );
+    poll_ExpectAnyArgsAndReturn( 0 );
+    ( void ) Plaintext_Recv( &networkContext, plaintextBuffer, BYTES_TO_RECV );
+    poll_ExpectAnyArgsAndReturn( 1 );
+    send_ExpectAnyArgsAndReturn( SEND_RECV_ERROR );
+    errno = EPIPE;
+    ( void ) Plaintext_Send( &networkContext, plaintextBuffer, BYTES_TO_SEND );
+    poll_ExpectAnyArgsAndReturn( 1 );
+    send_ExpectAnyArgsAndReturn( BYTES_TO_SEND );
+    ( void ) Plaintext_Send( &networkContext, plaintextBuffer, BYTES_TO_SEND );
+
+    socketStatus = Plaintext_GetStats( &networkContext, &stats );
+    TEST_ASSERT_EQUAL( SOCKETS_SUCCESS, socketStatus );
+    TEST_ASSERT_EQUAL( 1, stats.connects );
+    TEST_ASSERT_EQUAL( 1, stats.connectFailures );
+    TEST_ASSERT_EQUAL( 2, stats.recvCalls );
+    TEST_ASSERT_EQUAL( BYTES_TO_RECV - 1, stats.bytesReceived );
+    TEST_ASSERT_EQUAL( 1, stats.partialReads );
+    TEST_ASSERT_EQUAL( 1, stats.timeouts );
+    TEST_ASSERT_EQUAL( 2, stats.sendCalls );
+    TEST_ASSERT_EQUAL( BYTES_TO_SEND, stats.bytesSent );
+    TEST_ASSERT_EQUAL( 0, stats.partialSends );
+    TEST_ASSERT_EQUAL( 1, stats.errors );
+    TEST_ASSERT_EQUAL( 2, histogramCount( &stats.sendUs ) );
+    TEST_ASSERT_EQUAL( 2, histogramCount( &stats.recvUs ) );
+    TEST_ASSERT_EQUAL( 1, histogramCount( &stats.connectUs ) );
+}
+
+/**
+ * @brief Test that #Plaintext_GetStats rejects NULL parameters.
+ */
+void test_Plaintext_GetStats_Invalid_Params( void )
+{
+    SocketStatus_t socketStatus;
+    TransportStats_t stats = { 0 };
+    NetworkContext_t invalidContext = { 0 };
+
+    socketStatus = Plaintext_GetStats( NULL, &stats );
+    TEST_ASSERT_EQUAL( SOCKETS_INVALID_PARAMETER, socketStatus );
+
+    socketStatus = Plaintext_GetStats( &invalidContext, &stats );
+    TEST_ASSERT_EQUAL( SOCKETS_INVALID_PARAMETER, socketStatus );
+
+    socketStatus = Plaintext_GetStats( &networkContext, NULL );
+    TEST_ASSERT_EQUAL( SOCKETS_INVALID_PARAMETER, socketStatus );
+}
@@ -23,6 +23,7 @@
 #include <string.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <netinet/tcp.h>
 #include "/usr/include/errno.h"
 
 #include "unity.h"
@@ -35,10 +36,16 @@
 #include "mock_inet.h"
 #include "mock_unistd_api.h"
 #include "mock_stdio_api.h"
+#include "mock_poll_api.h"
+#include "mock_fcntl_api.h"
 
 /* The number of #addrinfo objects to create in the linked list. */
 #define NUM_ADDR_INFO        3
 
+/* The number of connection attempts in progress once every record has been
+ * tried. The first call to #socket fails in #expectSocketsConnectCalls. */
+#define NUM_PENDING          ( NUM_ADDR_INFO - 1 )
+
 /* The send and receive timeout to set for the socket. */
 #define SEND_RECV_TIMEOUT    0
 
@@ -49,6 +56,34 @@
 static struct addrinfo * addrInfo;
 static ServerInfo_t serverInfo;
 
+/* The number of attempts in progress at which #pollStub reports completion. */
+static nfds_t pendingAttemptsBeforeReady;
+
+/* Whether the last connection attempt reported by #pollStub succeeds. */
+static bool lastAttemptSucceeds;
+
+/* The call to #connect, counting from 0, that is refused outright. */
+static int connectRefusedCall;
+
+/* The address family passed to each call of #connect. */
+static sa_family_t connectFamilies[ 4 ];
+
+/* The errno to set when #setsockoptFailStub fails. */
+static int32_t setsockoptErrno;
+
+/* The number of #setsockopt calls that succeed before #setsockoptFailStub fails. */
+static int32_t setsockoptCallsUntilFailure;
+
+/* Error returned through SO_ERROR for a failed connection attempt. */
+static int32_t connectionRefused = ECONNREFUSED;
+
+/* The options passed to each call of #setsockoptRecordStub. */
+static int setsockoptNames[ 32 ];
+static int setsockoptCount;
+
+/* The option on which #setsockoptRecordStub fails, or -1 if none. */
+static int setsockoptFailingOption;
+
 /**
  * @brief Allocate a linked list that mocks a set of DNS records returned from
  * a call to #getaddrinfo.
@@ -70,6 +105,7 @@ static void allocateAddrInfoLinkedList( struct addrinfo ** head )
         next->ai_family = AF_UNSPEC;
         next->ai_socktype = SOCK_STREAM;
         next->ai_protocol = IPPROTO_TCP;
+        next->ai_addrlen = sizeof( struct sockaddr );
         next->ai_next = NULL;
 
         /* Every other IP address will be IPv4 for coverage. */
@@ -119,6 +155,156 @@ static void freeAddrInfoLinkedList( struct addrinfo * head )
     }
 }
 
+/**
+ * @brief Stub for #connect that leaves the connection in progress, as a
+ * non-blocking socket does.
+ */
+static int connectStub( int fd,
+                        const struct sockaddr * addr,
+                        socklen_t len,
+                        int numCalls )
+{
+    int returnStatus = -1;
+
+    ( void ) fd;
+    ( void ) len;
+
+    if( numCalls < ( int ) ( sizeof( connectFamilies ) / sizeof( connectFamilies[ 0 ] ) ) )
+    {
+        connectFamilies[ numCalls ] = addr->sa_family;
+    }
+
+    if( numCalls == connectRefusedCall )
+    {
+        errno = ECONNREFUSED;
+    }
+    else
+    {
+        errno = EINPROGRESS;
+    }
+
+    return returnStatus;
+}
+
+/**
+ * @brief Stub for #poll that lets the attempt delay elapse until
+ * #pendingAttemptsBeforeReady attempts are in progress, then reports either
+ * the last attempt or every attempt as complete.
+ */
+static int pollStub( struct pollfd * fds,
+                     nfds_t nfds,
+                     int timeout,
+                     int numCalls )
+{
+    int readyCount = 0;
+    nfds_t i;
+
+    ( void ) timeout;
+    ( void ) numCalls;
+
+    if( nfds == pendingAttemptsBeforeReady )
+    {
+        if( lastAttemptSucceeds == true )
+        {
+            fds[ nfds - 1 ].revents = POLLOUT;
+            readyCount = 1;
+        }
+        else
+        {
+            for( i = 0; i < nfds; i++ )
+            {
+                fds[ i ].revents = POLLOUT;
+            }
+
+            readyCount = ( int ) nfds;
+        }
+    }
+
+    return readyCount;
+}
+
+/**
+ * @brief Stub for #poll that fails with an error other than EINTR.
+ */
+static int pollFailStub( struct pollfd * fds,
+                         nfds_t nfds,
+                         int timeout,
+                         int numCalls )
+{
+    ( void ) fds;
+    ( void ) nfds;
+    ( void ) timeout;
+    ( void ) numCalls;
+
+    errno = EBADF;
+
+    return -1;
+}
+
+/**
+ * @brief Stub for #setsockopt that fails with #setsockoptErrno after
+ * #setsockoptCallsUntilFailure successful calls.
+ */
+static int setsockoptFailStub( int fd,
+                               int level,
+                               int optname,
+                               const void * optval,
+                               socklen_t optlen,
+                               int numCalls )
+{
+    int returnStatus = 0;
+
+    ( void ) fd;
+    ( void ) level;
+    ( void ) optname;
+    ( void ) optval;
+    ( void ) optlen;
+    ( void ) numCalls;
+
+    if( setsockoptCallsUntilFailure == 0 )
+    {
+        errno = setsockoptErrno;
+        returnStatus = -1;
+    }
+
+    setsockoptCallsUntilFailure--;
+
+    return returnStatus;
+}
+
+/**
+ * @brief Stub for #setsockopt that records the name of each option set and
+ * fails for #setsockoptFailingOption.
+ */
+static int setsockoptRecordStub( int fd,
+                                 int level,
+                                 int optname,
+                                 const void * optval,
+                                 socklen_t optlen,
+                                 int numCalls )
+{
+    int returnStatus = 0;
+
+    ( void ) fd;
+    ( void ) level;
+    ( void ) numCalls;
+
+    TEST_ASSERT_NOT_NULL( optval );
+    TEST_ASSERT_TRUE( optlen > 0 );
+    TEST_ASSERT_TRUE( setsockoptCount < ( int ) ( sizeof( setsockoptNames ) / sizeof( int ) ) );
+
+    setsockoptNames[ setsockoptCount ] = optname;
+    setsockoptCount++;
+
+    if( optname == setsockoptFailingOption )
+    {
+        errno = ENOPROTOOPT;
+        returnStatus = -1;
+    }
+
+    return returnStatus;
+}
+
 /* ============================   UNITY FIXTURES ============================ */
 
 /* Called before each test method. */
@@ -127,6 +313,20 @@ void setUp()
     serverInfo.pHostName = HOSTNAME;
     serverInfo.hostNameLength = strlen( HOSTNAME );
     serverInfo.port = PORT;
+
+    pendingAttemptsBeforeReady = NUM_PENDING;
+    lastAttemptSucceeds = true;
+    connectRefusedCall = -1;
+    memset( connectFamilies, 0, sizeof( connectFamilies ) );
+
+    setsockoptCount = 0;
+    setsockoptFailingOption = -1;
+
+    connect_Stub( connectStub );
+    poll_Stub( pollStub );
+
+    /* Start every test with an empty DNS cache. */
+    Sockets_InvalidateDnsCache( NULL );
 }
 
 /* Called after each test method. */
@@ -150,18 +350,33 @@ int suiteTearDown( int numFailures )
 /* ========================================================================== */
 
 /**
- * @brief Expect any methods called from #Sockets_Connect.
+ * @brief Expect the DNS lookup made by #Sockets_Connect when the host name is
+ * not in the DNS cache.
+ */
+static void expectDnsLookup( void )
+{
+    getaddrinfo_ExpectAnyArgsAndReturn( 0 );
+    getaddrinfo_ReturnThruPtr___pai( &addrInfo );
+    freeaddrinfo_ExpectAnyArgs();
+}
+
+/**
+ * @brief Expect the connection attempts made by #Sockets_Connect.
+ *
+ * The first call to #socket fails and the connection attempts to the remaining
+ * records are left in progress until all of them have been started.
  *
- * @param[in] connectSuccessIndex The index at which the #connect function succeeds.
+ * @param[in] connectSuccessIndex #NUM_ADDR_INFO if the attempt to the last
+ * record succeeds, or -1 if every attempt fails.
  */
-static void expectSocketsConnectCalls( int32_t connectSuccessIndex )
+static void expectConnectionAttempts( int32_t connectSuccessIndex )
 {
     uint16_t i;
 
-    TEST_ASSERT_TRUE( connectSuccessIndex <= NUM_ADDR_INFO );
+    TEST_ASSERT_TRUE( ( connectSuccessIndex == NUM_ADDR_INFO ) ||
+                      ( connectSuccessIndex == -1 ) );
 
-    getaddrinfo_ExpectAnyArgsAndReturn( 0 );
-    getaddrinfo_ReturnThruPtr___pai( &addrInfo );
+    lastAttemptSucceeds = ( connectSuccessIndex == NUM_ADDR_INFO );
 
     for( i = 1; i <= NUM_ADDR_INFO; i++ )
     {
@@ -178,20 +393,46 @@ static void expectSocketsConnectCalls( int32_t connectSuccessIndex )
 
         inet_ntop_ExpectAnyArgsAndReturn( NULL );
 
-        /* The last iteration should make connect() succeed. */
-        if( i == connectSuccessIndex )
+        /* Set the socket to non-blocking mode before #connectStub. */
+        fcntl_ExpectAnyArgsAndReturn( 0 );
+        fcntl_ExpectAnyArgsAndReturn( 0 );
+    }
+
+    if( lastAttemptSucceeds == true )
+    {
+        getsockopt_ExpectAnyArgsAndReturn( 0 );
+
+        /* Abandon the other attempts in progress. */
+        for( i = 1; i < NUM_PENDING; i++ )
         {
-            connect_ExpectAnyArgsAndReturn( 0 );
-            break;
+            close_ExpectAnyArgsAndReturn( 0 );
         }
-        else
+
+        /* Restore blocking mode on the connected socket. */
+        fcntl_ExpectAnyArgsAndReturn( 0 );
+        fcntl_ExpectAnyArgsAndReturn( 0 );
+    }
+    else
+    {
+        for( i = 0; i < NUM_PENDING; i++ )
         {
-            connect_ExpectAnyArgsAndReturn( -1 );
+            getsockopt_ExpectAnyArgsAndReturn( 0 );
+            getsockopt_ReturnMemThruPtr___optval( &connectionRefused, sizeof( connectionRefused ) );
             close_ExpectAnyArgsAndReturn( 0 );
         }
     }
+}
 
-    freeaddrinfo_ExpectAnyArgs();
+/**
+ * @brief Expect any methods called from #Sockets_Connect.
+ *
+ * @param[in] connectSuccessIndex #NUM_ADDR_INFO if the attempt to the last
+ * record succeeds, or -1 if every attempt fails.
+ */
+static void expectSocketsConnectCalls( int32_t connectSuccessIndex )
+{
+    expectDnsLookup();
+    expectConnectionAttempts( connectSuccessIndex );
 }
 
 /**
@@ -316,18 +557,14 @@ void test_Sockets_Connect_Fail_setsockopt( void )
 
     for( i = 0; i < ( sizeof( allErrorCases ) / sizeof( int32_t ) ); i++ )
     {
+        /* Resolve the host name on every iteration. */
+        Sockets_InvalidateDnsCache( NULL );
         expectSocketsConnectCalls( NUM_ADDR_INFO );
-        errno = allErrorCases[ i ];
 
-        if( i % 2 )
-        {
-            setsockopt_ExpectAnyArgsAndReturn( -1 );
-        }
-        else
-        {
-            setsockopt_ExpectAnyArgsAndReturn( 0 );
-            setsockopt_ExpectAnyArgsAndReturn( -1 );
-        }
+        /* errno is set by the stub as #connect overwrites it beforehand. */
+        setsockoptErrno = allErrorCases[ i ];
+        setsockoptCallsUntilFailure = ( i % 2 ) ? 0 : 1;
+        setsockopt_Stub( setsockoptFailStub );
 
         socketStatus = Sockets_Connect( &tcpSocket,
                                         &serverInfo,
@@ -370,3 +607,422 @@ void test_Sockets_Connect_Succeed_On_Nth_IP_Address( void )
                                     SEND_RECV_TIMEOUT );
     TEST_ASSERT_EQUAL( SOCKETS_SUCCESS, socketStatus );
 }
+
+/**
+ * @brief Test that #Sockets_Connect alternates between address families,
+ * starting with the family of the first record, and uses the first attempt
+ * to complete.
+ */
+void test_Sockets_Connect_Interleaves_Address_Families( void )
+{
+    SocketStatus_t socketStatus;
+    int tcpSocket = 1;
+    struct addrinfo records[ 4 ];
+    struct addrinfo * pRecords = records;
+    struct sockaddr_storage addresses[ 4 ];
+    uint16_t i;
+
+    memset( records, 0, sizeof( records ) );
+    memset( addresses, 0, sizeof( addresses ) );
+
+    /* Two IPv6 records followed by two IPv4 records. */
+    for( i = 0; i < 4; i++ )
+    {
+        records[ i ].ai_family = ( i < 2 ) ? AF_INET6 : AF_INET;
+        records[ i ].ai_socktype = SOCK_STREAM;
+        records[ i ].ai_protocol = IPPROTO_TCP;
+        records[ i ].ai_addrlen = sizeof( addresses[ i ] );
+        records[ i ].ai_addr = ( struct sockaddr * ) &addresses[ i ];
+        records[ i ].ai_addr->sa_family = records[ i ].ai_family;
+        records[ i ].ai_next = ( i < 3 ) ? &records[ i + 1 ] : NULL;
+    }
+
+    pendingAttemptsBeforeReady = 4;
+
+    getaddrinfo_ExpectAnyArgsAndReturn( 0 );
+    getaddrinfo_ReturnThruPtr___pai( &pRecords );
+    freeaddrinfo_ExpectAnyArgs();
+
+    for( i = 0; i < 4; i++ )
+    {
+        socket_ExpectAnyArgsAndReturn( 1 );
+        inet_ntop_ExpectAnyArgsAndReturn( NULL );
+        fcntl_ExpectAnyArgsAndReturn( 0 );
+        fcntl_ExpectAnyArgsAndReturn( 0 );
+    }
+
+    getsockopt_ExpectAnyArgsAndReturn( 0 );
+
+    for( i = 0; i < 3; i++ )
+    {
+        close_ExpectAnyArgsAndReturn( 0 );
+    }
+
+    fcntl_ExpectAnyArgsAndReturn( 0 );
+    fcntl_ExpectAnyArgsAndReturn( 0 );
+    setsockopt_ExpectAnyArgsAndReturn( 0 );
+    setsockopt_ExpectAnyArgsAndReturn( 0 );
+
+    socketStatus = Sockets_Connect( &tcpSocket,
+                                    &serverInfo,
+                                    SEND_RECV_TIMEOUT,
+                                    SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( SOCKETS_SUCCESS, socketStatus );
+    TEST_ASSERT_EQUAL( AF_INET6, connectFamilies[ 0 ] );
+    TEST_ASSERT_EQUAL( AF_INET, connectFamilies[ 1 ] );
+    TEST_ASSERT_EQUAL( AF_INET6, connectFamilies[ 2 ] );
+    TEST_ASSERT_EQUAL( AF_INET, connectFamilies[ 3 ] );
+}
+
+/**
+ * @brief Test that #Sockets_Connect moves on to the next record straight
+ * away when a connection attempt cannot be started.
+ */
+void test_Sockets_Connect_Attempts_Fail_To_Start( void )
+{
+    SocketStatus_t socketStatus;
+    int tcpSocket = 1;
+
+    /* The attempt to the third record is refused outright. */
+    connectRefusedCall = 0;
+
+    expectDnsLookup();
+
+    socket_ExpectAnyArgsAndReturn( -1 );
+
+    /* Setting non-blocking mode fails for the second record. */
+    socket_ExpectAnyArgsAndReturn( 1 );
+    inet_ntop_ExpectAnyArgsAndReturn( NULL );
+    fcntl_ExpectAnyArgsAndReturn( -1 );
+    close_ExpectAnyArgsAndReturn( 0 );
+
+    socket_ExpectAnyArgsAndReturn( 1 );
+    inet_ntop_ExpectAnyArgsAndReturn( NULL );
+    fcntl_ExpectAnyArgsAndReturn( 0 );
+    fcntl_ExpectAnyArgsAndReturn( 0 );
+    close_ExpectAnyArgsAndReturn( 0 );
+
+    socketStatus = Sockets_Connect( &tcpSocket,
+                                    &serverInfo,
+                                    SEND_RECV_TIMEOUT,
+                                    SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( SOCKETS_CONNECT_FAILURE, socketStatus );
+    TEST_ASSERT_EQUAL( -1, tcpSocket );
+}
+
+/**
+ * @brief Test that #Sockets_Connect abandons the attempts in progress when
+ * waiting for them fails, and fails when blocking mode cannot be restored.
+ */
+void test_Sockets_Connect_Wait_Fails( void )
+{
+    SocketStatus_t socketStatus;
+    int tcpSocket = 1;
+
+    poll_Stub( pollFailStub );
+
+    expectDnsLookup();
+    socket_ExpectAnyArgsAndReturn( 1 );
+    inet_ntop_ExpectAnyArgsAndReturn( NULL );
+    fcntl_ExpectAnyArgsAndReturn( 0 );
+    fcntl_ExpectAnyArgsAndReturn( 0 );
+    close_ExpectAnyArgsAndReturn( 0 );
+
+    socketStatus = Sockets_Connect( &tcpSocket,
+                                    &serverInfo,
+                                    SEND_RECV_TIMEOUT,
+                                    SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( SOCKETS_CONNECT_FAILURE, socketStatus );
+
+    /* The connection succeeds but the socket cannot be made blocking again. */
+    poll_Stub( pollStub );
+    pendingAttemptsBeforeReady = 1;
+
+    expectDnsLookup();
+    socket_ExpectAnyArgsAndReturn( 1 );
+    inet_ntop_ExpectAnyArgsAndReturn( NULL );
+    fcntl_ExpectAnyArgsAndReturn( 0 );
+    fcntl_ExpectAnyArgsAndReturn( 0 );
+    getsockopt_ExpectAnyArgsAndReturn( 0 );
+    fcntl_ExpectAnyArgsAndReturn( -1 );
+    close_ExpectAnyArgsAndReturn( 0 );
+
+    socketStatus = Sockets_Connect( &tcpSocket,
+                                    &serverInfo,
+                                    SEND_RECV_TIMEOUT,
+                                    SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( SOCKETS_CONNECT_FAILURE, socketStatus );
+}
+
+/**
+ * @brief Test that #Sockets_Connect reuses the resolved addresses of a server
+ * and counts the DNS cache hits and misses.
+ */
+void test_Sockets_Connect_Uses_Dns_Cache( void )
+{
+    SocketStatus_t socketStatus;
+    SocketsDnsCacheStats_t statsBefore, statsAfter;
+    int tcpSocket = 1;
+
+    socketStatus = Sockets_GetDnsCacheStats( &statsBefore );
+    TEST_ASSERT_EQUAL( SOCKETS_SUCCESS, socketStatus );
+
+    /* The first connection resolves the host name. */
+    expectSocketsConnectCalls( NUM_ADDR_INFO );
+    setsockopt_ExpectAnyArgsAndReturn( 0 );
+    setsockopt_ExpectAnyArgsAndReturn( 0 );
+
+    socketStatus = Sockets_Connect( &tcpSocket,
+                                    &serverInfo,
+                                    SEND_RECV_TIMEOUT,
+                                    SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( SOCKETS_SUCCESS, socketStatus );
+
+    /* The second connection uses the cached addresses. */
+    expectConnectionAttempts( NUM_ADDR_INFO );
+    setsockopt_ExpectAnyArgsAndReturn( 0 );
+    setsockopt_ExpectAnyArgsAndReturn( 0 );
+
+    socketStatus = Sockets_Connect( &tcpSocket,
+                                    &serverInfo,
+                                    SEND_RECV_TIMEOUT,
+                                    SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( SOCKETS_SUCCESS, socketStatus );
+
+    /* The cache is keyed by port as well as host name. */
+    serverInfo.port = PORT + 1;
+    expectSocketsConnectCalls( NUM_ADDR_INFO );
+    setsockopt_ExpectAnyArgsAndReturn( 0 );
+    setsockopt_ExpectAnyArgsAndReturn( 0 );
+
+    socketStatus = Sockets_Connect( &tcpSocket,
+                                    &serverInfo,
+                                    SEND_RECV_TIMEOUT,
+                                    SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( SOCKETS_SUCCESS, socketStatus );
+
+    socketStatus = Sockets_GetDnsCacheStats( &statsAfter );
+    TEST_ASSERT_EQUAL( SOCKETS_SUCCESS, socketStatus );
+    TEST_ASSERT_EQUAL( statsBefore.hits + 1U, statsAfter.hits );
+    TEST_ASSERT_EQUAL( statsBefore.misses + 2U, statsAfter.misses );
+}
+
+/**
+ * @brief Test that the cached addresses of a server are invalidated when no
+ * connection can be established to them.
+ */
+void test_Sockets_Connect_Invalidates_Dns_Cache( void )
+{
+    SocketStatus_t socketStatus;
+    int tcpSocket = 1;
+
+    expectSocketsConnectCalls( NUM_ADDR_INFO );
+    setsockopt_ExpectAnyArgsAndReturn( 0 );
+    setsockopt_ExpectAnyArgsAndReturn( 0 );
+
+    socketStatus = Sockets_Connect( &tcpSocket,
+                                    &serverInfo,
+                                    SEND_RECV_TIMEOUT,
+                                    SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( SOCKETS_SUCCESS, socketStatus );
+
+    /* Every cached address fails. */
+    expectConnectionAttempts( -1 );
+
+    socketStatus = Sockets_Connect( &tcpSocket,
+                                    &serverInfo,
+                                    SEND_RECV_TIMEOUT,
+                                    SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( SOCKETS_CONNECT_FAILURE, socketStatus );
+
+    /* The host name is resolved again. */
+    expectSocketsConnectCalls( NUM_ADDR_INFO );
+    setsockopt_ExpectAnyArgsAndReturn( 0 );
+    setsockopt_ExpectAnyArgsAndReturn( 0 );
+
+    socketStatus = Sockets_Connect( &tcpSocket,
+                                    &serverInfo,
+                                    SEND_RECV_TIMEOUT,
+                                    SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( SOCKETS_SUCCESS, socketStatus );
+
+    /* Explicit invalidation of the server also forces a new lookup. */
+    Sockets_InvalidateDnsCache( &serverInfo );
+    expectSocketsConnectCalls( NUM_ADDR_INFO );
+    setsockopt_ExpectAnyArgsAndReturn( 0 );
+    setsockopt_ExpectAnyArgsAndReturn( 0 );
+
+    socketStatus = Sockets_Connect( &tcpSocket,
+                                    &serverInfo,
+                                    SEND_RECV_TIMEOUT,
+                                    SEND_RECV_TIMEOUT );
+    TEST_ASSERT_EQUAL( SOCKETS_SUCCESS, socketStatus );
+}
+
+/**
+ * @brief Test that #Sockets_GetDnsCacheStats fails when invalid parameters
+ * are passed to the function.
+ */
+void test_Sockets_GetDnsCacheStats_Invalid_Params( void )
+{
+    TEST_ASSERT_EQUAL( SOCKETS_INVALID_PARAMETER, Sockets_GetDnsCacheStats( NULL ) );
+}
+
+/**
+ * @brief Test that #Sockets_SetTimeouts sets both timeouts on a valid socket
+ * and fails on an invalid one.
+ */
+void test_Sockets_SetTimeouts( void )
+{
+    TEST_ASSERT_EQUAL( SOCKETS_INVALID_PARAMETER,
+                       Sockets_SetTimeouts( -1, SEND_RECV_TIMEOUT, SEND_RECV_TIMEOUT ) );
+
+    setsockopt_ExpectAnyArgsAndReturn( 0 );
+    setsockopt_ExpectAnyArgsAndReturn( 0 );
+    TEST_ASSERT_EQUAL( SOCKETS_SUCCESS,
+                       Sockets_SetTimeouts( 1, SEND_RECV_TIMEOUT, SEND_RECV_TIMEOUT ) );
+}
+
+/**
+ * @brief Test that #Sockets_ConnectWithOptions applies the requested socket
+ * options to every connection attempt before the timeouts, leaving TCP Fast
+ * Open off the raced attempts.
+ */
+void test_Sockets_ConnectWithOptions_Applies_Options( void )
+{
+    SocketStatus_t socketStatus;
+    int tcpSocket = 1;
+    int i, j;
+    SocketsOptions_t options = { 0 };
+    const int expectedOptions[] =
+    {
+        TCP_NODELAY,      SO_KEEPALIVE, TCP_KEEPIDLE, TCP_KEEPINTVL, TCP_KEEPCNT,
+        TCP_USER_TIMEOUT, SO_SNDBUF, SO_RCVBUF
+    };
+    const int numOptions = ( int ) ( sizeof( expectedOptions ) / sizeof( int ) );
+
+    options.noDelay = 1U;
+    options.keepAlive = 1U;
+    options.keepAliveIdleSec = 30U;
+    options.keepAliveIntervalSec = 5U;
+    options.keepAliveCount = 3U;
+    options.userTimeoutMs = 10000U;
+    options.sendBufferSize = 4096U;
+    options.recvBufferSize = 8192U;
+    options.fastOpen = 1U;
+
+    expectSocketsConnectCalls( NUM_ADDR_INFO );
+    setsockopt_Stub( setsockoptRecordStub );
+
+    socketStatus = Sockets_ConnectWithOptions( &tcpSocket,
+                                               &serverInfo,
+                                               SEND_RECV_TIMEOUT,
+                                               SEND_RECV_TIMEOUT,
+                                               &options );
+    TEST_ASSERT_EQUAL( SOCKETS_SUCCESS, socketStatus );
+
+    /* Every attempt that created a socket, then the timeouts. */
+    TEST_ASSERT_EQUAL( ( NUM_PENDING * numOptions ) + 2, setsockoptCount );
+
+    for( i = 0; i < NUM_PENDING; i++ )
+    {
+        for( j = 0; j < numOptions; j++ )
+        {
+            TEST_ASSERT_EQUAL( expectedOptions[ j ], setsockoptNames[ ( i * numOptions ) + j ] );
+        }
+    }
+
+    TEST_ASSERT_EQUAL( SO_SNDTIMEO, setsockoptNames[ NUM_PENDING * numOptions ] );
+    TEST_ASSERT_EQUAL( SO_RCVTIMEO, setsockoptNames[ ( NUM_PENDING * numOptions ) + 1 ] );
+}
+
+/**
+ * @brief Test that #Sockets_ConnectWithOptions applies TCP Fast Open when the
+ * host resolves to a single address.
+ */
+void test_Sockets_ConnectWithOptions_FastOpen_Single_Address( void )
+{
+    SocketStatus_t socketStatus;
+    int tcpSocket = 1;
+    SocketsOptions_t options = { 0 };
+    struct addrinfo record;
+    struct addrinfo * pRecord = &record;
+    struct sockaddr_storage address;
+
+    memset( &record, 0, sizeof( record ) );
+    memset( &address, 0, sizeof( address ) );
+
+    record.ai_family = AF_INET;
+    record.ai_socktype = SOCK_STREAM;
+    record.ai_protocol = IPPROTO_TCP;
+    record.ai_addrlen = sizeof( address );
+    record.ai_addr = ( struct sockaddr * ) &address;
+    record.ai_addr->sa_family = AF_INET;
+    record.ai_next = NULL;
+
+    options.fastOpen = 1U;
+    pendingAttemptsBeforeReady = 1;
+
+    getaddrinfo_ExpectAnyArgsAndReturn( 0 );
+    getaddrinfo_ReturnThruPtr___pai( &pRecord );
+    freeaddrinfo_ExpectAnyArgs();
+
+    socket_ExpectAnyArgsAndReturn( 1 );
+    inet_ntop_ExpectAnyArgsAndReturn( NULL );
+    fcntl_ExpectAnyArgsAndReturn( 0 );
+    fcntl_ExpectAnyArgsAndReturn( 0 );
+    getsockopt_ExpectAnyArgsAndReturn( 0 );
+    fcntl_ExpectAnyArgsAndReturn( 0 );
+    fcntl_ExpectAnyArgsAndReturn( 0 );
+    setsockopt_Stub( setsockoptRecordStub );
+
+    socketStatus = Sockets_ConnectWithOptions( &tcpSocket,
+                                               &serverInfo,
+                                               SEND_RECV_TIMEOUT,
+                                               SEND_RECV_TIMEOUT,
+                                               &options );
+    TEST_ASSERT_EQUAL( SOCKETS_SUCCESS, socketStatus );
+    TEST_ASSERT_EQUAL( 3, setsockoptCount );
+    TEST_ASSERT_EQUAL( TCP_FASTOPEN_CONNECT, setsockoptNames[ 0 ] );
+    TEST_ASSERT_EQUAL( SO_SNDTIMEO, setsockoptNames[ 1 ] );
+    TEST_ASSERT_EQUAL( SO_RCVTIMEO, setsockoptNames[ 2 ] );
+}
+
+/**
+ * @brief Test that #Sockets_ConnectWithOptions abandons an attempt whose
+ * socket options cannot be set, and that options left at 0 are not set.
+ */
+void test_Sockets_ConnectWithOptions_Option_Fails( void )
+{
+    SocketStatus_t socketStatus;
+    int tcpSocket = 1;
+    uint16_t i;
+    SocketsOptions_t options = { 0 };
+
+    options.noDelay = 1U;
+    options.userTimeoutMs = 10000U;
+    setsockoptFailingOption = TCP_USER_TIMEOUT;
+
+    expectDnsLookup();
+    socket_ExpectAnyArgsAndReturn( -1 );
+
+    for( i = 1; i < NUM_ADDR_INFO; i++ )
+    {
+        socket_ExpectAnyArgsAndReturn( 1 );
+        inet_ntop_ExpectAnyArgsAndReturn( NULL );
+        close_ExpectAnyArgsAndReturn( 0 );
+    }
+
+    setsockopt_Stub( setsockoptRecordStub );
+
+    socketStatus = Sockets_ConnectWithOptions( &tcpSocket,
+                                               &serverInfo,
+                                               SEND_RECV_TIMEOUT,
+                                               SEND_RECV_TIMEOUT,
+                                               &options );
+    TEST_ASSERT_EQUAL( SOCKETS_CONNECT_FAILURE, socketStatus );
+    TEST_ASSERT_EQUAL( -1, tcpSocket );
+    TEST_ASSERT_EQUAL( NUM_PENDING * 2, setsockoptCount );
+    TEST_ASSERT_EQUAL( TCP_NODELAY, setsockoptNames[ 0 ] );
+    TEST_ASSERT_EQUAL( TCP_USER_TIMEOUT, setsockoptNames[ 1 ] );
+}
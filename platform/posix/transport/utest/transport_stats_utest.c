@@ -0,0 +1,167 @@
+/*
+ * AWS IoT Device SDK for Embedded C 202103.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "unity.h"
+
+/* Include paths for public enums, structures, and macros. */
+#include "transport_stats_posix.h"
+
+/* Bucket that holds the largest latencies. */
+#define LAST_BUCKET    ( TRANSPORT_STATS_HISTOGRAM_BUCKETS - 1U )
+
+static TransportStats_t stats;
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp()
+{
+    ( void ) memset( &stats, 0, sizeof( stats ) );
+}
+
+/* Called after each test method. */
+void tearDown()
+{
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Test that small latencies have a bucket each and that larger ones
+ * split every power of two in four buckets.
+ */
+void test_TransportStats_Bucket_Boundaries( void )
+{
+    size_t i;
+
+    for( i = 0; i < 8U; i++ )
+    {
+        TEST_ASSERT_EQUAL_UINT32( i, TransportStats_GetBucketLowerBound( i ) );
+    }
+
+    TEST_ASSERT_EQUAL_UINT32( 8U, TransportStats_GetBucketLowerBound( 8U ) );
+    TEST_ASSERT_EQUAL_UINT32( 10U, TransportStats_GetBucketLowerBound( 9U ) );
+    TEST_ASSERT_EQUAL_UINT32( 1024U, TransportStats_GetBucketLowerBound( 36U ) );
+    TEST_ASSERT_EQUAL_UINT32( 1280U, TransportStats_GetBucketLowerBound( 37U ) );
+    TEST_ASSERT_EQUAL_UINT32( 0xE0000000U, TransportStats_GetBucketLowerBound( LAST_BUCKET ) );
+
+    for( i = 1; i < TRANSPORT_STATS_HISTOGRAM_BUCKETS; i++ )
+    {
+        TEST_ASSERT_TRUE( TransportStats_GetBucketLowerBound( i - 1U ) <
+                          TransportStats_GetBucketLowerBound( i ) );
+    }
+}
+
+/**
+ * @brief Test that a latency is recorded in the bucket whose range holds it,
+ * and that latencies beyond 32 bits go to the last bucket.
+ */
+void test_TransportStats_RecordLatency( void )
+{
+    TransportStats_RecordLatency( &stats.sendUs, 3U );
+    TransportStats_RecordLatency( &stats.sendUs, 1279U );
+    TransportStats_RecordLatency( &stats.sendUs, 1280U );
+    TransportStats_RecordLatency( &stats.sendUs, 1ULL << 40 );
+
+    TEST_ASSERT_EQUAL_UINT32( 1U, stats.sendUs.counts[ 3 ] );
+    TEST_ASSERT_EQUAL_UINT32( 1U, stats.sendUs.counts[ 36 ] );
+    TEST_ASSERT_EQUAL_UINT32( 1U, stats.sendUs.counts[ 37 ] );
+    TEST_ASSERT_EQUAL_UINT32( 1U, stats.sendUs.counts[ LAST_BUCKET ] );
+    TEST_ASSERT_EQUAL_UINT64( 3U + 1279U + 1280U + ( 1ULL << 40 ), stats.sendUs.sumUs );
+}
+
+/**
+ * @brief Test that a percentile is the upper bound of the bucket that holds
+ * its rank, and zero for an empty histogram.
+ */
+void test_TransportStats_GetPercentile( void )
+{
+    uint32_t i;
+
+    TEST_ASSERT_EQUAL_UINT32( 0U, TransportStats_GetPercentile( &stats.recvUs, 50U ) );
+
+    for( i = 1; i <= 100U; i++ )
+    {
+        TransportStats_RecordLatency( &stats.recvUs, i );
+    }
+
+    /* The 50th latency, 50, is in the bucket from 48 to 55. */
+    TEST_ASSERT_EQUAL_UINT32( 55U, TransportStats_GetPercentile( &stats.recvUs, 50U ) );
+    TEST_ASSERT_EQUAL_UINT32( 1U, TransportStats_GetPercentile( &stats.recvUs, 0U ) );
+    TEST_ASSERT_EQUAL_UINT32( 111U, TransportStats_GetPercentile( &stats.recvUs, 100U ) );
+
+    TransportStats_RecordLatency( &stats.recvUs, UINT32_MAX );
+    TEST_ASSERT_EQUAL_UINT32( UINT32_MAX, TransportStats_GetPercentile( &stats.recvUs, 100U ) );
+}
+
+/**
+ * @brief Test that transfers are counted by direction and outcome, and that
+ * only successful connects and handshakes are timed.
+ */
+void test_TransportStats_Record_Transfers_And_Connects( void )
+{
+    TransportStats_t snapshot;
+
+    TransportStats_RecordTransfer( &stats, 1U, 10U, 10, 5U );
+    TransportStats_RecordTransfer( &stats, 1U, 10U, 4, 5U );
+    TransportStats_RecordTransfer( &stats, 0U, 10U, 10, 5U );
+    TransportStats_RecordTransfer( &stats, 0U, 10U, 0, 5U );
+    TransportStats_RecordTransfer( &stats, 0U, 10U, -1, 5U );
+    TransportStats_RecordConnect( &stats, 1U, 100U );
+    TransportStats_RecordConnect( &stats, 0U, 100U );
+    TransportStats_RecordHandshake( &stats, 1U, 100U );
+    TransportStats_RecordHandshake( &stats, 0U, 100U );
+
+    TransportStats_Snapshot( &stats, &snapshot );
+
+    TEST_ASSERT_EQUAL_UINT64( 2U, snapshot.sendCalls );
+    TEST_ASSERT_EQUAL_UINT64( 14U, snapshot.bytesSent );
+    TEST_ASSERT_EQUAL_UINT64( 1U, snapshot.partialSends );
+    TEST_ASSERT_EQUAL_UINT64( 3U, snapshot.recvCalls );
+    TEST_ASSERT_EQUAL_UINT64( 10U, snapshot.bytesReceived );
+    TEST_ASSERT_EQUAL_UINT64( 0U, snapshot.partialReads );
+    TEST_ASSERT_EQUAL_UINT64( 1U, snapshot.timeouts );
+    TEST_ASSERT_EQUAL_UINT64( 1U, snapshot.errors );
+    TEST_ASSERT_EQUAL_UINT64( 1U, snapshot.connects );
+    TEST_ASSERT_EQUAL_UINT64( 1U, snapshot.connectFailures );
+    TEST_ASSERT_EQUAL_UINT64( 1U, snapshot.handshakeFailures );
+    TEST_ASSERT_EQUAL_UINT64( 100U, snapshot.connectUs.sumUs );
+    TEST_ASSERT_EQUAL_UINT64( 100U, snapshot.handshakeUs.sumUs );
+    TEST_ASSERT_EQUAL_UINT64( 10U, snapshot.sendUs.sumUs );
+    TEST_ASSERT_EQUAL_UINT64( 15U, snapshot.recvUs.sumUs );
+    TEST_ASSERT_EQUAL_MEMORY( &stats, &snapshot, sizeof( stats ) );
+}
@@ -22,6 +22,7 @@
 
 #include <stdbool.h>
 #include <stdlib.h>
+#include <errno.h>
 
 #include "unity.h"
 
@@ -29,6 +30,7 @@
 #include "clock.h"
 
 #include "mock_time_api.h"
+#include "mock_event_api.h"
 
 /* The amount of time to sleep, which is a parameter passed to #Clock_SleepMs. */
 #define SLEEP_TIME_MS                  ( 500 )
@@ -41,6 +43,12 @@
 #define NANOSECONDS_PER_MILLISECOND    ( 1000000L )    /**< @brief Nanoseconds per millisecond. */
 #define MILLISECONDS_PER_SECOND        ( 1000L )
 
+/* File descriptor returned by the mocked #eventfd. */
+#define EVENT_FD                       ( 7 )
+
+/* Timeout passed to #Clock_WaitEvent. */
+#define WAIT_TIMEOUT_MS                ( 100U )
+
 /**
  * @brief Used to make assertions on the arguments passed to #nanosleep
  * from #Clock_SleepMs.
@@ -68,6 +76,71 @@ int nanosleep_validate_args( const struct timespec * requested_time,
     return 0;
 }
 
+/**
+ * @brief Expect a read of CLOCK_MONOTONIC that returns the given time.
+ *
+ * @param[in] pTimeSpec The time to return. It must outlive the call that reads
+ * the clock.
+ */
+static void expectClockMonotonic( struct timespec * pTimeSpec )
+{
+    clock_gettime_ExpectAndReturn( CLOCK_MONOTONIC, NULL, 0 );
+    clock_gettime_IgnoreArg_time_point();
+    clock_gettime_ReturnThruPtr_time_point( pTimeSpec );
+}
+
+/**
+ * @brief Stub of #poll for a wait that is interrupted by a signal after
+ * 30 ms, woken up after 60 ms, and interrupted again when the timeout expires.
+ */
+static int poll_retry( struct pollfd * fds,
+                       nfds_t nfds,
+                       int timeout,
+                       int numCalls )
+{
+    int returnValue = -1;
+
+    TEST_ASSERT_NOT_NULL( fds );
+    TEST_ASSERT_EQUAL( EVENT_FD, fds->fd );
+    TEST_ASSERT_EQUAL( 1U, nfds );
+
+    if( numCalls == 0 )
+    {
+        TEST_ASSERT_EQUAL( WAIT_TIMEOUT_MS, timeout );
+        errno = EINTR;
+    }
+    else if( numCalls == 1 )
+    {
+        TEST_ASSERT_EQUAL( WAIT_TIMEOUT_MS - 30, timeout );
+        returnValue = 1;
+    }
+    else
+    {
+        TEST_ASSERT_EQUAL( WAIT_TIMEOUT_MS - 60, timeout );
+        errno = EINTR;
+    }
+
+    return returnValue;
+}
+
+/**
+ * @brief Stub of #read for an event whose signal another thread consumed.
+ */
+static ssize_t read_consumed( int fd,
+                              void * buf,
+                              size_t nbytes,
+                              int numCalls )
+{
+    ( void ) fd;
+    ( void ) buf;
+    ( void ) nbytes;
+    ( void ) numCalls;
+
+    errno = EAGAIN;
+
+    return -1;
+}
+
 /* ============================   UNITY FIXTURES ============================ */
 
 /* Called before each test method. */
@@ -142,6 +215,29 @@ void test_Clock_GetTimeMs_Returns_Expected_Time_Guaranteed_Overflow( void )
     TEST_ASSERT_EQUAL( expectedTimeMs, actualTimeMs );
 }
 
+/**
+ * @brief Test that #Clock_GetTimeNs64 and #Clock_GetTimeUs64 return the full
+ * time of CLOCK_MONOTONIC without wrapping around.
+ */
+void test_Clock_GetTimeNs64_And_Us64_Return_Expected_Time( void )
+{
+    struct timespec timeSpec;
+
+    /* More than 2^32 milliseconds, which #Clock_GetTimeMs would wrap. */
+    timeSpec.tv_sec = 5000000;
+    timeSpec.tv_nsec = 123456789;
+
+    clock_gettime_ExpectAndReturn( CLOCK_MONOTONIC, NULL, 0 );
+    clock_gettime_IgnoreArg_time_point();
+    clock_gettime_ReturnThruPtr_time_point( &timeSpec );
+    TEST_ASSERT_EQUAL_UINT64( 5000000123456789ULL, Clock_GetTimeNs64() );
+
+    clock_gettime_ExpectAndReturn( CLOCK_MONOTONIC, NULL, 0 );
+    clock_gettime_IgnoreArg_time_point();
+    clock_gettime_ReturnThruPtr_time_point( &timeSpec );
+    TEST_ASSERT_EQUAL_UINT64( 5000000123456ULL, Clock_GetTimeUs64() );
+}
+
 /**
  * @brief Test that the call to #nanosleep in #Clock_SleepMs receives the
  * expected parameter values.
@@ -153,3 +249,141 @@ void test_Clock_SleepMs_Passes_Expected_Values_To_nanosleep()
     nanosleep_Stub( nanosleep_validate_args );
     Clock_SleepMs( sleepTimeMs );
 }
+
+/**
+ * @brief Test that #Clock_CreateEvent creates a non-blocking eventfd.
+ */
+void test_Clock_CreateEvent_Creates_Eventfd( void )
+{
+    ClockEvent_t event = { -1 };
+
+    eventfd_ExpectAndReturn( 0U, EFD_NONBLOCK | EFD_CLOEXEC, EVENT_FD );
+    TEST_ASSERT_EQUAL( CLOCK_EVENT_SUCCESS, Clock_CreateEvent( &event ) );
+    TEST_ASSERT_EQUAL( EVENT_FD, event.handle );
+
+    eventfd_ExpectAnyArgsAndReturn( -1 );
+    TEST_ASSERT_EQUAL( CLOCK_EVENT_API_ERROR, Clock_CreateEvent( &event ) );
+
+    TEST_ASSERT_EQUAL( CLOCK_EVENT_INVALID_PARAMETER, Clock_CreateEvent( NULL ) );
+}
+
+/**
+ * @brief Test that #Clock_SignalEvent increments the eventfd, and treats a
+ * saturated counter as signaled.
+ */
+void test_Clock_SignalEvent_Writes_Eventfd( void )
+{
+    ClockEvent_t event = { EVENT_FD };
+    ClockEvent_t invalidEvent = { -1 };
+
+    write_ExpectAndReturn( EVENT_FD, NULL, sizeof( uint64_t ), sizeof( uint64_t ) );
+    write_IgnoreArg___buf();
+    TEST_ASSERT_EQUAL( CLOCK_EVENT_SUCCESS, Clock_SignalEvent( &event ) );
+
+    errno = EAGAIN;
+    write_ExpectAnyArgsAndReturn( -1 );
+    TEST_ASSERT_EQUAL( CLOCK_EVENT_SUCCESS, Clock_SignalEvent( &event ) );
+
+    errno = EBADF;
+    write_ExpectAnyArgsAndReturn( -1 );
+    TEST_ASSERT_EQUAL( CLOCK_EVENT_API_ERROR, Clock_SignalEvent( &event ) );
+
+    TEST_ASSERT_EQUAL( CLOCK_EVENT_INVALID_PARAMETER, Clock_SignalEvent( NULL ) );
+    TEST_ASSERT_EQUAL( CLOCK_EVENT_INVALID_PARAMETER, Clock_SignalEvent( &invalidEvent ) );
+}
+
+/**
+ * @brief Test that #Clock_WaitEvent returns once the event is signaled and
+ * resets it.
+ */
+void test_Clock_WaitEvent_Signaled( void )
+{
+    ClockEvent_t event = { EVENT_FD };
+    struct timespec timeSpec = { GET_TIME_S, 0 };
+
+    expectClockMonotonic( &timeSpec );
+    poll_ExpectAndReturn( NULL, 1U, ( int ) WAIT_TIMEOUT_MS, 1 );
+    poll_IgnoreArg___fds();
+    read_ExpectAndReturn( EVENT_FD, NULL, sizeof( uint64_t ), sizeof( uint64_t ) );
+    read_IgnoreArg___buf();
+
+    TEST_ASSERT_EQUAL( CLOCK_EVENT_SUCCESS, Clock_WaitEvent( &event, WAIT_TIMEOUT_MS ) );
+}
+
+/**
+ * @brief Test that #Clock_WaitEvent times out when the event is not signaled.
+ */
+void test_Clock_WaitEvent_Timeout( void )
+{
+    ClockEvent_t event = { EVENT_FD };
+    struct timespec timeSpec = { GET_TIME_S, 0 };
+
+    expectClockMonotonic( &timeSpec );
+    poll_ExpectAnyArgsAndReturn( 0 );
+
+    TEST_ASSERT_EQUAL( CLOCK_EVENT_TIMEOUT, Clock_WaitEvent( &event, WAIT_TIMEOUT_MS ) );
+}
+
+/**
+ * @brief Test that #Clock_WaitEvent waits for the rest of the timeout after
+ * it is interrupted, or after another thread consumed the signal.
+ */
+void test_Clock_WaitEvent_Retries_For_Remaining_Time( void )
+{
+    ClockEvent_t event = { EVENT_FD };
+    struct timespec startTime = { GET_TIME_S, 0 };
+    struct timespec interruptTime = { GET_TIME_S, 30 * NANOSECONDS_PER_MILLISECOND };
+    struct timespec consumedTime = { GET_TIME_S, 60 * NANOSECONDS_PER_MILLISECOND };
+    struct timespec endTime = { GET_TIME_S, 100 * NANOSECONDS_PER_MILLISECOND };
+
+    poll_Stub( poll_retry );
+    read_Stub( read_consumed );
+
+    expectClockMonotonic( &startTime );
+    expectClockMonotonic( &interruptTime );
+    expectClockMonotonic( &consumedTime );
+    expectClockMonotonic( &endTime );
+
+    TEST_ASSERT_EQUAL( CLOCK_EVENT_TIMEOUT, Clock_WaitEvent( &event, WAIT_TIMEOUT_MS ) );
+}
+
+/**
+ * @brief Test that #Clock_WaitEvent fails on invalid parameters and errors of
+ * poll or read.
+ */
+void test_Clock_WaitEvent_Errors( void )
+{
+    ClockEvent_t event = { EVENT_FD };
+    ClockEvent_t invalidEvent = { -1 };
+    struct timespec timeSpec = { GET_TIME_S, 0 };
+
+    TEST_ASSERT_EQUAL( CLOCK_EVENT_INVALID_PARAMETER, Clock_WaitEvent( NULL, WAIT_TIMEOUT_MS ) );
+    TEST_ASSERT_EQUAL( CLOCK_EVENT_INVALID_PARAMETER, Clock_WaitEvent( &invalidEvent, WAIT_TIMEOUT_MS ) );
+
+    expectClockMonotonic( &timeSpec );
+    errno = EBADF;
+    poll_ExpectAnyArgsAndReturn( -1 );
+    TEST_ASSERT_EQUAL( CLOCK_EVENT_API_ERROR, Clock_WaitEvent( &event, WAIT_TIMEOUT_MS ) );
+
+    expectClockMonotonic( &timeSpec );
+    poll_ExpectAnyArgsAndReturn( 1 );
+    errno = EBADF;
+    read_ExpectAnyArgsAndReturn( -1 );
+    TEST_ASSERT_EQUAL( CLOCK_EVENT_API_ERROR, Clock_WaitEvent( &event, WAIT_TIMEOUT_MS ) );
+}
+
+/**
+ * @brief Test that #Clock_DestroyEvent closes the eventfd once.
+ */
+void test_Clock_DestroyEvent_Closes_Eventfd( void )
+{
+    ClockEvent_t event = { EVENT_FD };
+
+    close_ExpectAndReturn( EVENT_FD, 0 );
+    Clock_DestroyEvent( &event );
+    TEST_ASSERT_EQUAL( -1, event.handle );
+
+    /* Destroying the event again, or a NULL event, does nothing. */
+    Clock_DestroyEvent( &event );
+    Clock_DestroyEvent( NULL );
+}
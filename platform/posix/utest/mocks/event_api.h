@@ -0,0 +1,77 @@
+/*
+ * AWS IoT Device SDK for Embedded C 202103.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/**
+ * @file event_api.h
+ * @brief This file is used to generate a mock for the POSIX functions used by
+ * the events of clock_posix.c.
+ */
+
+#ifndef EVENT_API_H_
+#define EVENT_API_H_
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+/* Return file descriptor for generic event channel.  Set initial
+ * value to COUNT.  */
+extern int eventfd( unsigned int count,
+                    int flags );
+
+/* Poll the file descriptors described by the NFDS structures starting at
+ * FDS.  If TIMEOUT is nonzero and not -1, allow TIMEOUT milliseconds for
+ * an event to occur; if TIMEOUT is -1, block until an event occurs.
+ * Returns the number of file descriptors with events, zero if timed out,
+ * or -1 for errors.
+ *
+ * This function is a cancellation point and therefore not marked with
+ * __THROW.  */
+extern int poll( struct pollfd * __fds,
+                 nfds_t __nfds,
+                 int __timeout );
+
+/* Read NBYTES into BUF from FD.  Return the
+ * number read, -1 for errors or 0 for EOF.
+ *
+ * This function is a cancellation point and therefore not marked with
+ * __THROW.  */
+extern ssize_t read( int __fd,
+                     void * __buf,
+                     size_t __nbytes );
+
+/* Write N bytes of BUF to FD.  Return the number written, or -1.
+ *
+ * This function is a cancellation point and therefore not marked with
+ * __THROW.  */
+extern ssize_t write( int __fd,
+                      const void * __buf,
+                      size_t __n );
+
+/* Close the file descriptor FD.
+ *
+ * This function is a cancellation point and therefore not marked with
+ * __THROW.  */
+extern int close( int __fd );
+
+#endif /* ifndef EVENT_API_H_ */
@@ -0,0 +1,47 @@
+/*
+ * AWS IoT Device SDK for Embedded C 202103.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/**
+ * @file timerfd_api.h
+ * @brief This file is used to generate a mock for the functions of
+ * sys/timerfd.h used by the timer wheel.
+ */
+
+#ifndef TIMERFD_API_H_
+#define TIMERFD_API_H_
+
+#include <sys/timerfd.h>
+
+/* Return file descriptor for new interval timer source.  */
+extern int timerfd_create( __clockid_t __clock_id,
+                           int __flags );
+
+/* Set next expiration time of interval timer source UFD to UTMR.  If
+ * FLAGS has the TFD_TIMER_ABSTIME flag set the timeout value is
+ * absolute.  Optionally return the old expiration time in OTMR.  */
+extern int timerfd_settime( int __ufd,
+                            int __flags,
+                            const struct itimerspec * __utmr,
+                            struct itimerspec * __otmr );
+
+#endif /* ifndef TIMERFD_API_H_ */
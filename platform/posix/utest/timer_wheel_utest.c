@@ -0,0 +1,389 @@
+/*
+ * AWS IoT Device SDK for Embedded C 202103.00
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/* Standard includes. */
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+
+#include "unity.h"
+
+/* Include paths for public enums, structures, and macros. */
+#include "timer_wheel_posix.h"
+
+#include "mock_event_api.h"
+#include "mock_timerfd_api.h"
+
+/* File descriptor returned by the mocked #timerfd_create. */
+#define TIMER_FD      ( 9 )
+
+/* Period of a tick of the timer wheel under test. */
+#define TICK_MS       ( 10U )
+
+/* Number of timers used by the tests. */
+#define NUM_TIMERS    ( 3U )
+
+/* The timer wheel under test. */
+static TimerWheel_t timerWheel;
+
+/* Timers used by the tests. */
+static TimerWheelTimer_t timers[ NUM_TIMERS ];
+
+/* Number of times each timer expired. */
+static uint32_t expiredCount[ NUM_TIMERS ];
+
+/* Number of ticks returned by the next read of the timerfd. */
+static uint64_t dueTicks;
+
+/* Whether the timerfd was last armed or disarmed. */
+static bool ticksArmed;
+
+/* Number of calls to #timerfd_settime. */
+static int settimeCalls;
+
+/* ========================================================================== */
+
+/**
+ * @brief Stub of #read returning the ticks due on the timerfd.
+ */
+static ssize_t read_ticks( int fd,
+                           void * buf,
+                           size_t nbytes,
+                           int numCalls )
+{
+    ssize_t returnValue = -1;
+
+    ( void ) numCalls;
+
+    TEST_ASSERT_EQUAL( TIMER_FD, fd );
+    TEST_ASSERT_EQUAL( sizeof( uint64_t ), nbytes );
+
+    if( dueTicks == 0U )
+    {
+        errno = EAGAIN;
+    }
+    else
+    {
+        ( void ) memcpy( buf, &dueTicks, sizeof( dueTicks ) );
+        dueTicks = 0U;
+        returnValue = ( ssize_t ) sizeof( uint64_t );
+    }
+
+    return returnValue;
+}
+
+/**
+ * @brief Stub of #timerfd_settime recording whether the ticks are armed and
+ * checking their period.
+ */
+static int timerfd_settime_record( int ufd,
+                                   int flags,
+                                   const struct itimerspec * utmr,
+                                   struct itimerspec * otmr,
+                                   int numCalls )
+{
+    ( void ) numCalls;
+
+    TEST_ASSERT_EQUAL( TIMER_FD, ufd );
+    TEST_ASSERT_EQUAL( 0, flags );
+    TEST_ASSERT_NULL( otmr );
+
+    ticksArmed = ( utmr->it_value.tv_sec != 0 ) || ( utmr->it_value.tv_nsec != 0 );
+
+    if( ticksArmed == true )
+    {
+        TEST_ASSERT_EQUAL( 0, utmr->it_interval.tv_sec );
+        TEST_ASSERT_EQUAL( TICK_MS * 1000000L, utmr->it_interval.tv_nsec );
+    }
+
+    settimeCalls++;
+
+    return 0;
+}
+
+/**
+ * @brief Callback of the timers, counting their expirations.
+ */
+static void timerCallback( TimerWheelTimer_t * pTimer,
+                           void * pUserData )
+{
+    size_t index = ( size_t ) pUserData;
+
+    TEST_ASSERT_EQUAL_PTR( &timers[ index ], pTimer );
+    expiredCount[ index ]++;
+}
+
+/**
+ * @brief Callback of a periodic timer, which starts itself again.
+ */
+static void periodicCallback( TimerWheelTimer_t * pTimer,
+                              void * pUserData )
+{
+    timerCallback( pTimer, pUserData );
+
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_SUCCESS,
+                       TimerWheel_Start( &timerWheel, pTimer, TICK_MS, periodicCallback, pUserData ) );
+}
+
+/**
+ * @brief Process a number of ticks of the timer wheel.
+ *
+ * @param[in] ticks The ticks due on the timerfd.
+ *
+ * @return The number of timers that expired.
+ */
+static size_t processTicks( uint64_t ticks )
+{
+    size_t numExpired = 0U;
+
+    dueTicks = ticks;
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_SUCCESS, TimerWheel_Process( &timerWheel, &numExpired ) );
+
+    return numExpired;
+}
+
+/* ============================   UNITY FIXTURES ============================ */
+
+/* Called before each test method. */
+void setUp()
+{
+    ( void ) memset( timers, 0, sizeof( timers ) );
+    ( void ) memset( expiredCount, 0, sizeof( expiredCount ) );
+    dueTicks = 0U;
+    ticksArmed = false;
+    settimeCalls = 0;
+
+    timerfd_create_ExpectAndReturn( CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC, TIMER_FD );
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_SUCCESS, TimerWheel_Init( &timerWheel, TICK_MS ) );
+
+    read_Stub( read_ticks );
+    timerfd_settime_Stub( timerfd_settime_record );
+}
+
+/* Called after each test method. */
+void tearDown()
+{
+    close_ExpectAndReturn( TIMER_FD, 0 );
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_SUCCESS, TimerWheel_Deinit( &timerWheel ) );
+}
+
+/* Called at the beginning of the whole suite. */
+void suiteSetUp()
+{
+}
+
+/* Called at the end of the whole suite. */
+int suiteTearDown( int numFailures )
+{
+    return numFailures;
+}
+
+/* ========================================================================== */
+
+/**
+ * @brief Test that #TimerWheel_Init fails with invalid parameters or when
+ * the timerfd cannot be created.
+ */
+void test_TimerWheel_Init_Errors( void )
+{
+    TimerWheel_t otherWheel;
+
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_INVALID_PARAMETER, TimerWheel_Init( NULL, TICK_MS ) );
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_INVALID_PARAMETER, TimerWheel_Init( &otherWheel, 0U ) );
+
+    errno = EMFILE;
+    timerfd_create_ExpectAnyArgsAndReturn( -1 );
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_INSUFFICIENT_MEMORY, TimerWheel_Init( &otherWheel, TICK_MS ) );
+    TEST_ASSERT_EQUAL( -1, TimerWheel_GetDescriptor( &otherWheel ) );
+
+    TEST_ASSERT_EQUAL( TIMER_FD, TimerWheel_GetDescriptor( &timerWheel ) );
+    TEST_ASSERT_EQUAL( -1, TimerWheel_GetDescriptor( NULL ) );
+}
+
+/**
+ * @brief Test that timers expire at the first tick after their timeout, and
+ * that the ticks only run while timers are pending.
+ */
+void test_TimerWheel_Timers_Expire_After_Timeout( void )
+{
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_SUCCESS,
+                       TimerWheel_Start( &timerWheel, &timers[ 0 ], 3U * TICK_MS, timerCallback, ( void * ) 0 ) );
+    TEST_ASSERT_TRUE( ticksArmed );
+
+    /* A timeout that is not a multiple of the tick is rounded up. */
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_SUCCESS,
+                       TimerWheel_Start( &timerWheel, &timers[ 1 ], ( 3U * TICK_MS ) + 1U, timerCallback, ( void * ) 1 ) );
+    TEST_ASSERT_EQUAL( 1, settimeCalls );
+
+    /* Nothing is due yet. */
+    TEST_ASSERT_EQUAL( 0U, processTicks( 0U ) );
+    TEST_ASSERT_EQUAL( 0U, processTicks( 3U ) );
+    TEST_ASSERT_EQUAL( 1U, processTicks( 1U ) );
+    TEST_ASSERT_EQUAL( 1U, expiredCount[ 0 ] );
+    TEST_ASSERT_TRUE( ticksArmed );
+
+    TEST_ASSERT_EQUAL( 1U, processTicks( 1U ) );
+    TEST_ASSERT_EQUAL( 1U, expiredCount[ 1 ] );
+
+    /* The ticks stop once the wheel is empty. */
+    TEST_ASSERT_FALSE( ticksArmed );
+    TEST_ASSERT_EQUAL( 0U, timerWheel.numTimers );
+}
+
+/**
+ * @brief Test that timers in the higher levels of the wheel are brought down
+ * and expire at the right tick, including beyond the range of the wheel.
+ */
+void test_TimerWheel_Cascades_Long_Timers( void )
+{
+    uint64_t wheelRange = ( uint64_t ) 1U << ( TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS );
+
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_SUCCESS,
+                       TimerWheel_Start( &timerWheel, &timers[ 0 ], 100U * TICK_MS, timerCallback, ( void * ) 0 ) );
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_SUCCESS,
+                       TimerWheel_Start( &timerWheel, &timers[ 1 ], 5000U * TICK_MS, timerCallback, ( void * ) 1 ) );
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_SUCCESS,
+                       TimerWheel_Start( &timerWheel, &timers[ 2 ], ( uint32_t ) ( wheelRange + 100U ) * TICK_MS, timerCallback, ( void * ) 2 ) );
+
+    TEST_ASSERT_EQUAL( 0U, processTicks( 100U ) );
+    TEST_ASSERT_EQUAL( 1U, processTicks( 1U ) );
+    TEST_ASSERT_EQUAL( 1U, expiredCount[ 0 ] );
+
+    TEST_ASSERT_EQUAL( 0U, processTicks( 5000U - 101U ) );
+    TEST_ASSERT_EQUAL( 1U, processTicks( 1U ) );
+    TEST_ASSERT_EQUAL( 1U, expiredCount[ 1 ] );
+
+    /* The last timer is beyond the range of the wheel. */
+    TEST_ASSERT_EQUAL( 0U, processTicks( wheelRange + 100U - 5001U ) );
+    TEST_ASSERT_EQUAL( 1U, processTicks( 1U ) );
+    TEST_ASSERT_EQUAL( 1U, expiredCount[ 2 ] );
+}
+
+/**
+ * @brief Test that canceled timers do not expire, and that restarting a
+ * pending timer moves its expiry.
+ */
+void test_TimerWheel_Cancel_And_Restart( void )
+{
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_SUCCESS,
+                       TimerWheel_Start( &timerWheel, &timers[ 0 ], TICK_MS, timerCallback, ( void * ) 0 ) );
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_SUCCESS,
+                       TimerWheel_Start( &timerWheel, &timers[ 1 ], TICK_MS, timerCallback, ( void * ) 1 ) );
+
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_SUCCESS, TimerWheel_Cancel( &timerWheel, &timers[ 0 ] ) );
+    /* Canceling again does nothing. */
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_SUCCESS, TimerWheel_Cancel( &timerWheel, &timers[ 0 ] ) );
+
+    /* Restarting pushes the expiry back. */
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_SUCCESS,
+                       TimerWheel_Start( &timerWheel, &timers[ 1 ], 2U * TICK_MS, timerCallback, ( void * ) 1 ) );
+    TEST_ASSERT_EQUAL( 1U, timerWheel.numTimers );
+
+    TEST_ASSERT_EQUAL( 0U, processTicks( 2U ) );
+    TEST_ASSERT_EQUAL( 1U, processTicks( 1U ) );
+    TEST_ASSERT_EQUAL( 0U, expiredCount[ 0 ] );
+    TEST_ASSERT_EQUAL( 1U, expiredCount[ 1 ] );
+}
+
+/**
+ * @brief Test that a callback can start its timer again, which keeps the
+ * ticks running.
+ */
+void test_TimerWheel_Periodic_Timer( void )
+{
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_SUCCESS,
+                       TimerWheel_Start( &timerWheel, &timers[ 0 ], TICK_MS, periodicCallback, ( void * ) 0 ) );
+
+    TEST_ASSERT_EQUAL( 1U, processTicks( 2U ) );
+
+    /* The timer was started again after the ticks were processed. */
+    TEST_ASSERT_EQUAL( 0U, processTicks( 1U ) );
+    TEST_ASSERT_EQUAL( 1U, processTicks( 1U ) );
+    TEST_ASSERT_EQUAL( 2U, expiredCount[ 0 ] );
+    TEST_ASSERT_TRUE( ticksArmed );
+    TEST_ASSERT_EQUAL( 1, settimeCalls );
+
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_SUCCESS, TimerWheel_Cancel( &timerWheel, &timers[ 0 ] ) );
+}
+
+/**
+ * @brief Test that #TimerWheel_Run waits on the timerfd before processing the
+ * ticks.
+ */
+void test_TimerWheel_Run( void )
+{
+    size_t numExpired = 1U;
+
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_SUCCESS,
+                       TimerWheel_Start( &timerWheel, &timers[ 0 ], TICK_MS, timerCallback, ( void * ) 0 ) );
+
+    /* Timeout. */
+    poll_ExpectAndReturn( NULL, 1U, 0, 0 );
+    poll_IgnoreArg___fds();
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_SUCCESS, TimerWheel_Run( &timerWheel, 0U, &numExpired ) );
+    TEST_ASSERT_EQUAL( 0U, numExpired );
+
+    /* Interrupted. */
+    errno = EINTR;
+    poll_ExpectAndReturn( NULL, 1U, -1, -1 );
+    poll_IgnoreArg___fds();
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_SUCCESS, TimerWheel_Run( &timerWheel, TIMER_WHEEL_WAIT_FOREVER, NULL ) );
+
+    /* Ticks due. */
+    dueTicks = 2U;
+    poll_ExpectAndReturn( NULL, 1U, 100, 1 );
+    poll_IgnoreArg___fds();
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_SUCCESS, TimerWheel_Run( &timerWheel, 100U, &numExpired ) );
+    TEST_ASSERT_EQUAL( 1U, numExpired );
+
+    /* Error. */
+    errno = ENOMEM;
+    poll_ExpectAnyArgsAndReturn( -1 );
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_INSUFFICIENT_MEMORY, TimerWheel_Run( &timerWheel, 100U, NULL ) );
+}
+
+/**
+ * @brief Test that the functions of the timer wheel fail with invalid
+ * parameters.
+ */
+void test_TimerWheel_Invalid_Parameters( void )
+{
+    TimerWheel_t uninitializedWheel;
+
+    uninitializedWheel.timerDescriptor = -1;
+
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_INVALID_PARAMETER,
+                       TimerWheel_Start( NULL, &timers[ 0 ], TICK_MS, timerCallback, NULL ) );
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_INVALID_PARAMETER,
+                       TimerWheel_Start( &uninitializedWheel, &timers[ 0 ], TICK_MS, timerCallback, NULL ) );
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_INVALID_PARAMETER,
+                       TimerWheel_Start( &timerWheel, NULL, TICK_MS, timerCallback, NULL ) );
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_INVALID_PARAMETER,
+                       TimerWheel_Start( &timerWheel, &timers[ 0 ], TICK_MS, NULL, NULL ) );
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_INVALID_PARAMETER, TimerWheel_Cancel( NULL, &timers[ 0 ] ) );
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_INVALID_PARAMETER, TimerWheel_Cancel( &timerWheel, NULL ) );
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_INVALID_PARAMETER, TimerWheel_Process( NULL, NULL ) );
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_INVALID_PARAMETER, TimerWheel_Run( &uninitializedWheel, 0U, NULL ) );
+    TEST_ASSERT_EQUAL( TIMER_WHEEL_INVALID_PARAMETER, TimerWheel_Deinit( &uninitializedWheel ) );
+    TEST_ASSERT_EQUAL( 0U, timerWheel.numTimers );
+}